@@ -1,13 +1,24 @@
 #include <win32/sgePlatformNativeWin32.h>
+#include <headless/sgePlatformNativeHeadless.h>
 #include <core/sgeLog.h>
 #include <core/sgeScene.h>
 #include <core/sgeApplication.h>
 #include <core/sgeRenderer.h>
+#include <core/sgeTimer.h>
+#include <core/sgeProfiler.h>
+#include <core/sgeGLX.h>
+#include <core/sgeThread.h>
+#include <core/sgeSemaphore.h>
 #include <ui/sgeLabel.h>
 #include <ui/sgeViewGroup.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+#include <time.h>
 
 using namespace sge;
 
+#ifdef _WIN32
 char*   asiccToUtf8(const char* utf8)
 {
     int len = ::MultiByteToWideChar(CP_ACP, 0, utf8, -1, NULL, 0);
@@ -24,17 +35,725 @@ char*   asiccToUtf8(const char* utf8)
 
     return szAs;
 }
+#endif
+
+/**
+ * Benchmark drawing the frames one way in the first half of them and another way in the rest,
+ * the time of both is logged when the last frame is rendered
+ */
+class SplitBenchmark
+{
+public:
+    SplitBenchmark()
+        : mName(NULL), mUnit(NULL), mWorstLogged(false)
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            mWays[i] = NULL;
+            mElapsed[i] = 0;
+            mWorst[i] = 0;
+            mCount[i] = 0;
+        }
+    }
+
+    /**
+     * Name the benchmark and its two ways
+     * @param unit The item the time is reported per, NULL for the frame
+     * @param worst Also log the worst frame of both ways
+     */
+    void setNames(const char* name, const char* first, const char* second, const char* unit = NULL, bool worst = false)
+    {
+        mName = name;
+        mWays[0] = first;
+        mWays[1] = second;
+        mUnit = unit;
+        mWorstLogged = worst;
+    }
+
+    bool isEnabled() const
+    {
+        return mName != NULL;
+    }
+
+    /**
+     * Add the time of a frame drawn the second way or not
+     * @param count The items drawn in the time, with a unit
+     */
+    void add(bool second, float elapsed, int count = 1)
+    {
+        int way = second ? 1 : 0;
+        mElapsed[way] += elapsed;
+        mWorst[way] = std::max(mWorst[way], elapsed);
+        mCount[way] += count;
+    }
+
+    /**
+     * Get the average time of a way in seconds, per frame or per item of the unit
+     */
+    float getAverage(int way) const
+    {
+        return mCount[way] > 0 ? mElapsed[way] / mCount[way] : 0.0f;
+    }
+
+    void report() const
+    {
+        if (!isEnabled())
+        {
+            return;
+        }
+        if (mUnit != NULL)
+        {
+            Log::info("%s, %s %.2f us, %s %.2f us per %s over %d %ss", mName, mWays[0], getAverage(0) * 1e6f,
+                mWays[1], getAverage(1) * 1e6f, mUnit, mCount[0] + mCount[1], mUnit);
+            return;
+        }
+        Log::info("%s, %s %.3f ms, %s %.3f ms per frame", mName, mWays[0], getAverage(0) * 1000.0f,
+            mWays[1], getAverage(1) * 1000.0f);
+        if (mWorstLogged)
+        {
+            Log::info("%s, worst frame %s %.3f ms, %s %.3f ms", mName, mWays[0], mWorst[0] * 1000.0f,
+                mWays[1], mWorst[1] * 1000.0f);
+        }
+    }
+
+private:
+    const char* mName;
+    const char* mWays[2];
+    const char* mUnit;
+    bool    mWorstLogged;
+    float   mElapsed[2];
+    float   mWorst[2];
+    int     mCount[2];
+};
+
+#if SGE_TARGET_PLATFORM != SGE_PLATFORM_WIN32 && defined(OPENGLES)
+/**
+ * Post mouse moves to the headless platform from another thread, like input arriving
+ * while the application sleeps, the moves do not invalidate the scene
+ */
+class EventPoster : public Thread
+{
+public:
+    EventPoster(PlatformNative* platform)
+        : mPlatform(static_cast<PlatformHeadlessNative*>(platform)), mStop(0), mPosted(0)
+    {
+    }
+
+    void stop()
+    {
+        mStop.set();
+        join();
+    }
+
+    int getPostedCount() const
+    {
+        return mPosted;
+    }
+
+    virtual int run() override
+    {
+        while (!mStop.wait(15))
+        {
+            mPlatform->postMouseEvent(HeadlessMouseMove, mPosted % 800, 300);
+            ++mPosted;
+        }
+        return 0;
+    }
+
+private:
+    PlatformHeadlessNative* mPlatform;
+    Semaphore   mStop;
+    int         mPosted;
+};
+#endif
+
+/**
+ * The demos of App, one at a time
+ */
+enum DemoMode
+{
+    DemoNone,
+    DemoChart,
+    DemoIcons,
+    DemoDamage,
+    DemoWidgets,
+    DemoPlot,
+    DemoZoomText,
+    DemoAsyncGlyphs,
+    DemoLayers,
+    DemoLabels,
+    DemoRasterGlyphs,
+    DemoOnDemand,
+    DemoTessThreads,
+    DemoDisplayList,
+};
 
 class MyScene : public Scene
 {
 public:
 
+    int     mMaxFrames;
+    int     mFrames;
+    float   mElapsed;
+    Timer   mTimer;
+    DemoMode        mMode;
+    SplitBenchmark  mBench;
+    Vector<RendererImage*>  mIconImages;
+    float   mDamageArea;
+    ui::Label*  mBlinkLabel;
+    Vector<float2>      mSamples;
+    RendererPolyline    mPolyline;
+    int     mPlaceholders;
+    ui::ViewGroup*  mPanel;
+    RendererDisplayList mChromeList;
+    clock_t mClock;
+#if SGE_TARGET_PLATFORM != SGE_PLATFORM_WIN32 && defined(OPENGLES)
+    EventPoster*    mPoster;
+#endif
+
 public:
-    MyScene(Application* app): Scene(app) {}
+    MyScene(Application* app, int maxFrames = 0)
+        : Scene(app), mMaxFrames(maxFrames), mFrames(0), mElapsed(0), mMode(DemoNone)
+        , mDamageArea(0), mBlinkLabel(NULL), mPlaceholders(0), mPanel(NULL), mClock(0)
+#if SGE_TARGET_PLATFORM != SGE_PLATFORM_WIN32 && defined(OPENGLES)
+        , mPoster(NULL)
+#endif
+    {
+    }
+
+    ~MyScene()
+    {
+#if SGE_TARGET_PLATFORM != SGE_PLATFORM_WIN32 && defined(OPENGLES)
+        if (mPoster)
+        {
+            mPoster->stop();
+            delete mPoster;
+        }
+#endif
+        for (size_t i = 0; i < mIconImages.size(); ++i)
+        {
+            delete mIconImages[i];
+        }
+    }
+
+    /**
+     * Set the demo to run, the benchmarks draw the first half of the frames one way and the rest another way
+     */
+    void setMode(DemoMode mode)
+    {
+        mMode = mode;
+        switch (mode)
+        {
+        case DemoChart:
+            mBench.setNames("chart tessellation", "scalar", "simd");
+            break;
+        case DemoDamage:
+            getApplicaton()->setPartialRedraw(true);
+            break;
+        case DemoWidgets:
+            mBench.setNames("widgets", "paths", "instanced");
+            break;
+        case DemoPlot:
+            loadSamples();
+            mBench.setNames("plot", "path", "polyline");
+            break;
+        case DemoZoomText:
+            mBench.setNames("zoomed text", "bitmap glyphs", "distance field glyphs");
+            break;
+        case DemoAsyncGlyphs:
+            mBench.setNames("zoomed text", "glyphs rasterized when drawn", "on glyph raster threads", NULL, true);
+            break;
+        case DemoLayers:
+            mBench.setNames("animated panel", "direct", "layer");
+            break;
+        case DemoLabels:
+            mBench.setNames("labels", "laid out", "cached layouts");
+            break;
+        case DemoRasterGlyphs:
+            mBench.setNames("glyph rasterizers", "back-end", "accumulation", "glyph");
+            break;
+        case DemoTessThreads:
+            mBench.setNames("path tessellation", "1 thread", "4 threads");
+            break;
+        case DemoDisplayList:
+            mBench.setNames("panel chrome", "immediate", "display list");
+            break;
+        case DemoOnDemand:
+            // redraw when idle for the timeout, the loop sleeps in between
+            getApplicaton()->setRedrawMode(RedrawOnDemand);
+            getApplicaton()->setRedrawTimeout(10);
+#if SGE_TARGET_PLATFORM != SGE_PLATFORM_WIN32 && defined(OPENGLES)
+            mPoster = new EventPoster(getApplicaton()->getPlatform());
+            mPoster->start();
+#endif
+            break;
+        default:
+            break;
+        }
+    }
+
+    /**
+     * Whether the frame is in the second half of the max frames, drawn the second way of the benchmark
+     */
+    bool secondHalf() const
+    {
+        return mMaxFrames > 0 && mFrames > mMaxFrames / 2;
+    }
+
+    /**
+     * Add the time of a benchmark frame, the first frame warms up the caches and is skipped
+     */
+    void addTime(bool second, float elapsed, int count = 1)
+    {
+        if (mFrames > 1)
+        {
+            mBench.add(second, elapsed, count);
+        }
+    }
+
+    /**
+     * Stroke bezier curves, the first half of the frames uses the scalar
+     * tessellation path and the second half the SIMD kernels
+     */
+    void renderChart()
+    {
+        Renderer* r = getApplicaton()->getRenderer();
+        bool simd = secondHalf();
+        Renderer::setSimdEnabled(simd);
+
+        Timer timer;
+        r->setLineJoin(LineJoinRound);
+        r->setLineCap(LineCapRound);
+        for (int s = 0; s < 64; ++s)
+        {
+            float y0 = 40.0f + s * 8.0f;
+            r->beginPath();
+            r->moveTo(0, y0);
+            for (int i = 1; i <= 64; ++i)
+            {
+                float x = i * 12.5f;
+                float y = y0 + 30.0f * sinf(i * 0.35f + s + mFrames * 0.05f);
+                r->bezierTo(x - 8.0f, y0 - 20.0f, x - 4.0f, y + 20.0f, x, y);
+            }
+            r->setStrokeColor((s % 7) / 7.0f, (s % 5) / 5.0f, 1.0f, 0.8f);
+            r->setStrokeWidth(1.0f + (s % 4));
+            r->strokePath();
+        }
+        addTime(simd, timer.elapsed());
+    }
+
+    /**
+     * Fill and stroke a field of curved stars, tessellated on the drawing thread in the first
+     * half of the frames and on 4 tessellation threads in the second half
+     */
+    void renderStars()
+    {
+        Renderer* r = getApplicaton()->getRenderer();
+        bool parallel = secondHalf();
+        r->setTessellationThreads(parallel ? 4 : 1);
+
+        Timer timer;
+        for (int i = 0; i < 480; ++i)
+        {
+            float cx = 20.0f + (i % 20) * 40.0f;
+            float cy = 90.0f + (i / 20) * 20.0f;
+            float phase = i * 0.37f + mFrames * 0.05f;
+            r->beginPath();
+            r->moveTo(cx + 18.0f, cy);
+            for (int k = 1; k <= 12; ++k)
+            {
+                float a = k * 0.5236f;
+                float inner = 6.0f + 3.0f * sinf(phase + k);
+                r->quadTo(cx + inner * cosf(a - 0.2618f), cy + inner * sinf(a - 0.2618f),
+                    cx + 18.0f * cosf(a), cy + 18.0f * sinf(a));
+            }
+            r->closePath();
+            r->setFillColor((i % 7) / 7.0f, (i % 5) / 5.0f, 0.9f, 0.6f);
+            r->fillPath();
+            r->setStrokeColor(0.1f, 0.1f, 0.2f, 1.0f);
+            r->setStrokeWidth(1.5f);
+            r->strokePath();
+        }
+        // texts are drawn after the queued paths, the caption makes the flush of
+        // nvgEndFrame happen here, so the time covers the tessellation too
+        r->setFont("default");
+        r->setFontSize(14.0f);
+        r->setFillColor(0.1f, 0.1f, 0.2f, 1.0f);
+        r->drawText(10.0f, 70.0f, parallel ? "4 tessellation threads" : "1 tessellation thread", NULL);
+        addTime(parallel, timer.elapsed());
+    }
+
+    /**
+     * Draw the static chrome of a 360x260 panel, a window with a title bar, a toolbar
+     * of labelled buttons and a grid clipped by the scissor of the content area
+     */
+    void drawChrome()
+    {
+        Renderer* r = getApplicaton()->getRenderer();
+        r->beginPath();
+        r->roundedRect(0, 0, 360, 260, 8);
+        r->setFillPaint(r->createBoxGradient(0, 0, 360, 260, 8, 40,
+            float4(0.95f, 0.95f, 0.97f, 1.0f), float4(0.8f, 0.82f, 0.88f, 1.0f)));
+        r->fillPath();
+        r->setStrokeColor(0.3f, 0.3f, 0.4f, 1.0f);
+        r->setStrokeWidth(1.0f);
+        r->strokePath();
+
+        r->beginPath();
+        r->roundedRect(0, 0, 360, 30, 8, 8, 0, 0);
+        r->setFillPaint(r->createLinearGradient(0, 0, 0, 30,
+            float4(0.3f, 0.45f, 0.8f, 1.0f), float4(0.15f, 0.25f, 0.6f, 1.0f)));
+        r->fillPath();
+        for (int i = 0; i < 3; ++i)
+        {
+            r->beginPath();
+            r->circle(300.0f + i * 20.0f, 15.0f, 6.0f);
+            r->setFillColor(0.9f, 0.3f + i * 0.3f, 0.3f, 1.0f);
+            r->fillPath();
+        }
+        r->setFont("default");
+        r->setFontSize(16.0f);
+        r->setTextAlign(Alignment::MiddleLeft);
+        r->setFillColor(1.0f, 1.0f, 1.0f, 1.0f);
+        r->drawText(12.0f, 15.0f, "Display list panel", NULL);
+
+        r->setFontSize(12.0f);
+        r->setTextAlign(Alignment::MiddleCenter);
+        for (int i = 0; i < 8; ++i)
+        {
+            char text[16];
+            snprintf(text, sizeof(text), "Tool %d", i + 1);
+            r->beginPath();
+            r->roundedRect(10.0f + i * 43.0f, 40.0f, 38.0f, 26.0f, 4.0f);
+            r->setFillColor(0.85f, 0.87f, 0.92f, 1.0f);
+            r->fillPath();
+            r->setStrokeColor(0.5f, 0.5f, 0.6f, 1.0f);
+            r->strokePath();
+            r->setFillColor(0.1f, 0.1f, 0.2f, 1.0f);
+            r->drawText(29.0f + i * 43.0f, 53.0f, text, NULL);
+        }
+
+        int state = r->save();
+        r->addScissor(10, 76, 340, 174);
+        r->beginPath();
+        for (int i = 0; i <= 24; ++i)
+        {
+            r->moveTo(i * 16.0f, 60.0f);
+            r->lineTo(i * 16.0f, 270.0f);
+            r->moveTo(0, 60.0f + i * 10.0f);
+            r->lineTo(380.0f, 60.0f + i * 10.0f);
+        }
+        r->setStrokeColor(0.6f, 0.65f, 0.75f, 0.5f);
+        r->strokePath();
+        r->beginPath();
+        r->moveTo(0, 200.0f);
+        for (int i = 1; i <= 24; ++i)
+        {
+            r->bezierTo(i * 16.0f - 10.0f, 100.0f, i * 16.0f - 6.0f, 280.0f, i * 16.0f, 180.0f - (i % 5) * 20.0f);
+        }
+        r->setStrokeColor(0.9f, 0.4f, 0.1f, 1.0f);
+        r->setStrokeWidth(2.0f);
+        r->strokePath();
+        r->restore(state);
+    }
+
+    /**
+     * Slide, turn and zoom the panel chrome, drawn immediately in the first half of the frames
+     * and replayed from a display list recorded once in the rest, the list is tessellated again
+     * when the zoom changes beyond the scale tolerance
+     */
+    void renderChrome()
+    {
+        Renderer* r = getApplicaton()->getRenderer();
+        bool replay = secondHalf();
+        if (replay && mChromeList.isEmpty())
+        {
+            r->beginDisplayList(mChromeList);
+            drawChrome();
+            r->endDisplayList();
+        }
+
+        Timer timer;
+        int state = r->save();
+        r->doTranslate(220.0f + 160.0f * sinf(mFrames * 0.03f), 300.0f);
+        r->doRotate(0.15f * sinf(mFrames * 0.05f));
+        float scale = 1.0f + 0.3f * sinf(mFrames * 0.04f);
+        r->doScale(scale, scale);
+        r->doTranslate(-180.0f, -130.0f);
+        if (replay)
+        {
+            r->drawDisplayList(mChromeList);
+        }
+        else
+        {
+            drawChrome();
+        }
+        r->restore(state);
+        addTime(replay, timer.elapsed());
+    }
+
+    /**
+     * Draw a grid of widgets from primitives, the first half of the frames
+     * fills and strokes paths and the second half draws instances
+     */
+    void renderWidgets()
+    {
+        Renderer* r = getApplicaton()->getRenderer();
+        bool instanced = secondHalf();
+        r->setPrimitiveInstancing(instanced);
+
+        Timer timer;
+        const float4 border(0.2f, 0.2f, 0.25f, 1.0f);
+        const float4 shadow(0.0f, 0.0f, 0.0f, 0.4f);
+        for (int i = 0; i < 1500; ++i)
+        {
+            float x = (i % 50) * 16.0f;
+            float y = 100.0f + (i / 50) * 16.0f;
+            float4 color((i % 7) / 7.0f, (i % 5) / 5.0f, 0.8f, 1.0f);
+            r->drawShadow(x + 2, y + 3, 12, 12, 3, 4, shadow);
+            r->drawRoundedRect(x + 1, y + 1, 12, 12, 3, color, 1.0f, border);
+            r->drawCircle(x + 7, y + 7, 2.5f, float4(1, 1, 1, 1), 0, border);
+            r->drawLine(x + 3, y + 11, x + 11, y + 11, 1.0f, border);
+        }
+        addTime(instanced, timer.elapsed());
+    }
+
+    /**
+     * Generate the time series of 100000 samples for the plot
+     */
+    void loadSamples()
+    {
+        mSamples.clear();
+        srand(1);
+        float y = 0;
+        for (int i = 0; i < 100000; ++i)
+        {
+            y = y * 0.999f + (rand() % 2001 - 1000) * 0.003f;
+            mSamples.push_back(float2((float)i, y + 60.0f * sinf(i * 0.0005f)));
+        }
+        mPolyline.setPoints(&mSamples[0], mSamples.size());
+    }
+
+    /**
+     * Plot the time series zooming and panning, the first half of the frames
+     * strokes a path of lines and the second half a polyline
+     */
+    void renderPlot()
+    {
+        Renderer* r = getApplicaton()->getRenderer();
+        bool polyline = secondHalf();
+        int n = (int)mSamples.size();
+        // Zoom 1x to 8x, panning at each zoom
+        float zoom = (float)(1 << (mFrames / 8 % 4));
+        float scale = 800.0f * zoom / n;
+        float x0 = (n - 800.0f / scale) * (mFrames % 8) / 8.0f;
+
+        Timer timer;
+        int state = r->save();
+        r->addScissor(0, 100, 800, 400);
+        r->doTranslate(0, 300);
+        r->doScale(scale, 1.0f);
+        r->doTranslate(-x0, 0);
+        r->setStrokeColor(0.1f, 0.3f, 0.9f, 1.0f);
+        r->setStrokeWidth(2.0f);
+        if (polyline)
+        {
+            r->drawPolyline(mPolyline);
+        }
+        else
+        {
+            r->beginPath();
+            r->moveTo(mSamples[0].x, mSamples[0].y);
+            for (int i = 1; i < n; ++i)
+            {
+                r->lineTo(mSamples[i].x, mSamples[i].y);
+            }
+            r->strokePath();
+        }
+        r->restore(state);
+        addTime(polyline, timer.elapsed());
+    }
+
+    /**
+     * Zoom lines of text, with zoomtext to a new size every frame, the first half of the frames
+     * draws bitmap glyphs and the second half distance field glyphs. With asyncglyphs to a new size
+     * every 20 frames with bitmap glyphs, rasterized when drawn in the first half of the frames and
+     * on glyph raster threads in the second half
+     */
+    void renderZoomText()
+    {
+        Renderer* r = getApplicaton()->getRenderer();
+        bool second = secondHalf();
+        bool async = mMode == DemoAsyncGlyphs;
+        if (async)
+        {
+            r->setGlyphRasterThreads(second ? 2 : 0);
+        }
+
+        Timer timer;
+        int state = r->save();
+        r->setTextSDF(second && !async);
+        r->setFont("default");
+        r->setFillColor(0.1f, 0.1f, 0.2f, 1.0f);
+        float size = 12.0f + 48.0f * (0.5f - 0.5f * cosf(mFrames * 0.07f));
+        if (async)
+        {
+            size = 12.0f + 2.0f * (mFrames / 20 % 15) + (second ? 1.0f : 0.0f);
+        }
+        for (int i = 0; i < 4; ++i)
+        {
+            r->setFontSize(size * (1.0f + i * 0.25f));
+            r->drawText(10.0f, 100.0f + i * 90.0f, "The quick brown fox jumps over the lazy dog 0123456789", NULL);
+        }
+        r->restore(state);
+        addTime(second, timer.elapsed());
+        mPlaceholders += r->getGlyphPlaceholderCount();
+    }
+
+    /**
+     * Rasterize all the glyphs of the font at a new size every frame, alternately with
+     * the font back-end and with the accumulation rasterizer
+     */
+    void rasterGlyphs()
+    {
+        Renderer* r = getApplicaton()->getRenderer();
+        bool accumulate = mFrames % 2 == 1;
+        const unsigned int ranges[] = { 0x20, 0xffff };
+
+        int state = r->save();
+        r->setGlyphRasterizer(accumulate ? GlyphRasterAccumulate : GlyphRasterBackend);
+        r->setFont("default");
+        r->setFontSize(12.0f + mFrames);
+        Timer timer;
+        int count = r->prewarmGlyphs(ranges, 1);
+        addTime(accumulate, timer.elapsed(), count);
+        r->setGlyphRasterizer(GlyphRasterAccumulate);
+        r->restore(state);
+    }
+
+    /**
+     * Load a toolbar of small icons packed in the image atlas
+     */
+    void loadIcons()
+    {
+        Renderer* r = getApplicaton()->getRenderer();
+        r->setImageAtlas(64);
+
+        byte pixels[24 * 24 * 4];
+        for (int i = 0; i < 128; ++i)
+        {
+            for (int y = 0; y < 24; ++y)
+            {
+                for (int x = 0; x < 24; ++x)
+                {
+                    byte* p = &pixels[(y * 24 + x) * 4];
+                    bool inside = (x - 12) * (x - 12) + (y - 12) * (y - 12) < 100 + i % 20;
+                    p[0] = (byte)(i * 37);
+                    p[1] = (byte)(i * 91 + x * 4);
+                    p[2] = (byte)(i * 13 + y * 4);
+                    p[3] = inside ? 255 : 0;
+                }
+            }
+            mIconImages.push_back(new RendererImage(r->loadImage(pixels, 24, 24, 0)));
+        }
+
+        int pages = 0, images = 0;
+        r->getImageAtlasStats(&pages, &images);
+        Log::info("%d icons packed in %d atlas pages", images, pages);
+    }
+
+    void renderIcons()
+    {
+        Renderer* r = getApplicaton()->getRenderer();
+        for (size_t i = 0; i < mIconImages.size(); ++i)
+        {
+            float x = 8.0f + (i % 28) * 28.0f;
+            float y = 520.0f + (i / 28) * 28.0f;
+            r->beginPath();
+            r->rect(x, y, 24, 24);
+            r->setFillPaint(r->createImagePattern(x, y, 24, 24, 0, *mIconImages[i], 1.0f));
+            r->fillPath();
+        }
+    }
+
+    /**
+     * Blink one label every frame with the partial redraw,
+     * only the damage region of it is redrawn
+     */
+    void blinkLabel()
+    {
+        const int4& rect = getDamageRect();
+        mDamageArea += (float)rect.z * rect.w / ((float)getSize().x * getSize().y);
+        mBlinkLabel->setFontColor(float4(1.0f, (mFrames % 2) ? 1.0f : 0.5f, 0.5f, 1.0f));
+    }
+
+    /**
+     * Load a panel of labels, slid and faded, drawn directly in the first half
+     * of the frames and from the layer in the rest
+     */
+    void loadPanel(ui::ViewGroup* group)
+    {
+        mPanel = new ui::ViewGroup(getApplicaton());
+        mPanel->setLayoutParams(RefPtr<ui::LayoutParams>(new ui::LayoutParams(480, 336)));
+        // a dense table of wrapped labels, costly to draw directly every frame
+        for (int i = 0; i < 48; ++i)
+        {
+            char text[128];
+            snprintf(text, sizeof(text), "Panel item %d, the text wraps in its column"
+                " and is laid out only when the layer is drawn", i);
+            ui::Label* label = new ui::Label(getApplicaton());
+            label->setLayoutParams(RefPtr<ui::LayoutParams>(new ui::LayoutParams(120, 28)));
+            label->setText(text);
+            label->setFontSize(11);
+            label->setMuiltLine(true);
+            label->setTranslation((i % 4) * 120.0f, (i / 4) * 28.0f);
+            mPanel->addChild(RefPtr<ui::View>(label));
+        }
+        group->addChild(RefPtr<ui::View>(mPanel));
+    }
+
+    void animatePanel()
+    {
+        int half = mMaxFrames / 2;
+        int frame = mFrames < half ? mFrames : mFrames - half;
+        if (mFrames == half)
+        {
+            mPanel->setLayerEnabled(true);
+        }
+        mPanel->setTranslation((float)(frame % 160) * 2.0f, 200.0f);
+        mPanel->setAlpha(0.5f + 0.5f * cosf(frame * 0.05f));
+    }
+
+    /**
+     * Load a screen of labels, measured and drawn every frame, the first half of the frames
+     * lays out the text again and the second half uses the text layout cache
+     */
+    void loadLabels(ui::ViewGroup* group)
+    {
+        for (int i = 0; i < 240; ++i)
+        {
+            char text[128];
+            bool multiLine = i % 3 == 0;
+            snprintf(text, sizeof(text), multiLine ? "Item %d, a longer description that wraps" : "Item %d, %d.%d ms",
+                i, i * 7 % 100, i % 10);
+            ui::Label* label = new ui::Label(getApplicaton());
+            label->setLayoutParams(RefPtr<ui::LayoutParams>(new ui::LayoutParams(multiLine ? 96 : WRAP_CONTENT, WRAP_CONTENT)));
+            label->setText(text);
+            label->setFontSize(12);
+            label->setMuiltLine(multiLine);
+            label->setAlignment(Alignment::MiddleCenter);
+            label->setTranslation((i % 8) * 100.0f, 100.0f + (i / 8) * 16.0f);
+            group->addChild(RefPtr<ui::View>(label));
+        }
+    }
 
     virtual void onLoad() override
     {
         Scene::onLoad();
+        if (mMode == DemoIcons)
+        {
+            loadIcons();
+        }
 
         ui::ViewGroup* group = new ui::ViewGroup(getApplicaton());
         setRootView(RefPtr<ui::View>(group));
@@ -53,6 +772,139 @@ public:
         label2->setAlignment(Alignment::BottomLeft);
         label2->setText("%ABCDEFGHIJKLMNOPQRSTUVWXYZ#$&*?");
         group->addChild(RefPtr<ui::View>(label2));
+        mBlinkLabel = label2;
+
+        if (mMode == DemoLayers)
+        {
+            loadPanel(group);
+        }
+        if (mMode == DemoLabels)
+        {
+            loadLabels(group);
+        }
+    }
+
+    virtual void onRenderUI() override
+    {
+        if (mMode == DemoLabels)
+        {
+            getApplicaton()->getRenderer()->setTextLayoutCache(secondHalf());
+        }
+        Timer timer;
+        Scene::onRenderUI();
+        if (mMode == DemoLabels)
+        {
+            addTime(secondHalf(), timer.elapsed());
+        }
+        switch (mMode)
+        {
+        case DemoChart:
+            renderChart();
+            break;
+        case DemoTessThreads:
+            renderStars();
+            break;
+        case DemoDisplayList:
+            renderChrome();
+            break;
+        case DemoIcons:
+            renderIcons();
+            break;
+        case DemoWidgets:
+            renderWidgets();
+            break;
+        case DemoPlot:
+            renderPlot();
+            break;
+        case DemoZoomText:
+        case DemoAsyncGlyphs:
+            renderZoomText();
+            break;
+        case DemoRasterGlyphs:
+            rasterGlyphs();
+            break;
+        case DemoDamage:
+            blinkLabel();
+            break;
+        case DemoLayers:
+            animatePanel();
+            break;
+        default:
+            break;
+        }
+
+        // quit after max frames for headless benchmark
+        if (mFrames++ == 0)
+        {
+            mTimer.elapsed();
+            mClock = clock();
+        }
+        else
+        {
+            float elapsed = mTimer.elapsed();
+            mElapsed += elapsed;
+            if (mMode == DemoLayers)
+            {
+                mBench.add(secondHalf(), elapsed);
+            }
+        }
+        if (mMaxFrames > 0 && mFrames == mMaxFrames)
+        {
+            logStats();
+            getApplicaton()->quit();
+        }
+    }
+
+    void logStats()
+    {
+        Renderer* r = getApplicaton()->getRenderer();
+        Log::info("%d frames rendered, %.3f ms per frame", mFrames,
+            mFrames > 1 ? mElapsed * 1000.0f / (mFrames - 1) : 0.0f);
+        int calls = 0, merged = 0;
+        r->getDrawCallStats(&calls, &merged);
+        Log::info("%d draw calls, %d after merging, %d culled", calls, merged, r->getCulledCount());
+        int used = 0, peak = 0, growths = 0;
+        r->getMemoryStats(&used, &peak, &growths);
+        Log::info("frame arenas, %d KB used, %d KB peak, %d growths", used / 1024, peak / 1024, growths);
+        int pages = 0, hits = 0, misses = 0, evictions = 0;
+        r->getGlyphCacheStats(&pages, &hits, &misses, &evictions);
+        Log::info("glyph cache, %d pages, %.1f percent hits, %d evictions", pages,
+            hits + misses > 0 ? hits * 100.0f / (hits + misses) : 0.0f, evictions);
+        int fonts = 0, fontKB = 0;
+        Renderer::getMappedFontStats(&fonts, &fontKB);
+        Log::info("font files, %d mapped, %d KB shared by the renderers", fonts, fontKB);
+        int layouts = 0;
+        r->getTextLayoutStats(&layouts, &hits, &misses);
+        Log::info("text layout cache, %d strings, %.1f percent hits", layouts,
+            hits + misses > 0 ? hits * 100.0f / (hits + misses) : 0.0f);
+
+        mBench.report();
+        if (mMode == DemoPlot)
+        {
+            Log::info("plot, %d points stroked", mPolyline.getStrokedCount());
+        }
+        if (mMode == DemoAsyncGlyphs)
+        {
+            Log::info("zoomed text, %d glyph raster threads, %d placeholders", r->getGlyphRasterThreads(), mPlaceholders);
+        }
+        if (mMode == DemoDamage)
+        {
+            Log::info("partial redraw, %.1f percent of the scene redrawn per frame", mDamageArea * 100.0f / mFrames);
+        }
+        if (mMode == DemoDisplayList)
+        {
+            Log::info("panel chrome, display list replayed %d frames with %d tessellations",
+                mMaxFrames - mMaxFrames / 2, mChromeList.getTessellationCount());
+        }
+        if (mMode == DemoOnDemand)
+        {
+            int posted = 0;
+#if SGE_TARGET_PLATFORM != SGE_PLATFORM_WIN32 && defined(OPENGLES)
+            posted = mPoster->getPostedCount();
+#endif
+            Log::info("on demand, %.0f ms elapsed, %.0f ms of CPU time, %d events posted", mElapsed * 1000.0f,
+                (clock() - mClock) * 1000.0f / CLOCKS_PER_SEC, posted);
+        }
     }
 
     virtual void OnRenderModel() 
@@ -64,15 +916,70 @@ public:
     }
 };
 
-int main()
+/**
+ * The demo of each command line mode
+ */
+static const struct
+{
+    const char* name;
+    DemoMode    mode;
+} sModes[] =
+{
+    // "App 600 chart" benchmarks the SIMD tessellation kernels against the scalar path
+    { "chart", DemoChart },
+    // "App 600 icons" draws a toolbar of icons packed in the image atlas
+    { "icons", DemoIcons },
+    // "App 600 damage" blinks a label, redrawing only the damage region of it
+    { "damage", DemoDamage },
+    // "App 600 widgets" draws widgets from primitives as paths, then as instances
+    { "widgets", DemoWidgets },
+    // "App 60 plot" plots a time series as a path, then as a decimated polyline
+    { "plot", DemoPlot },
+    // "App 600 zoomtext" zooms text drawn from bitmap glyphs, then from distance fields
+    { "zoomtext", DemoZoomText },
+    // "App 600 asyncglyphs" zooms text rasterizing the glyphs when drawn, then on threads
+    { "asyncglyphs", DemoAsyncGlyphs },
+    // "App 600 layers" slides and fades a panel cached in an offscreen layer
+    { "layers", DemoLayers },
+    // "App 600 labels" lays out a screen of labels every frame, then uses the layout cache
+    { "labels", DemoLabels },
+    // "App 16 rasterglyphs" rasterizes the glyphs of the font with stb_truetype and by accumulation
+    { "rasterglyphs", DemoRasterGlyphs },
+    // "App 60 tessthreads" tessellates a field of stars on the drawing thread, then on 4 threads
+    { "tessthreads", DemoTessThreads },
+    // "App 600 displaylist" draws a zooming panel chrome immediately, then replays it from a display list
+    { "displaylist", DemoDisplayList },
+    // "App 100 ondemand" redraws when idle for the timeout of the on demand mode, events posted meanwhile
+    { "ondemand", DemoOnDemand },
+};
+
+int main(int argc, char** argv)
 {
 #ifdef _DEBUG
     _CrtSetDbgFlag(_CrtSetDbgFlag(_CRTDBG_REPORT_FLAG) | _CRTDBG_LEAK_CHECK_DF);
 #endif // _DEBUG
     
     Application app;
-    MyScene scene(&app);
+    // the max frames to render, 0 is unlimited
+    MyScene scene(&app, argc > 1 ? atoi(argv[1]) : 0);
+    // "App 600 thread" draws on the render thread
+    if (argc > 2 && strcmp(argv[2], "thread") == 0)
+    {
+        app.setRenderThreadEnabled(true);
+    }
+    for (size_t i = 0; argc > 2 && i < sizeof(sModes) / sizeof(sModes[0]); ++i)
+    {
+        if (strcmp(argv[2], sModes[i].name) == 0)
+        {
+            scene.setMode(sModes[i].mode);
+        }
+    }
     app.loadScene(&scene);
     app.run();
+#ifdef SGE_PROFILER
+    Profiler::logStats();
+    GPUProfiler::logStats();
+    Profiler::exportChromeTrace("trace.json");
+#endif
     return 0;
-}
\ No newline at end of file
+}
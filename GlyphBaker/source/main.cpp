@@ -0,0 +1,54 @@
+#include <core/sgeLog.h>
+#include <core/sgeApplication.h>
+#include <core/sgeRenderer.h>
+#include <core/sgeTimer.h>
+#include <stdlib.h>
+
+using namespace sge;
+
+// Basic Latin, Latin-1 Supplement and Latin Extended-A
+static const unsigned int sRanges[] = { 0x20, 0x7e, 0xa0, 0x17f };
+
+// Text sizes baked when none are given
+static const float sSizes[] = { 12.0f, 14.0f, 16.0f, 18.0f, 20.0f, 24.0f, 32.0f };
+
+/**
+ * Rasterize the glyphs of the default font at some text sizes and save the atlas to a glyph cache file,
+ * Application loads fonts/glyphs.cache at startup. Run from the directory of the fonts, the glyphs of a
+ * glyph cache loaded at startup are saved too.
+ * usage: GlyphBaker [file] [size...]
+ */
+int main(int argc, char** argv)
+{
+    const char* file = argc > 1 ? argv[1] : "fonts/glyphs.cache";
+
+    Application app;
+    Renderer* r = app.getRenderer();
+
+    Timer timer;
+    int count = 0;
+    r->setFont("default");
+    int sizes = argc > 2 ? argc - 2 : (int)(sizeof(sSizes) / sizeof(sSizes[0]));
+    for (int i = 0; i < sizes; ++i)
+    {
+        r->setFontSize(argc > 2 ? (float)atof(argv[i + 2]) : sSizes[i]);
+        count += r->prewarmGlyphs(sRanges, 2);
+    }
+    float elapsed = timer.elapsed();
+
+    int pages = 0, hits = 0, misses = 0, evictions = 0;
+    r->getGlyphCacheStats(&pages, &hits, &misses, &evictions);
+    if (evictions > 0)
+    {
+        Log::error("The font atlas is full, %d glyphs evicted, bake fewer sizes", evictions);
+    }
+
+    int saved = r->saveGlyphCache(file);
+    if (saved < 0)
+    {
+        return 1;
+    }
+    Log::info("%d glyphs rasterized in %.1f ms, %d glyphs on %d pages saved to %s",
+        count, elapsed * 1000.0f, saved, pages, file);
+    return 0;
+}
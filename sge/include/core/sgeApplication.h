@@ -54,6 +54,17 @@ namespace sge
     
     class ApplicationPrivate;
 
+    /**
+     * Enum of redraw mode
+     */
+    typedef enum RedrawMode
+    {
+        // Render every frame while no native events
+        RedrawContinuous    = 0,
+        // Render only if current scene invalidated, block for native events when idle
+        RedrawOnDemand      = 1,
+    } RedrawMode;
+
     /**
      * Class Application, to drive the application system
      */
@@ -97,6 +108,55 @@ namespace sge
         void loadScene(Scene* scene);
 
 
+        /**
+         * Set the redraw mode, the default is RedrawContinuous
+         * @note RedrawOnDemand will enable VSYNC, RedrawContinuous disable it
+         */
+        void setRedrawMode(RedrawMode mode);
+
+        /**
+         * Get the redraw mode
+         */
+        RedrawMode getRedrawMode();
+
+        /**
+         * Set the max idle time for RedrawOnDemand, based on milliseconds
+         * The scene will be redrawn after timeout, to drive timed animations
+         * @param ms The timeout, 0xFFFFFFFF to wait native events only (default)
+         */
+        void setRedrawTimeout(unsigned long ms);
+
+        /**
+         * Enable or disable the render thread, the default is disable.
+         * While enabled, the render thread owns the GL context, it draws the frame
+         * recorded by current thread and swaps buffers, so GL submission of
+         * a frame is overlapped with the measure/layout/draw of next frame.
+         * @note Scene::onRenderModel is called on the render thread, and GL
+         * can not be used on current thread except by Renderer
+         */
+        void setRenderThreadEnabled(bool enable);
+
+        /**
+         * Check the render thread is enabled
+         */
+        bool isRenderThreadEnabled();
+
+        /**
+         * Enable or disable the partial redraw, the default is disable.
+         * While enabled, the frame redraws only the damage region united by
+         * the invalidated views, the pixels outside of it are kept from the last
+         * frame in the back buffer (EGL_BUFFER_PRESERVED, or EGL_EXT_buffer_age
+         * without render thread), the whole scene is redrawn if none is supported.
+         * @note The ui drawn outside of views and the models should invalidate
+         * the scene or the rects they changed
+         */
+        void setPartialRedraw(bool enable);
+
+        /**
+         * Check the partial redraw is enabled
+         */
+        bool isPartialRedraw();
+
         /**
          * Run the application util quit
          */
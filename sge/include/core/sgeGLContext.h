@@ -75,6 +75,17 @@ namespace sge
          */
         bool initialize(WindowHandle hWnd, DisplayHandle hDC, int format = 0);
 
+#ifdef OPENGLES
+        /**
+         * Init OpenGLES context without native window,
+         * render to a pbuffer surface on a surfaceless display if supported
+         * @param width The surface width
+         * @param height The surface height
+         * @return true if init success
+         */
+        bool initializeOffscreen(int width, int height);
+#endif
+
         /**
          * Get the pixel format by msaa
          */
@@ -100,11 +111,40 @@ namespace sge
          */
         void makeCurrent();
 
+        /**
+         * Release this context from current thread, so another thread can make it current
+         */
+        void doneCurrent();
+
         /**
          * Swap the back buffer and front buffer
          */
         void swapBuffer();
 
+        /**
+         * Swap the back buffer and front buffer, hint the changed rect to the compositor
+         * with EGL_KHR_swap_buffers_with_damage if supported
+         * @param x The left of the damaged rect, in window coordinates
+         * @param y The top of the damaged rect, in window coordinates
+         * @param width The damaged width
+         * @param height The damaged height
+         */
+        void swapBuffer(int x, int y, int width, int height);
+
+        /**
+         * Request the back buffer keeps its content after swap (EGL_BUFFER_PRESERVED)
+         * @param enable Preserve the content or not
+         * @return true if the back buffer is preserved after this call
+         */
+        bool setPreserveBuffer(bool enable);
+
+        /**
+         * Get the age of the back buffer content, in frames
+         * @return 1 if it has the last frame (preserved), N if it has the frame
+         * swapped N frames ago (EGL_EXT_buffer_age), 0 if the content is undefined
+         */
+        int getBufferAge();
+
         /**
          * Enable or disable vertical synchronization
          * @param enable, the default is enable, limit 60 fps in most
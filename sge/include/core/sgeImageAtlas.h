@@ -0,0 +1,135 @@
+/**
+ *
+ * Simple graphic engine
+ * "sge" libraiy is a simple graphics engine, named sge.
+ *
+ * sgeImageAtlas.h
+ * date: 2026/10/18
+ * author: xiang
+ *
+ * License
+ *
+ * Copyright (c) 2017-2019, Xiang Wencheng <xiangwencheng@outlook.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * - Neither the names of its contributors may be used to endorse or
+ *   promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SGE_IMAGE_ATLAS_H
+#define SGE_IMAGE_ATLAS_H
+
+#include <core/sgePlatform.h>
+#include <core/sgeMath.h>
+
+namespace sge
+{
+    class ImageAtlasPrivate;
+
+    /**
+     * Packs small rgba images into shared atlas pages with skyline packing,
+     * so the images of a page are drawn without texture switches.
+     * Each image is padded by one pixel of its edge to keep linear filtering inside
+     */
+    class SGE_API ImageAtlas
+    {
+    public:
+        /**
+         * The location of an image in the atlas
+         */
+        struct Region
+        {
+            int page;       // The renderer image of the page
+            int pageSize;   // The width and height of the page
+            int x, y;       // The top left corner of the image in the page
+            int w, h;       // The size of the image
+        };
+
+        /**
+         * Constructor
+         * @param nativeCtx The nanovg context of the renderer creating the pages
+         * @param pageSize The width and height of the pages
+         */
+        ImageAtlas(void* nativeCtx, int pageSize);
+
+        /**
+         * Destructor, deletes the pages
+         */
+        ~ImageAtlas();
+
+        /**
+         * Get the width and height of the pages
+         */
+        int getPageSize() const;
+
+        /**
+         * Check if the image can be packed, the repeat and mipmap flags need a texture of their own
+         */
+        bool canAdd(int w, int h, int imageFlags) const;
+
+        /**
+         * Pack an image, a new page is created if it does not fit the pages of the same filtering
+         * @param rgbaData The rgba data of the image
+         * @param w The width of image
+         * @param h The height of image
+         * @param imageFlags The image flags, seealso enum ImageFlag
+         * @return The entry of the image, -1 if it can not be packed
+         */
+        int add(const byte* rgbaData, int w, int h, int imageFlags);
+
+        /**
+         * Free an entry, the space is reclaimed by defragment
+         */
+        void remove(int entry);
+
+        /**
+         * Get the location of an entry
+         * @return false if the entry is not valid
+         */
+        bool getRegion(int entry, Region* region) const;
+
+        /**
+         * Repack the pages which wasted at least the given ratio of a page by freed
+         * images, and delete the empty pages. Must be called outside of a frame,
+         * the regions of the moved images change
+         * @param wasteRatio The wasted area of the pages over the area of a page
+         * @return The number of images moved
+         */
+        int defragment(float wasteRatio = 0.25f);
+
+        /**
+         * Get the number of pages and images
+         */
+        void getStats(int* pages, int* images) const;
+
+    private:
+        ImageAtlasPrivate* d;
+        DISABLE_COPY(ImageAtlas)
+    };
+}
+
+#endif // !SGE_IMAGE_ATLAS_H
@@ -0,0 +1,105 @@
+/**
+ *
+ * Simple graphic engine
+ * "sge" libraiy is a simple graphics engine, named sge.
+ *
+ * sgeMappedFile.h
+ * date: 2026/10/18
+ * author: xiang
+ *
+ * License
+ *
+ * Copyright (c) 2017-2019, Xiang Wencheng <xiangwencheng@outlook.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * - Neither the names of its contributors may be used to endorse or
+ *   promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SGE_MAPPED_FILE_H
+#define SGE_MAPPED_FILE_H
+
+#include <core/sgePlatform.h>
+
+namespace sge
+{
+    class MappedFilePrivate;
+
+    /**
+     * Class MappedFile
+     * Map a file read-only into memory, the pages are read when first accessed
+     * and shared with the other mappings of the file
+     */
+    class SGE_API MappedFile
+    {
+    public:
+
+        /**
+         * Constructor, nothing mapped
+         */
+        MappedFile();
+
+        /**
+         * Destructor, unmap the file
+         */
+        ~MappedFile();
+
+        /**
+         * Map a file, the previous file is unmapped
+         * @param fileName The file to map
+         * @return true if mapped, false if the file can not be opened or is empty
+         */
+        bool open(const char* fileName);
+
+        /**
+         * Unmap the file
+         */
+        void close();
+
+        /**
+         * Check if a file is mapped
+         */
+        bool isOpen() const;
+
+        /**
+         * Get the mapped bytes, NULL if not mapped. They are read-only, writing them crashes
+         */
+        const unsigned char* getData() const;
+
+        /**
+         * Get the size of the mapped file in bytes
+         */
+        size_t getSize() const;
+
+    protected:
+        MappedFilePrivate* d;
+        DISABLE_COPY(MappedFile)
+    };
+
+}
+
+#endif //! SGE_MAPPED_FILE_H
@@ -171,6 +171,13 @@ namespace sge
          */
         virtual bool processEvents() = 0;
 
+        /**
+         * Block current thread until any native event arrived
+         * @param ms The max time to wait, based on milliseconds
+         * @return false if timeout
+         */
+        virtual bool waitEvents(unsigned long ms = 0xFFFFFFFF) = 0;
+
         /**
          * Send close message to native
          */
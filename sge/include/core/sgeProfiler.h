@@ -0,0 +1,274 @@
+/**
+ *
+ * Simple graphic engine
+ * "sge" libraiy is a simple graphics engine, named sge.
+ *
+ * sgeProfiler.h
+ * date: 2026/10/17
+ * author: xiang
+ *
+ * License
+ *
+ * Copyright (c) 2017-2019, Xiang Wencheng <xiangwencheng@outlook.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * - Neither the names of its contributors may be used to endorse or
+ *   promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SGE_PROFILER_H
+#define SGE_PROFILER_H
+
+/**
+ * CPU frame profiler, compiled in only if SGE_PROFILER defined (cmake USE_PROFILER)
+ * Use the macros, they are empty while the profiler is not compiled:
+ *      SGE_PROFILE_ZONE("name")    scoped zone, c++ only
+ *      SGE_PROFILE_BEGIN("name")   begin a zone, the name must be a static string
+ *      SGE_PROFILE_END()           end the last zone on current thread
+ *      SGE_PROFILE_FRAME_BEGIN()   begin a frame on main thread
+ *      SGE_PROFILE_FRAME_END()     end a frame and aggregate its statistics
+ * The gpu zones are measured by timer queries (see GPUProfiler in sgeGLX.h),
+ * must be used on the thread with current gl context:
+ *      SGE_GPU_PROFILE_ZONE("name")    scoped gpu zone, c++ only
+ *      SGE_GPU_PROFILE_BEGIN("name")   begin a gpu zone
+ *      SGE_GPU_PROFILE_END()           end the last gpu zone
+ *      SGE_GPU_PROFILE_FRAME_BEGIN()   begin a gpu frame
+ *      SGE_GPU_PROFILE_FRAME_END()     end a gpu frame
+ */
+
+#ifdef __cplusplus
+
+#include <core/sgePlatform.h>
+
+namespace sge
+{
+
+    /**
+     * The aggregate statistics of a named zone
+     */
+    typedef struct ProfileStat
+    {
+        String  name;
+        // call count per frame
+        float   calls;
+        // total time per frame, include children zones
+        float   totalMs;
+        // self time per frame, exclude children zones
+        float   selfMs;
+        // the max time of one call
+        float   maxMs;
+    } ProfileStat;
+
+    /**
+     * Class Profiler, records zones into per-thread ring buffers
+     */
+    class SGE_API Profiler
+    {
+    public:
+        /**
+         * Enable or disable recording at runtime, the default is enable
+         */
+        static void setEnabled(bool enable);
+
+        /**
+         * Check recording is enabled
+         */
+        static bool isEnabled();
+
+        /**
+         * Begin a zone on current thread
+         * @param name The zone name, must be a static string
+         */
+        static void begin(const char* name);
+
+        /**
+         * End the last zone on current thread
+         */
+        static void end();
+
+        /**
+         * Record a finished zone on a named track instead of current thread,
+         * used for zones timed by others such as gpu timer queries.
+         * The zones on tracks are exported but not aggregated into frame statistics
+         * @param track The track name, must be a static string
+         * @param name The zone name, must be a static string
+         * @param begin The begin time based on Profiler::now
+         * @param end The end time based on Profiler::now
+         */
+        static void record(const char* track, const char* name, long long begin, long long end);
+
+        /**
+         * Begin a frame, all zones in the frame time will be aggregated
+         */
+        static void beginFrame();
+
+        /**
+         * End current frame and aggregate its statistics
+         */
+        static void endFrame();
+
+        /**
+         * Get the count of profiled frames
+         */
+        static int getFrameCount();
+
+        /**
+         * Get the statistics of last frame
+         */
+        static void getLastFrameStats(Vector<ProfileStat>& stats);
+
+        /**
+         * Get the average statistics of all profiled frames
+         */
+        static void getAverageFrameStats(Vector<ProfileStat>& stats);
+
+        /**
+         * Log the average statistics of all profiled frames
+         */
+        static void logStats();
+
+        /**
+         * Export recorded zones of all threads with chrome trace json format,
+         * can be opened by chrome://tracing or ui.perfetto.dev
+         * @return false if write file failed
+         */
+        static bool exportChromeTrace(const char* file);
+
+        /**
+         * Clear all recorded zones and statistics
+         */
+        static void reset();
+
+        /**
+         * Get current profiler time based on nanoseconds
+         */
+        static long long now();
+
+    private:
+        Profiler() = delete;
+    };
+
+} // !namespace
+
+#endif // __cplusplus
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+    /**
+     * Begin a zone on current thread
+     * @param name The zone name, must be a static string
+     */
+    void ProfilerBegin(const char* name);
+
+    /**
+     * End the last zone on current thread
+     */
+    void ProfilerEnd();
+
+    /**
+     * Begin a gpu zone, see GPUProfiler::begin
+     */
+    void GPUProfilerBegin(const char* name);
+
+    /**
+     * End the last gpu zone, see GPUProfiler::end
+     */
+    void GPUProfilerEnd();
+
+    /**
+     * Begin a gpu frame, see GPUProfiler::beginFrame
+     */
+    void GPUProfilerBeginFrame();
+
+    /**
+     * End a gpu frame, see GPUProfiler::endFrame
+     */
+    void GPUProfilerEndFrame();
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#ifdef __cplusplus
+namespace sge
+{
+    /**
+     * Class ProfileZone, a scoped zone
+     */
+    class ProfileZone
+    {
+    public:
+        ProfileZone(const char* name) { Profiler::begin(name); }
+        ~ProfileZone() { Profiler::end(); }
+    private:
+        DISABLE_COPY(ProfileZone)
+    };
+
+    /**
+     * Class GPUProfileZone, a scoped gpu zone
+     */
+    class GPUProfileZone
+    {
+    public:
+        GPUProfileZone(const char* name) { GPUProfilerBegin(name); }
+        ~GPUProfileZone() { GPUProfilerEnd(); }
+    private:
+        DISABLE_COPY(GPUProfileZone)
+    };
+
+} // !namespace
+#endif // __cplusplus
+
+#ifdef SGE_PROFILER
+#define SGE_PROFILE_CONCAT_(a, b)   a##b
+#define SGE_PROFILE_CONCAT(a, b)    SGE_PROFILE_CONCAT_(a, b)
+#define SGE_PROFILE_ZONE(name)      sge::ProfileZone SGE_PROFILE_CONCAT(__profileZone, __LINE__)(name)
+#define SGE_PROFILE_BEGIN(name)     ProfilerBegin(name)
+#define SGE_PROFILE_END()           ProfilerEnd()
+#define SGE_PROFILE_FRAME_BEGIN()   sge::Profiler::beginFrame()
+#define SGE_PROFILE_FRAME_END()     sge::Profiler::endFrame()
+#define SGE_GPU_PROFILE_ZONE(name)      sge::GPUProfileZone SGE_PROFILE_CONCAT(__gpuProfileZone, __LINE__)(name)
+#define SGE_GPU_PROFILE_BEGIN(name)     GPUProfilerBegin(name)
+#define SGE_GPU_PROFILE_END()           GPUProfilerEnd()
+#define SGE_GPU_PROFILE_FRAME_BEGIN()   GPUProfilerBeginFrame()
+#define SGE_GPU_PROFILE_FRAME_END()     GPUProfilerEndFrame()
+#else
+#define SGE_PROFILE_ZONE(name)
+#define SGE_PROFILE_BEGIN(name)
+#define SGE_PROFILE_END()
+#define SGE_PROFILE_FRAME_BEGIN()
+#define SGE_PROFILE_FRAME_END()
+#define SGE_GPU_PROFILE_ZONE(name)
+#define SGE_GPU_PROFILE_BEGIN(name)
+#define SGE_GPU_PROFILE_END()
+#define SGE_GPU_PROFILE_FRAME_BEGIN()
+#define SGE_GPU_PROFILE_FRAME_END()
+#endif
+
+#endif // !SGE_PROFILER_H
@@ -69,6 +69,33 @@ namespace sge
     } LineJoinType;
     
 
+    /**
+     * Enum of vertex upload modes of the renderer
+     */
+    typedef enum BufferStreamMode {
+        BufferStreamNone        = 0, // Upload with glBufferData every frame.
+        BufferStreamOrphan      = 1, // Append to a mapped buffer, orphan it when full.
+        BufferStreamPersistent  = 2, // Write into a persistent mapped buffer guarded by fences.
+    } BufferStreamMode;
+
+    /**
+     * Enum of glyph bitmap rasterizers
+     */
+    typedef enum GlyphRasterizer {
+        GlyphRasterAccumulate   = 0, // Accumulate the signed area of the glyph outline per pixel.
+        GlyphRasterBackend      = 1, // Rasterize with the font back-end, stb_truetype or FreeType.
+    } GlyphRasterizer;
+
+
+    /**
+     * Enum of primitive types drawn by Renderer::drawPrimitives
+     */
+    typedef enum PrimitiveType {
+        PrimitiveRect   = 0, // Rounded rect at (x, y) of size (w, h), a circle if the size is twice the radius.
+        PrimitiveLine   = 1, // Line from (x, y) to (w, h) with round caps, the radius is half the width.
+    } PrimitiveType;
+
+
     /**
      * Enum of image flags for renderer
      */
@@ -122,6 +149,11 @@ namespace sge
     } Alignment;
 
     class Renderer;
+    class TessellationPool;
+    class GlyphRasterPool;
+    class MappedFile;
+    class LayerPool;
+    class ImageAtlas;
 
     /**
      * The renderer class
@@ -138,12 +170,18 @@ namespace sge
          * Get image size
          */
         int2 getImageSize();
+
+        /**
+         * Check if the image is packed in the image atlas of the renderer
+         */
+        bool isPacked() const;
         
     protected:
         friend class Renderer;
-        RendererImage(Renderer* renderer, int imageId);
+        RendererImage(Renderer* renderer, int imageId, int atlasEntry = -1);
         Renderer*   mRenderer;
         int         mImageId;
+        int         mAtlasEntry;
     };
 
     /**
@@ -163,6 +201,109 @@ namespace sge
         int image;
     };
 
+    /**
+     * A rect, rounded rect, circle or line drawn by Renderer::drawPrimitives,
+     * the colors are not premultiplied
+     */
+    struct RendererPrimitive
+    {
+        int     type;       // PrimitiveType
+        float   x, y, w, h;
+        float   radius;     // Corner radius, clamped to the half size
+        float   border;     // Width of the border inside the shape replacing the fill, 0 for none
+        float   feather;    // Width of the blurred edge for shadows, the border is not drawn if set
+        float4  fillColor;
+        float4  borderColor;
+    };
+
+    /**
+     * The retained display list, records fills, strokes and texts once
+     * and replays them across frames, the tessellated geometry is cached
+     * and only tessellated again when the replay scale changes beyond the
+     * scale tolerance
+     */
+    class SGE_API RendererDisplayList
+    {
+    public:
+        /**
+         * Constructor, define a empty display list
+         */
+        RendererDisplayList();
+
+        /**
+         * Destructor
+         */
+        ~RendererDisplayList();
+
+        /**
+         * Check if nothing recorded
+         */
+        bool isEmpty() const;
+
+        /**
+         * Remove all recorded content, so it can be recorded again
+         */
+        void clear();
+
+        /**
+         * Set the relative scale change allowed before the cached geometry
+         * is tessellated again
+         * @param tolerance The tolerance, the default is 0.1
+         */
+        void setScaleTolerance(float tolerance);
+
+        /**
+         * Get how many times the geometry has been tessellated
+         */
+        int getTessellationCount() const;
+
+    protected:
+        friend class Renderer;
+        void*   mList;
+
+    private:
+        DISABLE_COPY(RendererDisplayList)
+    };
+
+    /**
+     * The retained polyline, keeps a copy of a series of points with increasing x,
+     * e.g. the samples of a time series, and the decimation of the points per zoom
+     * level, so redraws at the same zoom and pans reuse it
+     */
+    class SGE_API RendererPolyline
+    {
+    public:
+        /**
+         * Constructor, define a empty polyline
+         */
+        RendererPolyline();
+
+        /**
+         * Destructor
+         */
+        ~RendererPolyline();
+
+        /**
+         * Set the points, they are copied and the cached decimation is dropped
+         * @param pts The points, x must not decrease
+         * @param count The number of points
+         * @return false if out of memory, the polyline is empty then
+         */
+        bool setPoints(const float2* pts, size_t count);
+
+        /**
+         * Get the number of points stroked by the last draw, after decimation and clipping
+         */
+        int getStrokedCount() const;
+
+    protected:
+        friend class Renderer;
+        void*   mLine;
+
+    private:
+        DISABLE_COPY(RendererPolyline)
+    };
+
     /**
      * The 2D renderer for gui render
      */
@@ -312,6 +453,22 @@ namespace sge
          */
         RendererImage loadImage(const byte* rgbaData, int w, int h, int imageFlags);
 
+        /**
+         * Pack the images loaded afterwards into shared atlas pages if they are not larger than maxImageSize
+         * and need no repeat or mipmaps, so the patterns of different images draw without texture switches.
+         * The pages wasting a quarter by freed images are repacked at the begin of the next frame,
+         * so the paints of packed images are valid until the frame ends. Drawing outside of the pattern
+         * rect of a packed image samples its neighbors instead of clamping
+         * @param maxImageSize The max width and height of packed images, 0 to disable (the default)
+         * @param pageSize The width and height of the pages, used if no image is packed yet
+         */
+        void setImageAtlas(int maxImageSize, int pageSize = 1024);
+
+        /**
+         * Get the number of atlas pages and packed images
+         */
+        void getImageAtlasStats(int* pages, int* images) const;
+
 
         /***   [--- Paint ---]   ***/
         
@@ -339,6 +496,12 @@ namespace sge
         RendererPaint createImagePattern(float ox, float oy, float ex, float ey,
             float angle, int image, float alpha);       
 
+        /**
+         * Create image pattern paint of a loaded image, the packed images map to their atlas page
+         */
+        RendererPaint createImagePattern(float ox, float oy, float ex, float ey,
+            float angle, const RendererImage& image, float alpha);
+
 
         /***   [--- Path ---]   ***/
 
@@ -474,14 +637,88 @@ namespace sge
         void setStrokeWidth(float size);
 
 
+        /***   [--- Primitive ---]   ***/
+
+        /**
+         * Draw rects, rounded rects, circles and lines without building paths, with the current
+         * transform, scissor and global alpha. Consecutive primitives are drawn in one instanced call
+         * with the anti-aliasing, border and blur computed in the fragment shader (GL3 and GLES3),
+         * they are filled and stroked as paths by other backends.
+         * @note The current path is cleared
+         * @param prims The primitives to draw in order
+         * @param count The number of primitives
+         */
+        void drawPrimitives(const RendererPrimitive* prims, int count);
+
+        /**
+         * Draw a rounded rect primitive
+         * @param borderWidth The width of the border inside the rect, 0 for none
+         */
+        void drawRoundedRect(float x, float y, float w, float h, float radius,
+            const float4& fillColor, float borderWidth, const float4& borderColor);
+
+        /**
+         * Draw a circle primitive
+         * @param borderWidth The width of the border inside the circle, 0 for none
+         */
+        void drawCircle(float cx, float cy, float radius,
+            const float4& fillColor, float borderWidth, const float4& borderColor);
+
+        /**
+         * Draw a line primitive with round caps
+         */
+        void drawLine(float x0, float y0, float x1, float y1, float width, const float4& color);
+
+        /**
+         * Draw the blurred shadow of a rounded rect
+         * @param blur The width of the blurred edge, centered on the rect outline
+         */
+        void drawShadow(float x, float y, float w, float h, float radius, float blur, const float4& color);
+
+        /**
+         * Enable or disable drawing the primitives as instances, it is enabled by default
+         * @return true if the primitives are drawn as instances, false if they are drawn as paths
+         */
+        bool setPrimitiveInstancing(bool enable);
+
+
+        /***   [--- Polyline ---]   ***/
+
+        /**
+         * Stroke the polyline with the current stroke style, transform and scissor,
+         * without building a path command per point. The points are decimated to the
+         * min and max y of each device pixel column, and only the points inside the
+         * viewport and scissor are stroked when the transform is not rotated
+         * @note The current path is cleared
+         * @param line The polyline
+         */
+        void drawPolyline(RendererPolyline& line);
+
+        /**
+         * Stroke a polyline of points without caching the decimation,
+         * use RendererPolyline for the series drawn in many frames
+         * @param pts The points, x must not decrease
+         * @param count The number of points
+         */
+        void drawPolyline(const float2* pts, size_t count);
+
+
         /***   [--- Text ---]   ***/
 
         /**
          * Creates font by loading it from the disk from specified file name
+         * The file is mapped read-only once for all the renderers of the process and read in place
          * Returns handle to the font, or -1 if failed
          */
         int loadFont(const char* name, const char* filename);
 
+        /**
+         * Get the font files mapped by the renderers of the process
+         * @param files The number of files, each is mapped once
+         * @param kilobytes The size of the files
+         */
+        static void getMappedFontStats(int* files, int* kilobytes);
+
         /**
          * Creates font by loading it from the specified memory chunk
          * Returns handle to the font, or -1 if failed
@@ -513,6 +750,14 @@ namespace sge
          */
         void setFontBlur(float blur);
 
+        /**
+         * Enable or disable drawing the current text style from signed distance field glyphs,
+         * rasterized once and scaled to any size and blur without new glyphs in the atlas.
+         * It is disabled by default, the bitmap glyphs are sharper at small sizes
+         * @return true if the distance fields are drawn, false if the bitmap glyphs are used
+         */
+        bool setTextSDF(bool enable);
+
         /**
          * Sets the letter spacing of current text style
          */
@@ -571,12 +816,243 @@ namespace sge
          * Measured values are returned in local coordinate space.
          */
         void getTextMetrics(float* ascender, float* descender, float* lineh);
+
+
+        /***   [--- Display list ---]   ***/
+
+        /**
+         * Clear the display list and begin recording into it, the following
+         * fillPath, strokePath and texts are recorded instead of drawn
+         * with the current states, the current transform becomes the list space
+         * @param list The display list to record
+         */
+        void beginDisplayList(RendererDisplayList& list);
+
+        /**
+         * End recording the display list
+         */
+        void endDisplayList();
+
+        /**
+         * Draw the display list with the current transform
+         * @param list The recorded display list
+         * @note The recorded content without scissor uses the current scissor,
+         * the current global alpha is applied
+         */
+        void drawDisplayList(RendererDisplayList& list);
+
+        /**
+         * Draw the display list with the current transform multiplied by xform
+         * @param list The recorded display list
+         * @param xform The transform matrix
+         */
+        void drawDisplayList(RendererDisplayList& list, const float* xform);
+
+
+        /***   [--- Layer ---]   ***/
+
+        /**
+         * Get an offscreen layer from the pool, it may be larger than asked
+         * @param width The min layer width
+         * @param height The min layer height
+         * @return The layer id, 0 if layers are not supported
+         */
+        int acquireLayer(int width, int height);
+
+        /**
+         * Give back a layer to the pool, its content is lost
+         * @param layer The layer id by acquireLayer
+         */
+        void releaseLayer(int layer);
+
+        /**
+         * Draw into the layer until endLayer, the layer is cleared to transparent,
+         * the state is saved and reset. Layers can be nested.
+         * @param layer The layer id by acquireLayer
+         * @return false if the layer can not be drawn into, endLayer must not be called
+         */
+        bool beginLayer(int layer);
+
+        /**
+         * Stop drawing into current layer, restore the state and the previous target
+         */
+        void endLayer();
+
+        /**
+         * Draw the top left rect of the layer with current transform and scissor
+         * @note The current path is cleared
+         * @param layer The layer id
+         * @param x The x position
+         * @param y The y position
+         * @param width The width of the rect, at most the layer width
+         * @param height The height of the rect, at most the layer height
+         * @param alpha The alpha multiplied to the layer
+         */
+        void drawLayer(int layer, float x, float y, float width, float height, float alpha);
+
+
+        /***   [--- Tessellation ---]   ***/
+
+        /**
+         * Set the number of threads tessellating fills and strokes, with more
+         * than 1 the paths are queued and tessellated in parallel chunks before
+         * they are submitted in order, at end of frame or before texts
+         * @param count The thread count including the calling thread, 0 to use
+         * the processor count, 1 to tessellate at each fillPath/strokePath
+         */
+        void setTessellationThreads(int count);
+
+        /**
+         * Get the number of threads tessellating fills and strokes
+         */
+        int getTessellationThreads() const;
+
+        /**
+         * Enable or disable the SIMD tessellation kernels of all renderers,
+         * they are enabled by default if the processor supports them
+         * @return true if SIMD kernels are in use
+         */
+        static bool setSimdEnabled(bool enable);
+
+        /**
+         * Check if the SIMD tessellation kernels are in use
+         */
+        static bool isSimdEnabled();
+
+        /**
+         * Enable or disable merging consecutive draw calls with the same blend and texture,
+         * it is enabled by default if the backend supports it (GLES3)
+         */
+        void setDrawCallMerging(bool enable);
+
+        /**
+         * Get the draw calls of the last rendered frame
+         * @param calls The calls recorded, fills and strokes of the paths, text and triangles
+         * @param merged The calls drawn after merging
+         */
+        void getDrawCallStats(int* calls, int* merged) const;
+
+        /**
+         * Get the memory of the frame arenas, the path commands and tessellation of the context
+         * and the calls, vertices and uniforms recorded for the backend are allocated from them,
+         * an arena keeps the largest frame reserved so steady frames allocate nothing
+         * @param used The bytes allocated in the current frame
+         * @param peak The most bytes allocated in a frame
+         * @param growths The times a frame went over the reserved bytes and allocated more
+         */
+        void getMemoryStats(int* used, int* peak, int* growths) const;
+
+        /**
+         * Get the glyph cache counters since the renderer was created, the glyphs are packed
+         * on up to four atlas pages and the least recently drawn are evicted when they are full
+         * @param pages The atlas pages in use, each is a texture
+         * @param hits The glyphs drawn from the atlas
+         * @param misses The glyphs rasterized to be drawn
+         * @param evictions The glyphs removed from the atlas to make room for others
+         */
+        void getGlyphCacheStats(int* pages, int* hits, int* misses, int* evictions) const;
+
+        /**
+         * Enable or disable the text layout cache, it is enabled by default. The shaped glyphs,
+         * bounds and line breaks of the last 1024 strings are kept with their font, size and
+         * spacing, so measuring and drawing unchanged text does not lay it out again every frame
+         */
+        void setTextLayoutCache(bool enable);
+
+        /**
+         * Get the text layout cache counters since the renderer was created
+         * @param layouts The strings laid out in the cache
+         * @param hits The texts measured or drawn with a cached layout
+         * @param misses The texts laid out to be cached
+         */
+        void getTextLayoutStats(int* layouts, int* hits, int* misses) const;
+
+        /**
+         * Set the threads rasterizing the glyphs missing from the atlas, by default 0 and the glyphs are
+         * rasterized when the text is drawn. Until its bitmap is ready a glyph is drawn stretched from
+         * another size of it, or not at all, and the scene is redrawn. Only the stb_truetype font back-end
+         * rasterizes on the threads
+         * @param count The number of threads, negative for the number of processors
+         */
+        void setGlyphRasterThreads(int count);
+
+        /**
+         * Get the number of threads rasterizing the glyphs, 0 if they are rasterized when drawn
+         */
+        int getGlyphRasterThreads() const;
+
+        /**
+         * Get the number of glyphs drawn without their bitmap in the current frame
+         */
+        int getGlyphPlaceholderCount() const;
+
+        /**
+         * Rasterize the glyphs of codepoint ranges in the current font, size and blur before they are drawn,
+         * on the glyph raster threads if set
+         * @param ranges The first and last codepoint of each range
+         * @param count The number of ranges
+         * @return The number of glyphs rasterized or submitted, the glyphs in the atlas already are skipped
+         */
+        int prewarmGlyphs(const unsigned int* ranges, int count);
+
+        /**
+         * Set the rasterizer of the glyphs added to the atlas from now on, the accumulation rasterizer
+         * is used by default. FreeType always rasterizes its hinted glyphs itself
+         * @param rasterizer The wanted rasterizer
+         * @return The rasterizer in use
+         */
+        GlyphRasterizer setGlyphRasterizer(GlyphRasterizer rasterizer);
+
+        /**
+         * Save the glyphs in the atlas to a glyph cache file, the atlas pages with the font hash,
+         * codepoint, size and blur of each glyph on them
+         * @param filename The file to write
+         * @return The number of glyphs saved, -1 if the file can not be written
+         */
+        int saveGlyphCache(const char* filename);
+
+        /**
+         * Load a glyph cache file before any text is drawn, the file is mapped and its atlas pages are
+         * uploaded. The glyphs of fonts not loaded are skipped, the glyphs missing from the file are
+         * rasterized when drawn
+         * @param filename The file saved by saveGlyphCache with the same fonts
+         * @return The number of glyphs loaded, -1 if the file can not be mapped or does not fit the atlas
+         */
+        int loadGlyphCache(const char* filename);
+
+        /**
+         * Enable or disable skipping the fills, strokes and texts outside of the scissor
+         * and the viewport before tessellation, it is enabled by default
+         */
+        void setScissorCulling(bool enable);
+
+        /**
+         * Get the number of fills, strokes and texts culled in the current frame
+         */
+        int getCulledCount() const;
+
+        /**
+         * Set how the vertices are uploaded, it takes effect after the next rendered frame.
+         * The persistent mode needs buffer storage (GL 4.4 or EXT_buffer_storage), it is used by default if supported
+         * @param mode The wanted mode
+         * @return The mode used from the next frame, an unsupported mode falls back to the best supported one
+         */
+        BufferStreamMode setBufferStreamMode(BufferStreamMode mode);
         
     protected:
         friend class Scene;
+        friend class Application;
+        friend class ApplicationPrivate;
         friend class RendererImage;
         friend class RendererPaint;
         void*   mNativeCtx;
+        TessellationPool*   mTessPool;
+        GlyphRasterPool*    mGlyphPool;
+        Vector<MappedFile*> mFontFiles;
+        LayerPool*          mLayerPool;
+        ImageAtlas*         mImageAtlas;
+        int                 mAtlasMaxSize;
+        RendererPolyline*   mPolyline;
 
         /**
          * Begin a new frame
@@ -596,6 +1072,35 @@ namespace sge
          */
         void cancelFrame();
 
+        /**
+         * Enable or disable deferred mode, in deferred mode the frames and
+         * image updates are recorded without GL calls, drawn by renderFrame
+         * on the thread owning the GL context.
+         * @note no frame can be in flight while switching, the GL context
+         * must be current while disable
+         */
+        void setDeferred(bool deferred);
+
+        /**
+         * Create a frame buffer for deferred mode
+         */
+        void* createFrame();
+
+        /**
+         * Delete a frame buffer
+         */
+        void deleteFrame(void* frame);
+
+        /**
+         * Move the recorded commands into frame, the frame must be drawn before swapped again
+         */
+        void swapFrame(void* frame);
+
+        /**
+         * Draw a swapped frame on the thread owning the GL context
+         */
+        void renderFrame(void* frame);
+
     private:
         DISABLE_COPY(Renderer)
     };
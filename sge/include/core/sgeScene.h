@@ -85,6 +85,11 @@ namespace sge
          */
         void setBrushColor(const float4& color);
 
+        /**
+         * Get the scene size
+         */
+        const int2& getSize();
+
         /**
          *  Set root view
          */
@@ -100,6 +105,32 @@ namespace sge
          */
         Application* getApplicaton();
 
+        /**
+         * Mark this scene need redraw
+         */
+        void invalidate();
+
+        /**
+         * Mark a rect of this scene need redraw, the rects invalidated
+         * before next frame are united into the damage region of it
+         * @param x The left of the rect
+         * @param y The top of the rect
+         * @param width The rect width
+         * @param height The rect height
+         */
+        void invalidate(int x, int y, int width, int height);
+
+        /**
+         * Get the damage region redrawn by last frame, as (x, y, width, height)
+         * @note it is the whole scene unless Application::setPartialRedraw enabled
+         */
+        const int4& getDamageRect();
+
+        /**
+         * Check this scene need redraw
+         */
+        bool isDirty();
+
     protected:
 
         /**
@@ -113,12 +144,25 @@ namespace sge
         virtual void onUnLoad();
 
         /**
-         * Render the base scene
+         * Render the base scene, only the damage region is redrawn
+         * if the back buffer keeps the content of the frames it is damaged by
+         * @param bufferAge The age of the back buffer content, 0 to redraw the whole scene
+         */
+        void onRender(int bufferAge = 0);
+
+        /**
+         * Clear the frame and render models,
+         * it is called on the render thread if Application render thread enabled
+         * @param color The clear color
+         * @param size The viewport size
+         * @param damage The region to redraw, (x, y, width, height) from the top left
          */
-        void onRender();
+        void onRenderBackground(const float4& color, const int2& size, const int4& damage);
         
         /**
          * Callback while need render models
+         * @note called on the render thread if Application render thread enabled,
+         * only GL and the data not changed by ui thread can be used
          */
         virtual void onRenderModel();
 
@@ -232,6 +276,7 @@ namespace sge
 
     private:
         friend class Application;
+        friend class ApplicationPrivate;
         friend class ScenePrivate;
         ScenePrivate* d;
     };
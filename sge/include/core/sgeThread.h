@@ -73,6 +73,11 @@ namespace sge
 		 */
 		static TID	getCurrentThreadId();
 
+        /**
+         * Get the number of online processors, at least 1
+         */
+        static int getProcessorCount();
+
         /**
          * Constructor
          */
@@ -47,6 +47,7 @@
 #include <core/sgeMath.h>
 #include <core/sgeLog.h>
 #include <core/sgeGLSLProgram.h>
+#include <core/sgeProfiler.h>
 
 #define PTR_OFFSET(x) ((void*)(x))  // BUFFER_OFFSET
 
@@ -425,6 +426,82 @@ namespace sge
         GLX() = delete; // Delete constructor, all function static
     };
 
+    /**
+     * Class GPUProfiler, measure gpu time of passes by timestamp queries.
+     * The queries are kept in a ring of frames, results are read back some
+     * frames later only if available, so it never stalls the pipeline.
+     * Needs GL3.3 or GL_EXT_disjoint_timer_query, all calls are ignored if not supported.
+     * The resolved zones are also recorded on the "GPU" track of Profiler
+     */
+    class SGE_API GPUProfiler
+    {
+    public:
+        /**
+         * Check timer queries supported by current context
+         */
+        static bool isSupported();
+
+        /**
+         * Begin a gpu frame, read back the available results of previous frames
+         */
+        static void beginFrame();
+
+        /**
+         * End current gpu frame
+         */
+        static void endFrame();
+
+        /**
+         * Begin a gpu zone, nested zones are supported
+         * @param name The zone name, must be a static string
+         */
+        static void begin(const char* name);
+
+        /**
+         * End the last gpu zone
+         */
+        static void end();
+
+        /**
+         * Get the count of resolved frames
+         */
+        static int getFrameCount();
+
+        /**
+         * Get the count of frames dropped, because of results not ready
+         * before the ring reused or gpu disjoint
+         */
+        static int getDroppedFrameCount();
+
+        /**
+         * Get the statistics of last resolved frame
+         */
+        static void getLastFrameStats(Vector<ProfileStat>& stats);
+
+        /**
+         * Get the average statistics of all resolved frames
+         */
+        static void getAverageFrameStats(Vector<ProfileStat>& stats);
+
+        /**
+         * Log the average statistics of all resolved frames
+         */
+        static void logStats();
+
+        /**
+         * Clear statistics
+         */
+        static void reset();
+
+        /**
+         * Delete all queries, must be called before the context destroyed
+         */
+        static void shutdown();
+
+    private:
+        GPUProfiler() = delete;
+    };
+
 } // !namespace
 
 #endif //!GLX
@@ -0,0 +1,148 @@
+/**
+ *
+ * Simple graphic engine
+ * "sge" libraiy is a simple graphics engine, named sge.
+ *
+ * sgePlatformNativeHeadless.h
+ * date: 2026/10/17
+ * author: xiang
+ *
+ * License
+ *
+ * Copyright (c) 2017-2019, Xiang Wencheng <xiangwencheng@outlook.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * - Neither the names of its contributors may be used to endorse or
+ *   promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifndef SGE_PLATFORM_NATIVE_HEADLESS_H
+#define SGE_PLATFORM_NATIVE_HEADLESS_H
+
+#include <core/sgePlatform.h>
+#include <core/sgePlatformNative.h>
+#include <core/sgeMutex.h>
+#include <core/sgeSemaphore.h>
+
+#ifdef OPENGLES
+
+namespace sge
+{
+
+    /**
+     * The synthetic event types for headless native
+     */
+    typedef enum HeadlessEventType
+    {
+        HeadlessLeftButtonDown,
+        HeadlessLeftButtonUp,
+        HeadlessLeftButtonClick,
+        HeadlessRightButtonDown,
+        HeadlessRightButtonUp,
+        HeadlessRightButtonClick,
+        HeadlessMiddleButtonDown,
+        HeadlessMiddleButtonUp,
+        HeadlessMiddleButtonClick,
+        HeadlessMouseMove,
+        HeadlessMouseWheel,
+        HeadlessKeyDown,
+        HeadlessKeyUp,
+        HeadlessClose,
+    } HeadlessEventType;
+
+    /**
+     * A synthetic event, only the fields of the type are used
+     */
+    typedef struct HeadlessEvent
+    {
+        HeadlessEventType   type;
+        MouseButtonEvent    mouse;
+        MouseWheelEvent     wheel;
+        KeyDownEvent        key;
+    } HeadlessEvent;
+
+    /**
+     * Headless native platform interface implement,
+     * a fixed size virtual window without any native window system.
+     * Rendered by an offscreen context, see also GLContext::initializeOffscreen
+     */
+    class SGE_API PlatformHeadlessNative : public PlatformNative
+    {
+    public:
+        PlatformHeadlessNative(int width = 800, int height = 600);
+        ~PlatformHeadlessNative();
+
+        WindowHandle getWindow() override { return (WindowHandle)0; }
+        DisplayHandle getDisplay() override { return EGL_DEFAULT_DISPLAY; }
+
+        void close() override;
+        bool isClosed() override { return mClosed; }
+
+        int2 getWindowSize() override { return mSize; }
+
+        virtual bool processEvents() override;
+
+        virtual bool waitEvents(unsigned long ms = 0xFFFFFFFF) override;
+
+    public:
+        /**
+         * Post a synthetic event, it will be dispatched by processEvents
+         * @note thread safe, can post from any thread
+         */
+        void postEvent(const HeadlessEvent& event);
+
+        /**
+         * Post a synthetic mouse button or move event
+         */
+        void postMouseEvent(HeadlessEventType type, int x, int y, byte masks = 0);
+
+        /**
+         * Post a synthetic mouse wheel event
+         */
+        void postMouseWheelEvent(int zDelta, int x, int y, byte masks = 0);
+
+        /**
+         * Post a synthetic key down or up event
+         */
+        void postKeyEvent(HeadlessEventType type, byte vKeyCode);
+
+    private:
+        void dispatchEvent(const HeadlessEvent& event);
+
+        int2                mSize;
+        bool                mClosed;
+        Mutex               mMutex;
+        Semaphore           mEventSem;
+        List<HeadlessEvent> mEvents;
+    };
+
+}
+
+#endif
+
+#endif // !SGE_PLATFORM_NATIVE_HEADLESS_H
@@ -69,6 +69,7 @@ namespace sge
 
         class LayoutParams;
         class ViewGroup;
+        class ViewPrivate;
 
 
 
@@ -179,6 +180,60 @@ namespace sge
              */
             int getHeight();
 
+            /**
+             * Request redraw this view, mark current scene dirty
+             */
+            void invalidate();
+
+            /**
+             * Request redraw a rect of this view, the rect is reported
+             * through the parents into the damage region of current scene
+             * @param x The left of the rect, relative to this view
+             * @param y The top of the rect, relative to this view
+             * @param width The rect width
+             * @param height The rect height
+             */
+            void invalidate(int x, int y, int width, int height);
+
+            /**
+             * Set the alpha of this view and children, multiplied to the parents.
+             * A view with layer fades as a whole, otherwise each shape fades itself
+             * @param alpha The alpha in [0, 1], the default is 1
+             */
+            void setAlpha(float alpha);
+
+            /**
+             * Get the alpha of this view
+             */
+            float getAlpha();
+
+            /**
+             * Set the offset this view is drawn at, relative to the frame,
+             * it moves the drawing only, the layout and events are not changed
+             * @param x The x offset
+             * @param y The y offset
+             */
+            void setTranslation(float x, float y);
+
+            /**
+             * Get the offset this view is drawn at
+             */
+            float2 getTranslation();
+
+            /**
+             * Enable or disable the layer, the default is disable.
+             * While enabled, this view and children are drawn into an offscreen layer,
+             * which is drawn as one image until any of them invalidated, so changing
+             * the translation or alpha does not draw them again.
+             * @note it is drawn directly if layers are not supported by the renderer
+             */
+            void setLayerEnabled(bool enable);
+
+            /**
+             * Check the layer is enabled
+             */
+            bool isLayerEnabled();
+
 #pragma region EventCallback
 
             /**
@@ -280,7 +335,7 @@ namespace sge
 #pragma endregion
 
         protected:
-            friend class Scene;
+            friend class sge::Scene;
             friend class ViewGroup;
 
             void setParent(ViewGroup* parent);
@@ -305,6 +360,12 @@ namespace sge
              */
             void doDraw();
 
+            /**
+             * Draw this view into the layer if dirty
+             * @return false if the layer is not available, it is drawn directly
+             */
+            bool updateLayer();
+
             /**
              * Set frame for this view
              */
@@ -71,6 +71,8 @@ namespace sge
 
         virtual bool processEvents() override;
 
+        virtual bool waitEvents(unsigned long ms = 0xFFFFFFFF) override;
+
     public:
         virtual LRESULT     wndProc(HWND hWnd, UINT msgId, WPARAM wParam, LPARAM lParam);
 
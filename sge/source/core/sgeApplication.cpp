@@ -46,31 +46,209 @@
 #include <core/sgeRenderer.h>
 #include <core/sgeGLContext.h>
 #include <core/sgeLog.h>
+#include <core/sgeProfiler.h>
+#include <core/sgeGLX.h>
+#include <core/sgeThread.h>
+#include <core/sgeSemaphore.h>
 
 #if SGE_TARGET_PLATFORM == SGE_PLATFORM_WIN32
 #include <win32/sgePlatformNativeWin32.h>
+#elif defined(OPENGLES)
+#include <headless/sgePlatformNativeHeadless.h>
+#endif
+
+#if SGE_TARGET_PLATFORM == SGE_PLATFORM_WIN32 || defined(OPENGLES)
 
 namespace sge
 {
 
+    /**
+     * A frame submitted to the render thread
+     */
+    struct RenderPacket
+    {
+        void*   frame;
+        Scene*  scene;
+        float4  color;
+        int2    size;
+        int4    damage;
+        bool    vsync;
+        bool    quit;
+    };
+
     class ApplicationPrivate
     {
     public:
         Scene*              mCurScene;
+#if SGE_TARGET_PLATFORM == SGE_PLATFORM_WIN32
         PlatformWin32Native mPlatform;
+#else
+        PlatformHeadlessNative  mPlatform;
+#endif
         GLContext           mGLContext;
         Renderer*           mRenderer;
+        RedrawMode          mRedrawMode;
+        unsigned long       mRedrawTimeout;
+        bool                mVSYNC;
+        bool                mPartialRedraw;
+        bool                mBufferPreserved;
+
+        // render thread, packets are used in turn, 2 frames in flight at most
+        Thread*             mRenderThread;
+        RenderPacket        mPackets[2];
+        int                 mPacketIndex;
+        Semaphore           mFreePackets;
+        Semaphore           mReadyPackets;
 
         ApplicationPrivate()
             : mCurScene(NULL)
+#if SGE_TARGET_PLATFORM == SGE_PLATFORM_WIN32
             , mPlatform(0, 800, 600)
+#else
+            , mPlatform(800, 600)
+#endif
             , mRenderer(NULL)
-        {}
+            , mRedrawMode(RedrawContinuous)
+            , mRedrawTimeout(0xFFFFFFFF)
+            , mVSYNC(false)
+            , mPartialRedraw(false)
+            , mBufferPreserved(false)
+            , mRenderThread(NULL)
+            , mPacketIndex(0)
+            , mFreePackets(2)
+            , mReadyPackets(0)
+        {
+            for (int i = 0; i < 2; ++i)
+            {
+                mPackets[i].frame = NULL;
+                mPackets[i].scene = NULL;
+                mPackets[i].quit = false;
+            }
+        }
 
         ~ApplicationPrivate()
         {
             ASSERT(mCurScene == NULL && "not released");
             ASSERT(mRenderer == NULL && "not released");
+            ASSERT(mRenderThread == NULL && "not stopped");
+        }
+
+        void setEnableVSYNC(bool enable)
+        {
+            mVSYNC = enable;
+            // the render thread applies it with next frame
+            if (!mRenderThread)
+            {
+                mGLContext.setEnableVSYNC(enable);
+            }
+        }
+
+        RenderPacket& beginPacket()
+        {
+            SGE_PROFILE_ZONE("Application::waitRenderThread");
+            mFreePackets.wait();
+            return mPackets[mPacketIndex];
+        }
+
+        void endPacket()
+        {
+            mPacketIndex = (mPacketIndex + 1) % 2;
+            mReadyPackets.set();
+        }
+
+        void submitFrame(Scene* scene)
+        {
+            RenderPacket& packet = beginPacket();
+            mRenderer->swapFrame(packet.frame);
+            packet.scene = scene;
+            packet.color = scene->getBrushColor();
+            packet.size = scene->getSize();
+            packet.damage = scene->getDamageRect();
+            packet.vsync = mVSYNC;
+            endPacket();
+        }
+
+        void waitRenderIdle()
+        {
+            if (mRenderThread)
+            {
+                mFreePackets.wait();
+                mFreePackets.wait();
+                mFreePackets.set(2);
+            }
+        }
+
+        void startRenderThread()
+        {
+            for (int i = 0; i < 2; ++i)
+            {
+                mPackets[i].frame = mRenderer->createFrame();
+            }
+            mRenderer->setDeferred(true);
+            mGLContext.doneCurrent();
+
+            Runable runable;
+            runable.bind<ApplicationPrivate>(this, &ApplicationPrivate::renderThreadRun);
+            mRenderThread = new Thread(runable);
+            mRenderThread->start();
+        }
+
+        void stopRenderThread()
+        {
+            RenderPacket& packet = beginPacket();
+            packet.quit = true;
+            endPacket();
+            mRenderThread->join();
+            delete mRenderThread;
+            mRenderThread = NULL;
+
+            mGLContext.makeCurrent();
+            mGLContext.setEnableVSYNC(mVSYNC);
+            mRenderer->setDeferred(false);
+            for (int i = 0; i < 2; ++i)
+            {
+                mRenderer->deleteFrame(mPackets[i].frame);
+                mPackets[i].frame = NULL;
+            }
+            mPacketIndex = 0;
+        }
+
+        int renderThreadRun()
+        {
+            mGLContext.makeCurrent();
+            bool vsync = mVSYNC;
+            int index = 0;
+            while (true)
+            {
+                mReadyPackets.wait();
+                RenderPacket& packet = mPackets[index];
+                index = (index + 1) % 2;
+                if (packet.quit)
+                {
+                    packet.quit = false;
+                    mFreePackets.set();
+                    break;
+                }
+
+                if (packet.vsync != vsync)
+                {
+                    vsync = packet.vsync;
+                    mGLContext.setEnableVSYNC(vsync);
+                }
+
+                SGE_GPU_PROFILE_FRAME_BEGIN();
+                packet.scene->onRenderBackground(packet.color, packet.size, packet.damage);
+                mRenderer->renderFrame(packet.frame);
+                SGE_GPU_PROFILE_FRAME_END();
+                {
+                    SGE_PROFILE_ZONE("GLContext::swapBuffer");
+                    mGLContext.swapBuffer(packet.damage.x, packet.damage.y, packet.damage.z, packet.damage.w);
+                }
+                packet.scene = NULL;
+                mFreePackets.set();
+            }
+            mGLContext.doneCurrent();
+            return 0;
         }
     };
 
@@ -78,17 +256,31 @@ namespace sge
     Application::Application()
         : d(new ApplicationPrivate())
     {        
+#if SGE_TARGET_PLATFORM == SGE_PLATFORM_WIN32
         bool ret = d->mGLContext.initialize(d->mPlatform.getWindow(), 0, 0);
+#else
+        int2 size = d->mPlatform.getWindowSize();
+        bool ret = d->mGLContext.initializeOffscreen(size.x, size.y);
+#endif
         if (!ret)
         {
             Log::error("Application init gl context failed");
         }
-        d->mGLContext.setEnableVSYNC(false);
+        d->setEnableVSYNC(false);
         d->mRenderer = new Renderer();
         d->mPlatform.mOnCloseEvent.bind<Application>(this, &Application::onClose);
         
         // load fonts
-        d->mRenderer->loadFont("default", "fonts/YaHei.Consolas.ttf");
+        if (d->mRenderer->loadFont("default", "fonts/YaHei.Consolas.ttf") < 0)
+        {
+            d->mRenderer->loadFont("default", "fonts/DroidSans.ttf");
+        }
+        // glyphs baked by GlyphBaker, if any, are not rasterized again
+        int glyphs = d->mRenderer->loadGlyphCache("fonts/glyphs.cache");
+        if (glyphs > 0)
+        {
+            Log::info("Loaded %d glyphs from fonts/glyphs.cache", glyphs);
+        }
     }
 
 
@@ -96,6 +288,10 @@ namespace sge
     {
         if (d)
         {
+            if (d->mRenderThread)
+            {
+                d->stopRenderThread();
+            }
             if (d->mCurScene)
             {
                 loadScene(NULL);
@@ -105,34 +301,121 @@ namespace sge
                 delete d->mRenderer;
                 d->mRenderer = NULL;
             }
+            GPUProfiler::shutdown();
             delete d;
             d = NULL;
         }
     }
 
 
+    void Application::setRedrawMode(RedrawMode mode)
+    {
+        d->mRedrawMode = mode;
+        d->setEnableVSYNC(mode == RedrawOnDemand);
+        if (d->mCurScene)
+        {
+            d->mCurScene->invalidate();
+        }
+    }
+
+    RedrawMode Application::getRedrawMode() { return d->mRedrawMode; }
+
+    void Application::setRedrawTimeout(unsigned long ms) { d->mRedrawTimeout = ms; }
+
     void Application::run()
     {
         while (!d->mPlatform.isClosed())
         {
-            if (!d->mPlatform.processEvents())
+            if (d->mPlatform.processEvents())
             {
-                if (d->mCurScene)
+                continue;
+            }
+
+            Scene* scene = d->mCurScene;
+            if (scene && (d->mRedrawMode == RedrawContinuous || scene->isDirty()))
+            {
+                SGE_PROFILE_FRAME_BEGIN();
+                if (d->mRenderThread)
                 {
-                    d->mCurScene->onRender();
-                    d->mGLContext.swapBuffer();
+                    // record this frame while the render thread draws last one,
+                    // the age can not be queried here, only the preserved buffer is reused
+                    scene->onRender(d->mPartialRedraw && d->mBufferPreserved ? 1 : 0);
+                    d->submitFrame(scene);
                 }
+                else
+                {
+                    SGE_GPU_PROFILE_FRAME_BEGIN();
+                    scene->onRender(d->mPartialRedraw ? d->mGLContext.getBufferAge() : 0);
+                    SGE_GPU_PROFILE_FRAME_END();
+                    const int4& damage = scene->getDamageRect();
+                    d->mGLContext.swapBuffer(damage.x, damage.y, damage.z, damage.w);
+                }
+                SGE_PROFILE_FRAME_END();
             }
+            else if (d->mRedrawMode == RedrawOnDemand)
+            {
+                // idle, sleep until native events or timeout
+                if (!d->mPlatform.waitEvents(d->mRedrawTimeout) && d->mCurScene)
+                {
+                    d->mCurScene->invalidate();
+                }
+            }
+        }
+    }
+
+
+    void Application::setRenderThreadEnabled(bool enable)
+    {
+        if (enable == isRenderThreadEnabled())
+            return;
+
+        if (enable)
+        {
+            d->startRenderThread();
+        }
+        else
+        {
+            d->stopRenderThread();
+        }
+        if (d->mCurScene)
+        {
+            d->mCurScene->invalidate();
+        }
+    }
+
+    bool Application::isRenderThreadEnabled() { return d->mRenderThread != NULL; }
+
+    void Application::setPartialRedraw(bool enable)
+    {
+        if (enable == d->mPartialRedraw)
+            return;
+
+        // the surface attribute is changed between frames
+        d->waitRenderIdle();
+        d->mPartialRedraw = enable;
+        d->mBufferPreserved = d->mGLContext.setPreserveBuffer(enable);
+        if (enable && !d->mBufferPreserved)
+        {
+            Log::info("EGL_BUFFER_PRESERVED is not supported, redraw partially by buffer age only");
+        }
+        if (d->mCurScene)
+        {
+            d->mCurScene->invalidate();
         }
     }
 
+    bool Application::isPartialRedraw() { return d->mPartialRedraw; }
 
     void Application::loadScene(Scene* scene)
     {        
+        // the render thread may be drawing the old scene
+        d->waitRenderIdle();
+
         Scene* oldScene = d->mCurScene;
         if (scene)
         {
             scene->onLoad();
+            scene->invalidate();
         }
         d->mCurScene = scene;
 
@@ -147,24 +430,24 @@ namespace sge
 
     void Application::quit()
     {
-        if (getPlatform()->isClosed())
+        if (!getPlatform()->isClosed())
         {
             getPlatform()->close();
         }
     }
 
-    inline bool Application::onClose()
+    bool Application::onClose()
     {
         // unload the scene
         loadScene(NULL);
         return false;
     }
 
-    inline PlatformNative * Application::getPlatform() { return &d->mPlatform; }
+    PlatformNative * Application::getPlatform() { return &d->mPlatform; }
     
-    inline Renderer * Application::getRenderer() { return d->mRenderer; }
+    Renderer * Application::getRenderer() { return d->mRenderer; }
 
-    inline Scene * Application::getCurrentScene() { return d->mCurScene; }
+    Scene * Application::getCurrentScene() { return d->mCurScene; }
 
 }
 
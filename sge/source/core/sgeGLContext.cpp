@@ -72,6 +72,29 @@ namespace sge
 #endif
         return EGL_OPENGL_ES2_BIT;
     }
+
+    static EGLDisplay eglGetOffscreenDisplay()
+    {
+#if defined(EGL_EXT_platform_base) && defined(EGL_PLATFORM_SURFACELESS_MESA)
+        // surfaceless platform need not any window system, e.g. mesa llvmpipe
+        const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if (extensions && strstr(extensions, "EGL_MESA_platform_surfaceless"))
+        {
+            PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+                (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+            if (getPlatformDisplay)
+            {
+                EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+                if (display != EGL_NO_DISPLAY)
+                {
+                    Log::info("Use EGL_PLATFORM_SURFACELESS_MESA");
+                    return display;
+                }
+            }
+        }
+#endif
+        return eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
 #endif
 
 #ifndef OPENGLES
@@ -220,6 +243,10 @@ namespace sge
         EGLSurface      mSurface;
         EGLContext      mContext;
         EGLDisplay      mDisplay;
+        bool            mPbuffer;
+        bool            mPreserved;
+        bool            mBufferAge;
+        PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC  mSwapWithDamage;
 #else
         HGLRC           mHRC;
 #endif
@@ -231,6 +258,10 @@ namespace sge
             , mSurface(EGL_NO_SURFACE)
             , mContext(EGL_NO_CONTEXT)
             , mDisplay(EGL_NO_DISPLAY)
+            , mPbuffer(false)
+            , mPreserved(false)
+            , mBufferAge(false)
+            , mSwapWithDamage(NULL)
 #else
             , mHRC(NULL)
 #endif
@@ -249,6 +280,30 @@ namespace sge
             ASSERT(mHRC == NULL);
 #endif
         }
+
+#ifdef OPENGLES
+        /**
+         * Query the swap behavior and the partial swap extensions of the surface
+         */
+        void initSwapBehavior()
+        {
+            EGLint behavior = 0;
+            eglQuerySurface(mDisplay, mSurface, EGL_SWAP_BEHAVIOR, &behavior);
+            // pbuffer has not any front buffer, the swap does nothing
+            mPreserved = mPbuffer || behavior == EGL_BUFFER_PRESERVED;
+
+            const char* extensions = eglQueryString(mDisplay, EGL_EXTENSIONS);
+            mBufferAge = extensions && strstr(extensions, "EGL_EXT_buffer_age");
+            if (extensions && strstr(extensions, "EGL_KHR_swap_buffers_with_damage"))
+            {
+                mSwapWithDamage = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)eglGetProcAddress("eglSwapBuffersWithDamageKHR");
+            }
+            else if (extensions && strstr(extensions, "EGL_EXT_swap_buffers_with_damage"))
+            {
+                mSwapWithDamage = (PFNEGLSWAPBUFFERSWITHDAMAGEKHRPROC)eglGetProcAddress("eglSwapBuffersWithDamageEXT");
+            }
+        }
+#endif
     };
 
     GLContext::GLContext()
@@ -339,6 +394,7 @@ namespace sge
         d->mContext = context;
         d->mDisplay = display;
         d->mSurface = surface;
+        d->initSwapBehavior();
         //eglQuerySurface(display, surface, EGL_WIDTH, &_width);
         //eglQuerySurface(display, surface, EGL_HEIGHT, &_height);
 #else
@@ -392,6 +448,87 @@ namespace sge
         return true;
     }
 
+#ifdef OPENGLES
+    bool GLContext::initializeOffscreen(int width, int height)
+    {
+        ASSERT(EGL_NO_CONTEXT == d->mContext && "Not init gl context again");
+
+        EGLDisplay  display = eglGetOffscreenDisplay();
+        if (display == EGL_NO_DISPLAY)
+        {
+            Log::error("eglGetDisplay = EGL_NO_DISPLAY");
+            return false;
+        }
+
+        EGLint  major, minor;
+        if (EGL_FALSE == eglInitialize(display, &major, &minor))
+        {
+            Log::error("eglInitialize = EGL_FALSE");
+            return false;
+        }
+
+        const EGLint attribs[] =
+        {
+            EGL_RENDERABLE_TYPE, eglGetSupportedRendererType(display),
+            EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_DEPTH_SIZE, 8,
+            EGL_STENCIL_SIZE, 8,
+            EGL_NONE
+        };
+
+        EGLint	numConfigs(0);
+        EGLConfig   config;
+        if (EGL_FALSE == eglChooseConfig(display, attribs, &config, 1, &numConfigs) || numConfigs == 0)
+        {
+            Log::error("eglChooseConfig = EGL_FALSE");
+            eglTerminate(display);
+            return false;
+        }
+
+        const EGLint surfaceAttribs[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+        EGLSurface  surface = eglCreatePbufferSurface(display, config, surfaceAttribs);
+        if (EGL_NO_SURFACE == surface)
+        {
+            Log::error("eglCreatePbufferSurface = EGL_NO_SURFACE");
+            eglTerminate(display);
+            return  false;
+        }
+
+        EGLint  attr[] = { EGL_CONTEXT_CLIENT_VERSION,
+            attribs[1] == EGL_OPENGL_ES3_BIT_KHR ? 3 : 2
+            , EGL_NONE };
+        EGLContext  context = eglCreateContext(display, config, EGL_NO_CONTEXT, attr);
+        if (EGL_NO_CONTEXT == context)
+        {
+            Log::error("eglCreateContext = EGL_NO_CONTEXT");
+            eglDestroySurface(display, surface);
+            eglTerminate(display);
+            return  false;
+        }
+
+        if (EGL_FALSE == eglMakeCurrent(display, surface, surface, context))
+        {
+            Log::error("eglMakeCurrent = EGL_FALSE");
+            eglDestroyContext(display, context);
+            eglDestroySurface(display, surface);
+            eglTerminate(display);
+            return  false;
+        }
+
+        d->mConfig = config;
+        d->mContext = context;
+        d->mDisplay = display;
+        d->mSurface = surface;
+        d->mPbuffer = true;
+        d->initSwapBehavior();
+        return true;
+    }
+#endif
+
     GLContext::~GLContext()
     {
         shutdown();
@@ -415,6 +552,10 @@ namespace sge
                 d->mSurface = EGL_NO_SURFACE;
             }
             d->mConfig = 0;
+            d->mPbuffer = false;
+            d->mPreserved = false;
+            d->mBufferAge = false;
+            d->mSwapWithDamage = NULL;
             eglTerminate(d->mDisplay);
             d->mDisplay = EGL_NO_DISPLAY;
         }
@@ -430,7 +571,7 @@ namespace sge
 #endif
     }
 
-    inline void GLContext::makeCurrent()
+    void GLContext::makeCurrent()
     {
 #ifdef OPENGLES
         EGLBoolean  ret = eglMakeCurrent(d->mDisplay, d->mSurface, d->mSurface, d->mContext);
@@ -440,7 +581,17 @@ namespace sge
 #endif
     }
 
-    inline void GLContext::swapBuffer()
+    void GLContext::doneCurrent()
+    {
+#ifdef OPENGLES
+        EGLBoolean  ret = eglMakeCurrent(d->mDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        ASSERT(EGL_TRUE == ret);
+#else
+        wglMakeCurrent(NULL, NULL);
+#endif
+    }
+
+    void GLContext::swapBuffer()
     {
 #ifdef OPENGLES
         EGLBoolean  ret = eglSwapBuffers(d->mDisplay, d->mSurface);
@@ -450,10 +601,75 @@ namespace sge
 #endif
     }
 
-    inline void GLContext::setEnableVSYNC(GLboolean enable)
+    void GLContext::swapBuffer(int x, int y, int width, int height)
+    {
+#ifdef OPENGLES
+        if (d->mSwapWithDamage && width > 0 && height > 0)
+        {
+            // the rect origin of EGL is bottom left
+            EGLint surfaceHeight = 0;
+            eglQuerySurface(d->mDisplay, d->mSurface, EGL_HEIGHT, &surfaceHeight);
+            EGLint rect[4] = { x, surfaceHeight - y - height, width, height };
+            EGLBoolean  ret = d->mSwapWithDamage(d->mDisplay, d->mSurface, rect, 1);
+            ASSERT(EGL_TRUE == ret);
+            return;
+        }
+#endif
+        swapBuffer();
+    }
+
+    bool GLContext::setPreserveBuffer(bool enable)
+    {
+#ifdef OPENGLES
+        if (d->mPbuffer)
+        {
+            return true;
+        }
+
+        EGLint surfaceType = 0;
+        eglGetConfigAttrib(d->mDisplay, d->mConfig, EGL_SURFACE_TYPE, &surfaceType);
+        if (enable && !(surfaceType & EGL_SWAP_BEHAVIOR_PRESERVED_BIT))
+        {
+            return false;
+        }
+
+        if (EGL_FALSE == eglSurfaceAttrib(d->mDisplay, d->mSurface, EGL_SWAP_BEHAVIOR,
+            enable ? EGL_BUFFER_PRESERVED : EGL_BUFFER_DESTROYED))
+        {
+            Log::error("eglSurfaceAttrib(EGL_SWAP_BEHAVIOR) = EGL_FALSE");
+            return d->mPreserved;
+        }
+        d->mPreserved = enable;
+        return enable;
+#else
+        // WGL has not any reliable way to keep the back buffer
+        return false;
+#endif
+    }
+
+    int GLContext::getBufferAge()
+    {
+#ifdef OPENGLES
+        if (d->mPreserved)
+        {
+            return 1;
+        }
+        if (d->mBufferAge)
+        {
+            EGLint age = 0;
+            if (EGL_TRUE == eglQuerySurface(d->mDisplay, d->mSurface, EGL_BUFFER_AGE_EXT, &age))
+            {
+                return age;
+            }
+        }
+#endif
+        return 0;
+    }
+
+    void GLContext::setEnableVSYNC(GLboolean enable)
     {
 #ifdef OPENGLES
-        eglSwapInterval(d->mDisplay, enable ? EGL_MAX_SWAP_INTERVAL : 0);
+        eglSwapInterval(d->mDisplay, enable ? 1 : 0);
 #else
         wglSwapIntervalEXT(enable);
 #endif
@@ -44,6 +44,33 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include <image/stb_image.h>
 
+#include <string.h>
+#include <algorithm>
+
+#ifdef OPENGLES
+#include <GLES2/gl2ext.h>
+typedef PFNGLQUERYCOUNTEREXTPROC            PFNQUERYCOUNTERPROC;
+typedef PFNGLGETQUERYOBJECTUI64VEXTPROC     PFNGETQUERYOBJECTUI64VPROC;
+#define SGE_GL_TIMESTAMP                    GL_TIMESTAMP_EXT
+#else
+typedef PFNGLQUERYCOUNTERPROC               PFNQUERYCOUNTERPROC;
+typedef PFNGLGETQUERYOBJECTUI64VPROC        PFNGETQUERYOBJECTUI64VPROC;
+#define SGE_GL_TIMESTAMP                    GL_TIMESTAMP
+#endif
+
+// The count of frames in flight, results are read back after this frames
+#ifndef SGE_GPU_PROFILER_FRAMES
+#define SGE_GPU_PROFILER_FRAMES     4
+#endif
+
+// The max zones of one frame, zones over it are ignored
+#ifndef SGE_GPU_PROFILER_MAX_ZONES
+#define SGE_GPU_PROFILER_MAX_ZONES  256
+#endif
+
+// The max nested depth of gpu zones
+#define SGE_GPU_PROFILER_MAX_DEPTH  32
+
 void glClearError()
 {
     while (GLenum error = glGetError());
@@ -148,4 +175,386 @@ namespace sge
         return true;
     }
 
-}
\ No newline at end of file
+
+    struct GPUProfileZoneDesc
+    {
+        const char* name;
+        int         parent;
+    };
+
+    struct GPUProfileFrame
+    {
+        GPUProfileZoneDesc  zones[SGE_GPU_PROFILER_MAX_ZONES];
+        GLuint              queries[SGE_GPU_PROFILER_MAX_ZONES * 2];
+        int                 count;
+        bool                pending;
+        // cpu time - gpu time when the frame begin
+        long long           offset;
+    };
+
+    struct GPUProfileAccum
+    {
+        int         calls;
+        long long   total;
+        long long   self;
+        long long   max;
+    };
+
+    class GPUProfilerPrivate
+    {
+    public:
+        bool                            mInitialized;
+        bool                            mSupported;
+        bool                            mInFrame;
+        PFNQUERYCOUNTERPROC             mQueryCounter;
+        PFNGETQUERYOBJECTUI64VPROC      mGetQueryObjectui64v;
+        GPUProfileFrame                 mFrames[SGE_GPU_PROFILER_FRAMES];
+        int                             mCurrent;
+        int                             mStack[SGE_GPU_PROFILER_MAX_DEPTH];
+        int                             mDepth;
+        int                             mResolved;
+        int                             mDropped;
+        Map<String, GPUProfileAccum>    mLastFrame;
+        Map<String, GPUProfileAccum>    mAllFrames;
+
+        GPUProfilerPrivate()
+            : mInitialized(false)
+            , mSupported(false)
+            , mInFrame(false)
+            , mQueryCounter(NULL)
+            , mGetQueryObjectui64v(NULL)
+            , mCurrent(0)
+            , mDepth(0)
+            , mResolved(0)
+            , mDropped(0)
+        {
+            memset(mFrames, 0, sizeof(mFrames));
+        }
+
+        static GPUProfilerPrivate& instance()
+        {
+            static GPUProfilerPrivate profiler;
+            return profiler;
+        }
+
+        void initialize()
+        {
+            mInitialized = true;
+#ifdef OPENGLES
+            bool hasExtension = false;
+            GLint count = 0;
+            glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+            for (GLint i = 0; i < count && !hasExtension; ++i)
+            {
+                const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+                hasExtension = ext && strcmp(ext, "GL_EXT_disjoint_timer_query") == 0;
+            }
+            if (hasExtension)
+            {
+                mQueryCounter = (PFNQUERYCOUNTERPROC)eglGetProcAddress("glQueryCounterEXT");
+                mGetQueryObjectui64v = (PFNGETQUERYOBJECTUI64VPROC)eglGetProcAddress("glGetQueryObjectui64vEXT");
+            }
+#else
+            mQueryCounter = glQueryCounter;
+            mGetQueryObjectui64v = glGetQueryObjectui64v;
+#endif
+            mSupported = mQueryCounter && mGetQueryObjectui64v;
+            if (mSupported)
+            {
+                // clear the disjoint flag
+                isDisjoint();
+            }
+            else
+            {
+                Log::warn("GPUProfiler timer query is not supported");
+            }
+        }
+
+        bool isDisjoint()
+        {
+#ifdef OPENGLES
+            GLint disjoint = 0;
+            glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+            return disjoint != 0;
+#else
+            return false;
+#endif
+        }
+
+        bool resolve(GPUProfileFrame& frame)
+        {
+            // queries are finished in order, the frame zone ended at last
+            GLuint available = 0;
+            glGetQueryObjectuiv(frame.queries[1], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available)
+                return false;
+
+            long long durations[SGE_GPU_PROFILER_MAX_ZONES];
+            long long children[SGE_GPU_PROFILER_MAX_ZONES];
+            for (int i = 0; i < frame.count; ++i)
+            {
+                GLuint64 begin = 0, end = 0;
+                mGetQueryObjectui64v(frame.queries[i * 2], GL_QUERY_RESULT, &begin);
+                mGetQueryObjectui64v(frame.queries[i * 2 + 1], GL_QUERY_RESULT, &end);
+                durations[i] = end > begin ? (long long)(end - begin) : 0;
+                children[i] = 0;
+                Profiler::record("GPU", frame.zones[i].name, (long long)begin + frame.offset, (long long)end + frame.offset);
+            }
+
+            mLastFrame.clear();
+            for (int i = 0; i < frame.count; ++i)
+            {
+                int parent = frame.zones[i].parent;
+                if (parent >= 0)
+                {
+                    children[parent] += durations[i];
+                }
+            }
+            for (int i = 0; i < frame.count; ++i)
+            {
+                accumulate(mLastFrame, frame.zones[i].name, durations[i], durations[i] - children[i]);
+                accumulate(mAllFrames, frame.zones[i].name, durations[i], durations[i] - children[i]);
+            }
+            mResolved++;
+            return true;
+        }
+
+        static void accumulate(Map<String, GPUProfileAccum>& accums, const char* name, long long duration, long long self)
+        {
+            GPUProfileAccum& accum = accums[name];
+            accum.calls++;
+            accum.total += duration;
+            accum.self += self;
+            accum.max = std::max(accum.max, duration);
+        }
+
+        static void toStats(const Map<String, GPUProfileAccum>& accums, int frames, Vector<ProfileStat>& stats)
+        {
+            stats.clear();
+            if (frames <= 0)
+                return;
+
+            for (Map<String, GPUProfileAccum>::const_iterator it = accums.begin(); it != accums.end(); ++it)
+            {
+                ProfileStat stat;
+                stat.name = it->first;
+                stat.calls = (float)it->second.calls / frames;
+                stat.totalMs = (float)(it->second.total / 1000000.0 / frames);
+                stat.selfMs = (float)(it->second.self / 1000000.0 / frames);
+                stat.maxMs = (float)(it->second.max / 1000000.0);
+                stats.push_back(stat);
+            }
+
+            std::sort(stats.begin(), stats.end(),
+                [](const ProfileStat& a, const ProfileStat& b) { return a.totalMs > b.totalMs; });
+        }
+    };
+
+    bool GPUProfiler::isSupported()
+    {
+        GPUProfilerPrivate& p = GPUProfilerPrivate::instance();
+        if (!p.mInitialized)
+        {
+            p.initialize();
+        }
+        return p.mSupported;
+    }
+
+    void GPUProfiler::beginFrame()
+    {
+        GPUProfilerPrivate& p = GPUProfilerPrivate::instance();
+        if (!isSupported() || p.mInFrame)
+            return;
+
+        // read back from the oldest frame, stop at the first not ready
+        bool disjoint = p.isDisjoint();
+        for (int i = 1; i <= SGE_GPU_PROFILER_FRAMES; ++i)
+        {
+            GPUProfileFrame& frame = p.mFrames[(p.mCurrent + i) % SGE_GPU_PROFILER_FRAMES];
+            if (!frame.pending)
+                continue;
+            if (disjoint)
+            {
+                frame.pending = false;
+                p.mDropped++;
+            }
+            else if (p.resolve(frame))
+            {
+                frame.pending = false;
+            }
+            else
+            {
+                break;
+            }
+        }
+
+        p.mCurrent = (p.mCurrent + 1) % SGE_GPU_PROFILER_FRAMES;
+        GPUProfileFrame& frame = p.mFrames[p.mCurrent];
+        if (frame.pending)
+        {
+            // the gpu is too far behind, do not wait it
+            frame.pending = false;
+            p.mDropped++;
+        }
+        frame.count = 0;
+
+        GLint64 gpuTime = 0;
+        glGetInteger64v(SGE_GL_TIMESTAMP, &gpuTime);
+        frame.offset = Profiler::now() - (long long)gpuTime;
+
+        p.mInFrame = true;
+        p.mDepth = 0;
+        begin("Frame");
+    }
+
+    void GPUProfiler::endFrame()
+    {
+        GPUProfilerPrivate& p = GPUProfilerPrivate::instance();
+        if (!p.mInFrame)
+            return;
+
+        while (p.mDepth > 0)
+        {
+            end();
+        }
+        GPUProfileFrame& frame = p.mFrames[p.mCurrent];
+        frame.pending = frame.count > 0;
+        p.mInFrame = false;
+    }
+
+    void GPUProfiler::begin(const char* name)
+    {
+        GPUProfilerPrivate& p = GPUProfilerPrivate::instance();
+        if (!p.mInFrame)
+            return;
+
+        int depth = p.mDepth++;
+        if (depth >= SGE_GPU_PROFILER_MAX_DEPTH)
+            return;
+
+        GPUProfileFrame& frame = p.mFrames[p.mCurrent];
+        if (frame.count >= SGE_GPU_PROFILER_MAX_ZONES)
+        {
+            p.mStack[depth] = -1;
+            return;
+        }
+
+        int index = frame.count++;
+        if (frame.queries[index * 2] == 0)
+        {
+            GLCall(glGenQueries(2, &frame.queries[index * 2]));
+        }
+        frame.zones[index].name = name;
+        frame.zones[index].parent = depth > 0 ? p.mStack[depth - 1] : -1;
+        p.mStack[depth] = index;
+        p.mQueryCounter(frame.queries[index * 2], SGE_GL_TIMESTAMP);
+    }
+
+    void GPUProfiler::end()
+    {
+        GPUProfilerPrivate& p = GPUProfilerPrivate::instance();
+        if (!p.mInFrame || p.mDepth <= 0)
+            return;
+
+        int depth = --p.mDepth;
+        if (depth >= SGE_GPU_PROFILER_MAX_DEPTH || p.mStack[depth] < 0)
+            return;
+
+        GPUProfileFrame& frame = p.mFrames[p.mCurrent];
+        p.mQueryCounter(frame.queries[p.mStack[depth] * 2 + 1], SGE_GL_TIMESTAMP);
+    }
+
+    int GPUProfiler::getFrameCount() { return GPUProfilerPrivate::instance().mResolved; }
+
+    int GPUProfiler::getDroppedFrameCount() { return GPUProfilerPrivate::instance().mDropped; }
+
+    void GPUProfiler::getLastFrameStats(Vector<ProfileStat>& stats)
+    {
+        GPUProfilerPrivate& p = GPUProfilerPrivate::instance();
+        GPUProfilerPrivate::toStats(p.mLastFrame, 1, stats);
+    }
+
+    void GPUProfiler::getAverageFrameStats(Vector<ProfileStat>& stats)
+    {
+        GPUProfilerPrivate& p = GPUProfilerPrivate::instance();
+        GPUProfilerPrivate::toStats(p.mAllFrames, p.mResolved, stats);
+    }
+
+    void GPUProfiler::logStats()
+    {
+        Vector<ProfileStat> stats;
+        getAverageFrameStats(stats);
+        Log::info("GPUProfiler average of %d frames, %d dropped:", getFrameCount(), getDroppedFrameCount());
+        Log::info("%-32s %8s %10s %10s %10s", "gpu zone", "calls", "total(ms)", "self(ms)", "max(ms)");
+        for (size_t i = 0; i < stats.size(); ++i)
+        {
+            const ProfileStat& stat = stats[i];
+            Log::info("%-32s %8.1f %10.3f %10.3f %10.3f", stat.name.c_str(),
+                stat.calls, stat.totalMs, stat.selfMs, stat.maxMs);
+        }
+    }
+
+    void GPUProfiler::reset()
+    {
+        GPUProfilerPrivate& p = GPUProfilerPrivate::instance();
+        p.mLastFrame.clear();
+        p.mAllFrames.clear();
+        p.mResolved = 0;
+        p.mDropped = 0;
+    }
+
+    void GPUProfiler::shutdown()
+    {
+        GPUProfilerPrivate& p = GPUProfilerPrivate::instance();
+        if (!p.mInitialized)
+            return;
+
+        for (int i = 0; i < SGE_GPU_PROFILER_FRAMES; ++i)
+        {
+            GPUProfileFrame& frame = p.mFrames[i];
+            for (int j = 0; j < SGE_GPU_PROFILER_MAX_ZONES * 2; ++j)
+            {
+                if (frame.queries[j])
+                {
+                    glDeleteQueries(1, &frame.queries[j]);
+                }
+            }
+            frame.count = 0;
+            frame.pending = false;
+        }
+        memset(p.mFrames, 0, sizeof(p.mFrames));
+        p.mInitialized = false;
+        p.mSupported = false;
+        p.mInFrame = false;
+    }
+
+}
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+    void GPUProfilerBegin(const char* name)
+    {
+        sge::GPUProfiler::begin(name);
+    }
+
+    void GPUProfilerEnd()
+    {
+        sge::GPUProfiler::end();
+    }
+
+    void GPUProfilerBeginFrame()
+    {
+        sge::GPUProfiler::beginFrame();
+    }
+
+    void GPUProfilerEndFrame()
+    {
+        sge::GPUProfiler::endFrame();
+    }
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -0,0 +1,495 @@
+/**
+ *
+ * Simple graphic engine
+ * "sge" libraiy is a simple graphics engine, named sge.
+ *
+ * sgeImageAtlas.cpp
+ * date: 2026/10/18
+ * author: xiang
+ *
+ * License
+ *
+ * Copyright (c) 2017-2019, Xiang Wencheng <xiangwencheng@outlook.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * - Neither the names of its contributors may be used to endorse or
+ *   promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <core/sgeImageAtlas.h>
+#include <core/sgeLog.h>
+#include <string.h>
+#include <algorithm>
+
+#include "../nanovg/nanovg.h"
+
+namespace sge
+{
+    /**
+     * A segment of the skyline, the page is free below y from x to x + width
+     */
+    struct AtlasNode
+    {
+        int x, y, width;
+    };
+
+    /**
+     * A page of the atlas, the pixels are kept to repack and to upload regions
+     */
+    struct AtlasPage
+    {
+        int                 image;
+        int                 flags;
+        int                 images;
+        int                 packedArea;
+        int                 liveArea;
+        Vector<AtlasNode>   skyline;
+        Vector<byte>        pixels;
+    };
+
+    /**
+     * A packed image, the rect includes the padding
+     */
+    struct AtlasEntry
+    {
+        int     page;   // -1 if free
+        int     x, y, w, h;
+    };
+
+    /**
+     * Orders the entries by height then width, descending
+     */
+    struct AtlasTallerFirst
+    {
+        const Vector<AtlasEntry>* entries;
+        bool operator()(int a, int b) const
+        {
+            const AtlasEntry& ea = (*entries)[a];
+            const AtlasEntry& eb = (*entries)[b];
+            return ea.h != eb.h ? ea.h > eb.h : ea.w > eb.w;
+        }
+    };
+
+    class ImageAtlasPrivate
+    {
+    public:
+        NVGcontext*         ctx;
+        int                 pageSize;
+        Vector<AtlasPage>   pages;
+        Vector<AtlasEntry>  entries;
+        Vector<int>         freeEntries;
+
+        /**
+         * The flags deciding the sampling of a page
+         */
+        static int pageFlags(int imageFlags)
+        {
+            return imageFlags & (NVG_IMAGE_PREMULTIPLIED | NVG_IMAGE_NEAREST);
+        }
+
+        static void resetSkyline(AtlasPage& page, int pageSize)
+        {
+            AtlasNode node = { 0, 0, pageSize };
+            page.skyline.clear();
+            page.skyline.push_back(node);
+            page.packedArea = 0;
+        }
+
+        /**
+         * Get the lowest y where a rect of width w fits starting at node i, -1 if not fit
+         */
+        int rectFits(const AtlasPage& page, int i, int w, int h) const
+        {
+            int x = page.skyline[i].x;
+            int y = page.skyline[i].y;
+            int spaceLeft;
+            if (x + w > pageSize)
+                return -1;
+            spaceLeft = w;
+            while (spaceLeft > 0)
+            {
+                if (i == (int)page.skyline.size())
+                    return -1;
+                y = std::max(y, page.skyline[i].y);
+                if (y + h > pageSize)
+                    return -1;
+                spaceLeft -= page.skyline[i].width;
+                ++i;
+            }
+            return y;
+        }
+
+        /**
+         * Insert a rect into the skyline at node i, shrinking the covered nodes
+         */
+        static void addSkylineLevel(AtlasPage& page, int i, int x, int y, int w, int h)
+        {
+            AtlasNode node = { x, y + h, w };
+            page.skyline.insert(page.skyline.begin() + i, node);
+
+            for (size_t j = i + 1; j < page.skyline.size(); ++j)
+            {
+                AtlasNode& prev = page.skyline[j - 1];
+                AtlasNode& cur = page.skyline[j];
+                if (cur.x >= prev.x + prev.width)
+                    break;
+                int shrink = prev.x + prev.width - cur.x;
+                cur.x += shrink;
+                cur.width -= shrink;
+                if (cur.width > 0)
+                    break;
+                page.skyline.erase(page.skyline.begin() + j);
+                --j;
+            }
+
+            // Merge same height skyline segments that are next to each other
+            for (size_t j = 0; j + 1 < page.skyline.size(); ++j)
+            {
+                if (page.skyline[j].y == page.skyline[j + 1].y)
+                {
+                    page.skyline[j].width += page.skyline[j + 1].width;
+                    page.skyline.erase(page.skyline.begin() + j + 1);
+                    --j;
+                }
+            }
+        }
+
+        /**
+         * Find the bottom left position of a rect, the lowest then the narrowest level
+         */
+        bool packRect(AtlasPage& page, int w, int h, int* rx, int* ry) const
+        {
+            int bestHeight = pageSize, bestWidth = pageSize, bestIndex = -1, bestX = -1, bestY = -1;
+            for (int i = 0; i < (int)page.skyline.size(); ++i)
+            {
+                int y = rectFits(page, i, w, h);
+                if (y == -1)
+                    continue;
+                if (y + h < bestHeight || (y + h == bestHeight && page.skyline[i].width < bestWidth))
+                {
+                    bestIndex = i;
+                    bestWidth = page.skyline[i].width;
+                    bestHeight = y + h;
+                    bestX = page.skyline[i].x;
+                    bestY = y;
+                }
+            }
+            if (bestIndex == -1)
+                return false;
+
+            addSkylineLevel(page, bestIndex, bestX, bestY, w, h);
+            page.packedArea += w * h;
+            *rx = bestX;
+            *ry = bestY;
+            return true;
+        }
+
+        /**
+         * Copy an image into the padded rect of its entry, the padding repeats the edge pixels
+         */
+        void blit(AtlasPage& page, const AtlasEntry& entry, const byte* rgbaData, bool flipY) const
+        {
+            int w = entry.w - 2, h = entry.h - 2;
+            for (int row = 0; row < entry.h; ++row)
+            {
+                int srcRow = std::min(std::max(row - 1, 0), h - 1);
+                if (flipY)
+                    srcRow = h - 1 - srcRow;
+                const byte* src = rgbaData + (size_t)srcRow * w * 4;
+                byte* dst = &page.pixels[((size_t)(entry.y + row) * pageSize + entry.x) * 4];
+                memcpy(dst, src, 4);
+                memcpy(dst + 4, src, (size_t)w * 4);
+                memcpy(dst + (size_t)(w + 1) * 4, src + (size_t)(w - 1) * 4, 4);
+            }
+        }
+
+        int createPage(int flags)
+        {
+            int index = 0;
+            while (index < (int)pages.size() && pages[index].image > 0)
+                ++index;
+            if (index == (int)pages.size())
+                pages.push_back(AtlasPage());
+
+            AtlasPage& page = pages[index];
+            page.flags = flags;
+            page.images = 0;
+            page.liveArea = 0;
+            page.pixels.assign((size_t)pageSize * pageSize * 4, 0);
+            resetSkyline(page, pageSize);
+            page.image = nvgCreateImageRGBA(ctx, pageSize, pageSize, flags, &page.pixels[0]);
+            if (page.image <= 0)
+            {
+                Log::error("ImageAtlas create page %dx%d failed", pageSize, pageSize);
+                page.image = 0;
+                Vector<byte>().swap(page.pixels);
+                return -1;
+            }
+            return index;
+        }
+
+        void deletePage(int index)
+        {
+            AtlasPage& page = pages[index];
+            nvgDeleteImage(ctx, page.image);
+            page.image = 0;
+            page.images = 0;
+            Vector<AtlasNode>().swap(page.skyline);
+            Vector<byte>().swap(page.pixels);
+        }
+
+        /**
+         * Repack the live images of the pages with flags into as few pages as possible,
+         * returns the number of images moved
+         */
+        int repack(int flags)
+        {
+            Vector<int> group, order;
+            for (int i = 0; i < (int)pages.size(); ++i)
+            {
+                if (pages[i].image > 0 && pages[i].flags == flags)
+                    group.push_back(i);
+            }
+            for (int i = 0; i < (int)entries.size(); ++i)
+            {
+                if (entries[i].page != -1 && pages[entries[i].page].flags == flags)
+                    order.push_back(i);
+            }
+
+            // Tallest first packs the skyline tightest
+            AtlasTallerFirst taller = { &entries };
+            std::sort(order.begin(), order.end(), taller);
+
+            Vector<AtlasPage> packed(group.size());
+            Vector<AtlasEntry> moved(entries);
+            size_t used = 0;
+            for (size_t i = 0; i < packed.size(); ++i)
+            {
+                packed[i].image = pages[group[i]].image;
+                packed[i].flags = flags;
+                packed[i].images = 0;
+                packed[i].liveArea = 0;
+                resetSkyline(packed[i], pageSize);
+            }
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                AtlasEntry& entry = moved[order[i]];
+                size_t p = 0;
+                int x = 0, y = 0;
+                while (p < packed.size() && !packRect(packed[p], entry.w, entry.h, &x, &y))
+                    ++p;
+                // The images fitted the pages before, only a worse packing fails
+                if (p == packed.size())
+                    return 0;
+                if (packed[p].pixels.empty())
+                    packed[p].pixels.assign((size_t)pageSize * pageSize * 4, 0);
+
+                const AtlasPage& src = pages[entry.page];
+                for (int row = 0; row < entry.h; ++row)
+                {
+                    memcpy(&packed[p].pixels[((size_t)(y + row) * pageSize + x) * 4],
+                        &src.pixels[((size_t)(entry.y + row) * pageSize + entry.x) * 4], (size_t)entry.w * 4);
+                }
+                entry.page = group[p];
+                entry.x = x;
+                entry.y = y;
+                packed[p].images++;
+                packed[p].liveArea += entry.w * entry.h;
+                used = std::max(used, p + 1);
+            }
+
+            int count = 0;
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                const AtlasEntry& a = entries[order[i]];
+                const AtlasEntry& b = moved[order[i]];
+                if (a.page != b.page || a.x != b.x || a.y != b.y)
+                    ++count;
+            }
+            entries.swap(moved);
+
+            for (size_t i = 0; i < packed.size(); ++i)
+            {
+                AtlasPage& page = pages[group[i]];
+                if (i >= used)
+                {
+                    deletePage(group[i]);
+                    continue;
+                }
+                page.skyline.swap(packed[i].skyline);
+                page.pixels.swap(packed[i].pixels);
+                page.images = packed[i].images;
+                page.packedArea = packed[i].packedArea;
+                page.liveArea = packed[i].liveArea;
+                nvgUpdateImage(ctx, page.image, &page.pixels[0]);
+            }
+            return count;
+        }
+    };
+
+    ImageAtlas::ImageAtlas(void* nativeCtx, int pageSize)
+        : d(new ImageAtlasPrivate())
+    {
+        d->ctx = (NVGcontext*)nativeCtx;
+        d->pageSize = pageSize;
+    }
+
+    ImageAtlas::~ImageAtlas()
+    {
+        if (d)
+        {
+            for (size_t i = 0; i < d->pages.size(); ++i)
+            {
+                if (d->pages[i].image > 0)
+                    nvgDeleteImage(d->ctx, d->pages[i].image);
+            }
+            delete d;
+            d = NULL;
+        }
+    }
+
+    int ImageAtlas::getPageSize() const
+    {
+        return d->pageSize;
+    }
+
+    bool ImageAtlas::canAdd(int w, int h, int imageFlags) const
+    {
+        const int ownTexture = NVG_IMAGE_GENERATE_MIPMAPS | NVG_IMAGE_REPEATX | NVG_IMAGE_REPEATY;
+        return w > 0 && h > 0 && w + 2 <= d->pageSize && h + 2 <= d->pageSize && (imageFlags & ownTexture) == 0;
+    }
+
+    int ImageAtlas::add(const byte* rgbaData, int w, int h, int imageFlags)
+    {
+        if (!canAdd(w, h, imageFlags))
+            return -1;
+
+        int flags = ImageAtlasPrivate::pageFlags(imageFlags);
+        AtlasEntry entry = { -1, 0, 0, w + 2, h + 2 };
+        for (int i = 0; i < (int)d->pages.size() && entry.page == -1; ++i)
+        {
+            AtlasPage& page = d->pages[i];
+            if (page.image > 0 && page.flags == flags && d->packRect(page, entry.w, entry.h, &entry.x, &entry.y))
+                entry.page = i;
+        }
+        if (entry.page == -1)
+        {
+            int i = d->createPage(flags);
+            if (i == -1 || !d->packRect(d->pages[i], entry.w, entry.h, &entry.x, &entry.y))
+                return -1;
+            entry.page = i;
+        }
+
+        AtlasPage& page = d->pages[entry.page];
+        d->blit(page, entry, rgbaData, (imageFlags & NVG_IMAGE_FLIPY) != 0);
+        nvgUpdateImageRegion(d->ctx, page.image, entry.x, entry.y, entry.w, entry.h, &page.pixels[0]);
+        page.images++;
+        page.liveArea += entry.w * entry.h;
+
+        int index;
+        if (!d->freeEntries.empty())
+        {
+            index = d->freeEntries.back();
+            d->freeEntries.pop_back();
+            d->entries[index] = entry;
+        }
+        else
+        {
+            index = (int)d->entries.size();
+            d->entries.push_back(entry);
+        }
+        return index;
+    }
+
+    void ImageAtlas::remove(int entry)
+    {
+        if (entry < 0 || entry >= (int)d->entries.size() || d->entries[entry].page == -1)
+            return;
+
+        AtlasEntry& e = d->entries[entry];
+        AtlasPage& page = d->pages[e.page];
+        page.images--;
+        page.liveArea -= e.w * e.h;
+        e.page = -1;
+        d->freeEntries.push_back(entry);
+    }
+
+    bool ImageAtlas::getRegion(int entry, Region* region) const
+    {
+        if (entry < 0 || entry >= (int)d->entries.size() || d->entries[entry].page == -1)
+            return false;
+
+        const AtlasEntry& e = d->entries[entry];
+        region->page = d->pages[e.page].image;
+        region->pageSize = d->pageSize;
+        region->x = e.x + 1;
+        region->y = e.y + 1;
+        region->w = e.w - 2;
+        region->h = e.h - 2;
+        return true;
+    }
+
+    int ImageAtlas::defragment(float wasteRatio)
+    {
+        int moved = 0;
+        int pageArea = d->pageSize * d->pageSize;
+        Vector<int> done;
+        for (int i = 0; i < (int)d->pages.size(); ++i)
+        {
+            const AtlasPage& page = d->pages[i];
+            if (page.image <= 0)
+                continue;
+            if (page.images == 0)
+            {
+                d->deletePage(i);
+                continue;
+            }
+            if (page.packedArea - page.liveArea < wasteRatio * pageArea)
+                continue;
+            if (std::find(done.begin(), done.end(), page.flags) != done.end())
+                continue;
+            done.push_back(page.flags);
+            moved += d->repack(page.flags);
+        }
+        return moved;
+    }
+
+    void ImageAtlas::getStats(int* pages, int* images) const
+    {
+        int npages = 0, nimages = 0;
+        for (size_t i = 0; i < d->pages.size(); ++i)
+        {
+            if (d->pages[i].image > 0)
+            {
+                npages++;
+                nimages += d->pages[i].images;
+            }
+        }
+        if (pages) *pages = npages;
+        if (images) *images = nimages;
+    }
+}
@@ -0,0 +1,216 @@
+/**
+ *
+ * Simple graphic engine
+ * "sge" libraiy is a simple graphics engine, named sge.
+ *
+ * sgeMappedFile.cpp
+ * date: 2026/10/18
+ * author: xiang
+ *
+ * License
+ *
+ * Copyright (c) 2017-2019, Xiang Wencheng <xiangwencheng@outlook.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * - Neither the names of its contributors may be used to endorse or
+ *   promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <core/sgeMappedFile.h>
+
+#ifdef _WIN32
+
+#include <Windows.h>
+
+namespace sge
+{
+
+    class MappedFilePrivate
+    {
+        HANDLE                  hFile;
+        HANDLE                  hMapping;
+        const unsigned char*    data;
+        size_t                  size;
+
+        friend class MappedFile;
+    };
+
+    MappedFile::MappedFile()
+        : d(new MappedFilePrivate())
+    {
+        d->hFile = INVALID_HANDLE_VALUE;
+        d->hMapping = NULL;
+        d->data = NULL;
+        d->size = 0;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (d)
+        {
+            close();
+            delete d;
+            d = NULL;
+        }
+    }
+
+    bool MappedFile::open(const char* fileName)
+    {
+        close();
+        d->hFile = ::CreateFileA(fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (d->hFile == INVALID_HANDLE_VALUE)
+            return false;
+
+        LARGE_INTEGER size;
+        if (!::GetFileSizeEx(d->hFile, &size) || size.QuadPart == 0)
+        {
+            close();
+            return false;
+        }
+        d->hMapping = ::CreateFileMappingA(d->hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (d->hMapping == NULL)
+        {
+            close();
+            return false;
+        }
+        d->data = (const unsigned char*)::MapViewOfFile(d->hMapping, FILE_MAP_READ, 0, 0, 0);
+        if (d->data == NULL)
+        {
+            close();
+            return false;
+        }
+        d->size = (size_t)size.QuadPart;
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (d->data)
+            ::UnmapViewOfFile(d->data);
+        if (d->hMapping)
+            ::CloseHandle(d->hMapping);
+        if (d->hFile != INVALID_HANDLE_VALUE)
+            ::CloseHandle(d->hFile);
+        d->hFile = INVALID_HANDLE_VALUE;
+        d->hMapping = NULL;
+        d->data = NULL;
+        d->size = 0;
+    }
+
+}
+
+#else
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace sge
+{
+
+    class MappedFilePrivate
+    {
+        const unsigned char*    data;
+        size_t                  size;
+
+        friend class MappedFile;
+    };
+
+    MappedFile::MappedFile()
+        : d(new MappedFilePrivate())
+    {
+        d->data = NULL;
+        d->size = 0;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (d)
+        {
+            close();
+            delete d;
+            d = NULL;
+        }
+    }
+
+    bool MappedFile::open(const char* fileName)
+    {
+        close();
+        int fd = ::open(fileName, O_RDONLY);
+        if (fd < 0)
+            return false;
+
+        // the mapping keeps the file, the descriptor is closed at once
+        struct stat st;
+        void* data = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            data = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        ::close(fd);
+        if (data == MAP_FAILED)
+            return false;
+
+        d->data = (const unsigned char*)data;
+        d->size = (size_t)st.st_size;
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (d->data)
+        {
+            munmap((void*)d->data, d->size);
+        }
+        d->data = NULL;
+        d->size = 0;
+    }
+
+}
+
+#endif
+
+namespace sge
+{
+
+    bool MappedFile::isOpen() const
+    {
+        return d->data != NULL;
+    }
+
+    const unsigned char* MappedFile::getData() const
+    {
+        return d->data;
+    }
+
+    size_t MappedFile::getSize() const
+    {
+        return d->size;
+    }
+
+}
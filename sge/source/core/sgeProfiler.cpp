@@ -0,0 +1,454 @@
+/**
+ *
+ * Simple graphic engine
+ * "sge" libraiy is a simple graphics engine, named sge.
+ *
+ * sgeProfiler.cpp
+ * date: 2026/10/17
+ * author: xiang
+ *
+ * License
+ *
+ * Copyright (c) 2017-2019, Xiang Wencheng <xiangwencheng@outlook.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * - Neither the names of its contributors may be used to endorse or
+ *   promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <core/sgeProfiler.h>
+#include <core/sgeMutex.h>
+#include <core/sgeThread.h>
+#include <core/sgeLog.h>
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <time.h>
+#endif
+
+// The max recorded zones for each thread, old zones will be overwritten
+#ifndef SGE_PROFILER_RING_SIZE
+#define SGE_PROFILER_RING_SIZE  (1 << 16)
+#endif
+
+// The max nested depth of zones
+#define SGE_PROFILER_MAX_DEPTH  64
+
+namespace sge
+{
+    struct ProfileEvent
+    {
+        const char* name;
+        long long   begin;
+        long long   end;
+        long long   self;
+        int         depth;
+    };
+
+    struct ProfileOpenZone
+    {
+        const char* name;
+        long long   begin;
+        long long   children;
+    };
+
+    struct ProfileAccum
+    {
+        int         calls;
+        long long   total;
+        long long   self;
+        long long   max;
+    };
+
+    class ProfileThread
+    {
+    public:
+        TID                 mTid;
+        // the track name, NULL for threads
+        const char*         mName;
+        Mutex               mMutex;
+        ProfileEvent*       mEvents;
+        unsigned long long  mWritten;
+        ProfileOpenZone     mStack[SGE_PROFILER_MAX_DEPTH];
+        int                 mDepth;
+
+        ProfileThread(TID tid, const char* name = NULL)
+            : mTid(tid)
+            , mName(name)
+            , mEvents(new ProfileEvent[SGE_PROFILER_RING_SIZE])
+            , mWritten(0)
+            , mDepth(0)
+        {}
+
+        ~ProfileThread()
+        {
+            delete[] mEvents;
+        }
+
+        // get the first event index still in ring
+        unsigned long long first() const
+        {
+            return mWritten > SGE_PROFILER_RING_SIZE ? mWritten - SGE_PROFILER_RING_SIZE : 0;
+        }
+
+        const ProfileEvent& at(unsigned long long index) const
+        {
+            return mEvents[index % SGE_PROFILER_RING_SIZE];
+        }
+    };
+
+    class ProfilerPrivate
+    {
+    public:
+        Mutex                       mMutex;
+        Vector<ProfileThread*>      mThreads;
+        bool                        mEnabled;
+        long long                   mStartTime;
+        long long                   mFrameBegin;
+        int                         mFrames;
+        Map<String, ProfileAccum>   mLastFrame;
+        Map<String, ProfileAccum>   mAllFrames;
+
+        ProfilerPrivate()
+            : mEnabled(true)
+            , mStartTime(Profiler::now())
+            , mFrameBegin(0)
+            , mFrames(0)
+        {}
+
+        ~ProfilerPrivate()
+        {
+            for (size_t i = 0; i < mThreads.size(); ++i)
+            {
+                delete mThreads[i];
+            }
+            mThreads.clear();
+        }
+
+        static ProfilerPrivate& instance()
+        {
+            static ProfilerPrivate profiler;
+            return profiler;
+        }
+
+        static ProfileThread* currentThread()
+        {
+            static thread_local ProfileThread* thread = NULL;
+            if (thread == NULL)
+            {
+                thread = new ProfileThread(Thread::getCurrentThreadId());
+                ProfilerPrivate& p = instance();
+                ScopeLock lock(p.mMutex);
+                p.mThreads.push_back(thread);
+            }
+            return thread;
+        }
+
+        ProfileThread* getTrack(const char* name)
+        {
+            ScopeLock lock(mMutex);
+            for (size_t i = 0; i < mThreads.size(); ++i)
+            {
+                if (mThreads[i]->mName && strcmp(mThreads[i]->mName, name) == 0)
+                    return mThreads[i];
+            }
+            // tracks use small ids which never be used by real threads
+            ProfileThread* track = new ProfileThread((TID)(mThreads.size() + 1), name);
+            mThreads.push_back(track);
+            return track;
+        }
+    };
+
+    static void accumulate(Map<String, ProfileAccum>& accums, const ProfileEvent& event)
+    {
+        ProfileAccum& accum = accums[event.name];
+        long long duration = event.end - event.begin;
+        accum.calls++;
+        accum.total += duration;
+        accum.self += event.self;
+        accum.max = std::max(accum.max, duration);
+    }
+
+    static void toStats(const Map<String, ProfileAccum>& accums, int frames, Vector<ProfileStat>& stats)
+    {
+        stats.clear();
+        if (frames <= 0)
+            return;
+
+        for (Map<String, ProfileAccum>::const_iterator it = accums.begin(); it != accums.end(); ++it)
+        {
+            ProfileStat stat;
+            stat.name = it->first;
+            stat.calls = (float)it->second.calls / frames;
+            stat.totalMs = (float)(it->second.total / 1000000.0 / frames);
+            stat.selfMs = (float)(it->second.self / 1000000.0 / frames);
+            stat.maxMs = (float)(it->second.max / 1000000.0);
+            stats.push_back(stat);
+        }
+
+        std::sort(stats.begin(), stats.end(),
+            [](const ProfileStat& a, const ProfileStat& b) { return a.totalMs > b.totalMs; });
+    }
+
+    long long Profiler::now()
+    {
+#ifdef _WIN32
+        static LARGE_INTEGER freq = { 0 };
+        if (freq.QuadPart == 0)
+        {
+            QueryPerformanceFrequency(&freq);
+        }
+        LARGE_INTEGER counter;
+        QueryPerformanceCounter(&counter);
+        return (long long)(counter.QuadPart * (1000000000.0 / freq.QuadPart));
+#else
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+#endif
+    }
+
+    void Profiler::setEnabled(bool enable) { ProfilerPrivate::instance().mEnabled = enable; }
+
+    bool Profiler::isEnabled() { return ProfilerPrivate::instance().mEnabled; }
+
+    void Profiler::begin(const char* name)
+    {
+        if (!ProfilerPrivate::instance().mEnabled)
+            return;
+
+        ProfileThread* thread = ProfilerPrivate::currentThread();
+        if (thread->mDepth < SGE_PROFILER_MAX_DEPTH)
+        {
+            ProfileOpenZone& zone = thread->mStack[thread->mDepth];
+            zone.name = name;
+            zone.children = 0;
+            zone.begin = now();
+        }
+        thread->mDepth++;
+    }
+
+    void Profiler::end()
+    {
+        if (!ProfilerPrivate::instance().mEnabled)
+            return;
+
+        ProfileThread* thread = ProfilerPrivate::currentThread();
+        if (thread->mDepth <= 0)
+            return;
+
+        int depth = --thread->mDepth;
+        if (depth >= SGE_PROFILER_MAX_DEPTH)
+            return;
+
+        const ProfileOpenZone& zone = thread->mStack[depth];
+        ProfileEvent event;
+        event.name = zone.name;
+        event.begin = zone.begin;
+        event.end = now();
+        event.self = (event.end - event.begin) - zone.children;
+        event.depth = depth;
+        if (depth > 0)
+        {
+            thread->mStack[depth - 1].children += event.end - event.begin;
+        }
+
+        ScopeLock lock(thread->mMutex);
+        thread->mEvents[thread->mWritten % SGE_PROFILER_RING_SIZE] = event;
+        thread->mWritten++;
+    }
+
+    void Profiler::record(const char* track, const char* name, long long begin, long long end)
+    {
+        ProfilerPrivate& p = ProfilerPrivate::instance();
+        if (!p.mEnabled)
+            return;
+
+        ProfileThread* thread = p.getTrack(track);
+        ProfileEvent event;
+        event.name = name;
+        event.begin = begin;
+        event.end = end;
+        event.self = end - begin;
+        event.depth = 0;
+
+        ScopeLock lock(thread->mMutex);
+        thread->mEvents[thread->mWritten % SGE_PROFILER_RING_SIZE] = event;
+        thread->mWritten++;
+    }
+
+    void Profiler::beginFrame()
+    {
+        ProfilerPrivate& p = ProfilerPrivate::instance();
+        if (!p.mEnabled)
+            return;
+
+        p.mFrameBegin = now();
+        begin("Frame");
+    }
+
+    void Profiler::endFrame()
+    {
+        ProfilerPrivate& p = ProfilerPrivate::instance();
+        if (!p.mEnabled)
+            return;
+
+        end();
+
+        ScopeLock lock(p.mMutex);
+        p.mLastFrame.clear();
+        for (size_t i = 0; i < p.mThreads.size(); ++i)
+        {
+            ProfileThread* thread = p.mThreads[i];
+            if (thread->mName)
+                continue;
+            ScopeLock threadLock(thread->mMutex);
+            // events are ordered by end time, scan back to the frame begin
+            unsigned long long first = thread->first();
+            for (unsigned long long index = thread->mWritten; index > first; --index)
+            {
+                const ProfileEvent& event = thread->at(index - 1);
+                if (event.end < p.mFrameBegin)
+                    break;
+                if (event.begin >= p.mFrameBegin)
+                {
+                    accumulate(p.mLastFrame, event);
+                    accumulate(p.mAllFrames, event);
+                }
+            }
+        }
+        p.mFrames++;
+    }
+
+    int Profiler::getFrameCount() { return ProfilerPrivate::instance().mFrames; }
+
+    void Profiler::getLastFrameStats(Vector<ProfileStat>& stats)
+    {
+        ProfilerPrivate& p = ProfilerPrivate::instance();
+        ScopeLock lock(p.mMutex);
+        toStats(p.mLastFrame, 1, stats);
+    }
+
+    void Profiler::getAverageFrameStats(Vector<ProfileStat>& stats)
+    {
+        ProfilerPrivate& p = ProfilerPrivate::instance();
+        ScopeLock lock(p.mMutex);
+        toStats(p.mAllFrames, p.mFrames, stats);
+    }
+
+    void Profiler::logStats()
+    {
+        Vector<ProfileStat> stats;
+        getAverageFrameStats(stats);
+        Log::info("Profiler average of %d frames:", getFrameCount());
+        Log::info("%-32s %8s %10s %10s %10s", "zone", "calls", "total(ms)", "self(ms)", "max(ms)");
+        for (size_t i = 0; i < stats.size(); ++i)
+        {
+            const ProfileStat& stat = stats[i];
+            Log::info("%-32s %8.1f %10.3f %10.3f %10.3f", stat.name.c_str(),
+                stat.calls, stat.totalMs, stat.selfMs, stat.maxMs);
+        }
+    }
+
+    bool Profiler::exportChromeTrace(const char* file)
+    {
+        ASSERT(file);
+        FILE* fp = fopen(file, "wb");
+        if (!fp)
+        {
+            Log::error("Profiler can not open %s", file);
+            return false;
+        }
+
+        ProfilerPrivate& p = ProfilerPrivate::instance();
+        ScopeLock lock(p.mMutex);
+        bool first = true;
+        fprintf(fp, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        for (size_t i = 0; i < p.mThreads.size(); ++i)
+        {
+            ProfileThread* thread = p.mThreads[i];
+            ScopeLock threadLock(thread->mMutex);
+            if (thread->mName)
+            {
+                fprintf(fp, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", (unsigned long)thread->mTid, thread->mName);
+                first = false;
+            }
+            for (unsigned long long index = thread->first(); index < thread->mWritten; ++index)
+            {
+                const ProfileEvent& event = thread->at(index);
+                fprintf(fp, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}",
+                    first ? "" : ",\n", event.name, thread->mName ? thread->mName : "cpu", (unsigned long)thread->mTid,
+                    (event.begin - p.mStartTime) / 1000.0, (event.end - event.begin) / 1000.0);
+                first = false;
+            }
+        }
+        fprintf(fp, "\n]}\n");
+        fclose(fp);
+        return true;
+    }
+
+    void Profiler::reset()
+    {
+        ProfilerPrivate& p = ProfilerPrivate::instance();
+        ScopeLock lock(p.mMutex);
+        for (size_t i = 0; i < p.mThreads.size(); ++i)
+        {
+            ProfileThread* thread = p.mThreads[i];
+            ScopeLock threadLock(thread->mMutex);
+            thread->mWritten = 0;
+        }
+        p.mLastFrame.clear();
+        p.mAllFrames.clear();
+        p.mFrames = 0;
+    }
+
+}
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+    void ProfilerBegin(const char* name)
+    {
+        sge::Profiler::begin(name);
+    }
+
+    void ProfilerEnd()
+    {
+        sge::Profiler::end();
+    }
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
@@ -1,5 +1,15 @@
 #include <core/sgeRenderer.h>
 #include <core/sgeGLContext.h>
+#include <core/sgeProfiler.h>
+#include <core/sgeThread.h>
+#include <core/sgeSemaphore.h>
+#include <core/sgeMutex.h>
+#include <core/sgeMappedFile.h>
+#include <core/sgeImageAtlas.h>
+#include <core/sgeLog.h>
+#include <image/stb_image.h>
+#include <algorithm>
+#include <climits>
 
 #ifdef USE_NVG_GL3
     #ifdef OPENGLES
@@ -15,18 +25,28 @@
     #endif
 #endif
 
+#ifdef OPENGLES
+#include <GLES2/gl2ext.h>
+#endif
+
 #include "../nanovg/nanovg.h"
 #include "../nanovg/nanovg_gl.h"
 
 namespace sge
 {
-    RendererImage::RendererImage(Renderer* renderer, int imageId)
+    RendererImage::RendererImage(Renderer* renderer, int imageId, int atlasEntry)
         : mRenderer(renderer)
         , mImageId(imageId)
+        , mAtlasEntry(atlasEntry)
     {}
 
     RendererImage::~RendererImage()
     {
+        if (mRenderer && mAtlasEntry >= 0)
+        {
+            mRenderer->mImageAtlas->remove(mAtlasEntry);
+            mAtlasEntry = -1;
+        }
         if (mRenderer && mImageId >= 0)
         {
             nvgDeleteImage((NVGcontext*)mRenderer->mNativeCtx, mImageId);
@@ -34,17 +54,508 @@ namespace sge
         }
     }
 
-    inline int2 RendererImage::getImageSize()
+    int2 RendererImage::getImageSize()
     {
         int2 size;
+        ImageAtlas::Region region;
+        if (mAtlasEntry >= 0 && mRenderer->mImageAtlas->getRegion(mAtlasEntry, &region))
+            return int2(region.w, region.h);
         nvgImageSize((NVGcontext*)mRenderer->mNativeCtx, mImageId, &size.x, &size.y);
         return size;
     }
 
-    inline RendererPaint::RendererPaint() {}
+    bool RendererImage::isPacked() const
+    {
+        return mAtlasEntry >= 0;
+    }
+
+    RendererPaint::RendererPaint() {}
+
+    /**
+     * Worker threads running the nanovg tessellation chunks,
+     * the calling thread runs a share of the chunks too
+     */
+    class TessellationPool
+    {
+    public:
+        TessellationPool(int threads)
+            : mTask(NULL)
+            , mData(NULL)
+            , mCount(0)
+            , mQuit(false)
+            , mDone(0)
+        {
+            for (int i = 1; i < threads; ++i)
+            {
+                Worker* worker = new Worker(this, i);
+                Runable runable;
+                runable.bind<Worker>(worker, &Worker::run);
+                worker->mThread = new Thread(runable);
+                worker->mThread->start();
+                mWorkers.push_back(worker);
+            }
+        }
+
+        ~TessellationPool()
+        {
+            mQuit = true;
+            for (size_t i = 0; i < mWorkers.size(); ++i)
+            {
+                mWorkers[i]->mStart.set();
+            }
+            for (size_t i = 0; i < mWorkers.size(); ++i)
+            {
+                mWorkers[i]->mThread->join();
+                delete mWorkers[i]->mThread;
+                delete mWorkers[i];
+            }
+        }
+
+        int getThreadCount() const
+        {
+            return (int)mWorkers.size() + 1;
+        }
+
+        static void parallelFor(void* uptr, NVGtaskFunc task, void* data, int count)
+        {
+            TessellationPool* pool = (TessellationPool*)uptr;
+            int wakes = std::min(pool->getThreadCount(), count) - 1;
+            pool->mTask = task;
+            pool->mData = data;
+            pool->mCount = count;
+            for (int i = 0; i < wakes; ++i)
+            {
+                pool->mWorkers[i]->mStart.set();
+            }
+            pool->runTasks(0);
+            for (int i = 0; i < wakes; ++i)
+            {
+                pool->mDone.wait();
+            }
+        }
+
+    private:
+        struct Worker
+        {
+            TessellationPool*   mPool;
+            int                 mIndex;
+            Thread*             mThread;
+            Semaphore           mStart;
+
+            Worker(TessellationPool* pool, int index)
+                : mPool(pool), mIndex(index), mThread(NULL), mStart(0)
+            {}
+
+            int run()
+            {
+                while (true)
+                {
+                    mStart.wait();
+                    if (mPool->mQuit)
+                        return 0;
+                    mPool->runTasks(mIndex);
+                    mPool->mDone.set();
+                }
+            }
+        };
+
+        void runTasks(int first)
+        {
+            for (int i = first; i < mCount; i += getThreadCount())
+            {
+                mTask(mData, i);
+            }
+        }
+
+        NVGtaskFunc     mTask;
+        void*           mData;
+        int             mCount;
+        volatile bool   mQuit;
+        Semaphore       mDone;
+        Vector<Worker*> mWorkers;
+        DISABLE_COPY(TessellationPool)
+    };
+
+    /**
+     * Worker threads rasterizing the glyphs missing from the nanovg font atlas,
+     * the finished glyphs are collected by the rendering thread
+     */
+    class GlyphRasterPool
+    {
+    public:
+        GlyphRasterPool(int threads)
+            : mHead(0)
+            , mRunning(0)
+            , mWaiting(false)
+            , mQuit(false)
+            , mQueued(0)
+            , mFinished(0)
+        {
+            for (int i = 0; i < threads; ++i)
+            {
+                Runable runable;
+                runable.bind<GlyphRasterPool>(this, &GlyphRasterPool::run);
+                Thread* thread = new Thread(runable);
+                thread->start();
+                mThreads.push_back(thread);
+            }
+        }
+
+        ~GlyphRasterPool()
+        {
+            mQuit = true;
+            mQueued.set((long)mThreads.size());
+            for (size_t i = 0; i < mThreads.size(); ++i)
+            {
+                mThreads[i]->join();
+                delete mThreads[i];
+            }
+        }
+
+        int getThreadCount() const
+        {
+            return (int)mThreads.size();
+        }
+
+        static void submit(void* uptr, NVGtaskFunc task, void* data)
+        {
+            GlyphRasterPool* pool = (GlyphRasterPool*)uptr;
+            {
+                ScopeLock lock(pool->mMutex);
+                Task t = { task, data };
+                pool->mTasks.push_back(t);
+            }
+            pool->mQueued.set();
+        }
+
+        static int collect(void* uptr, void** data, int max, int wait)
+        {
+            GlyphRasterPool* pool = (GlyphRasterPool*)uptr;
+            while (wait)
+            {
+                {
+                    ScopeLock lock(pool->mMutex);
+                    if (pool->isIdle())
+                        break;
+                    pool->mWaiting = true;
+                }
+                pool->mFinished.wait();
+            }
+
+            ScopeLock lock(pool->mMutex);
+            int count = std::min(max, (int)pool->mDone.size());
+            std::copy(pool->mDone.begin(), pool->mDone.begin() + count, data);
+            pool->mDone.erase(pool->mDone.begin(), pool->mDone.begin() + count);
+            return count;
+        }
+
+    private:
+        struct Task
+        {
+            NVGtaskFunc task;
+            void*       data;
+        };
+
+        bool isIdle() const
+        {
+            return mHead == mTasks.size() && mRunning == 0;
+        }
+
+        int run()
+        {
+            while (true)
+            {
+                mQueued.wait();
+                if (mQuit)
+                    return 0;
+
+                Task task;
+                {
+                    ScopeLock lock(mMutex);
+                    task = mTasks[mHead++];
+                    if (mHead == mTasks.size())
+                    {
+                        mTasks.clear();
+                        mHead = 0;
+                    }
+                    mRunning++;
+                }
+                task.task(task.data, 0);
+
+                bool wake;
+                {
+                    ScopeLock lock(mMutex);
+                    mDone.push_back(task.data);
+                    mRunning--;
+                    wake = mWaiting && isIdle();
+                    if (wake)
+                        mWaiting = false;
+                }
+                if (wake)
+                    mFinished.set();
+            }
+        }
+
+        Mutex           mMutex;
+        Vector<Task>    mTasks;
+        size_t          mHead;
+        Vector<void*>   mDone;
+        int             mRunning;
+        bool            mWaiting;
+        volatile bool   mQuit;
+        Semaphore       mQueued;
+        Semaphore       mFinished;
+        Vector<Thread*> mThreads;
+        DISABLE_COPY(GlyphRasterPool)
+    };
+
+    /**
+     * Font files mapped once in the process and shared by the renderers,
+     * a file is unmapped when the last renderer using it is deleted
+     */
+    class SharedFontFiles
+    {
+    public:
+        static MappedFile* acquire(const char* fileName)
+        {
+            ScopeLock lock(getMutex());
+            Vector<Entry>& entries = getEntries();
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                if (entries[i].path == fileName)
+                {
+                    entries[i].refs++;
+                    return entries[i].file;
+                }
+            }
+
+            MappedFile* file = new MappedFile();
+            if (!file->open(fileName) || file->getSize() > INT_MAX)
+            {
+                delete file;
+                return NULL;
+            }
+            Entry entry = { fileName, file, 1 };
+            entries.push_back(entry);
+            return file;
+        }
+
+        static void release(MappedFile* file)
+        {
+            ScopeLock lock(getMutex());
+            Vector<Entry>& entries = getEntries();
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                if (entries[i].file == file && --entries[i].refs == 0)
+                {
+                    delete file;
+                    entries.erase(entries.begin() + i);
+                    return;
+                }
+            }
+        }
+
+        static void getStats(int* files, size_t* bytes)
+        {
+            ScopeLock lock(getMutex());
+            Vector<Entry>& entries = getEntries();
+            *files = (int)entries.size();
+            *bytes = 0;
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                *bytes += entries[i].file->getSize();
+            }
+        }
+
+    private:
+        struct Entry
+        {
+            std::string path;
+            MappedFile* file;
+            int         refs;
+        };
+
+        static Mutex& getMutex()
+        {
+            static Mutex mutex;
+            return mutex;
+        }
+
+        static Vector<Entry>& getEntries()
+        {
+            static Vector<Entry> entries;
+            return entries;
+        }
+    };
+
+    RendererDisplayList::RendererDisplayList()
+        : mList(nvgCreateDisplayList())
+    {
+        ASSERT(mList);
+    }
+
+    RendererDisplayList::~RendererDisplayList()
+    {
+        nvgDeleteDisplayList((NVGdisplayList*)mList);
+    }
+
+    bool RendererDisplayList::isEmpty() const
+    {
+        return nvgDisplayListEmpty((NVGdisplayList*)mList) != 0;
+    }
+
+    void RendererDisplayList::clear()
+    {
+        nvgClearDisplayList((NVGdisplayList*)mList);
+    }
+
+    void RendererDisplayList::setScaleTolerance(float tolerance)
+    {
+        nvgDisplayListScaleTolerance((NVGdisplayList*)mList, tolerance);
+    }
+
+    int RendererDisplayList::getTessellationCount() const
+    {
+        return nvgDisplayListTessellations((NVGdisplayList*)mList);
+    }
+
+    RendererPolyline::RendererPolyline()
+        : mLine(nvgCreatePolyline())
+    {
+        ASSERT(mLine);
+    }
+
+    RendererPolyline::~RendererPolyline()
+    {
+        nvgDeletePolyline((NVGpolyline*)mLine);
+    }
+
+    bool RendererPolyline::setPoints(const float2* pts, size_t count)
+    {
+        if (count > INT_MAX)
+        {
+            Log::error("Polyline of %u K points is too large", (unsigned)(count >> 10));
+            nvgPolylinePoints((NVGpolyline*)mLine, NULL, 0);
+            return false;
+        }
+        return nvgPolylinePoints((NVGpolyline*)mLine, (const float*)pts, (int)count) != 0;
+    }
+
+    int RendererPolyline::getStrokedCount() const
+    {
+        return nvgPolylineStrokedCount((NVGpolyline*)mLine);
+    }
+
+    /**
+     * Offscreen layers, the released ones are kept for the layers
+     * of the same or a bit smaller size
+     */
+    class LayerPool
+    {
+    public:
+        LayerPool(NVGcontext* ctx)
+            : mCtx(ctx)
+        {
+        }
+
+        ~LayerPool()
+        {
+            for (size_t i = 0; i < mLayers.size(); ++i)
+            {
+                nvgDeleteImage(mCtx, mLayers[i].image);
+            }
+        }
+
+        int acquire(int width, int height)
+        {
+            if (width <= 0 || height <= 0)
+                return 0;
+
+            // round up the size, so views resized a little reuse the layer
+            width = (width + LAYER_GRANULARITY - 1) / LAYER_GRANULARITY * LAYER_GRANULARITY;
+            height = (height + LAYER_GRANULARITY - 1) / LAYER_GRANULARITY * LAYER_GRANULARITY;
+
+            int best = -1;
+            for (size_t i = 0; i < mLayers.size(); ++i)
+            {
+                const Layer& layer = mLayers[i];
+                if (layer.used || layer.width < width || layer.height < height
+                    || layer.width * layer.height > 2 * width * height)
+                    continue;
+                if (best < 0 || layer.width * layer.height < mLayers[best].width * mLayers[best].height)
+                    best = (int)i;
+            }
+            if (best >= 0)
+            {
+                mLayers[best].used = true;
+                return mLayers[best].image;
+            }
+
+            int image = nvgCreateImageRGBA(mCtx, width, height,
+                NVG_IMAGE_RENDER_TARGET | NVG_IMAGE_FLIPY | NVG_IMAGE_PREMULTIPLIED, NULL);
+            if (image == 0)
+            {
+                Log::error("Create %dx%d layer failed", width, height);
+                return 0;
+            }
+            Layer layer = { image, width, height, true };
+            mLayers.push_back(layer);
+            return image;
+        }
+
+        void release(int image)
+        {
+            int unused = 0;
+            for (size_t i = 0; i < mLayers.size(); ++i)
+            {
+                if (mLayers[i].image == image)
+                    mLayers[i].used = false;
+                if (!mLayers[i].used)
+                    ++unused;
+            }
+
+            // keep a few for reuse
+            if (unused > LAYER_MAX_UNUSED)
+            {
+                for (size_t i = 0; i < mLayers.size(); ++i)
+                {
+                    if (mLayers[i].image == image)
+                    {
+                        nvgDeleteImage(mCtx, image);
+                        mLayers.erase(mLayers.begin() + i);
+                        break;
+                    }
+                }
+            }
+        }
+
+    private:
+        enum
+        {
+            LAYER_GRANULARITY = 32,
+            LAYER_MAX_UNUSED = 4,
+        };
+
+        struct Layer
+        {
+            int     image;
+            int     width;
+            int     height;
+            bool    used;
+        };
+
+        NVGcontext*     mCtx;
+        Vector<Layer>   mLayers;
+    };
 
     Renderer::Renderer()
         : mNativeCtx(NULL)
+        , mTessPool(NULL)
+        , mGlyphPool(NULL)
+        , mLayerPool(NULL)
+        , mImageAtlas(NULL)
+        , mAtlasMaxSize(0)
+        , mPolyline(NULL)
     {
         int flag = NVG_ANTIALIAS | NVG_STENCIL_STROKES;
 #ifdef _DEBUG
@@ -66,6 +577,14 @@ namespace sge
     {
         if (mNativeCtx)
         {
+            setTessellationThreads(1);
+            setGlyphRasterThreads(0);
+            delete mPolyline;
+            mPolyline = NULL;
+            delete mImageAtlas;
+            mImageAtlas = NULL;
+            delete mLayerPool;
+            mLayerPool = NULL;
 #if defined NANOVG_GL2
             nvgDeleteGL2((NVGcontext*)mNativeCtx);
 #elif defined NANOVG_GL3
@@ -76,141 +595,212 @@ namespace sge
             nvgDeleteGLES3((NVGcontext*)mNativeCtx);
 #endif
             mNativeCtx = NULL;
+            // the fonts are deleted, unmap their files
+            for (size_t i = 0; i < mFontFiles.size(); ++i)
+            {
+                SharedFontFiles::release(mFontFiles[i]);
+            }
+            mFontFiles.clear();
         }
     }
 
-    inline int Renderer::save()
+    int Renderer::save()
     {
         return nvgSave((NVGcontext*)mNativeCtx);
     }
 
-    inline void Renderer::restore(int index)
+    void Renderer::restore(int index)
     {
         nvgRestore((NVGcontext*)mNativeCtx, index);
     }
 
-    inline void Renderer::reset()
+    void Renderer::reset()
     {
         nvgReset((NVGcontext*)mNativeCtx);
     }
 
-    inline void Renderer::setShapeAntiAlias(bool enable)
+    void Renderer::setShapeAntiAlias(bool enable)
     {
         nvgShapeAntiAlias((NVGcontext*)mNativeCtx, enable ? 1 : 0);
     }
 
-    inline void Renderer::setStrokeColor(float r, float g, float b, float a)
+    void Renderer::setStrokeColor(float r, float g, float b, float a)
     {
         nvgStrokeColor((NVGcontext*)mNativeCtx, nvgRGBAf(r, g, b, a));
     }
 
-    inline void Renderer::setStrokePaint(const RendererPaint& paint)
+    void Renderer::setStrokePaint(const RendererPaint& paint)
     {
         nvgStrokePaint((NVGcontext*)mNativeCtx, *(NVGpaint*)&paint);
     }
 
-    inline void Renderer::setFillColor(float r, float g, float b, float a)
+    void Renderer::setFillColor(float r, float g, float b, float a)
     {
         nvgFillColor((NVGcontext*)mNativeCtx, nvgRGBAf(r, g, b, a));
     }
 
-    inline void Renderer::setFillColor(const float4& color)
+    void Renderer::setFillColor(const float4& color)
     {
         nvgFillColor((NVGcontext*)mNativeCtx, *(NVGcolor*)&color);
     }
 
-    inline void Renderer::setFillPaint(const RendererPaint& paint)
+    void Renderer::setFillPaint(const RendererPaint& paint)
     {
         nvgFillPaint((NVGcontext*)mNativeCtx, *(NVGpaint*)&paint);
     }
 
-    inline void Renderer::setMiterLimit(float limit)
+    void Renderer::setMiterLimit(float limit)
     {
         nvgMiterLimit((NVGcontext*)mNativeCtx, limit);
     }
 
-    inline void Renderer::setStrokeWidth(float size)
+    void Renderer::setStrokeWidth(float size)
     {
         nvgStrokeWidth((NVGcontext*)mNativeCtx, size);
     }
 
-    inline void Renderer::setLineCap(LineCapType type)
+    void Renderer::setLineCap(LineCapType type)
     {
         nvgLineCap((NVGcontext*)mNativeCtx, type);
     }
 
-    inline void Renderer::setLineJoin(LineJoinType type)
+    void Renderer::setLineJoin(LineJoinType type)
     {
         nvgLineJoin((NVGcontext*)mNativeCtx, type);
     }
 
-    inline void Renderer::globalAlpha(float alpha)
+    void Renderer::globalAlpha(float alpha)
     {
         nvgGlobalAlpha((NVGcontext*)mNativeCtx, alpha);
     }
 
-    inline void Renderer::resetTransform()
+    void Renderer::resetTransform()
     {
         nvgResetTransform((NVGcontext*)mNativeCtx);
     }
 
-    inline void Renderer::doTransform(const float* xform)
+    void Renderer::doTransform(const float* xform)
     {
         nvgTransform((NVGcontext*)mNativeCtx, xform[0], xform[1], xform[2], xform[3], xform[4], xform[5]);
     }
 
-    inline void Renderer::getCurrentTransform(float * out_xform)
+    void Renderer::getCurrentTransform(float * out_xform)
     {
         nvgCurrentTransform((NVGcontext*)mNativeCtx, out_xform);
     }
 
-    inline void Renderer::doTranslate(float x, float y)
+    void Renderer::doTranslate(float x, float y)
     {
         nvgTranslate((NVGcontext*)mNativeCtx, x, y);
     }
 
-    inline void Renderer::doRotate(float angle)
+    void Renderer::doRotate(float angle)
     {
         nvgRotate((NVGcontext*)mNativeCtx, DEG2RAD(angle));
     }
 
-    inline void Renderer::doSkewX(float angle)
+    void Renderer::doSkewX(float angle)
     {
         nvgSkewX((NVGcontext*)mNativeCtx, DEG2RAD(angle));
     }
 
-    inline void Renderer::doSkewY(float angle)
+    void Renderer::doSkewY(float angle)
     {
         nvgSkewY((NVGcontext*)mNativeCtx, DEG2RAD(angle));
     }
 
-    inline void Renderer::doScale(float x, float y)
+    void Renderer::doScale(float x, float y)
     {
         nvgScale((NVGcontext*)mNativeCtx, x, y);
     }
 
 
-    inline RendererImage Renderer::loadImage(const char* file, int imageFlag)
+    /**
+     * Pack the image if the atlas is enabled and it is small enough, returns the atlas entry or -1
+     */
+    static int packImage(ImageAtlas* atlas, int maxSize, const byte* rgbaData, int w, int h, int imageFlags)
+    {
+        if (maxSize <= 0 || w > maxSize || h > maxSize)
+            return -1;
+        return atlas->add(rgbaData, w, h, imageFlags);
+    }
+
+    RendererImage Renderer::loadImage(const char* file, int imageFlag)
     {
         //TODO: return RefPtr if found in cache map
+        if (mAtlasMaxSize > 0)
+        {
+            int w, h, n;
+            byte* data = stbi_load(file, &w, &h, &n, 4);
+            if (data == NULL)
+            {
+                Log::error("Failed to load %s - %s", file, stbi_failure_reason());
+                return RendererImage(this, 0);
+            }
+            int atlasEntry = packImage(mImageAtlas, mAtlasMaxSize, data, w, h, imageFlag);
+            int imageId = atlasEntry < 0 ? nvgCreateImageRGBA((NVGcontext*)mNativeCtx, w, h, imageFlag, data) : -1;
+            stbi_image_free(data);
+            return RendererImage(this, imageId, atlasEntry);
+        }
         int imageId = nvgCreateImage((NVGcontext*)mNativeCtx, file, imageFlag);
         return RendererImage(this, imageId);
     }
 
 
-    inline RendererImage Renderer::loadImage(byte* fileData, size_t dataLen, int imageFlag)
+    RendererImage Renderer::loadImage(byte* fileData, size_t dataLen, int imageFlag)
     {
         //TODO: return RefPtr if found in cache map
+        if (mAtlasMaxSize > 0)
+        {
+            int w, h, n;
+            byte* data = stbi_load_from_memory(fileData, (int)dataLen, &w, &h, &n, 4);
+            if (data == NULL)
+            {
+                Log::error("Failed to load image - %s", stbi_failure_reason());
+                return RendererImage(this, 0);
+            }
+            int atlasEntry = packImage(mImageAtlas, mAtlasMaxSize, data, w, h, imageFlag);
+            int imageId = atlasEntry < 0 ? nvgCreateImageRGBA((NVGcontext*)mNativeCtx, w, h, imageFlag, data) : -1;
+            stbi_image_free(data);
+            return RendererImage(this, imageId, atlasEntry);
+        }
         int imageId = nvgCreateImageMem((NVGcontext*)mNativeCtx, imageFlag, fileData, dataLen);
         return RendererImage(this, imageId);
     }
 
-    inline RendererImage Renderer::loadImage(const byte* rgbaData, int w, int h, int imageFlags)
+    RendererImage Renderer::loadImage(const byte* rgbaData, int w, int h, int imageFlags)
     {
         //TODO: return RefPtr if found in cache map
+        int atlasEntry = packImage(mImageAtlas, mAtlasMaxSize, rgbaData, w, h, imageFlags);
+        if (atlasEntry >= 0)
+            return RendererImage(this, -1, atlasEntry);
         int imageId = nvgCreateImageRGBA((NVGcontext*)mNativeCtx, w, h, imageFlags, rgbaData);
         return RendererImage(this, imageId);
     }
+
+    void Renderer::setImageAtlas(int maxImageSize, int pageSize)
+    {
+        int images = 0;
+        if (mImageAtlas)
+            mImageAtlas->getStats(NULL, &images);
+        if (mImageAtlas == NULL || (images == 0 && mImageAtlas->getPageSize() != pageSize))
+        {
+            delete mImageAtlas;
+            mImageAtlas = new ImageAtlas(mNativeCtx, pageSize);
+        }
+        mAtlasMaxSize = std::min(maxImageSize, mImageAtlas->getPageSize() - 2);
+    }
+
+    void Renderer::getImageAtlasStats(int* pages, int* images) const
+    {
+        if (mImageAtlas)
+        {
+            mImageAtlas->getStats(pages, images);
+            return;
+        }
+        if (pages) *pages = 0;
+        if (images) *images = 0;
+    }
     
     RendererPaint Renderer::createLinearGradient(float sx, float sy, float ex, float ey,
         const float4& icol, const float4& ocol)
@@ -245,200 +835,546 @@ namespace sge
         *(NVGpaint*)&paint = nvgImagePattern((NVGcontext*)mNativeCtx, ox, oy, ex, ey, angle, image, alpha);
         return paint;
     }
+
+    RendererPaint Renderer::createImagePattern(float ox, float oy, float ex, float ey,
+        float angle, const RendererImage& image, float alpha)
+    {
+        ImageAtlas::Region region;
+        if (image.mAtlasEntry < 0 || !mImageAtlas->getRegion(image.mAtlasEntry, &region))
+            return createImagePattern(ox, oy, ex, ey, angle, image.mImageId, alpha);
+
+        // Scale the pattern to the page and move its origin to the page corner, in the rotated space
+        float sx = region.x * ex / region.w;
+        float sy = region.y * ey / region.h;
+        float cs = cosf(angle), sn = sinf(angle);
+        return createImagePattern(ox - (cs * sx - sn * sy), oy - (sn * sx + cs * sy),
+            ex * region.pageSize / region.w, ey * region.pageSize / region.h, angle, region.page, alpha);
+    }
     
-    inline void Renderer::addScissor(float x, float y, float w, float h)
+    void Renderer::drawPrimitives(const RendererPrimitive* prims, int count)
+    {
+        // the same layout as NVGprimitive, as float4 is NVGcolor
+        nvgPrimitives((NVGcontext*)mNativeCtx, (const NVGprimitive*)prims, count);
+    }
+
+    void Renderer::drawRoundedRect(float x, float y, float w, float h, float radius,
+        const float4& fillColor, float borderWidth, const float4& borderColor)
+    {
+        RendererPrimitive prim = { PrimitiveRect, x, y, w, h, radius, borderWidth, 0.0f, fillColor, borderColor };
+        drawPrimitives(&prim, 1);
+    }
+
+    void Renderer::drawCircle(float cx, float cy, float radius,
+        const float4& fillColor, float borderWidth, const float4& borderColor)
+    {
+        RendererPrimitive prim = { PrimitiveRect, cx - radius, cy - radius, radius * 2, radius * 2, radius,
+            borderWidth, 0.0f, fillColor, borderColor };
+        drawPrimitives(&prim, 1);
+    }
+
+    void Renderer::drawLine(float x0, float y0, float x1, float y1, float width, const float4& color)
+    {
+        RendererPrimitive prim = { PrimitiveLine, x0, y0, x1, y1, width * 0.5f, 0.0f, 0.0f, color, color };
+        drawPrimitives(&prim, 1);
+    }
+
+    void Renderer::drawShadow(float x, float y, float w, float h, float radius, float blur, const float4& color)
+    {
+        RendererPrimitive prim = { PrimitiveRect, x, y, w, h, radius, 0.0f, blur, color, color };
+        drawPrimitives(&prim, 1);
+    }
+
+    bool Renderer::setPrimitiveInstancing(bool enable)
+    {
+        return nvgInstancedPrimitives((NVGcontext*)mNativeCtx, enable ? 1 : 0) != 0;
+    }
+
+    void Renderer::drawPolyline(RendererPolyline& line)
+    {
+        SGE_PROFILE_ZONE("Renderer::drawPolyline");
+        nvgStrokePolyline((NVGcontext*)mNativeCtx, (NVGpolyline*)line.mLine);
+    }
+
+    void Renderer::drawPolyline(const float2* pts, size_t count)
+    {
+        if (mPolyline == NULL)
+            mPolyline = new RendererPolyline();
+        if (mPolyline->setPoints(pts, count))
+            drawPolyline(*mPolyline);
+    }
+
+    int Renderer::acquireLayer(int width, int height)
+    {
+        if (mLayerPool == NULL)
+            mLayerPool = new LayerPool((NVGcontext*)mNativeCtx);
+        return mLayerPool->acquire(width, height);
+    }
+
+    void Renderer::releaseLayer(int layer)
+    {
+        if (mLayerPool && layer != 0)
+            mLayerPool->release(layer);
+    }
+
+    bool Renderer::beginLayer(int layer)
+    {
+        return layer != 0 && nvgBeginLayer((NVGcontext*)mNativeCtx, layer) != 0;
+    }
+
+    void Renderer::endLayer()
+    {
+        nvgEndLayer((NVGcontext*)mNativeCtx);
+    }
+
+    void Renderer::drawLayer(int layer, float x, float y, float width, float height, float alpha)
+    {
+        NVGcontext* ctx = (NVGcontext*)mNativeCtx;
+        int w = 0, h = 0;
+        nvgImageSize(ctx, layer, &w, &h);
+        int saveCount = nvgSave(ctx);
+        nvgBeginPath(ctx);
+        nvgRect(ctx, x, y, width, height);
+        nvgFillPaint(ctx, nvgImagePattern(ctx, x, y, (float)w, (float)h, 0, layer, alpha));
+        nvgFill(ctx);
+        nvgRestore(ctx, saveCount);
+    }
+
+    void Renderer::addScissor(float x, float y, float w, float h)
     {
         nvgScissor((NVGcontext*)mNativeCtx, x, y, w, h);
     }
 
-    inline void Renderer::addIntersectScissor(float x, float y, float w, float h)
+    void Renderer::addIntersectScissor(float x, float y, float w, float h)
     {
         nvgIntersectScissor((NVGcontext*)mNativeCtx, x, y, w, h);
     }
 
-    inline void Renderer::resetScissor()
+    void Renderer::resetScissor()
     {
         nvgResetScissor((NVGcontext*)mNativeCtx);
     }
 
-    inline void Renderer::beginFrame(float w, float h, float dpi)
+    void Renderer::beginFrame(float w, float h, float dpi)
     {
+        // Paints of the last frame are done, the packed images may move
+        if (mImageAtlas)
+            mImageAtlas->defragment();
         nvgBeginFrame((NVGcontext*)mNativeCtx, w, h, dpi);
     }
 
     void Renderer::endFrame()
     {
+        SGE_PROFILE_ZONE("Renderer::endFrame");
         nvgEndFrame((NVGcontext*)mNativeCtx);
     }
 
-    inline void Renderer::cancelFrame()
+    void Renderer::cancelFrame()
     {
         nvgCancelFrame((NVGcontext*)mNativeCtx);
     }
 
+    void Renderer::setDeferred(bool deferred)
+    {
+        nvglSetDeferred((NVGcontext*)mNativeCtx, deferred ? 1 : 0);
+    }
+
+    void* Renderer::createFrame()
+    {
+        return nvglCreateFrame();
+    }
+
+    void Renderer::deleteFrame(void* frame)
+    {
+        nvglDeleteFrame((NVGLframe*)frame);
+    }
+
+    void Renderer::swapFrame(void* frame)
+    {
+        nvglSwapFrame((NVGcontext*)mNativeCtx, (NVGLframe*)frame);
+    }
+
+    void Renderer::renderFrame(void* frame)
+    {
+        nvglRenderFrame((NVGcontext*)mNativeCtx, (NVGLframe*)frame);
+    }
+
 
-    inline void Renderer::beginPath()
+    void Renderer::beginPath()
     {
         nvgBeginPath((NVGcontext*)mNativeCtx);
     }
 
-    inline void Renderer::moveTo(float x, float y)
+    void Renderer::moveTo(float x, float y)
     {
         nvgMoveTo((NVGcontext*)mNativeCtx, x, y);
     }
 
-    inline void Renderer::lineTo(float x, float y)
+    void Renderer::lineTo(float x, float y)
     {
         nvgLineTo((NVGcontext*)mNativeCtx, x, y);
     }
 
-    inline void Renderer::bezierTo(float c1x, float c1y, float c2x, float c2y, float x, float y)
+    void Renderer::bezierTo(float c1x, float c1y, float c2x, float c2y, float x, float y)
     {
         nvgBezierTo((NVGcontext*)mNativeCtx, c1x, c1y, c2x, c2y, x, y);
     }
 
-    inline void Renderer::quadTo(float c1x, float c1y, float x, float y)
+    void Renderer::quadTo(float c1x, float c1y, float x, float y)
     {
         nvgQuadTo((NVGcontext*)mNativeCtx, c1x, c1y, x, y);
     }
 
-    inline void Renderer::arcTo(float x1, float y1, float x2, float y2, float radius)
+    void Renderer::arcTo(float x1, float y1, float x2, float y2, float radius)
     {
         nvgArcTo((NVGcontext*)mNativeCtx, x1, y1, x2, y2, radius);
     }
 
-    inline void Renderer::closePath()
+    void Renderer::closePath()
     {
         nvgClosePath((NVGcontext*)mNativeCtx);
     }
 
-    inline void Renderer::pathWinding(bool solid)
+    void Renderer::pathWinding(bool solid)
     {
         nvgPathWinding((NVGcontext*)mNativeCtx, solid ? NVG_SOLID : NVG_HOLE);
     }
 
-    inline void Renderer::arc(float centerX, float centerY, float radius, float startAngle, float endAngle, bool ccw)
+    void Renderer::arc(float centerX, float centerY, float radius, float startAngle, float endAngle, bool ccw)
     {
         nvgArc((NVGcontext*)mNativeCtx, centerX, centerY, radius, startAngle, endAngle, ccw ? NVG_CCW : NVG_CW);
     }
 
-    inline void Renderer::rect(float x, float y, float w, float h)
+    void Renderer::rect(float x, float y, float w, float h)
     {
         nvgRect((NVGcontext*)mNativeCtx, x, y, w, h);
     }
 
-    inline void Renderer::roundedRect(float x, float y, float w, float h, float radTopLeft, float radTopRight, float radBottomRight, float radBottomLeft)
+    void Renderer::roundedRect(float x, float y, float w, float h, float radTopLeft, float radTopRight, float radBottomRight, float radBottomLeft)
     {
         nvgRoundedRectVarying((NVGcontext*)mNativeCtx, x, y, w, h, radTopLeft, radTopRight, radBottomRight, radBottomLeft);
     }
 
-    inline void Renderer::ellipse(float cx, float cy, float rx, float ry)
+    void Renderer::ellipse(float cx, float cy, float rx, float ry)
     {
         nvgEllipse((NVGcontext*)mNativeCtx, cx, cy, rx, ry);
     }
 
-    inline void Renderer::circle(float cx, float cy, float radius)
+    void Renderer::circle(float cx, float cy, float radius)
     {
         nvgCircle((NVGcontext*)mNativeCtx, cx, cy, radius);
     }
 
-    inline void Renderer::fillPath()
+    void Renderer::fillPath()
     {
         nvgFill((NVGcontext*)mNativeCtx);
     }
 
-    inline void Renderer::strokePath()
+    void Renderer::strokePath()
     {
         nvgStroke((NVGcontext*)mNativeCtx);
     }
     
-    inline int Renderer::loadFont(const char* name, const char* filename)
+    int Renderer::loadFont(const char* name, const char* filename)
     {
-        return nvgCreateFont((NVGcontext*)mNativeCtx, name, filename);
+        // the font reads the shared mapping in place, read the file if it can not be mapped
+        MappedFile* file = SharedFontFiles::acquire(filename);
+        if (file == NULL)
+            return nvgCreateFont((NVGcontext*)mNativeCtx, name, filename);
+
+        int font = nvgCreateFontMem((NVGcontext*)mNativeCtx, name, (unsigned char*)file->getData(), (int)file->getSize(), 0);
+        if (font < 0)
+        {
+            SharedFontFiles::release(file);
+            return font;
+        }
+        mFontFiles.push_back(file);
+        return font;
     }
 
-    inline int Renderer::loadFontMem(const char* name, unsigned char* data, int ndata, int freeData)
+    void Renderer::getMappedFontStats(int* files, int* kilobytes)
+    {
+        int count;
+        size_t bytes;
+        SharedFontFiles::getStats(&count, &bytes);
+        if (files) *files = count;
+        if (kilobytes) *kilobytes = (int)(bytes >> 10);
+    }
+
+    int Renderer::loadFontMem(const char* name, unsigned char* data, int ndata, int freeData)
     {
         return nvgCreateFontMem((NVGcontext*)mNativeCtx, name, data, ndata, freeData);
     }
     
-    inline int Renderer::findFont(const char* name)
+    int Renderer::findFont(const char* name)
     {
         return nvgFindFont((NVGcontext*)mNativeCtx, name);
     }
 
-    inline int Renderer::addFallbackFontId(int baseFont, int fallbackFont)
+    int Renderer::addFallbackFontId(int baseFont, int fallbackFont)
     {
         return nvgAddFallbackFontId((NVGcontext*)mNativeCtx, baseFont, fallbackFont);
     }
 
-    inline int Renderer::addFallbackFont(const char* baseFont, const char* fallbackFont)
+    int Renderer::addFallbackFont(const char* baseFont, const char* fallbackFont)
     {
         return nvgAddFallbackFont((NVGcontext*)mNativeCtx, baseFont, fallbackFont);
     }
 
-    inline void Renderer::setFontSize(float size)
+    void Renderer::setFontSize(float size)
     {
         nvgFontSize((NVGcontext*)mNativeCtx, size);
     }
 
-    inline void Renderer::setFontBlur(float blur)
+    void Renderer::setFontBlur(float blur)
     {
         nvgFontBlur((NVGcontext*)mNativeCtx, blur);
     }
 
-    inline void Renderer::setTextLetterSpacing(float spacing)
+    bool Renderer::setTextSDF(bool enable)
+    {
+        return nvgTextSDF((NVGcontext*)mNativeCtx, enable ? 1 : 0) != 0;
+    }
+
+    void Renderer::setTextLetterSpacing(float spacing)
     {
         nvgTextLetterSpacing((NVGcontext*)mNativeCtx, spacing);
     }
 
-    inline void Renderer::setTextLineHeight(float lineHeight)
+    void Renderer::setTextLineHeight(float lineHeight)
     {
         nvgTextLineHeight((NVGcontext*)mNativeCtx, lineHeight);
     }
 
-    inline void Renderer::setTextAlign(Alignment align)
+    void Renderer::setTextAlign(Alignment align)
     {
         nvgTextAlign((NVGcontext*)mNativeCtx, align);
     }
 
-    inline void Renderer::setFont(int font)
+    void Renderer::setFont(int font)
     {
         nvgFontFaceId((NVGcontext*)mNativeCtx, font);
     }
 
-    inline void Renderer::setFont(const char* font)
+    void Renderer::setFont(const char* font)
     {
         nvgFontFace((NVGcontext*)mNativeCtx, font);
     }
     
-    inline float Renderer::drawText(float x, float y, const char* string, const char* end)
+    float Renderer::drawText(float x, float y, const char* string, const char* end)
     {
         return nvgText((NVGcontext*)mNativeCtx, x, y, string, end);
     }
 
-    inline void Renderer::drawTextBox(float x, float y, float breakRowWidth, const char* string, const char* end)
+    void Renderer::drawTextBox(float x, float y, float breakRowWidth, const char* string, const char* end)
     {
         nvgTextBox((NVGcontext*)mNativeCtx, x, y, breakRowWidth, string, end);
     }
 
-    inline float Renderer::measureText(float x, float y, const char* string, const char* end, float* bounds)
+    float Renderer::measureText(float x, float y, const char* string, const char* end, float* bounds)
     {
         return nvgTextBounds((NVGcontext*)mNativeCtx, x, y, string, end, bounds);
     }
 
-    inline void Renderer::measureTextBox(float x, float y, float breakRowWidth, const char* string, const char* end, float* bounds)
+    void Renderer::measureTextBox(float x, float y, float breakRowWidth, const char* string, const char* end, float* bounds)
     {
         nvgTextBoxBounds((NVGcontext*)mNativeCtx, x, y, breakRowWidth, string, end, bounds);
     }
 
     //void Renderer::textGlyphPositions(float x, float y, const char* string, const char* end, NVGglyphPosition* positions, int maxPositions);
 
-    inline void Renderer::getTextMetrics(float* ascender, float* descender, float* lineh)
+    void Renderer::getTextMetrics(float* ascender, float* descender, float* lineh)
     {
         nvgTextMetrics((NVGcontext*)mNativeCtx, ascender, descender, lineh);
     }
     
+    void Renderer::beginDisplayList(RendererDisplayList& list)
+    {
+        nvgBeginDisplayList((NVGcontext*)mNativeCtx, (NVGdisplayList*)list.mList);
+    }
+
+    void Renderer::endDisplayList()
+    {
+        nvgEndDisplayList((NVGcontext*)mNativeCtx);
+    }
+
+    void Renderer::drawDisplayList(RendererDisplayList& list)
+    {
+        nvgDrawDisplayList((NVGcontext*)mNativeCtx, (NVGdisplayList*)list.mList);
+    }
+
+    void Renderer::drawDisplayList(RendererDisplayList& list, const float* xform)
+    {
+        NVGcontext* ctx = (NVGcontext*)mNativeCtx;
+        int state = nvgSave(ctx);
+        nvgTransform(ctx, xform[0], xform[1], xform[2], xform[3], xform[4], xform[5]);
+        nvgDrawDisplayList(ctx, (NVGdisplayList*)list.mList);
+        nvgRestore(ctx, state);
+    }
+
+    void Renderer::setTessellationThreads(int count)
+    {
+        if (count <= 0)
+            count = Thread::getProcessorCount();
+        if (count == getTessellationThreads())
+            return;
+
+        nvgParallelTessellation((NVGcontext*)mNativeCtx, NULL, NULL, 0);
+        if (mTessPool)
+        {
+            delete mTessPool;
+            mTessPool = NULL;
+        }
+        if (count > 1)
+        {
+            mTessPool = new TessellationPool(count);
+            nvgParallelTessellation((NVGcontext*)mNativeCtx, &TessellationPool::parallelFor, mTessPool, count);
+        }
+    }
+
+    int Renderer::getTessellationThreads() const
+    {
+        return mTessPool ? mTessPool->getThreadCount() : 1;
+    }
+
+    bool Renderer::setSimdEnabled(bool enable)
+    {
+        return nvgSimdLevel(enable ? nvgSimdSupported() : NVG_SIMD_NONE) != NVG_SIMD_NONE;
+    }
+
+    bool Renderer::isSimdEnabled()
+    {
+        return nvgGetSimdLevel() != NVG_SIMD_NONE;
+    }
+
+    void Renderer::setDrawCallMerging(bool enable)
+    {
+        nvglSetMergeCalls((NVGcontext*)mNativeCtx, enable ? 1 : 0);
+    }
+
+    void Renderer::getDrawCallStats(int* calls, int* merged) const
+    {
+        nvglFrameStats((NVGcontext*)mNativeCtx, calls, merged);
+    }
+
+    void Renderer::getMemoryStats(int* used, int* peak, int* growths) const
+    {
+        NVGarenaStats context, backend;
+        nvgMemoryStats((NVGcontext*)mNativeCtx, &context);
+        nvglMemoryStats((NVGcontext*)mNativeCtx, &backend);
+        if (used) *used = context.used + backend.used;
+        if (peak) *peak = context.peak + backend.peak;
+        if (growths) *growths = context.growths + backend.growths;
+    }
+
+    void Renderer::getGlyphCacheStats(int* pages, int* hits, int* misses, int* evictions) const
+    {
+        NVGglyphCacheStats stats;
+        nvgGlyphCacheStats((NVGcontext*)mNativeCtx, &stats);
+        if (pages) *pages = stats.pages;
+        if (hits) *hits = stats.hits;
+        if (misses) *misses = stats.misses;
+        if (evictions) *evictions = stats.evictions;
+    }
+
+    void Renderer::setTextLayoutCache(bool enable)
+    {
+        nvgTextLayoutCache((NVGcontext*)mNativeCtx, enable ? 1 : 0);
+    }
+
+    void Renderer::getTextLayoutStats(int* layouts, int* hits, int* misses) const
+    {
+        NVGtextLayoutStats stats;
+        nvgTextLayoutStats((NVGcontext*)mNativeCtx, &stats);
+        if (layouts) *layouts = stats.layouts;
+        if (hits) *hits = stats.hits;
+        if (misses) *misses = stats.misses;
+    }
+
+    void Renderer::setGlyphRasterThreads(int count)
+    {
+        if (count < 0)
+            count = Thread::getProcessorCount();
+        if (count == getGlyphRasterThreads())
+            return;
+
+        nvgAsyncGlyphs((NVGcontext*)mNativeCtx, NULL, NULL, NULL);
+        if (mGlyphPool)
+        {
+            delete mGlyphPool;
+            mGlyphPool = NULL;
+        }
+        if (count > 0)
+        {
+            mGlyphPool = new GlyphRasterPool(count);
+            nvgAsyncGlyphs((NVGcontext*)mNativeCtx, &GlyphRasterPool::submit, &GlyphRasterPool::collect, mGlyphPool);
+        }
+    }
+
+    int Renderer::getGlyphRasterThreads() const
+    {
+        return mGlyphPool ? mGlyphPool->getThreadCount() : 0;
+    }
+
+    int Renderer::getGlyphPlaceholderCount() const
+    {
+        return nvgGlyphPlaceholders((NVGcontext*)mNativeCtx);
+    }
+
+    int Renderer::prewarmGlyphs(const unsigned int* ranges, int count)
+    {
+        return nvgPrewarmGlyphs((NVGcontext*)mNativeCtx, ranges, count);
+    }
+
+    GlyphRasterizer Renderer::setGlyphRasterizer(GlyphRasterizer rasterizer)
+    {
+        return (GlyphRasterizer)nvgGlyphRasterizer((NVGcontext*)mNativeCtx, rasterizer);
+    }
+
+    int Renderer::saveGlyphCache(const char* filename)
+    {
+        int count = nvgSaveGlyphCache((NVGcontext*)mNativeCtx, filename);
+        if (count < 0)
+        {
+            Log::error("Failed to write glyph cache %s", filename);
+        }
+        return count;
+    }
+
+    int Renderer::loadGlyphCache(const char* filename)
+    {
+        // the pages are copied to the atlas, the mapping is not kept
+        MappedFile file;
+        if (!file.open(filename))
+            return -1;
+        if (file.getSize() > (size_t)INT_MAX)
+        {
+            Log::error("Glyph cache %s is too large", filename);
+            return -1;
+        }
+
+        int count = nvgLoadGlyphCache((NVGcontext*)mNativeCtx, file.getData(), (int)file.getSize());
+        if (count < 0)
+        {
+            Log::error("Glyph cache %s is invalid or does not match the font atlas", filename);
+        }
+        return count;
+    }
+
+    void Renderer::setScissorCulling(bool enable)
+    {
+        nvgScissorCulling((NVGcontext*)mNativeCtx, enable ? 1 : 0);
+    }
+
+    int Renderer::getCulledCount() const
+    {
+        return nvgCulledCount((NVGcontext*)mNativeCtx);
+    }
+
+    BufferStreamMode Renderer::setBufferStreamMode(BufferStreamMode mode)
+    {
+        return (BufferStreamMode)nvglSetStreamMode((NVGcontext*)mNativeCtx, mode);
+    }
+
     //void Renderer::textBreakLines(const char* string, const char* end, float breakRowWidth, NVGtextRow* rows, int maxRows);
 
 }
\ No newline at end of file
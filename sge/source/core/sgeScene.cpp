@@ -43,8 +43,13 @@
 #include <core/sgeScene.h>
 #include <core/sgeApplication.h>
 #include <core/sgeRenderer.h>
+#include <core/sgeProfiler.h>
 #include <ui/sgeView.h>
 #include <ui/sgeViewGroup.h>
+#include <algorithm>
+
+// the max buffer age can be redrawn partially
+#define DAMAGE_HISTORY  3
 
 namespace sge
 {
@@ -55,17 +60,99 @@ namespace sge
         RefPtr<ui::View>    mDecor;
         int2                mSize;
         float4              mBrushColor;
+        bool                mDirty;
+
+        // damage of next frame and the previous frames, (left, top, right, bottom)
+        bool                mFullDamage;
+        int4                mDamage;
+        int4                mDamageHistory[DAMAGE_HISTORY];
+        // region redrawn by last frame, (x, y, width, height)
+        int4                mDamageRect;
 
         ScenePrivate(Application* app)
             : mApp(app)
             , mDecor(NULL)
             , mSize(1, 1)
             , mBrushColor(0.2f, 0.2f, 0.2f, 1.0f)
-        {}
+            , mDirty(true)
+            , mFullDamage(true)
+            , mDamage(0, 0, 0, 0)
+            , mDamageRect(0, 0, 1, 1)
+        {
+            for (int i = 0; i < DAMAGE_HISTORY; ++i)
+            {
+                mDamageHistory[i] = int4(0, 0, 0, 0);
+            }
+        }
 
         ~ScenePrivate()
         {
         }
+
+        static bool isEmpty(const int4& rect)
+        {
+            return rect.z <= rect.x || rect.w <= rect.y;
+        }
+
+        static void unite(int4& rect, const int4& other)
+        {
+            if (isEmpty(other))
+                return;
+            if (isEmpty(rect))
+            {
+                rect = other;
+                return;
+            }
+            // int4 is packed, compare copies of the fields, std::min and std::max
+            // would bind references to misaligned members
+            int left = other.x, top = other.y, right = other.z, bottom = other.w;
+            int x = rect.x, y = rect.y, z = rect.z, w = rect.w;
+            rect.x = left < x ? left : x;
+            rect.y = top < y ? top : y;
+            rect.z = right > z ? right : z;
+            rect.w = bottom > w ? bottom : w;
+        }
+
+        /**
+         * Pick the region to redraw for the back buffer of the age,
+         * and push the damage of this frame into the history
+         * @return The region, (left, top, right, bottom)
+         */
+        int4 takeDamageRegion(int bufferAge)
+        {
+            int4 full(0, 0, mSize.x, mSize.y);
+            int4 damage = full;
+            if (!mFullDamage)
+            {
+                int left = mDamage.x, top = mDamage.y, right = mDamage.z, bottom = mDamage.w;
+                damage.x = left > 0 ? left : 0;
+                damage.y = top > 0 ? top : 0;
+                damage.z = right < full.z ? right : full.z;
+                damage.w = bottom < full.w ? bottom : full.w;
+                if (isEmpty(damage))
+                    damage = int4(0, 0, 0, 0);
+            }
+
+            // the back buffer misses the damage of the frames after it
+            int4 region = full;
+            if (bufferAge > 0 && bufferAge <= DAMAGE_HISTORY + 1)
+            {
+                region = damage;
+                for (int i = 0; i < bufferAge - 1; ++i)
+                {
+                    unite(region, mDamageHistory[i]);
+                }
+            }
+
+            for (int i = DAMAGE_HISTORY - 1; i > 0; --i)
+            {
+                mDamageHistory[i] = mDamageHistory[i - 1];
+            }
+            mDamageHistory[0] = damage;
+            mDamage = int4(0, 0, 0, 0);
+            mFullDamage = false;
+            return region;
+        }
     };
 
     Scene::Scene(Application* app_not_null)
@@ -83,9 +170,26 @@ namespace sge
         }
     }
 
-    inline const float4 & Scene::getBrushColor() { return d->mBrushColor; }
+    const float4 & Scene::getBrushColor() { return d->mBrushColor; }
+
+    const int2 & Scene::getSize() { return d->mSize; }
+
+    void Scene::setBrushColor(const float4 & color) { d->mBrushColor = color; invalidate(); }
+
+    void Scene::invalidate() { d->mDirty = true; d->mFullDamage = true; }
+
+    void Scene::invalidate(int x, int y, int width, int height)
+    {
+        d->mDirty = true;
+        if (width > 0 && height > 0)
+        {
+            ScenePrivate::unite(d->mDamage, int4(x, y, x + width, y + height));
+        }
+    }
+
+    const int4 & Scene::getDamageRect() { return d->mDamageRect; }
 
-    inline void Scene::setBrushColor(const float4 & color) { d->mBrushColor = color; }
+    bool Scene::isDirty() { return d->mDirty; }
 
     void Scene::onLoad()
     {
@@ -127,20 +231,74 @@ namespace sge
         platform->mOnResizeEvent.bind(NULL);
     }
 
-    void Scene::onRender()
+    void Scene::onRender(int bufferAge)
     {
-        glClearColor(d->mBrushColor.x, d->mBrushColor.y, d->mBrushColor.z, d->mBrushColor.w);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glViewport(0, 0, d->mSize.x, d->mSize.y);
-
-        // draw models
-        onRenderModel();
+        SGE_PROFILE_ZONE("Scene::onRender");
+        // nothing invalidated while redraw continuous, the damage is unknown
+        if (!d->mDirty)
+        {
+            d->mFullDamage = true;
+        }
+        // clear before draw, invalidate while rendering request next frame
+        d->mDirty = false;
+        int4 region = d->takeDamageRegion(bufferAge);
+        d->mDamageRect = int4(region.x, region.y, region.z - region.x, region.w - region.y);
+        bool partial = region.x != 0 || region.y != 0 || region.z != d->mSize.x || region.w != d->mSize.y;
+
+        // the render thread draws background with the submitted frame
+        if (!d->mApp->isRenderThreadEnabled())
+        {
+            onRenderBackground(d->mBrushColor, d->mSize, d->mDamageRect);
+        }
 
-        // draw ui
+        // draw ui, the paths outside of damage region are culled by the scissor
         Renderer* renderer = d->mApp->getRenderer();
         renderer->beginFrame((float)d->mSize.x, (float)d->mSize.y);
-        onRenderUI();
+        if (partial)
+        {
+            renderer->addScissor((float)d->mDamageRect.x, (float)d->mDamageRect.y,
+                (float)d->mDamageRect.z, (float)d->mDamageRect.w);
+        }
+        {
+            SGE_PROFILE_ZONE("Scene::onRenderUI");
+            onRenderUI();
+        }
         renderer->endFrame();
+
+        // redraw the glyphs drawn without bitmap once they are rasterized
+        if (renderer->getGlyphPlaceholderCount() > 0)
+        {
+            invalidate();
+        }
+    }
+
+    void Scene::onRenderBackground(const float4& color, const int2& size, const int4& damage)
+    {
+        // keep the pixels outside of damage region, the rect of GL is from bottom left
+        bool partial = damage.x != 0 || damage.y != 0 || damage.z != size.x || damage.w != size.y;
+        if (partial)
+        {
+            glEnable(GL_SCISSOR_TEST);
+            glScissor(damage.x, size.y - damage.y - damage.w, damage.z, damage.w);
+        }
+
+        SGE_GPU_PROFILE_BEGIN("Scene::clear");
+        glClearColor(color.x, color.y, color.z, color.w);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glViewport(0, 0, size.x, size.y);
+        SGE_GPU_PROFILE_END();
+
+        // draw models
+        {
+            SGE_PROFILE_ZONE("Scene::onRenderModel");
+            SGE_GPU_PROFILE_ZONE("Scene::onRenderModel");
+            onRenderModel();
+        }
+
+        if (partial)
+        {
+            glDisable(GL_SCISSOR_TEST);
+        }
     }
 
     void Scene::onRenderModel()
@@ -152,18 +310,27 @@ namespace sge
         if (d->mDecor.get())
         {
             // do measure the gui
-            d->mDecor->doMeasure(ui::UNSPECIFIED, d->mSize.x, ui::UNSPECIFIED, d->mSize.y);
+            {
+                SGE_PROFILE_ZONE("View::doMeasure");
+                d->mDecor->doMeasure(ui::UNSPECIFIED, d->mSize.x, ui::UNSPECIFIED, d->mSize.y);
+            }
             // do layout the gui
-            RefPtr<ui::LayoutParams> params = d->mDecor->getLayoutParams();
-            int measuredWidth = d->mDecor->getMeasuredWidth();
-            int measuredHeight = d->mDecor->getMeasuredHeight();
-            d->mDecor->doLayout(0, 0, measuredWidth, measuredHeight);
+            {
+                SGE_PROFILE_ZONE("View::doLayout");
+                RefPtr<ui::LayoutParams> params = d->mDecor->getLayoutParams();
+                int measuredWidth = d->mDecor->getMeasuredWidth();
+                int measuredHeight = d->mDecor->getMeasuredHeight();
+                d->mDecor->doLayout(0, 0, measuredWidth, measuredHeight);
+            }
             // do draw the gui
-            d->mDecor->doDraw();
+            {
+                SGE_PROFILE_ZONE("View::doDraw");
+                d->mDecor->doDraw();
+            }
         }
     }
 
-    inline void Scene::setRootView(RefPtr<ui::View> view) 
+    void Scene::setRootView(RefPtr<ui::View> view) 
     {
         if (view.get())
         {
@@ -174,11 +341,12 @@ namespace sge
             }
         }
         d->mDecor = view;
+        invalidate();
     }
 
-    inline RefPtr<ui::View> Scene::getRootView() { return d->mDecor; }
+    RefPtr<ui::View> Scene::getRootView() { return d->mDecor; }
 
-    inline Application * Scene::getApplicaton() { return d->mApp; }
+    Application * Scene::getApplicaton() { return d->mApp; }
 
     bool Scene::onLeftButtonDownEvent(const MouseDownEvent & event)
     {
@@ -300,6 +468,7 @@ namespace sge
     bool Scene::onResizeEvent(const ResizeEvent & event)
     {
         d->mSize = event.size;
+        invalidate();
         if (d->mDecor.get())
         {
             d->mDecor->requestMeasure();
@@ -76,7 +76,7 @@ namespace sge
         }
     }
 
-    inline bool Semaphore::wait(unsigned long ms)
+    bool Semaphore::wait(unsigned long ms)
     {
         switch (::WaitForSingleObject(d->hSem, ms))
         {
@@ -91,7 +91,7 @@ namespace sge
         return false;
     }
 
-    inline bool Semaphore::set(long number)
+    bool Semaphore::set(long number)
     {
         return TRUE == ::ReleaseSemaphore(d->hSem, number, 0);
     }
@@ -130,22 +130,22 @@ namespace sge
 		}
 	}
 
-    inline bool Semaphore::wait(unsigned long ms)
+    bool Semaphore::wait(unsigned long ms)
 	{
 		struct timespec abstime;
 		struct timeval tv;
 		gettimeofday(&tv, 0);
 		abstime.tv_sec = tv.tv_sec + ms / 1000;
 		abstime.tv_nsec = tv.tv_usec * 1000 + (ms % 1000) * 1000000;
-		if (abstime.tv_nsec >= 10000000000)
+		if (abstime.tv_nsec >= 1000000000)
 		{
-			abstime.tv_nsec -= 10000000000;
+			abstime.tv_nsec -= 1000000000;
 			abstime.tv_sec++;
 		}
 		return 0 == sem_timedwait(&d->hSem, &abstime);
 	}
 
-    inline bool Semaphore::set(long number)
+    bool Semaphore::set(long number)
 	{
 		bool ret = true;
 		for (long i = 0; i < number; ++i)
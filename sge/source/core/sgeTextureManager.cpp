@@ -41,6 +41,7 @@
  */
 
 #include <core/sgeTextureManager.h>
+#include <algorithm>
 
 namespace sge
 {
@@ -99,6 +99,13 @@ namespace sge
 		return GetCurrentThreadId();
 	}
 
+    int Thread::getProcessorCount()
+    {
+        SYSTEM_INFO info;
+        ::GetSystemInfo(&info);
+        return info.dwNumberOfProcessors > 0 ? (int)info.dwNumberOfProcessors : 1;
+    }
+
     Thread::Thread()
         : d(new ThreadPrivate())
     {
@@ -221,6 +228,12 @@ namespace sge
 		return pthread_self();
 	}
 
+	int Thread::getProcessorCount()
+	{
+		long count = sysconf(_SC_NPROCESSORS_ONLN);
+		return count > 0 ? (int)count : 1;
+	}
+
 	Thread::Thread()
 		: d(new ThreadPrivate())
 	{
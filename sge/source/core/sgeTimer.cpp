@@ -83,7 +83,7 @@ namespace sge
     }
 
 
-    inline float Timer::elapsed()
+    float Timer::elapsed()
     {
         LARGE_INTEGER nowTime;
         QueryPerformanceCounter(&nowTime);
@@ -112,6 +112,7 @@ namespace sge
 	Timer::Timer()
 		: d(new TimerPrivate())
 	{
+		gettimeofday(&d->time, NULL);
 	}
 
 	Timer::~Timer()
@@ -129,7 +130,7 @@ namespace sge
 		gettimeofday(&current, NULL);
 		int offsev = current.tv_sec - d->time.tv_sec;
 		int offusev = current.tv_usec - d->time.tv_usec;
-		float elapsed = ((offsev * 1000000) + offusev) * 0.0000001f;
+		float elapsed = ((offsev * 1000000) + offusev) * 0.000001f;
 		d->time = current;
 		return elapsed;
 	}
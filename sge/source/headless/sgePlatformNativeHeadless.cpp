@@ -0,0 +1,195 @@
+/**
+ *
+ * Simple graphic engine
+ * "sge" libraiy is a simple graphics engine, named sge.
+ *
+ * sgePlatformNativeHeadless.cpp
+ * date: 2026/10/17
+ * author: xiang
+ *
+ * License
+ *
+ * Copyright (c) 2017-2019, Xiang Wencheng <xiangwencheng@outlook.com>
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * - Redistributions of source code must retain the above copyright
+ *   notice, this list of conditions and the following disclaimer.
+ * - Redistributions in binary form must reproduce the above copyright
+ *   notice, this list of conditions and the following disclaimer in
+ *   the documentation and/or other materials provided with the
+ *   distribution.
+ * - Neither the names of its contributors may be used to endorse or
+ *   promote products derived from this software without specific
+ *   prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY
+ * WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <headless/sgePlatformNativeHeadless.h>
+#include <core/sgeLog.h>
+#include <core/sgeTimer.h>
+
+#ifdef OPENGLES
+
+namespace sge
+{
+
+    PlatformHeadlessNative::PlatformHeadlessNative(int width, int height)
+        : mSize(width, height)
+        , mClosed(false)
+        , mEventSem(0)
+    {
+        Log::info("Headless native created with %dx%d", width, height);
+    }
+
+    PlatformHeadlessNative::~PlatformHeadlessNative()
+    {
+        mClosed = true;
+    }
+
+    void PlatformHeadlessNative::close()
+    {
+        HeadlessEvent event;
+        event.type = HeadlessClose;
+        postEvent(event);
+    }
+
+    void PlatformHeadlessNative::postEvent(const HeadlessEvent& event)
+    {
+        {
+            ScopeLock lock(mMutex);
+            mEvents.push_back(event);
+        }
+        mEventSem.set();
+    }
+
+    void PlatformHeadlessNative::postMouseEvent(HeadlessEventType type, int x, int y, byte masks)
+    {
+        ASSERT(type <= HeadlessMouseMove && "not a mouse event");
+        HeadlessEvent event;
+        event.type = type;
+        event.mouse.pos = int2(x, y);
+        event.mouse.masks = masks;
+        postEvent(event);
+    }
+
+    void PlatformHeadlessNative::postMouseWheelEvent(int zDelta, int x, int y, byte masks)
+    {
+        HeadlessEvent event;
+        event.type = HeadlessMouseWheel;
+        event.wheel.zDelta = zDelta;
+        event.wheel.pos = int2(x, y);
+        event.wheel.masks = masks;
+        postEvent(event);
+    }
+
+    void PlatformHeadlessNative::postKeyEvent(HeadlessEventType type, byte vKeyCode)
+    {
+        ASSERT((type == HeadlessKeyDown || type == HeadlessKeyUp) && "not a key event");
+        HeadlessEvent event;
+        event.type = type;
+        event.key.vKeyCode = vKeyCode;
+        postEvent(event);
+    }
+
+    bool PlatformHeadlessNative::processEvents()
+    {
+        HeadlessEvent event;
+        {
+            ScopeLock lock(mMutex);
+            if (mEvents.empty())
+            {
+                return false;
+            }
+            event = mEvents.front();
+            mEvents.pop_front();
+        }
+
+        dispatchEvent(event);
+        return true;
+    }
+
+    bool PlatformHeadlessNative::waitEvents(unsigned long ms)
+    {
+        // the semaphore only wakes the wait, the queue tells whether there are events,
+        // the counts of events already processed are dropped until it is not empty
+        Timer timer;
+        float waited = 0;
+        for (;;)
+        {
+            {
+                ScopeLock lock(mMutex);
+                if (!mEvents.empty())
+                {
+                    return true;
+                }
+            }
+
+            unsigned long left = ms;
+            if (ms != 0xFFFFFFFF)
+            {
+                waited += timer.elapsed() * 1000.0f;
+                if (waited >= ms)
+                {
+                    return false;
+                }
+                left = ms - (unsigned long)waited;
+            }
+            if (!mEventSem.wait(left))
+            {
+                return false;
+            }
+        }
+    }
+
+    void PlatformHeadlessNative::dispatchEvent(const HeadlessEvent& event)
+    {
+        switch (event.type)
+        {
+        case HeadlessLeftButtonDown: mOnLeftButtonDownEvent(event.mouse); break;
+        case HeadlessLeftButtonUp: mOnLeftButtonUpEvent(event.mouse); break;
+        case HeadlessLeftButtonClick: mOnLeftButtonClickEvent(event.mouse); break;
+        case HeadlessRightButtonDown: mOnRightButtonDownEvent(event.mouse); break;
+        case HeadlessRightButtonUp: mOnRightButtonUpEvent(event.mouse); break;
+        case HeadlessRightButtonClick: mOnRightButtonClickEvent(event.mouse); break;
+        case HeadlessMiddleButtonDown: mOnMiddleButtonDownEvent(event.mouse); break;
+        case HeadlessMiddleButtonUp: mOnMiddleButtonUpEvent(event.mouse); break;
+        case HeadlessMiddleButtonClick: mOnMiddleButtonClickEvent(event.mouse); break;
+        case HeadlessMouseMove: mOnMouseMoveEvent(event.mouse); break;
+        case HeadlessMouseWheel: mOnMouseWheelEvent(event.wheel); break;
+        case HeadlessKeyDown: mOnKeyDownEvent(event.key); break;
+        case HeadlessKeyUp: mOnKeyUpEvent(event.key); break;
+
+        case HeadlessClose:
+        {
+            // same as win32, closed unless the handler wants to keep it
+            if (!mOnCloseEvent())
+            {
+                Log::info("Headless native closed");
+                mClosed = true;
+            }
+        } break;
+
+        default:
+            break;
+        }
+    }
+
+}
+
+#endif
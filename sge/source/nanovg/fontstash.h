@@ -57,6 +57,7 @@ enum FONSerrorCode {
 struct FONSparams {
 	int width, height;
 	unsigned char flags;
+	int pages;	// Most atlas pages of width x height, 1 if 0 or when the stash renders itself
 	void* userPtr;
 	int (*renderCreate)(void* uptr, int width, int height);
 	int (*renderResize)(void* uptr, int width, int height);
@@ -70,13 +71,23 @@ struct FONSquad
 {
 	float x0,y0,s0,t0;
 	float x1,y1,s1,t1;
+	int page;
 };
 typedef struct FONSquad FONSquad;
 
+// Glyph of a shaped run, the pen moves by kern before the glyph and by advance after it.
+struct FONSrunGlyph {
+	unsigned int codepoint;
+	float kern;		// Kerning and letter spacing
+	float advance;
+};
+typedef struct FONSrunGlyph FONSrunGlyph;
+
 struct FONStextIter {
 	float x, y, nextx, nexty, scale, spacing;
 	unsigned int codepoint;
-	short isize, iblur;
+	short isize, iblur;		// Glyph cache key, FONS_SDF_SIZE*10 and FONS_SDF_BLUR for distance fields
+	float sdfScale;			// Scale of the distance field glyphs to the text size, 0 for bitmaps
 	struct FONSfont* font;
 	int prevGlyphIndex;
 	const char* str;
@@ -84,9 +95,27 @@ struct FONStextIter {
 	const char* end;
 	unsigned int utf8state;
 	int bitmapOption;
+	const FONSrunGlyph* run;	// Shaped run iterated instead of the string
+	int nrun;
+	int irun;
 };
 typedef struct FONStextIter FONStextIter;
 
+// Glyph cache statistics since the stash was created.
+struct FONSatlasStats {
+	int pages;		// Atlas pages allocated.
+	int hits;		// Glyphs drawn from the atlas.
+	int misses;		// Glyphs rasterized to be drawn.
+	int evictions;	// Glyphs removed from the atlas to make room for others.
+};
+typedef struct FONSatlasStats FONSatlasStats;
+
+// Rasterizer of the glyph bitmaps.
+enum FONSrasterizer {
+	FONS_RASTER_ACCUMULATE = 0,		// Signed area of the flattened outline accumulated per pixel
+	FONS_RASTER_BACKEND = 1,		// The font back-end's own rasterizer
+};
+
 typedef struct FONScontext FONScontext;
 
 // Constructor and destructor.
@@ -100,6 +129,40 @@ void fonsGetAtlasSize(FONScontext* s, int* width, int* height);
 int fonsExpandAtlas(FONScontext* s, int width, int height);
 // Resets the whole stash.
 int fonsResetAtlas(FONScontext* stash, int width, int height);
+// Starts a frame. When the pages are full the least recently drawn glyphs are evicted to make room,
+// the glyphs drawn since the last call are kept.
+void fonsBeginFrame(FONScontext* s);
+// Returns the number of atlas pages.
+int fonsPageCount(FONScontext* s);
+void fonsAtlasStats(FONScontext* s, FONSatlasStats* stats);
+
+// Asynchronous rasterization. When set, the bitmaps of missing glyphs are rasterized by tasks submitted
+// to other threads, the glyphs are drawn stretched from another size of them, or not at all, until the
+// finished tasks are collected into the atlas. The collect function stores up to max data pointers of
+// the finished tasks and returns their number, with wait it first waits for all the submitted tasks.
+typedef void (*FONSsubmitFunc)(void* uptr, void (*task)(void* data, int index), void* data);
+typedef int (*FONScollectFunc)(void* uptr, void** data, int max, int wait);
+// Sets the task runner, NULL rasterizes when the glyphs are drawn again. The submitted tasks are waited for.
+void fonsAsyncRasterizer(FONScontext* s, FONSsubmitFunc submit, FONScollectFunc collect, void* uptr);
+// Copies the glyphs of the finished tasks into the atlas, returns the number of glyphs added.
+int fonsCollectGlyphs(FONScontext* s);
+// Returns the number of glyphs drawn with a placeholder since fonsBeginFrame().
+int fonsPlaceholderCount(FONScontext* s);
+// Rasterizes the glyphs of the codepoints first to last in the current font, size and blur ahead of drawing,
+// codepoints missing from the font are skipped. Returns the number of glyphs rasterized or submitted.
+int fonsPrewarmGlyphs(FONScontext* s, unsigned int first, unsigned int last);
+// Sets the rasterizer of the glyph bitmaps added from now on, returns the one in use. Only the
+// stb_truetype back-end accumulates, FreeType always rasterizes its hinted glyphs itself.
+int fonsGlyphRasterizer(FONScontext* s, int rasterizer);
+
+// Glyph cache file. The pages of the atlas are saved with the glyphs on them, keyed by a hash of their
+// font, codepoint, size and blur, to be loaded by another stash with the same page size instead of
+// rasterizing them again. Returns the number of glyphs saved, -1 if the file can not be written.
+int fonsSaveGlyphCache(FONScontext* s, const char* path);
+// Loads a glyph cache file read into data into the empty atlas, before any glyph is rasterized. The glyphs
+// of the fonts not added are skipped. Returns the number of glyphs loaded, -1 if the data is not a glyph
+// cache of this page size or the atlas holds glyphs already.
+int fonsLoadGlyphCache(FONScontext* s, const unsigned char* data, int ndata);
 
 // Add fonts
 int fonsAddFont(FONScontext* s, const char* name, const char* path);
@@ -118,6 +181,9 @@ void fonsSetSpacing(FONScontext* s, float spacing);
 void fonsSetBlur(FONScontext* s, float blur);
 void fonsSetAlign(FONScontext* s, int align);
 void fonsSetFont(FONScontext* s, int font);
+// Draws the glyphs from signed distance fields cached once at FONS_SDF_SIZE and scaled to the
+// text size, the blur is left to the renderer. The atlas holds 0.5 on the glyph edge.
+void fonsSetSDF(FONScontext* s, int enabled);
 
 // Draw text
 float fonsDrawText(FONScontext* s, float x, float y, const char* string, const char* end);
@@ -131,9 +197,16 @@ void fonsVertMetrics(FONScontext* s, float* ascender, float* descender, float* l
 int fonsTextIterInit(FONScontext* stash, FONStextIter* iter, float x, float y, const char* str, const char* end, int bitmapOption);
 int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, struct FONSquad* quad);
 
-// Pull texture changes
-const unsigned char* fonsGetTextureData(FONScontext* stash, int* width, int* height);
-int fonsValidateTexture(FONScontext* s, int* dirty);
+// Shaped runs, the glyphs of a string with the kerning of the current state applied so they can be
+// drawn again without decoding and kerning the string. Returns the number of glyphs, or -1 when the
+// string has more than maxGlyphs glyphs.
+int fonsShapeText(FONScontext* s, const char* str, const char* end, FONSrunGlyph* glyphs, int maxGlyphs);
+// Iterates a shaped run like fonsTextIterInit() the string, the str and next pointers are not set.
+int fonsRunIterInit(FONScontext* stash, FONStextIter* iter, float x, float y, const FONSrunGlyph* glyphs, int nglyphs, int bitmapOption);
+
+// Pull texture changes of a page
+const unsigned char* fonsGetTextureData(FONScontext* stash, int page, int* width, int* height);
+int fonsValidateTexture(FONScontext* s, int page, int* dirty);
 
 // Draws the stash texture for debugging
 void fonsDrawDebug(FONScontext* s, float x, float y);
@@ -145,11 +218,130 @@ void fonsDrawDebug(FONScontext* s, float x, float y);
 
 #define FONS_NOTUSED(v)  (void)sizeof(v)
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define FONS_SSE2
+#	include <emmintrin.h>
+#endif
+
+// Glyph outline flattened to segments in pixels with y down, the distance fields are computed from it.
+struct FONSoutline {
+	float* segs;		// x0,y0,x1,y1 of each segment
+	int nsegs;
+	int csegs;
+	float scale;		// Font units to pixels
+	float px, py;		// Current point
+	float sx, sy;		// Start of the contour
+	int* near;			// Per row work buffers of the distance field
+	float* cross;
+	int cwork;
+	float* accum;		// Zeroed area buffer of the accumulation rasterizer
+	int caccum;
+};
+typedef struct FONSoutline FONSoutline;
+
+static int fons__outlineLine(FONSoutline* o, float x, float y)
+{
+	float* seg;
+	if (x == o->px && y == o->py) return 1;
+	if (o->nsegs+1 > o->csegs) {
+		int csegs = o->csegs == 0 ? 64 : o->csegs * 2;
+		float* segs = (float*)realloc(o->segs, sizeof(float) * 4 * csegs);
+		if (segs == NULL) return 0;
+		o->segs = segs;
+		o->csegs = csegs;
+	}
+	seg = &o->segs[o->nsegs*4];
+	seg[0] = o->px;
+	seg[1] = o->py;
+	seg[2] = x;
+	seg[3] = y;
+	o->nsegs++;
+	o->px = x;
+	o->py = y;
+	return 1;
+}
+
+static void fons__outlineClose(FONSoutline* o)
+{
+	fons__outlineLine(o, o->sx, o->sy);
+}
+
+static void fons__outlineMove(FONSoutline* o, float x, float y)
+{
+	fons__outlineClose(o);
+	o->px = o->sx = x;
+	o->py = o->sy = y;
+}
+
+// Number of segments keeping a curve with the given second difference within 1/20 pixel.
+static int fons__outlineSteps(float ddx, float ddy)
+{
+	int n = (int)ceilf(sqrtf(sqrtf(ddx*ddx + ddy*ddy) * 2.5f));
+	return n < 1 ? 1 : (n > 32 ? 32 : n);
+}
+
+static void fons__outlineQuad(FONSoutline* o, float cx, float cy, float x, float y)
+{
+	float x0 = o->px, y0 = o->py;
+	int i, n = fons__outlineSteps(x0 - 2*cx + x, y0 - 2*cy + y);
+	for (i = 1; i <= n; i++) {
+		float t = (float)i / n, u = 1.0f - t;
+		fons__outlineLine(o, u*u*x0 + 2*u*t*cx + t*t*x, u*u*y0 + 2*u*t*cy + t*t*y);
+	}
+}
+
+static void fons__outlineCubic(FONSoutline* o, float c1x, float c1y, float c2x, float c2y, float x, float y)
+{
+	float x0 = o->px, y0 = o->py;
+	float ddx = fabsf(x0 - 2*c1x + c2x) > fabsf(c1x - 2*c2x + x) ? x0 - 2*c1x + c2x : c1x - 2*c2x + x;
+	float ddy = fabsf(y0 - 2*c1y + c2y) > fabsf(c1y - 2*c2y + y) ? y0 - 2*c1y + c2y : c1y - 2*c2y + y;
+	int i, n = fons__outlineSteps(ddx*1.5f, ddy*1.5f);
+	for (i = 1; i <= n; i++) {
+		float t = (float)i / n, u = 1.0f - t;
+		fons__outlineLine(o, u*u*u*x0 + 3*u*u*t*c1x + 3*u*t*t*c2x + t*t*t*x,
+						  u*u*u*y0 + 3*u*u*t*c1y + 3*u*t*t*c2y + t*t*t*y);
+	}
+}
+
+// Bump allocator of the rasterizer, the stash has one and each task of the asynchronous rasterizer another.
+struct FONSscratch {
+	unsigned char* data;
+	int n;
+	FONScontext* stash;		// Reports FONS_SCRATCH_FULL, NULL in the tasks
+};
+typedef struct FONSscratch FONSscratch;
+
+static FONSscratch* fons__stashScratch(FONScontext* stash);
+
+// Kerning pair of the font, listed by the back-end when the font is added.
+struct FONSkernPair {
+	unsigned int glyphs;	// glyph1 << 16 | glyph2
+	int advance;			// In font units
+};
+typedef struct FONSkernPair FONSkernPair;
+
+// The glyph indices of the BMP codepoints are kept in pages of 256 codepoints, a page
+// is allocated when one of its codepoints has a glyph.
+#define FONS_CMAP_PAGES 256
+
+static int fons__cmapSet(unsigned short** cmap, unsigned int codepoint, unsigned int glyph)
+{
+	unsigned short** page = &cmap[codepoint >> 8];
+	if (glyph == 0) return 1;
+	if (*page == NULL) {
+		*page = (unsigned short*)calloc(256, sizeof(unsigned short));
+		if (*page == NULL) return 0;
+	}
+	(*page)[codepoint & 0xff] = (unsigned short)glyph;
+	return 1;
+}
+
 #ifdef FONS_USE_FREETYPE
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
 #include FT_ADVANCES_H
+#include FT_OUTLINE_H
 #include <math.h>
 
 struct FONSttFontImpl {
@@ -157,6 +349,12 @@ struct FONSttFontImpl {
 };
 typedef struct FONSttFontImpl FONSttFontImpl;
 
+// A face is not used from several threads, the glyphs are rasterized when they are drawn.
+#define FONS_TT_REENTRANT 0
+
+// The hinted bitmaps are rendered by FreeType.
+#define FONS_TT_ACCUMULATE 0
+
 static FT_Library ftLibrary;
 
 int fons__tt_init(FONScontext *context)
@@ -185,6 +383,12 @@ int fons__tt_loadFont(FONScontext *context, FONSttFontImpl *font, unsigned char
 	return ftError == 0;
 }
 
+void fons__tt_setAllocator(FONSttFontImpl *font, FONSscratch *scratch)
+{
+	FONS_NOTUSED(font);
+	FONS_NOTUSED(scratch);
+}
+
 void fons__tt_getFontVMetrics(FONSttFontImpl *font, int *ascent, int *descent, int *lineGap)
 {
 	*ascent = font->font->ascender;
@@ -202,6 +406,26 @@ int fons__tt_getGlyphIndex(FONSttFontImpl *font, int codepoint)
 	return FT_Get_Char_Index(font->font, codepoint);
 }
 
+int fons__tt_buildCmap(FONSttFontImpl *font, unsigned short** cmap)
+{
+	FT_UInt glyph;
+	FT_ULong codepoint = FT_Get_First_Char(font->font, &glyph);
+	while (glyph != 0 && codepoint < 0x10000) {
+		if (!fons__cmapSet(cmap, (unsigned int)codepoint, glyph)) return 0;
+		codepoint = FT_Get_Next_Char(font->font, codepoint, &glyph);
+	}
+	return 1;
+}
+
+// The pairs of FT_Get_Kerning can not be listed, the back-end is asked for each pair.
+int fons__tt_getKernPairs(FONSttFontImpl *font, FONSkernPair* pairs, int maxPairs)
+{
+	FONS_NOTUSED(font);
+	FONS_NOTUSED(pairs);
+	FONS_NOTUSED(maxPairs);
+	return -1;
+}
+
 int fons__tt_buildGlyphBitmap(FONSttFontImpl *font, int glyph, float size, float scale,
 							  int *advance, int *lsb, int *x0, int *y0, int *x1, int *y1)
 {
@@ -245,6 +469,56 @@ void fons__tt_renderGlyphBitmap(FONSttFontImpl *font, unsigned char *output, int
 	}
 }
 
+static int fons__ftMoveTo(const FT_Vector* to, void* user)
+{
+	FONSoutline* o = (FONSoutline*)user;
+	fons__outlineMove(o, to->x * o->scale, -to->y * o->scale);
+	return 0;
+}
+
+static int fons__ftLineTo(const FT_Vector* to, void* user)
+{
+	FONSoutline* o = (FONSoutline*)user;
+	fons__outlineLine(o, to->x * o->scale, -to->y * o->scale);
+	return 0;
+}
+
+static int fons__ftConicTo(const FT_Vector* c, const FT_Vector* to, void* user)
+{
+	FONSoutline* o = (FONSoutline*)user;
+	fons__outlineQuad(o, c->x * o->scale, -c->y * o->scale, to->x * o->scale, -to->y * o->scale);
+	return 0;
+}
+
+static int fons__ftCubicTo(const FT_Vector* c1, const FT_Vector* c2, const FT_Vector* to, void* user)
+{
+	FONSoutline* o = (FONSoutline*)user;
+	fons__outlineCubic(o, c1->x * o->scale, -c1->y * o->scale, c2->x * o->scale, -c2->y * o->scale,
+					   to->x * o->scale, -to->y * o->scale);
+	return 0;
+}
+
+int fons__tt_buildGlyphOutline(FONSttFontImpl *font, int glyph, float scale, FONSoutline* outline)
+{
+	FT_Outline_Funcs funcs;
+	FT_Error ftError;
+
+	outline->nsegs = 0;
+	outline->scale = scale;
+	outline->px = outline->py = outline->sx = outline->sy = 0.0f;
+	ftError = FT_Load_Glyph(font->font, glyph, FT_LOAD_NO_SCALE | FT_LOAD_NO_HINTING);
+	if (ftError) return 0;
+	if (font->font->glyph->format != FT_GLYPH_FORMAT_OUTLINE) return 0;
+	memset(&funcs, 0, sizeof(funcs));
+	funcs.move_to = fons__ftMoveTo;
+	funcs.line_to = fons__ftLineTo;
+	funcs.conic_to = fons__ftConicTo;
+	funcs.cubic_to = fons__ftCubicTo;
+	ftError = FT_Outline_Decompose(&font->font->glyph->outline, &funcs, outline);
+	fons__outlineClose(outline);
+	return ftError == 0;
+}
+
 int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 {
 	FT_Vector ftKerning;
@@ -266,6 +540,12 @@ struct FONSttFontImpl {
 };
 typedef struct FONSttFontImpl FONSttFontImpl;
 
+// A copy of the font info with its own allocator rasterizes on another thread.
+#define FONS_TT_REENTRANT 1
+
+// The bitmaps are accumulated from the glyph outlines unless the stb_truetype rasterizer is chosen.
+#define FONS_TT_ACCUMULATE 1
+
 int fons__tt_init(FONScontext *context)
 {
 	FONS_NOTUSED(context);
@@ -283,11 +563,16 @@ int fons__tt_loadFont(FONScontext *context, FONSttFontImpl *font, unsigned char
 	int stbError;
 	FONS_NOTUSED(dataSize);
 
-	font->font.userdata = context;
+	font->font.userdata = fons__stashScratch(context);
 	stbError = stbtt_InitFont(&font->font, data, 0);
 	return stbError;
 }
 
+void fons__tt_setAllocator(FONSttFontImpl *font, FONSscratch *scratch)
+{
+	font->font.userdata = scratch;
+}
+
 void fons__tt_getFontVMetrics(FONSttFontImpl *font, int *ascent, int *descent, int *lineGap)
 {
 	stbtt_GetFontVMetrics(&font->font, ascent, descent, lineGap);
@@ -303,6 +588,75 @@ int fons__tt_getGlyphIndex(FONSttFontImpl *font, int codepoint)
 	return stbtt_FindGlyphIndex(&font->font, codepoint);
 }
 
+// Walks the cmap subtable stbtt_FindGlyphIndex() searches, returns 0 for the formats it does not read.
+int fons__tt_buildCmap(FONSttFontImpl *font, unsigned short** cmap)
+{
+	stbtt_uint8* data = font->font.data;
+	stbtt_uint32 map = (stbtt_uint32)font->font.index_map;
+	stbtt_uint16 format = ttUSHORT(data + map);
+	stbtt_uint32 c, i;
+
+	if (format == 0) {
+		stbtt_int32 bytes = ttUSHORT(data + map + 2);
+		for (c = 0; (stbtt_int32)c < bytes-6 && c < 256; c++)
+			if (!fons__cmapSet(cmap, c, ttBYTE(data + map + 6 + c))) return 0;
+		return 1;
+	} else if (format == 6) {
+		stbtt_uint32 first = ttUSHORT(data + map + 6);
+		stbtt_uint32 count = ttUSHORT(data + map + 8);
+		for (c = first; c < first+count && c < 0x10000; c++)
+			if (!fons__cmapSet(cmap, c, ttUSHORT(data + map + 10 + (c - first)*2))) return 0;
+		return 1;
+	} else if (format == 4) {
+		// A codepoint maps in the first segment ending at or after it, when it is not before its start.
+		stbtt_uint32 segcount = ttUSHORT(data + map + 6) >> 1;
+		stbtt_uint32 ends = map + 14, starts = ends + segcount*2 + 2;
+		stbtt_uint32 deltas = starts + segcount*2, offsets = deltas + segcount*2;
+		stbtt_uint32 next = 0;
+		for (i = 0; i < segcount; i++) {
+			stbtt_uint32 end = ttUSHORT(data + ends + 2*i);
+			stbtt_uint32 start = ttUSHORT(data + starts + 2*i);
+			stbtt_uint16 offset = ttUSHORT(data + offsets + 2*i);
+			stbtt_int16 delta = ttSHORT(data + deltas + 2*i);
+			for (c = next > start ? next : start; c <= end; c++) {
+				stbtt_uint32 glyph = offset == 0 ? (stbtt_uint16)(c + delta) :
+					ttUSHORT(data + offset + (c - start)*2 + offsets + 2*i);
+				if (!fons__cmapSet(cmap, c, glyph)) return 0;
+			}
+			if (end+1 > next) next = end+1;
+		}
+		return 1;
+	} else if (format == 12 || format == 13) {
+		stbtt_uint32 ngroups = ttULONG(data + map + 12);
+		for (i = 0; i < ngroups; i++) {
+			stbtt_uint32 start = ttULONG(data + map + 16 + i*12);
+			stbtt_uint32 end = ttULONG(data + map + 16 + i*12 + 4);
+			stbtt_uint32 glyph = ttULONG(data + map + 16 + i*12 + 8);
+			for (c = start; c <= end && c < 0x10000; c++)
+				if (!fons__cmapSet(cmap, c, format == 12 ? glyph + c - start : glyph)) return 0;
+		}
+		return 1;
+	}
+	return 0;
+}
+
+// Lists the pairs of the table stbtt_GetGlyphKernAdvance() searches, the count when pairs is NULL.
+int fons__tt_getKernPairs(FONSttFontImpl *font, FONSkernPair* pairs, int maxPairs)
+{
+	stbtt_uint8* data = font->font.data + font->font.kern;
+	int i, n;
+	if (!font->font.kern || ttUSHORT(data+2) < 1 || ttUSHORT(data+8) != 1)
+		return 0;
+	n = ttUSHORT(data+10);
+	if (pairs == NULL)
+		return n;
+	for (i = 0; i < n && i < maxPairs; i++) {
+		pairs[i].glyphs = ttULONG(data+18+(i*6));
+		pairs[i].advance = ttSHORT(data+22+(i*6));
+	}
+	return i;
+}
+
 int fons__tt_buildGlyphBitmap(FONSttFontImpl *font, int glyph, float size, float scale,
 							  int *advance, int *lsb, int *x0, int *y0, int *x1, int *y1)
 {
@@ -318,6 +672,29 @@ void fons__tt_renderGlyphBitmap(FONSttFontImpl *font, unsigned char *output, int
 	stbtt_MakeGlyphBitmap(&font->font, output, outWidth, outHeight, outStride, scaleX, scaleY, glyph);
 }
 
+int fons__tt_buildGlyphOutline(FONSttFontImpl *font, int glyph, float scale, FONSoutline* outline)
+{
+	stbtt_vertex* verts = NULL;
+	int i, n = stbtt_GetGlyphShape(&font->font, glyph, &verts);
+
+	outline->nsegs = 0;
+	outline->scale = scale;
+	outline->px = outline->py = outline->sx = outline->sy = 0.0f;
+	for (i = 0; i < n; i++) {
+		float x = verts[i].x * scale, y = -verts[i].y * scale;
+		if (verts[i].type == STBTT_vmove)
+			fons__outlineMove(outline, x, y);
+		else if (verts[i].type == STBTT_vline)
+			fons__outlineLine(outline, x, y);
+		else if (verts[i].type == STBTT_vcurve)
+			fons__outlineQuad(outline, verts[i].cx * scale, -verts[i].cy * scale, x, y);
+	}
+	fons__outlineClose(outline);
+	if (verts != NULL)
+		stbtt_FreeShape(&font->font, verts);
+	return 1;
+}
+
 int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 {
 	return stbtt_GetGlyphKernAdvance(&font->font, glyph1, glyph2);
@@ -349,6 +726,19 @@ int fons__tt_getGlyphKernAdvance(FONSttFontImpl *font, int glyph1, int glyph2)
 #ifndef FONS_MAX_FALLBACKS
 #	define FONS_MAX_FALLBACKS 20
 #endif
+#ifndef FONS_MAX_PAGES
+#	define FONS_MAX_PAGES 8
+#endif
+// Pixel size the distance field glyphs are rasterized at, and the distance in pixels at that size
+// mapped to the 0..1 range of the atlas around the edge.
+#ifndef FONS_SDF_SIZE
+#	define FONS_SDF_SIZE 48
+#endif
+#ifndef FONS_SDF_SPREAD
+#	define FONS_SDF_SPREAD 6
+#endif
+// Blur of the distance field glyphs in the cache key, no bitmap glyph has a negative blur.
+#define FONS_SDF_BLUR -1
 
 static unsigned int fons__hashint(unsigned int a)
 {
@@ -377,8 +767,11 @@ struct FONSglyph
 	int index;
 	int next;
 	short size, blur;
-	short x0,y0,x1,y1;
-	short xadv,xoff,yoff;
+	short page;
+	short x0,y0,x1,y1;		// x0,y0 are -1 if the bitmap is not in the atlas
+	short xadv,xoff,yoff;	// xadv is in 1/10 pixels, in font units for distance fields
+	short pending;			// 1 while the bitmap is rasterized by a task
+	int lastUsed;			// Frame the glyph was last drawn in
 };
 typedef struct FONSglyph FONSglyph;
 
@@ -398,6 +791,10 @@ struct FONSfont
 	int lut[FONS_HASH_LUT_SIZE];
 	int fallbacks[FONS_MAX_FALLBACKS];
 	int nfallbacks;
+	unsigned short* cmap[FONS_CMAP_PAGES];	// Glyph indices of the BMP codepoints when hasCmap
+	int hasCmap;
+	FONSkernPair* kern;		// Kerning pairs hashed by glyphs, NULL when the font has none
+	int kernMask;			// Slots-1 of kern, -1 when the back-end is asked for each pair
 };
 typedef struct FONSfont FONSfont;
 
@@ -409,6 +806,7 @@ struct FONSstate
 	unsigned int color;
 	float blur;
 	float spacing;
+	int sdf;
 };
 typedef struct FONSstate FONSstate;
 
@@ -426,45 +824,76 @@ struct FONSatlas
 };
 typedef struct FONSatlas FONSatlas;
 
+struct FONSpage
+{
+	FONSatlas* atlas;
+	int dirtyRect[4];
+	int lastUsed;		// Frame a glyph of the page was last drawn in
+};
+typedef struct FONSpage FONSpage;
+
+// Free space on a page
+struct FONSrect
+{
+	short page, x, y, w, h;
+};
+typedef struct FONSrect FONSrect;
+
 struct FONScontext
 {
 	FONSparams params;
 	float itw,ith;
-	unsigned char* texData;
-	int dirtyRect[4];
+	unsigned char* texData;		// The pages one after the other
+	FONSpage pages[FONS_MAX_PAGES];
+	int npages;
+	FONSrect* freeRects;
+	int nfreeRects;
+	int cfreeRects;
+	int frame;
+	FONSatlasStats stats;
 	FONSfont** fonts;
-	FONSatlas* atlas;
 	int cfonts;
 	int nfonts;
 	float verts[FONS_VERTEX_COUNT*2];
 	float tcoords[FONS_VERTEX_COUNT*2];
 	unsigned int colors[FONS_VERTEX_COUNT];
 	int nverts;
-	unsigned char* scratch;
-	int nscratch;
+	FONSscratch scratch;
 	FONSstate states[FONS_MAX_STATES];
 	int nstates;
 	void (*handleError)(void* uptr, int error, int val);
 	void* errorUptr;
+	FONSoutline outline;
+	FONSsubmitFunc submit;		// Asynchronous rasterizer
+	FONScollectFunc collect;
+	void* asyncUptr;
+	int njobs;					// Tasks submitted and not collected
+	int placeholders;			// Glyphs drawn without their bitmap this frame
+	int rasterizer;				// FONSrasterizer of the bitmaps
 };
 
+static FONSscratch* fons__stashScratch(FONScontext* stash)
+{
+	return &stash->scratch;
+}
+
 #ifdef STB_TRUETYPE_IMPLEMENTATION
 
 static void* fons__tmpalloc(size_t size, void* up)
 {
 	unsigned char* ptr;
-	FONScontext* stash = (FONScontext*)up;
+	FONSscratch* scratch = (FONSscratch*)up;
 
 	// 16-byte align the returned pointer
 	size = (size + 0xf) & ~0xf;
 
-	if (stash->nscratch+(int)size > FONS_SCRATCH_BUF_SIZE) {
-		if (stash->handleError)
-			stash->handleError(stash->errorUptr, FONS_SCRATCH_FULL, stash->nscratch+(int)size);
+	if (scratch->n+(int)size > FONS_SCRATCH_BUF_SIZE) {
+		if (scratch->stash != NULL && scratch->stash->handleError)
+			scratch->stash->handleError(scratch->stash->errorUptr, FONS_SCRATCH_FULL, scratch->n+(int)size);
 		return NULL;
 	}
-	ptr = stash->scratch + stash->nscratch;
-	stash->nscratch += (int)size;
+	ptr = scratch->data + scratch->n;
+	scratch->n += (int)size;
 	return ptr;
 }
 
@@ -698,25 +1127,68 @@ static int fons__atlasAddRect(FONSatlas* atlas, int rw, int rh, int* rx, int* ry
 	return 1;
 }
 
+static unsigned char* fons__texel(FONScontext* stash, int page, int x, int y)
+{
+	return &stash->texData[(size_t)page * stash->params.width * stash->params.height + x + y * stash->params.width];
+}
+
+static void fons__addDirty(FONScontext* stash, int page, int x0, int y0, int x1, int y1)
+{
+	int* dirty = stash->pages[page].dirtyRect;
+	dirty[0] = fons__mini(dirty[0], x0);
+	dirty[1] = fons__mini(dirty[1], y0);
+	dirty[2] = fons__maxi(dirty[2], x1);
+	dirty[3] = fons__maxi(dirty[3], y1);
+}
+
+static void fons__clearDirty(FONScontext* stash, int page)
+{
+	int* dirty = stash->pages[page].dirtyRect;
+	dirty[0] = stash->params.width;
+	dirty[1] = stash->params.height;
+	dirty[2] = 0;
+	dirty[3] = 0;
+}
+
 static void fons__addWhiteRect(FONScontext* stash, int w, int h)
 {
 	int x, y, gx, gy;
 	unsigned char* dst;
-	if (fons__atlasAddRect(stash->atlas, w, h, &gx, &gy) == 0)
+	if (fons__atlasAddRect(stash->pages[0].atlas, w, h, &gx, &gy) == 0)
 		return;
 
 	// Rasterize
-	dst = &stash->texData[gx + gy * stash->params.width];
+	dst = fons__texel(stash, 0, gx, gy);
 	for (y = 0; y < h; y++) {
 		for (x = 0; x < w; x++)
 			dst[x] = 0xff;
 		dst += stash->params.width;
 	}
 
-	stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], gx);
-	stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], gy);
-	stash->dirtyRect[2] = fons__maxi(stash->dirtyRect[2], gx+w);
-	stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], gy+h);
+	fons__addDirty(stash, 0, gx, gy, gx+w, gy+h);
+}
+
+// Appends an empty page to the texture data.
+static int fons__addPage(FONScontext* stash)
+{
+	FONSpage* page = &stash->pages[stash->npages];
+	size_t size = (size_t)stash->params.width * stash->params.height;
+	unsigned char* data = (unsigned char*)realloc(stash->texData, size * (stash->npages+1));
+	if (data == NULL) return 0;
+	stash->texData = data;
+	memset(&data[size * stash->npages], 0, size);
+
+	// The atlas of a page is kept when the stash is reset.
+	if (page->atlas == NULL)
+		page->atlas = fons__allocAtlas(stash->params.width, stash->params.height, FONS_INIT_ATLAS_NODES);
+	else
+		fons__atlasReset(page->atlas, stash->params.width, stash->params.height);
+	if (page->atlas == NULL) return 0;
+
+	page->lastUsed = stash->frame;
+	fons__clearDirty(stash, stash->npages);
+	stash->npages++;
+	return 1;
 }
 
 FONScontext* fonsCreateInternal(FONSparams* params)
@@ -731,8 +1203,9 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 	stash->params = *params;
 
 	// Allocate scratch buffer.
-	stash->scratch = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
-	if (stash->scratch == NULL) goto error;
+	stash->scratch.data = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
+	if (stash->scratch.data == NULL) goto error;
+	stash->scratch.stash = stash;
 
 	// Initialize implementation library
 	if (!fons__tt_init(stash)) goto error;
@@ -742,8 +1215,10 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 			goto error;
 	}
 
-	stash->atlas = fons__allocAtlas(stash->params.width, stash->params.height, FONS_INIT_ATLAS_NODES);
-	if (stash->atlas == NULL) goto error;
+	if (stash->params.pages < 1 || stash->params.renderDraw != NULL)
+		stash->params.pages = 1;
+	if (stash->params.pages > FONS_MAX_PAGES)
+		stash->params.pages = FONS_MAX_PAGES;
 
 	// Allocate space for fonts.
 	stash->fonts = (FONSfont**)malloc(sizeof(FONSfont*) * FONS_INIT_FONTS);
@@ -755,14 +1230,7 @@ FONScontext* fonsCreateInternal(FONSparams* params)
 	// Create texture for the cache.
 	stash->itw = 1.0f/stash->params.width;
 	stash->ith = 1.0f/stash->params.height;
-	stash->texData = (unsigned char*)malloc(stash->params.width * stash->params.height);
-	if (stash->texData == NULL) goto error;
-	memset(stash->texData, 0, stash->params.width * stash->params.height);
-
-	stash->dirtyRect[0] = stash->params.width;
-	stash->dirtyRect[1] = stash->params.height;
-	stash->dirtyRect[2] = 0;
-	stash->dirtyRect[3] = 0;
+	if (!fons__addPage(stash)) goto error;
 
 	// Add white rect at 0,0 for debug drawing.
 	fons__addWhiteRect(stash, 2,2);
@@ -822,6 +1290,11 @@ void fonsSetFont(FONScontext* stash, int font)
 	fons__getState(stash)->font = font;
 }
 
+void fonsSetSDF(FONScontext* stash, int enabled)
+{
+	fons__getState(stash)->sdf = enabled;
+}
+
 void fonsPushState(FONScontext* stash)
 {
 	if (stash->nstates >= FONS_MAX_STATES) {
@@ -853,11 +1326,16 @@ void fonsClearState(FONScontext* stash)
 	state->blur = 0;
 	state->spacing = 0;
 	state->align = FONS_ALIGN_LEFT | FONS_ALIGN_BASELINE;
+	state->sdf = 0;
 }
 
 static void fons__freeFont(FONSfont* font)
 {
+	int i;
 	if (font == NULL) return;
+	for (i = 0; i < FONS_CMAP_PAGES; i++)
+		if (font->cmap[i]) free(font->cmap[i]);
+	if (font->kern) free(font->kern);
 	if (font->glyphs) free(font->glyphs);
 	if (font->freeData && font->data) free(font->data);
 	free(font);
@@ -918,6 +1396,80 @@ error:
 	return FONS_INVALID;
 }
 
+#define FONS_KERN_EMPTY 0xffffffffu
+
+// Builds the cmap of the BMP and the hashed kerning pairs, the back-end is asked for what is not built.
+static void fons__buildLookups(FONSfont* font)
+{
+	int i, n, slots;
+	FONSkernPair* pairs;
+
+	font->hasCmap = fons__tt_buildCmap(&font->font, font->cmap);
+	if (!font->hasCmap) {
+		for (i = 0; i < FONS_CMAP_PAGES; i++) {
+			if (font->cmap[i]) free(font->cmap[i]);
+			font->cmap[i] = NULL;
+		}
+	}
+
+	font->kernMask = -1;
+	n = fons__tt_getKernPairs(&font->font, NULL, 0);
+	if (n <= 0) {
+		font->kernMask = n == 0 ? 0 : -1;
+		return;
+	}
+	for (slots = 16; slots < n*4; slots *= 2)
+		;
+	pairs = (FONSkernPair*)malloc(sizeof(FONSkernPair) * n);
+	font->kern = (FONSkernPair*)malloc(sizeof(FONSkernPair) * slots);
+	if (pairs == NULL || font->kern == NULL) {
+		free(pairs);
+		free(font->kern);
+		font->kern = NULL;
+		return;
+	}
+	for (i = 0; i < slots; i++)
+		font->kern[i].glyphs = FONS_KERN_EMPTY;
+	font->kernMask = slots-1;
+	n = fons__tt_getKernPairs(&font->font, pairs, n);
+	// Inserted in table order, the first of duplicate pairs is kept.
+	for (i = 0; i < n; i++) {
+		unsigned int h = fons__hashint(pairs[i].glyphs) & font->kernMask;
+		if (pairs[i].glyphs == FONS_KERN_EMPTY) continue;
+		while (font->kern[h].glyphs != FONS_KERN_EMPTY && font->kern[h].glyphs != pairs[i].glyphs)
+			h = (h+1) & font->kernMask;
+		if (font->kern[h].glyphs == FONS_KERN_EMPTY)
+			font->kern[h] = pairs[i];
+	}
+	free(pairs);
+}
+
+static int fons__glyphIndex(FONSfont* font, unsigned int codepoint)
+{
+	if (font->hasCmap && codepoint < 0x10000) {
+		const unsigned short* page = font->cmap[codepoint >> 8];
+		return page != NULL ? page[codepoint & 0xff] : 0;
+	}
+	return fons__tt_getGlyphIndex(&font->font, codepoint);
+}
+
+static int fons__kernAdvance(FONSfont* font, int glyph1, int glyph2)
+{
+	unsigned int glyphs, h;
+	if (font->kernMask < 0)
+		return fons__tt_getGlyphKernAdvance(&font->font, glyph1, glyph2);
+	if (font->kern == NULL)
+		return 0;
+	glyphs = (unsigned int)glyph1 << 16 | (unsigned int)glyph2;
+	h = fons__hashint(glyphs) & font->kernMask;
+	while (font->kern[h].glyphs != FONS_KERN_EMPTY) {
+		if (font->kern[h].glyphs == glyphs)
+			return font->kern[h].advance;
+		h = (h+1) & font->kernMask;
+	}
+	return 0;
+}
+
 int fonsAddFontMem(FONScontext* stash, const char* name, unsigned char* data, int dataSize, int freeData)
 {
 	int i, ascent, descent, fh, lineGap;
@@ -942,8 +1494,10 @@ int fonsAddFontMem(FONScontext* stash, const char* name, unsigned char* data, in
 	font->freeData = (unsigned char)freeData;
 
 	// Init font
-	stash->nscratch = 0;
+	stash->scratch.n = 0;
 	if (!fons__tt_loadFont(stash, &font->font, data, dataSize)) goto error;
+	fons__tt_setAllocator(&font->font, &stash->scratch);
+	fons__buildLookups(font);
 
 	// Store normalized line height. The real line height is got
 	// by multiplying the lineh by font size.
@@ -983,6 +1537,30 @@ static FONSglyph* fons__allocGlyph(FONSfont* font)
 	return &font->glyphs[font->nglyphs-1];
 }
 
+// Drops the glyphs without a bitmap when they are most of the font, the evicted glyphs are
+// measured again when they are used.
+static void fons__pruneGlyphs(FONSfont* font)
+{
+	int i, n = 0;
+	unsigned int h;
+	for (i = 0; i < font->nglyphs; i++) {
+		if (font->glyphs[i].x0 >= 0 || font->glyphs[i].pending) n++;
+	}
+	if (font->nglyphs - n < FONS_INIT_GLYPHS || font->nglyphs - n < n) return;
+
+	for (i = 0; i < FONS_HASH_LUT_SIZE; i++)
+		font->lut[i] = -1;
+	for (i = n = 0; i < font->nglyphs; i++) {
+		if (font->glyphs[i].x0 < 0 && !font->glyphs[i].pending) continue;
+		font->glyphs[n] = font->glyphs[i];
+		h = fons__hashint(font->glyphs[n].codepoint) & (FONS_HASH_LUT_SIZE-1);
+		font->glyphs[n].next = font->lut[h];
+		font->lut[h] = n;
+		n++;
+	}
+	font->nglyphs = n;
+}
+
 
 // Based on Exponential blur, Jani Huhtanen, 2006
 
@@ -1049,109 +1627,848 @@ static void fons__blur(FONScontext* stash, unsigned char* dst, int w, int h, int
 //	fons__blurcols(dst, w, h, dstStride, alpha);
 }
 
-static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint,
-								 short isize, short iblur, int bitmapOption)
+// Writes the signed distance of the pixel centers to the outline, -spread..spread is mapped to 0..255
+// so the edge is at 0.5 and the inside above, (ox,oy) is the top left corner of dst in the outline.
+static void fons__distanceField(FONSoutline* o, unsigned char* dst, int w, int h, int dstStride,
+								float ox, float oy, float spread)
 {
-	int i, g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy, x, y;
-	float scale;
-	FONSglyph* glyph = NULL;
-	unsigned int h;
-	float size = isize/10.0f;
-	int pad, added;
-	unsigned char* bdst;
-	unsigned char* dst;
-	FONSfont* renderFont = font;
-
-	if (isize < 2) return NULL;
-	if (iblur > 20) iblur = 20;
-	pad = iblur+2;
-
-	// Reset allocator.
-	stash->nscratch = 0;
+	int x, y, i, nnear, ncross;
 
-	// Find code point and size.
-	h = fons__hashint(codepoint) & (FONS_HASH_LUT_SIZE-1);
-	i = font->lut[h];
-	while (i != -1) {
-		if (font->glyphs[i].codepoint == codepoint && font->glyphs[i].size == isize && font->glyphs[i].blur == iblur) {
-			glyph = &font->glyphs[i];
-			if (bitmapOption == FONS_GLYPH_BITMAP_OPTIONAL || (glyph->x0 >= 0 && glyph->y0 >= 0)) {
-			  return glyph;
-			}
-			// At this point, glyph exists but the bitmap data is not yet created.
-			break;
+	if (o->nsegs > o->cwork) {
+		int* near = (int*)realloc(o->near, sizeof(int) * o->nsegs);
+		float* cross;
+		if (near != NULL) o->near = near;
+		cross = (float*)realloc(o->cross, sizeof(float) * 2 * o->nsegs);
+		if (cross != NULL) o->cross = cross;
+		if (near == NULL || cross == NULL) {
+			for (y = 0; y < h; y++)
+				memset(&dst[y*dstStride], 0, w);
+			return;
 		}
-		i = font->glyphs[i].next;
+		o->cwork = o->nsegs;
 	}
 
-	// Create a new glyph or rasterize bitmap data for a cached glyph.
-	g = fons__tt_getGlyphIndex(&font->font, codepoint);
-	// Try to find the glyph in fallback fonts.
-	if (g == 0) {
-		for (i = 0; i < font->nfallbacks; ++i) {
-			FONSfont* fallbackFont = stash->fonts[font->fallbacks[i]];
-			int fallbackIndex = fons__tt_getGlyphIndex(&fallbackFont->font, codepoint);
-			if (fallbackIndex != 0) {
-				g = fallbackIndex;
-				renderFont = fallbackFont;
-				break;
+	for (y = 0; y < h; y++) {
+		float py = oy + y + 0.5f;
+		// Segments closer than the spread to the row, and the row crossings for the winding.
+		nnear = ncross = 0;
+		for (i = 0; i < o->nsegs; i++) {
+			const float* seg = &o->segs[i*4];
+			float miny = seg[1] < seg[3] ? seg[1] : seg[3];
+			float maxy = seg[1] < seg[3] ? seg[3] : seg[1];
+			if (miny - spread <= py && py <= maxy + spread)
+				o->near[nnear++] = i;
+			if ((seg[1] <= py) != (seg[3] <= py)) {
+				o->cross[ncross*2+0] = seg[0] + (py - seg[1]) * (seg[2] - seg[0]) / (seg[3] - seg[1]);
+				o->cross[ncross*2+1] = seg[3] > seg[1] ? 1.0f : -1.0f;
+				ncross++;
 			}
 		}
-		// It is possible that we did not find a fallback glyph.
-		// In that case the glyph index 'g' is 0, and we'll proceed below and cache empty glyph.
+		for (x = 0; x < w; x++) {
+			float px = ox + x + 0.5f;
+			float best = spread*spread;
+			float winding = 0.0f, d;
+			for (i = 0; i < ncross; i++) {
+				if (o->cross[i*2] > px)
+					winding += o->cross[i*2+1];
+			}
+			for (i = 0; i < nnear; i++) {
+				const float* seg = &o->segs[o->near[i]*4];
+				float dx = seg[2] - seg[0], dy = seg[3] - seg[1];
+				float t = ((px - seg[0])*dx + (py - seg[1])*dy) / (dx*dx + dy*dy);
+				float ex, ey;
+				if (t < 0.0f) t = 0.0f;
+				else if (t > 1.0f) t = 1.0f;
+				ex = seg[0] + t*dx - px;
+				ey = seg[1] + t*dy - py;
+				if (ex*ex + ey*ey < best)
+					best = ex*ex + ey*ey;
+			}
+			d = sqrtf(best);
+			if (winding == 0.0f) d = -d;
+			d = 0.5f + d / (2.0f*spread);
+			dst[x + y*dstStride] = (unsigned char)((d < 0.0f ? 0.0f : (d > 1.0f ? 1.0f : d)) * 255.0f + 0.5f);
+		}
 	}
-	scale = fons__tt_getPixelHeightScale(&renderFont->font, size);
-	fons__tt_buildGlyphBitmap(&renderFont->font, g, size, scale, &advance, &lsb, &x0, &y0, &x1, &y1);
-	gw = x1-x0 + pad*2;
-	gh = y1-y0 + pad*2;
+}
 
-	// Determines the spot to draw glyph in the atlas.
-	if (bitmapOption == FONS_GLYPH_BITMAP_REQUIRED) {
-		// Find free spot for the rect in the atlas
-		added = fons__atlasAddRect(stash->atlas, gw, gh, &gx, &gy);
-		if (added == 0 && stash->handleError != NULL) {
-			// Atlas is full, let the user to resize the atlas (or not), and try again.
-			stash->handleError(stash->errorUptr, FONS_ATLAS_FULL, 0);
-			added = fons__atlasAddRect(stash->atlas, gw, gh, &gx, &gy);
+// Adds the area the segment covers right of each pixel boundary it crosses to the accumulation
+// buffer, rows aw floats apart and (x,y) in pixels of the bitmap with x clamped to 0..w.
+static void fons__accumulateLine(float* accum, int aw, int w, int h, float x0, float y0, float x1, float y1)
+{
+	float dir, dxdy, x, t;
+	int y, ystart, yend;
+
+	if (y0 == y1) return;
+	x0 = x0 < 0.0f ? 0.0f : (x0 > (float)w ? (float)w : x0);
+	x1 = x1 < 0.0f ? 0.0f : (x1 > (float)w ? (float)w : x1);
+	dir = 1.0f;
+	if (y0 > y1) {
+		t = x0; x0 = x1; x1 = t;
+		t = y0; y0 = y1; y1 = t;
+		dir = -1.0f;
+	}
+	dxdy = (x1 - x0) / (y1 - y0);
+	x = x0;
+	if (y0 < 0.0f) {
+		x -= y0 * dxdy;
+		y0 = 0.0f;
+	}
+	ystart = (int)y0;
+	yend = (int)ceilf(y1);
+	if (yend > h) yend = h;
+	for (y = ystart; y < yend; y++) {
+		float* row = &accum[y*aw];
+		float dy = ((float)(y+1) < y1 ? (float)(y+1) : y1) - ((float)y > y0 ? (float)y : y0);
+		float xnext = x + dxdy * dy;
+		float d = dy * dir;
+		float xa = x < xnext ? x : xnext, xb = x < xnext ? xnext : x;
+		float xafloor = floorf(xa);
+		int xai = (int)xafloor, xbi = (int)ceilf(xb);
+		if (xbi <= xai + 1) {
+			// Within one pixel, split by the mid point.
+			float xm = 0.5f * (x + xnext) - xafloor;
+			row[xai] += d - d * xm;
+			row[xai+1] += d * xm;
+		} else {
+			float s = 1.0f / (xb - xa);
+			float xaf = xa - xafloor, xbf = xb - (float)xbi + 1.0f;
+			float a0 = 0.5f * s * (1.0f - xaf) * (1.0f - xaf);
+			float am = 0.5f * s * xbf * xbf;
+			int xi;
+			row[xai] += d * a0;
+			if (xbi == xai + 2) {
+				row[xai+1] += d * (1.0f - a0 - am);
+			} else {
+				float a1 = s * (1.5f - xaf), a2;
+				row[xai+1] += d * (a1 - a0);
+				for (xi = xai + 2; xi < xbi - 1; xi++)
+					row[xi] += d * s;
+				a2 = a1 + (float)(xbi - xai - 3) * s;
+				row[xbi-1] += d * (1.0f - a2 - am);
+			}
+			row[xbi] += d * am;
 		}
-		if (added == 0) return NULL;
-	} else {
-		// Negative coordinate indicates there is no bitmap data created.
-		gx = -1;
-		gy = -1;
+		x = xnext;
 	}
+}
 
-	// Init glyph.
-	if (glyph == NULL) {
-		glyph = fons__allocGlyph(font);
-		glyph->codepoint = codepoint;
-		glyph->size = isize;
-		glyph->blur = iblur;
-		glyph->next = 0;
+// Rasterizes the outline by accumulating the signed area of its segments per pixel, the running
+// sum along each row is the coverage with the nonzero winding rule. (ox,oy) is the top left corner
+// of dst in the outline. Returns 0 when out of memory.
+static int fons__accumulateOutline(FONSoutline* o, unsigned char* dst, int w, int h, int dstStride,
+								   float ox, float oy)
+{
+	// Two floats past the row for the boundaries at x = w, rounded up for whole SIMD steps.
+	int aw = (w + 5) & ~3;
+	int i, x, y;
 
-		// Insert char to hash lookup.
-		glyph->next = font->lut[h];
-		font->lut[h] = font->nglyphs-1;
+	if (aw * h > o->caccum) {
+		float* accum = (float*)realloc(o->accum, sizeof(float) * aw * h);
+		if (accum == NULL) return 0;
+		memset(accum, 0, sizeof(float) * aw * h);
+		o->accum = accum;
+		o->caccum = aw * h;
 	}
-	glyph->index = g;
-	glyph->x0 = (short)gx;
-	glyph->y0 = (short)gy;
-	glyph->x1 = (short)(glyph->x0+gw);
-	glyph->y1 = (short)(glyph->y0+gh);
-	glyph->xadv = (short)(scale * advance * 10.0f);
+
+	for (i = 0; i < o->nsegs; i++) {
+		const float* seg = &o->segs[i*4];
+		fons__accumulateLine(o->accum, aw, w, h, seg[0] - ox, seg[1] - oy, seg[2] - ox, seg[3] - oy);
+	}
+
+	// Prefix sum of each row, the buffer is cleared behind it for the next glyph.
+	for (y = 0; y < h; y++) {
+		float* row = &o->accum[y*aw];
+		unsigned char* out = &dst[y*dstStride];
+#ifdef FONS_SSE2
+		__m128 sum = _mm_setzero_ps();
+		__m128 sign = _mm_set1_ps(-0.0f), one = _mm_set1_ps(1.0f), full = _mm_set1_ps(255.0f), half = _mm_set1_ps(0.5f);
+		for (x = 0; x < w; x += 4) {
+			__m128 v = _mm_loadu_ps(&row[x]);
+			__m128i c;
+			int bytes;
+			v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 4)));
+			v = _mm_add_ps(v, _mm_castsi128_ps(_mm_slli_si128(_mm_castps_si128(v), 8)));
+			v = _mm_add_ps(v, sum);
+			sum = _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3));
+			v = _mm_min_ps(_mm_andnot_ps(sign, v), one);
+			c = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, full), half));
+			c = _mm_packs_epi32(c, c);
+			bytes = _mm_cvtsi128_si32(_mm_packus_epi16(c, c));
+			if (x + 4 <= w) {
+				memcpy(&out[x], &bytes, 4);
+			} else {
+				for (i = 0; x + i < w; i++)
+					out[x+i] = (unsigned char)(bytes >> (i*8));
+			}
+		}
+#else
+		float sum = 0.0f;
+		for (x = 0; x < w; x++) {
+			float v;
+			sum += row[x];
+			v = sum < 0.0f ? -sum : sum;
+			out[x] = (unsigned char)((v > 1.0f ? 1.0f : v) * 255.0f + 0.5f);
+		}
+#endif
+		memset(row, 0, sizeof(float) * aw);
+	}
+	return 1;
+}
+
+// Rasterizes the w x h bitmap of a glyph, (x0,y0) is the top left corner of its box at scale.
+static void fons__renderGlyph(FONSttFontImpl* font, FONSoutline* outline, int rasterizer, unsigned char* dst,
+							  int w, int h, int dstStride, float scale, int glyph, int x0, int y0)
+{
+#if FONS_TT_ACCUMULATE
+	if (rasterizer == FONS_RASTER_ACCUMULATE) {
+		if (fons__tt_buildGlyphOutline(font, glyph, scale, outline))
+			fons__accumulateOutline(outline, dst, w, h, dstStride, (float)x0, (float)y0);
+		return;
+	}
+#else
+	FONS_NOTUSED(outline);
+	FONS_NOTUSED(rasterizer);
+	FONS_NOTUSED(x0);
+	FONS_NOTUSED(y0);
+#endif
+	fons__tt_renderGlyphBitmap(font, dst, w, h, dstStride, scale, scale, glyph);
+}
+
+// Glyph bitmap rasterized by a task of the asynchronous rasterizer, the task only reads the font.
+struct FONSjob {
+	FONSfont* font;				// Font of the glyph, and the copy of the font rendering it
+	FONSttFontImpl renderFont;
+	unsigned int codepoint;
+	short size, blur;
+	int index;
+	float scale;
+	int pad, gw, gh, x0, y0;
+	int rasterizer;
+	unsigned char* bitmap;		// gw x gh, NULL when out of memory
+};
+typedef struct FONSjob FONSjob;
+
+#ifndef FONS_COLLECT_BATCH
+#	define FONS_COLLECT_BATCH 64
+#endif
+
+static void fons__rasterizeJob(void* data, int index)
+{
+	FONSjob* job = (FONSjob*)data;
+	FONSscratch scratch;
+	FONSoutline outline;
+	int x, y, gw = job->gw, gh = job->gh, pad = job->pad;
+	unsigned char* dst;
+	FONS_NOTUSED(index);
+
+	job->bitmap = (unsigned char*)calloc(gw*gh, 1);
+	scratch.data = (unsigned char*)malloc(FONS_SCRATCH_BUF_SIZE);
+	scratch.n = 0;
+	scratch.stash = NULL;
+	if (job->bitmap == NULL || scratch.data == NULL) {
+		free(job->bitmap);
+		free(scratch.data);
+		job->bitmap = NULL;
+		return;
+	}
+	fons__tt_setAllocator(&job->renderFont, &scratch);
+
+	memset(&outline, 0, sizeof(outline));
+	if (job->blur == FONS_SDF_BLUR) {
+		if (fons__tt_buildGlyphOutline(&job->renderFont, job->index, job->scale, &outline))
+			fons__distanceField(&outline, job->bitmap, gw, gh, gw,
+								(float)(job->x0 - pad), (float)(job->y0 - pad), (float)FONS_SDF_SPREAD);
+	} else {
+		fons__renderGlyph(&job->renderFont, &outline, job->rasterizer, &job->bitmap[pad + pad*gw], gw-pad*2, gh-pad*2, gw,
+						  job->scale, job->index, job->x0, job->y0);
+		dst = job->bitmap;
+		for (y = 0; y < gh; y++) {
+			dst[y*gw] = 0;
+			dst[gw-1 + y*gw] = 0;
+		}
+		for (x = 0; x < gw; x++) {
+			dst[x] = 0;
+			dst[x + (gh-1)*gw] = 0;
+		}
+		if (job->blur > 0) {
+			scratch.n = 0;
+			fons__blur(NULL, dst, gw, gh, gw, job->blur);
+		}
+	}
+	free(outline.segs);
+	free(outline.near);
+	free(outline.cross);
+	free(outline.accum);
+	free(scratch.data);
+}
+
+// Pieces of free space smaller than this are not reused.
+#define FONS_MIN_FREE_RECT 8
+
+static void fons__addFreeRect(FONScontext* stash, int page, int x, int y, int w, int h)
+{
+	FONSrect* r;
+	if (w < FONS_MIN_FREE_RECT || h < FONS_MIN_FREE_RECT) return;
+	if (stash->nfreeRects+1 > stash->cfreeRects) {
+		int cap = stash->cfreeRects == 0 ? 16 : stash->cfreeRects * 2;
+		FONSrect* rects = (FONSrect*)realloc(stash->freeRects, sizeof(FONSrect) * cap);
+		if (rects == NULL) return;
+		stash->freeRects = rects;
+		stash->cfreeRects = cap;
+	}
+	r = &stash->freeRects[stash->nfreeRects++];
+	r->page = (short)page;
+	r->x = (short)x;
+	r->y = (short)y;
+	r->w = (short)w;
+	r->h = (short)h;
+}
+
+// Takes space from the free rect leaving the shortest side on a page drawn this frame. The rect is
+// cut into the piece right of the glyph and the full width below it, the free rects do not overlap.
+static int fons__takeFreeRect(FONScontext* stash, int w, int h, int* page, int* x, int* y)
+{
+	int i, best = -1, bestSide = 0;
+	FONSrect r;
+	for (i = 0; i < stash->nfreeRects; i++) {
+		FONSrect* fr = &stash->freeRects[i];
+		int side = fons__mini(fr->w - w, fr->h - h);
+		if (side < 0 || stash->pages[fr->page].lastUsed < stash->frame) continue;
+		if (best == -1 || side < bestSide) {
+			best = i;
+			bestSide = side;
+		}
+	}
+	if (best == -1) return 0;
+
+	r = stash->freeRects[best];
+	stash->freeRects[best] = stash->freeRects[--stash->nfreeRects];
+	*page = r.page;
+	*x = r.x;
+	*y = r.y;
+	fons__addFreeRect(stash, r.page, r.x + w, r.y, r.w - w, h);
+	fons__addFreeRect(stash, r.page, r.x, r.y + h, r.w, r.h - h);
+	return 1;
+}
+
+static int fons__cmpShort(const void* a, const void* b)
+{
+	return *(const short*)a - *(const short*)b;
+}
+
+static int fons__cmpRectX(const void* a, const void* b)
+{
+	return ((const FONSrect*)a)->x - ((const FONSrect*)b)->x;
+}
+
+// Makes the space around the rects of a page free rects, in horizontal bands between the edges
+// of the rects, the free rects of a band are extended down by the same rects of the next band.
+static void fons__addFreeSpace(FONScontext* stash, int page, FONSrect* used, int nused)
+{
+	int i, j, k, nys = 0, nband, prev = 0, nprev = 0, nrects = 0, crects = nused*2 + 16;
+	short* ys = (short*)malloc(sizeof(short) * (nused*2 + 2));
+	FONSrect* band = (FONSrect*)malloc(sizeof(FONSrect) * (nused + 1));
+	FONSrect* rects = (FONSrect*)malloc(sizeof(FONSrect) * crects);
+	if (ys == NULL || band == NULL || rects == NULL) goto done;
+
+	ys[nys++] = 0;
+	ys[nys++] = (short)stash->params.height;
+	for (i = 0; i < nused; i++) {
+		ys[nys++] = used[i].y;
+		ys[nys++] = (short)(used[i].y + used[i].h);
+	}
+	qsort(ys, nys, sizeof(short), fons__cmpShort);
+	qsort(used, nused, sizeof(FONSrect), fons__cmpRectX);
+
+	for (i = 0; i+1 < nys; i++) {
+		int y0 = ys[i], y1 = ys[i+1], x = 0, first = nrects;
+		if (y0 == y1) continue;
+		// The rects across the band by x, the gaps between them are free.
+		nband = 0;
+		for (j = 0; j < nused; j++) {
+			if (used[j].y <= y0 && used[j].y + used[j].h >= y1)
+				band[nband++] = used[j];
+		}
+		for (j = 0; j <= nband; j++) {
+			int x1 = j < nband ? band[j].x : stash->params.width;
+			if (x1 > x) {
+				FONSrect* r = NULL;
+				if (nrects+1 > crects) {
+					FONSrect* grown = (FONSrect*)realloc(rects, sizeof(FONSrect) * crects * 2);
+					if (grown == NULL) goto done;
+					rects = grown;
+					crects *= 2;
+				}
+				for (k = prev; k < prev + nprev; k++) {
+					if (rects[k].x == x && rects[k].w == x1 - x && rects[k].y + rects[k].h == y0) {
+						r = &rects[k];
+						break;
+					}
+				}
+				if (r != NULL) {
+					// Extended, moved to this band.
+					FONSrect t = *r;
+					t.h = (short)(t.h + y1 - y0);
+					r->w = 0;
+					rects[nrects++] = t;
+				} else {
+					rects[nrects].page = (short)page;
+					rects[nrects].x = (short)x;
+					rects[nrects].y = (short)y0;
+					rects[nrects].w = (short)(x1 - x);
+					rects[nrects].h = (short)(y1 - y0);
+					nrects++;
+				}
+			}
+			if (j < nband)
+				x = fons__maxi(x, band[j].x + band[j].w);
+		}
+		prev = first;
+		nprev = nrects - first;
+	}
+	for (i = 0; i < nrects; i++) {
+		if (rects[i].w != 0)
+			fons__addFreeRect(stash, page, rects[i].x, rects[i].y, rects[i].w, rects[i].h);
+	}
+
+done:
+	if (ys != NULL) free(ys);
+	if (band != NULL) free(band);
+	if (rects != NULL) free(rects);
+}
+
+// Replaces the free rects of a page with the space around its glyphs, merging the space of the
+// evicted glyphs. The page is only packed from the free rects until it is emptied.
+static void fons__rebuildFreeSpace(FONScontext* stash, int page)
+{
+	int i, j, nused = 1;
+	FONSrect* used;
+	FONSatlas* atlas = stash->pages[page].atlas;
+
+	for (i = 0; i < stash->nfonts; i++)
+		nused += stash->fonts[i]->nglyphs;
+	used = (FONSrect*)malloc(sizeof(FONSrect) * nused);
+	if (used == NULL) return;
+
+	nused = 0;
+	if (page == 0) {
+		// The white rect.
+		used[nused].page = 0;
+		used[nused].x = used[nused].y = 0;
+		used[nused].w = used[nused].h = 2;
+		nused++;
+	}
+	for (i = 0; i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		for (j = 0; j < font->nglyphs; j++) {
+			FONSglyph* glyph = &font->glyphs[j];
+			if (glyph->x0 < 0 || glyph->page != page) continue;
+			used[nused].page = (short)page;
+			used[nused].x = glyph->x0;
+			used[nused].y = glyph->y0;
+			used[nused].w = (short)(glyph->x1 - glyph->x0);
+			used[nused].h = (short)(glyph->y1 - glyph->y0);
+			nused++;
+		}
+	}
+
+	for (i = j = 0; i < stash->nfreeRects; i++) {
+		if (stash->freeRects[i].page != page)
+			stash->freeRects[j++] = stash->freeRects[i];
+	}
+	stash->nfreeRects = j;
+	fons__addFreeSpace(stash, page, used, nused);
+	free(used);
+
+	fons__atlasReset(atlas, atlas->width, atlas->height);
+	atlas->nodes[0].y = (short)atlas->height;
+}
+
+static void fons__evictGlyph(FONScontext* stash, FONSglyph* glyph)
+{
+	// Keep the size, like glyphs measured without a bitmap.
+	glyph->x1 = (short)(glyph->x1 - glyph->x0 - 1);
+	glyph->y1 = (short)(glyph->y1 - glyph->y0 - 1);
+	glyph->x0 = -1;
+	glyph->y0 = -1;
+	stash->stats.evictions++;
+}
+
+// Evicts the least recently drawn glyph at least w x h not drawn this frame, from a page drawn this
+// frame, with the glyphs drawn before it on the pages drawn this frame.
+static int fons__evictLRUGlyphs(FONScontext* stash, int w, int h)
+{
+	int i, j, p, oldest = -1;
+	int evicted[FONS_MAX_PAGES];
+	for (i = 0; i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		for (j = 0; j < font->nglyphs; j++) {
+			FONSglyph* glyph = &font->glyphs[j];
+			if (glyph->x0 < 0 || glyph->lastUsed >= stash->frame) continue;
+			if (stash->pages[glyph->page].lastUsed < stash->frame) continue;
+			if (glyph->x1 - glyph->x0 < w || glyph->y1 - glyph->y0 < h) continue;
+			if (oldest == -1 || glyph->lastUsed < oldest)
+				oldest = glyph->lastUsed;
+		}
+	}
+	if (oldest == -1) return 0;
+
+	for (p = 0; p < stash->npages; p++)
+		evicted[p] = 0;
+	for (i = 0; i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		for (j = 0; j < font->nglyphs; j++) {
+			FONSglyph* glyph = &font->glyphs[j];
+			if (glyph->x0 < 0 || glyph->lastUsed > oldest) continue;
+			if (stash->pages[glyph->page].lastUsed < stash->frame) continue;
+			evicted[glyph->page] = 1;
+			fons__evictGlyph(stash, glyph);
+		}
+	}
+	for (p = 0; p < stash->npages; p++) {
+		if (evicted[p])
+			fons__rebuildFreeSpace(stash, p);
+	}
+	return 1;
+}
+
+// Empties the least recently drawn page not drawn this frame and returns it, or -1.
+static int fons__evictLRUPage(FONScontext* stash)
+{
+	int i, j, page = -1;
+	for (i = 0; i < stash->npages; i++) {
+		if (stash->pages[i].lastUsed >= stash->frame) continue;
+		if (page == -1 || stash->pages[i].lastUsed < stash->pages[page].lastUsed)
+			page = i;
+	}
+	if (page == -1) return -1;
+
+	for (i = 0; i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		for (j = 0; j < font->nglyphs; j++) {
+			FONSglyph* glyph = &font->glyphs[j];
+			if (glyph->x0 >= 0 && glyph->page == page)
+				fons__evictGlyph(stash, glyph);
+		}
+	}
+	for (i = j = 0; i < stash->nfreeRects; i++) {
+		if (stash->freeRects[i].page != page)
+			stash->freeRects[j++] = stash->freeRects[i];
+	}
+	stash->nfreeRects = j;
+	fons__atlasReset(stash->pages[page].atlas, stash->params.width, stash->params.height);
+	if (page == 0)
+		fons__addWhiteRect(stash, 2,2);
+	return page;
+}
+
+// Evicts the glyphs not drawn this frame from the page where they take the most space.
+// Returns 0 if all the glyphs are drawn this frame.
+static int fons__compactPage(FONScontext* stash)
+{
+	int i, j, p, page = -1, best = 0;
+	int stale[FONS_MAX_PAGES];
+	for (p = 0; p < stash->npages; p++)
+		stale[p] = 0;
+	for (i = 0; i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		for (j = 0; j < font->nglyphs; j++) {
+			FONSglyph* glyph = &font->glyphs[j];
+			if (glyph->x0 >= 0 && glyph->lastUsed < stash->frame)
+				stale[glyph->page] += (glyph->x1 - glyph->x0) * (glyph->y1 - glyph->y0);
+		}
+	}
+	for (p = 0; p < stash->npages; p++) {
+		if (stale[p] > best) {
+			best = stale[p];
+			page = p;
+		}
+	}
+	if (page == -1) return 0;
+
+	for (i = 0; i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		for (j = 0; j < font->nglyphs; j++) {
+			FONSglyph* glyph = &font->glyphs[j];
+			if (glyph->x0 >= 0 && glyph->page == page && glyph->lastUsed < stash->frame)
+				fons__evictGlyph(stash, glyph);
+		}
+	}
+	fons__rebuildFreeSpace(stash, page);
+	return 1;
+}
+
+// Finds space for a glyph: packed on a page, on a new page, in the space of evicted glyphs or
+// evicting the least recently drawn glyphs. The glyphs drawn in a frame are kept on the pages drawn
+// in the frame, the space of the others is taken by emptying the least recently drawn page, and
+// when all the pages are drawn in the frame by evicting all the glyphs not drawn from a page.
+static int fons__allocRect(FONScontext* stash, int w, int h, int* page, int* x, int* y)
+{
+	int i;
+	for (i = 0; i < stash->npages; i++) {
+		if (fons__atlasAddRect(stash->pages[i].atlas, w, h, x, y)) {
+			*page = i;
+			return 1;
+		}
+	}
+	if (stash->npages < stash->params.pages && fons__addPage(stash)) {
+		*page = stash->npages-1;
+		return fons__atlasAddRect(stash->pages[*page].atlas, w, h, x, y);
+	}
+	if (fons__takeFreeRect(stash, w, h, page, x, y))
+		return 1;
+	if (fons__evictLRUGlyphs(stash, w, h) && fons__takeFreeRect(stash, w, h, page, x, y))
+		return 1;
+	*page = fons__evictLRUPage(stash);
+	if (*page != -1)
+		return fons__atlasAddRect(stash->pages[*page].atlas, w, h, x, y);
+	while (fons__compactPage(stash)) {
+		if (fons__takeFreeRect(stash, w, h, page, x, y))
+			return 1;
+	}
+	return 0;
+}
+
+static FONSglyph* fons__findGlyph(FONSfont* font, unsigned int codepoint, short isize, short iblur)
+{
+	int i = font->lut[fons__hashint(codepoint) & (FONS_HASH_LUT_SIZE-1)];
+	while (i != -1) {
+		if (font->glyphs[i].codepoint == codepoint && font->glyphs[i].size == isize && font->glyphs[i].blur == iblur)
+			return &font->glyphs[i];
+		i = font->glyphs[i].next;
+	}
+	return NULL;
+}
+
+static int fons__hasGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint)
+{
+	int i;
+	if (fons__glyphIndex(font, codepoint) != 0)
+		return 1;
+	for (i = 0; i < font->nfallbacks; ++i) {
+		if (fons__glyphIndex(stash->fonts[font->fallbacks[i]], codepoint) != 0)
+			return 1;
+	}
+	return 0;
+}
+
+// Submits the rasterization of the bitmap of the glyph, the glyph is pending until the task is collected.
+static void fons__submitGlyph(FONScontext* stash, FONSfont* font, FONSfont* renderFont, FONSglyph* glyph,
+							  float scale, int pad, int x0, int y0)
+{
+	FONSjob* job = (FONSjob*)malloc(sizeof(FONSjob));
+	if (job == NULL) return;
+	job->font = font;
+	job->renderFont = renderFont->font;
+	job->codepoint = glyph->codepoint;
+	job->size = glyph->size;
+	job->blur = glyph->blur;
+	job->index = glyph->index;
+	job->scale = scale;
+	job->pad = pad;
+	job->gw = glyph->x1 - glyph->x0;
+	job->gh = glyph->y1 - glyph->y0;
+	job->x0 = x0;
+	job->y0 = y0;
+	job->rasterizer = stash->rasterizer;
+	job->bitmap = NULL;
+	glyph->pending = 1;
+	stash->njobs++;
+	stash->submit(stash->asyncUptr, fons__rasterizeJob, job);
+}
+
+// Copies the bitmap of a finished task into the atlas, unless the glyph was reset meanwhile.
+static int fons__finishJob(FONScontext* stash, FONSjob* job)
+{
+	FONSglyph* glyph = fons__findGlyph(job->font, job->codepoint, job->size, job->blur);
+	int y, gpage = 0, gx, gy, added = 0;
+	unsigned char* dst;
+
+	stash->njobs--;
+	if (glyph != NULL && glyph->pending) {
+		glyph->pending = 0;
+		if (job->bitmap != NULL) {
+			added = fons__allocRect(stash, job->gw, job->gh, &gpage, &gx, &gy);
+			if (added == 0 && stash->handleError != NULL) {
+				stash->handleError(stash->errorUptr, FONS_ATLAS_FULL, 0);
+				added = fons__allocRect(stash, job->gw, job->gh, &gpage, &gx, &gy);
+			}
+		}
+		if (added) {
+			glyph->page = (short)gpage;
+			glyph->x0 = (short)gx;
+			glyph->y0 = (short)gy;
+			glyph->x1 = (short)(gx+job->gw);
+			glyph->y1 = (short)(gy+job->gh);
+			for (y = 0; y < job->gh; y++) {
+				dst = fons__texel(stash, gpage, gx, gy+y);
+				memcpy(dst, &job->bitmap[y*job->gw], job->gw);
+			}
+			if (glyph->lastUsed >= stash->frame)
+				stash->pages[gpage].lastUsed = stash->frame;
+			stash->stats.misses++;
+			fons__addDirty(stash, gpage, glyph->x0, glyph->y0, glyph->x1, glyph->y1);
+		}
+	}
+	free(job->bitmap);
+	free(job);
+	return added;
+}
+
+static int fons__collectJobs(FONScontext* stash, int wait)
+{
+	void* done[FONS_COLLECT_BATCH];
+	int i, n, added = 0;
+	if (stash->collect == NULL) return 0;
+	do {
+		n = stash->collect(stash->asyncUptr, done, FONS_COLLECT_BATCH, wait);
+		for (i = 0; i < n; i++)
+			added += fons__finishJob(stash, (FONSjob*)done[i]);
+	} while (wait ? stash->njobs > 0 && n > 0 : n == FONS_COLLECT_BATCH);
+	return added;
+}
+
+static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned int codepoint,
+								 short isize, short iblur, int bitmapOption)
+{
+	int i, g, advance, lsb, x0, y0, x1, y1, gw, gh, gx, gy, gpage = 0, x, y;
+	float scale;
+	FONSglyph* glyph = NULL;
+	unsigned int h;
+	float size = isize/10.0f;
+	int pad, added;
+	unsigned char* bdst;
+	unsigned char* dst;
+	FONSfont* renderFont = font;
+	int sdf = iblur == FONS_SDF_BLUR;
+	int async = bitmapOption == FONS_GLYPH_BITMAP_REQUIRED && stash->submit != NULL && FONS_TT_REENTRANT;
+
+	if (isize < 2) return NULL;
+	if (iblur > 20) iblur = 20;
+	pad = sdf ? FONS_SDF_SPREAD+1 : iblur+2;
+
+	// Reset allocator.
+	stash->scratch.n = 0;
+
+	// Find code point and size.
+	h = fons__hashint(codepoint) & (FONS_HASH_LUT_SIZE-1);
+	i = font->lut[h];
+	while (i != -1) {
+		if (font->glyphs[i].codepoint == codepoint && font->glyphs[i].size == isize && font->glyphs[i].blur == iblur) {
+			glyph = &font->glyphs[i];
+			if (bitmapOption == FONS_GLYPH_BITMAP_OPTIONAL) {
+			  return glyph;
+			}
+			if (glyph->x0 >= 0 && glyph->y0 >= 0) {
+				glyph->lastUsed = stash->frame;
+				stash->pages[glyph->page].lastUsed = stash->frame;
+				stash->stats.hits++;
+				return glyph;
+			}
+			if (glyph->pending) {
+				glyph->lastUsed = stash->frame;
+				return glyph;
+			}
+			// At this point, glyph exists but the bitmap data is not yet created.
+			break;
+		}
+		i = font->glyphs[i].next;
+	}
+
+	// Create a new glyph or rasterize bitmap data for a cached glyph.
+	g = fons__glyphIndex(font, codepoint);
+	// Try to find the glyph in fallback fonts.
+	if (g == 0) {
+		for (i = 0; i < font->nfallbacks; ++i) {
+			FONSfont* fallbackFont = stash->fonts[font->fallbacks[i]];
+			int fallbackIndex = fons__glyphIndex(fallbackFont, codepoint);
+			if (fallbackIndex != 0) {
+				g = fallbackIndex;
+				renderFont = fallbackFont;
+				break;
+			}
+		}
+		// It is possible that we did not find a fallback glyph.
+		// In that case the glyph index 'g' is 0, and we'll proceed below and cache empty glyph.
+	}
+	scale = fons__tt_getPixelHeightScale(&renderFont->font, size);
+	fons__tt_buildGlyphBitmap(&renderFont->font, g, size, scale, &advance, &lsb, &x0, &y0, &x1, &y1);
+	gw = x1-x0 + pad*2;
+	gh = y1-y0 + pad*2;
+
+	// Determines the spot to draw glyph in the atlas, a task rasterizes it first when asynchronous.
+	if (bitmapOption == FONS_GLYPH_BITMAP_REQUIRED && !async) {
+		// Find free spot for the rect in the atlas
+		added = fons__allocRect(stash, gw, gh, &gpage, &gx, &gy);
+		if (added == 0 && stash->handleError != NULL) {
+			// Atlas is full, let the user to resize the atlas (or not), and try again.
+			stash->handleError(stash->errorUptr, FONS_ATLAS_FULL, 0);
+			added = fons__allocRect(stash, gw, gh, &gpage, &gx, &gy);
+		}
+		if (added == 0) return NULL;
+		stash->pages[gpage].lastUsed = stash->frame;
+		stash->stats.misses++;
+	} else {
+		// Negative coordinate indicates there is no bitmap data created.
+		gx = -1;
+		gy = -1;
+	}
+
+	// Init glyph.
+	if (glyph == NULL) {
+		glyph = fons__allocGlyph(font);
+		glyph->codepoint = codepoint;
+		glyph->size = isize;
+		glyph->blur = iblur;
+		glyph->pending = 0;
+		glyph->next = 0;
+
+		// Insert char to hash lookup.
+		glyph->next = font->lut[h];
+		font->lut[h] = font->nglyphs-1;
+	}
+	glyph->index = g;
+	glyph->page = (short)gpage;
+	glyph->lastUsed = stash->frame;
+	glyph->x0 = (short)gx;
+	glyph->y0 = (short)gy;
+	glyph->x1 = (short)(glyph->x0+gw);
+	glyph->y1 = (short)(glyph->y0+gh);
+	glyph->xadv = sdf ? (short)advance : (short)(scale * advance * 10.0f);
 	glyph->xoff = (short)(x0 - pad);
 	glyph->yoff = (short)(y0 - pad);
 
 	if (bitmapOption == FONS_GLYPH_BITMAP_OPTIONAL) {
 		return glyph;
 	}
+	if (async) {
+		fons__submitGlyph(stash, font, renderFont, glyph, scale, pad, x0, y0);
+		return glyph;
+	}
 
-	// Rasterize
-	dst = &stash->texData[(glyph->x0+pad) + (glyph->y0+pad) * stash->params.width];
-	fons__tt_renderGlyphBitmap(&renderFont->font, dst, gw-pad*2,gh-pad*2, stash->params.width, scale, scale, g);
+	// Distance field, the outermost pixels are further than the spread and empty.
+	if (sdf) {
+		SGE_PROFILE_BEGIN("fons__distanceField");
+		dst = fons__texel(stash, gpage, glyph->x0, glyph->y0);
+		if (fons__tt_buildGlyphOutline(&renderFont->font, g, scale, &stash->outline))
+			fons__distanceField(&stash->outline, dst, gw, gh, stash->params.width,
+								(float)(x0 - pad), (float)(y0 - pad), (float)FONS_SDF_SPREAD);
+		SGE_PROFILE_END();
+		goto done;
+	}
+
+	// Rasterize, the space of an evicted glyph is cleared first for the padding.
+	SGE_PROFILE_BEGIN("fons__rasterizeGlyph");
+	dst = fons__texel(stash, gpage, glyph->x0, glyph->y0);
+	for (y = 0; y < gh; y++)
+		memset(&dst[y*stash->params.width], 0, gw);
+	dst = fons__texel(stash, gpage, glyph->x0+pad, glyph->y0+pad);
+	fons__renderGlyph(&renderFont->font, &stash->outline, stash->rasterizer, dst, gw-pad*2, gh-pad*2,
+					  stash->params.width, scale, g, x0, y0);
 
 	// Make sure there is one pixel empty border.
-	dst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
+	dst = fons__texel(stash, gpage, glyph->x0, glyph->y0);
 	for (y = 0; y < gh; y++) {
 		dst[y*stash->params.width] = 0;
 		dst[gw-1 + y*stash->params.width] = 0;
@@ -1173,27 +2490,60 @@ static FONSglyph* fons__getGlyph(FONScontext* stash, FONSfont* font, unsigned in
 
 	// Blur
 	if (iblur > 0) {
-		stash->nscratch = 0;
-		bdst = &stash->texData[glyph->x0 + glyph->y0 * stash->params.width];
+		stash->scratch.n = 0;
+		bdst = fons__texel(stash, gpage, glyph->x0, glyph->y0);
 		fons__blur(stash, bdst, gw, gh, stash->params.width, iblur);
 	}
+	SGE_PROFILE_END();
 
-	stash->dirtyRect[0] = fons__mini(stash->dirtyRect[0], glyph->x0);
-	stash->dirtyRect[1] = fons__mini(stash->dirtyRect[1], glyph->y0);
-	stash->dirtyRect[2] = fons__maxi(stash->dirtyRect[2], glyph->x1);
-	stash->dirtyRect[3] = fons__maxi(stash->dirtyRect[3], glyph->y1);
+done:
+	fons__addDirty(stash, gpage, glyph->x0, glyph->y0, glyph->x1, glyph->y1);
 
 	return glyph;
 }
 
+// Returns the scale of the distance field glyphs to the text size and replaces the cache key,
+// or 0 if the state draws bitmap glyphs.
+static float fons__sdfKey(FONSstate* state, short* isize, short* iblur)
+{
+	float sdfScale;
+	if (!state->sdf || *isize < 2) return 0.0f;
+	sdfScale = (float)*isize/10.0f / FONS_SDF_SIZE;
+	*isize = FONS_SDF_SIZE*10;
+	*iblur = FONS_SDF_BLUR;
+	return sdfScale;
+}
+
 static void fons__getQuad(FONScontext* stash, FONSfont* font,
 						   int prevGlyphIndex, FONSglyph* glyph,
-						   float scale, float spacing, float* x, float* y, FONSquad* q)
+						   float scale, float spacing, float sdfScale, float* x, float* y, FONSquad* q)
 {
 	float rx,ry,xoff,yoff,x0,y0,x1,y1;
 
+	if (sdfScale > 0.0f) {
+		// Scaled, the positions are not snapped to pixels.
+		if (prevGlyphIndex != -1)
+			*x += fons__kernAdvance(font, prevGlyphIndex, glyph->index) * scale + spacing;
+		rx = *x + (glyph->xoff+1) * sdfScale;
+		ry = (stash->params.flags & FONS_ZERO_TOPLEFT) ? *y + (glyph->yoff+1) * sdfScale : *y - (glyph->yoff+1) * sdfScale;
+		q->x0 = rx;
+		q->y0 = ry;
+		q->x1 = rx + (glyph->x1 - glyph->x0 - 2) * sdfScale;
+		if (stash->params.flags & FONS_ZERO_TOPLEFT)
+			q->y1 = ry + (glyph->y1 - glyph->y0 - 2) * sdfScale;
+		else
+			q->y1 = ry - (glyph->y1 - glyph->y0 - 2) * sdfScale;
+		q->s0 = (glyph->x0+1) * stash->itw;
+		q->t0 = (glyph->y0+1) * stash->ith;
+		q->s1 = (glyph->x1-1) * stash->itw;
+		q->t1 = (glyph->y1-1) * stash->ith;
+		q->page = glyph->page;
+		*x += glyph->xadv * scale;
+		return;
+	}
+
 	if (prevGlyphIndex != -1) {
-		float adv = fons__tt_getGlyphKernAdvance(&font->font, prevGlyphIndex, glyph->index) * scale;
+		float adv = fons__kernAdvance(font, prevGlyphIndex, glyph->index) * scale;
 		*x += (int)(adv + spacing + 0.5f);
 	}
 
@@ -1206,6 +2556,7 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 	y0 = (float)(glyph->y0+1);
 	x1 = (float)(glyph->x1-1);
 	y1 = (float)(glyph->y1-1);
+	q->page = glyph->page;
 
 	if (stash->params.flags & FONS_ZERO_TOPLEFT) {
 		rx = (float)(int)(*x + xoff);
@@ -1238,17 +2589,46 @@ static void fons__getQuad(FONScontext* stash, FONSfont* font,
 	*x += (int)(glyph->xadv / 10.0f + 0.5f);
 }
 
+// Draws a glyph whose bitmap is not in the atlas yet stretched from the nearest size of it in the atlas,
+// or collapses the quad.
+static void fons__placeholderQuad(FONScontext* stash, FONSfont* font, FONSglyph* glyph, FONSquad* q)
+{
+	FONSglyph* best = NULL;
+	int i = font->lut[fons__hashint(glyph->codepoint) & (FONS_HASH_LUT_SIZE-1)];
+
+	stash->placeholders++;
+	while (i != -1) {
+		FONSglyph* other = &font->glyphs[i];
+		if (other->codepoint == glyph->codepoint && other->blur == glyph->blur && other->x0 >= 0 &&
+			(best == NULL || abs(other->size - glyph->size) < abs(best->size - glyph->size)))
+			best = other;
+		i = other->next;
+	}
+	if (best == NULL) {
+		q->x1 = q->x0;
+		q->y1 = q->y0;
+		q->s0 = q->t0 = q->s1 = q->t1 = 0.0f;
+		q->page = 0;
+		return;
+	}
+	best->lastUsed = stash->frame;
+	stash->pages[best->page].lastUsed = stash->frame;
+	q->s0 = (best->x0+1) * stash->itw;
+	q->t0 = (best->y0+1) * stash->ith;
+	q->s1 = (best->x1-1) * stash->itw;
+	q->t1 = (best->y1-1) * stash->ith;
+	q->page = best->page;
+}
+
 static void fons__flush(FONScontext* stash)
 {
-	// Flush texture
-	if (stash->dirtyRect[0] < stash->dirtyRect[2] && stash->dirtyRect[1] < stash->dirtyRect[3]) {
+	// Flush texture, the stash renders with one page.
+	int* dirty = stash->pages[0].dirtyRect;
+	if (dirty[0] < dirty[2] && dirty[1] < dirty[3]) {
 		if (stash->params.renderUpdate != NULL)
-			stash->params.renderUpdate(stash->params.userPtr, stash->dirtyRect, stash->texData);
+			stash->params.renderUpdate(stash->params.userPtr, dirty, stash->texData);
 		// Reset dirty rect
-		stash->dirtyRect[0] = stash->params.width;
-		stash->dirtyRect[1] = stash->params.height;
-		stash->dirtyRect[2] = 0;
-		stash->dirtyRect[3] = 0;
+		fons__clearDirty(stash, 0);
 	}
 
 	// Flush triangles
@@ -1307,7 +2687,7 @@ float fonsDrawText(FONScontext* stash,
 	int prevGlyphIndex = -1;
 	short isize = (short)(state->size*10.0f);
 	short iblur = (short)state->blur;
-	float scale;
+	float scale, sdfScale;
 	FONSfont* font;
 	float width;
 
@@ -1333,13 +2713,16 @@ float fonsDrawText(FONScontext* stash,
 	}
 	// Align vertically.
 	y += fons__getVertAlign(stash, font, state->align, isize);
+	sdfScale = fons__sdfKey(state, &isize, &iblur);
 
 	for (; str != end; ++str) {
 		if (fons__decutf8(&utf8state, &codepoint, *(const unsigned char*)str))
 			continue;
 		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur, FONS_GLYPH_BITMAP_REQUIRED);
 		if (glyph != NULL) {
-			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
+			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, sdfScale, &x, &y, &q);
+			if (glyph->x0 < 0)
+				fons__placeholderQuad(stash, font, glyph, &q);
 
 			if (stash->nverts+6 > FONS_VERTEX_COUNT)
 				fons__flush(stash);
@@ -1388,6 +2771,7 @@ int fonsTextIterInit(FONScontext* stash, FONStextIter* iter,
 	}
 	// Align vertically.
 	y += fons__getVertAlign(stash, iter->font, state->align, iter->isize);
+	iter->sdfScale = fons__sdfKey(state, &iter->isize, &iter->iblur);
 
 	if (end == NULL)
 		end = str + strlen(str);
@@ -1405,10 +2789,142 @@ int fonsTextIterInit(FONScontext* stash, FONStextIter* iter,
 	return 1;
 }
 
+int fonsShapeText(FONScontext* stash, const char* str, const char* end, FONSrunGlyph* glyphs, int maxGlyphs)
+{
+	FONSstate* state = fons__getState(stash);
+	unsigned int codepoint;
+	unsigned int utf8state = 0;
+	FONSglyph* glyph = NULL;
+	int prevGlyphIndex = -1;
+	short isize = (short)(state->size*10.0f);
+	short iblur = (short)state->blur;
+	float scale, sdfScale, kern, advance;
+	FONSfont* font;
+	int n = 0;
+
+	if (stash == NULL) return 0;
+	if (state->font < 0 || state->font >= stash->nfonts) return 0;
+	font = stash->fonts[state->font];
+	if (font->data == NULL) return 0;
+
+	scale = fons__tt_getPixelHeightScale(&font->font, (float)isize/10.0f);
+	sdfScale = fons__sdfKey(state, &isize, &iblur);
+
+	if (end == NULL)
+		end = str + strlen(str);
+
+	for (; str != end; ++str) {
+		if (fons__decutf8(&utf8state, &codepoint, *(const unsigned char*)str))
+			continue;
+		if (n == maxGlyphs) return -1;
+		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur, FONS_GLYPH_BITMAP_OPTIONAL);
+		kern = advance = 0;
+		if (glyph != NULL) {
+			// Same rounding as fons__getQuad(), so the run is drawn where the string is.
+			if (prevGlyphIndex != -1) {
+				kern = fons__kernAdvance(font, prevGlyphIndex, glyph->index) * scale;
+				if (sdfScale > 0.0f)
+					kern += state->spacing;
+				else
+					kern = (float)(int)(kern + state->spacing + 0.5f);
+			}
+			if (sdfScale > 0.0f)
+				advance = glyph->xadv * scale;
+			else
+				advance = (float)(int)(glyph->xadv / 10.0f + 0.5f);
+		}
+		glyphs[n].codepoint = codepoint;
+		glyphs[n].kern = kern;
+		glyphs[n].advance = advance;
+		n++;
+		prevGlyphIndex = glyph != NULL ? glyph->index : -1;
+	}
+
+	return n;
+}
+
+int fonsRunIterInit(FONScontext* stash, FONStextIter* iter,
+					float x, float y, const FONSrunGlyph* glyphs, int nglyphs, int bitmapOption)
+{
+	FONSstate* state = fons__getState(stash);
+	float width = x;
+	int i;
+
+	memset(iter, 0, sizeof(*iter));
+
+	if (stash == NULL) return 0;
+	if (state->font < 0 || state->font >= stash->nfonts) return 0;
+	iter->font = stash->fonts[state->font];
+	if (iter->font->data == NULL) return 0;
+
+	iter->isize = (short)(state->size*10.0f);
+	iter->iblur = (short)state->blur;
+	iter->scale = fons__tt_getPixelHeightScale(&iter->font->font, (float)iter->isize/10.0f);
+
+	// Align horizontally, the pen is moved from x like fonsTextBounds() does.
+	if (!(state->align & FONS_ALIGN_LEFT)) {
+		for (i = 0; i < nglyphs; i++) {
+			width += glyphs[i].kern;
+			width += glyphs[i].advance;
+		}
+		width -= x;
+	}
+	if (state->align & FONS_ALIGN_LEFT) {
+		// empty
+	} else if (state->align & FONS_ALIGN_RIGHT) {
+		x -= width;
+	} else if (state->align & FONS_ALIGN_CENTER) {
+		x -= width * 0.5f;
+	}
+	// Align vertically.
+	y += fons__getVertAlign(stash, iter->font, state->align, iter->isize);
+	iter->sdfScale = fons__sdfKey(state, &iter->isize, &iter->iblur);
+
+	iter->x = iter->nextx = x;
+	iter->y = iter->nexty = y;
+	iter->spacing = state->spacing;
+	iter->run = glyphs;
+	iter->nrun = nglyphs;
+	iter->irun = 0;
+	iter->prevGlyphIndex = -1;
+	iter->bitmapOption = bitmapOption;
+
+	return 1;
+}
+
+static int fons__runIterNext(FONScontext* stash, FONStextIter* iter, FONSquad* quad)
+{
+	const FONSrunGlyph* run;
+	FONSglyph* glyph;
+
+	if (iter->irun == iter->nrun)
+		return 0;
+
+	run = &iter->run[iter->irun++];
+	iter->codepoint = run->codepoint;
+	iter->x = iter->nextx;
+	iter->y = iter->nexty;
+	glyph = fons__getGlyph(stash, iter->font, run->codepoint, iter->isize, iter->iblur, iter->bitmapOption);
+	if (glyph != NULL) {
+		// The kerning was applied when shaping.
+		iter->nextx += run->kern;
+		fons__getQuad(stash, iter->font, -1, glyph, iter->scale, iter->spacing, iter->sdfScale, &iter->nextx, &iter->nexty, quad);
+		if (glyph->x0 < 0 && iter->bitmapOption == FONS_GLYPH_BITMAP_REQUIRED)
+			fons__placeholderQuad(stash, iter->font, glyph, quad);
+	}
+	iter->prevGlyphIndex = glyph != NULL ? glyph->index : -1;
+
+	return 1;
+}
+
 int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, FONSquad* quad)
 {
 	FONSglyph* glyph = NULL;
 	const char* str = iter->next;
+
+	if (iter->run != NULL)
+		return fons__runIterNext(stash, iter, quad);
+
 	iter->str = iter->next;
 
 	if (str == iter->end)
@@ -1423,8 +2939,11 @@ int fonsTextIterNext(FONScontext* stash, FONStextIter* iter, FONSquad* quad)
 		iter->y = iter->nexty;
 		glyph = fons__getGlyph(stash, iter->font, iter->codepoint, iter->isize, iter->iblur, iter->bitmapOption);
 		// If the iterator was initialized with FONS_GLYPH_BITMAP_OPTIONAL, then the UV coordinates of the quad will be invalid.
-		if (glyph != NULL)
-			fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->scale, iter->spacing, &iter->nextx, &iter->nexty, quad);
+		if (glyph != NULL) {
+			fons__getQuad(stash, iter->font, iter->prevGlyphIndex, glyph, iter->scale, iter->spacing, iter->sdfScale, &iter->nextx, &iter->nexty, quad);
+			if (glyph->x0 < 0 && iter->bitmapOption == FONS_GLYPH_BITMAP_REQUIRED)
+				fons__placeholderQuad(stash, iter->font, glyph, quad);
+		}
 		iter->prevGlyphIndex = glyph != NULL ? glyph->index : -1;
 		break;
 	}
@@ -1463,8 +2982,8 @@ void fonsDrawDebug(FONScontext* stash, float x, float y)
 	fons__vertex(stash, x+w, y+h, 1, 1, 0xffffffff);
 
 	// Drawbug draw atlas
-	for (i = 0; i < stash->atlas->nnodes; i++) {
-		FONSatlasNode* n = &stash->atlas->nodes[i];
+	for (i = 0; i < stash->pages[0].atlas->nnodes; i++) {
+		FONSatlasNode* n = &stash->pages[0].atlas->nodes[i];
 
 		if (stash->nverts+6 > FONS_VERTEX_COUNT)
 			fons__flush(stash);
@@ -1494,7 +3013,7 @@ float fonsTextBounds(FONScontext* stash,
 	int prevGlyphIndex = -1;
 	short isize = (short)(state->size*10.0f);
 	short iblur = (short)state->blur;
-	float scale;
+	float scale, sdfScale;
 	FONSfont* font;
 	float startx, advance;
 	float minx, miny, maxx, maxy;
@@ -1508,6 +3027,7 @@ float fonsTextBounds(FONScontext* stash,
 
 	// Align vertically.
 	y += fons__getVertAlign(stash, font, state->align, isize);
+	sdfScale = fons__sdfKey(state, &isize, &iblur);
 
 	minx = maxx = x;
 	miny = maxy = y;
@@ -1521,7 +3041,7 @@ float fonsTextBounds(FONScontext* stash,
 			continue;
 		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur, FONS_GLYPH_BITMAP_OPTIONAL);
 		if (glyph != NULL) {
-			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, &x, &y, &q);
+			fons__getQuad(stash, font, prevGlyphIndex, glyph, scale, state->spacing, sdfScale, &x, &y, &q);
 			if (q.x0 < minx) minx = q.x0;
 			if (q.x1 > maxx) maxx = q.x1;
 			if (stash->params.flags & FONS_ZERO_TOPLEFT) {
@@ -1602,47 +3122,342 @@ void fonsLineBounds(FONScontext* stash, float y, float* miny, float* maxy)
 	}
 }
 
-const unsigned char* fonsGetTextureData(FONScontext* stash, int* width, int* height)
+const unsigned char* fonsGetTextureData(FONScontext* stash, int page, int* width, int* height)
 {
 	if (width != NULL)
 		*width = stash->params.width;
 	if (height != NULL)
 		*height = stash->params.height;
-	return stash->texData;
+	if (page < 0 || page >= stash->npages)
+		return NULL;
+	return fons__texel(stash, page, 0, 0);
 }
 
-int fonsValidateTexture(FONScontext* stash, int* dirty)
+int fonsValidateTexture(FONScontext* stash, int page, int* dirty)
 {
-	if (stash->dirtyRect[0] < stash->dirtyRect[2] && stash->dirtyRect[1] < stash->dirtyRect[3]) {
-		dirty[0] = stash->dirtyRect[0];
-		dirty[1] = stash->dirtyRect[1];
-		dirty[2] = stash->dirtyRect[2];
-		dirty[3] = stash->dirtyRect[3];
+	int* rect;
+	if (page < 0 || page >= stash->npages)
+		return 0;
+	rect = stash->pages[page].dirtyRect;
+	if (rect[0] < rect[2] && rect[1] < rect[3]) {
+		dirty[0] = rect[0];
+		dirty[1] = rect[1];
+		dirty[2] = rect[2];
+		dirty[3] = rect[3];
 		// Reset dirty rect
-		stash->dirtyRect[0] = stash->params.width;
-		stash->dirtyRect[1] = stash->params.height;
-		stash->dirtyRect[2] = 0;
-		stash->dirtyRect[3] = 0;
+		fons__clearDirty(stash, page);
 		return 1;
 	}
 	return 0;
 }
 
+void fonsBeginFrame(FONScontext* stash)
+{
+	int i;
+	if (stash == NULL) return;
+	stash->frame++;
+	stash->placeholders = 0;
+	for (i = 0; i < stash->nfonts; i++)
+		fons__pruneGlyphs(stash->fonts[i]);
+}
+
+int fonsPageCount(FONScontext* stash)
+{
+	if (stash == NULL) return 0;
+	return stash->npages;
+}
+
+void fonsAtlasStats(FONScontext* stash, FONSatlasStats* stats)
+{
+	if (stash == NULL) return;
+	*stats = stash->stats;
+	stats->pages = stash->npages;
+}
+
+void fonsAsyncRasterizer(FONScontext* stash, FONSsubmitFunc submit, FONScollectFunc collect, void* uptr)
+{
+	if (stash == NULL) return;
+	fons__collectJobs(stash, 1);
+	stash->submit = submit;
+	stash->collect = collect;
+	stash->asyncUptr = uptr;
+}
+
+int fonsCollectGlyphs(FONScontext* stash)
+{
+	if (stash == NULL) return 0;
+	return fons__collectJobs(stash, 0);
+}
+
+int fonsPlaceholderCount(FONScontext* stash)
+{
+	if (stash == NULL) return 0;
+	return stash->placeholders;
+}
+
+int fonsGlyphRasterizer(FONScontext* stash, int rasterizer)
+{
+	if (stash == NULL) return FONS_RASTER_BACKEND;
+#if FONS_TT_ACCUMULATE
+	stash->rasterizer = rasterizer == FONS_RASTER_BACKEND ? FONS_RASTER_BACKEND : FONS_RASTER_ACCUMULATE;
+#else
+	FONS_NOTUSED(rasterizer);
+	stash->rasterizer = FONS_RASTER_BACKEND;
+#endif
+	return stash->rasterizer;
+}
+
+#define FONS_CACHE_MAGIC 0x434e4f46		// "FONC"
+#define FONS_CACHE_VERSION 1
+
+// Glyph cache file header, followed by the glyphs and by the rows of each page down to its lowest glyph.
+struct FONScacheHeader {
+	unsigned int magic;
+	int version;
+	int width, height;
+	int npages;
+	int rows[FONS_MAX_PAGES];
+	int nglyphs;
+};
+typedef struct FONScacheHeader FONScacheHeader;
+
+struct FONScacheGlyph {
+	unsigned int font;		// fons__fontHash() of the font the glyph is drawn with
+	unsigned int codepoint;
+	int index;
+	short size, blur;
+	short page;
+	short x0, y0, x1, y1;
+	short xadv, xoff, yoff;
+};
+typedef struct FONScacheGlyph FONScacheGlyph;
+
+// FNV-1a of the size and the table directory of the font, the directory holds the checksum of each table.
+static unsigned int fons__fontHash(FONSfont* font)
+{
+	unsigned int h = 2166136261u;
+	int i, n = 12;
+	if (font->data == NULL) return 0;
+	if (font->dataSize >= 12)
+		n += ((font->data[4] << 8) | font->data[5]) * 16;
+	if (n > font->dataSize) n = font->dataSize;
+	for (i = 0; i < 4; i++) {
+		h ^= ((unsigned int)font->dataSize >> (i*8)) & 0xff;
+		h *= 16777619u;
+	}
+	for (i = 0; i < n; i++) {
+		h ^= font->data[i];
+		h *= 16777619u;
+	}
+	return h;
+}
+
+int fonsSaveGlyphCache(FONScontext* stash, const char* path)
+{
+	FONScacheHeader header;
+	FONScacheGlyph rec;
+	FILE* fp;
+	int i, j, p, ok;
+
+	if (stash == NULL) return -1;
+	fons__collectJobs(stash, 1);
+
+	memset(&header, 0, sizeof(header));
+	header.magic = FONS_CACHE_MAGIC;
+	header.version = FONS_CACHE_VERSION;
+	header.width = stash->params.width;
+	header.height = stash->params.height;
+	header.npages = stash->npages;
+	header.rows[0] = 2;	// The white rect.
+	for (i = 0; i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		for (j = 0; j < font->nglyphs; j++) {
+			FONSglyph* glyph = &font->glyphs[j];
+			if (glyph->x0 < 0) continue;
+			header.rows[glyph->page] = fons__maxi(header.rows[glyph->page], glyph->y1);
+			header.nglyphs++;
+		}
+	}
+
+	fp = fopen(path, "wb");
+	if (fp == NULL) return -1;
+	ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+	for (i = 0; ok && i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		unsigned int hash = fons__fontHash(font);
+		for (j = 0; ok && j < font->nglyphs; j++) {
+			FONSglyph* glyph = &font->glyphs[j];
+			if (glyph->x0 < 0) continue;
+			memset(&rec, 0, sizeof(rec));
+			rec.font = hash;
+			rec.codepoint = glyph->codepoint;
+			rec.index = glyph->index;
+			rec.size = glyph->size;
+			rec.blur = glyph->blur;
+			rec.page = glyph->page;
+			rec.x0 = glyph->x0;
+			rec.y0 = glyph->y0;
+			rec.x1 = glyph->x1;
+			rec.y1 = glyph->y1;
+			rec.xadv = glyph->xadv;
+			rec.xoff = glyph->xoff;
+			rec.yoff = glyph->yoff;
+			ok = fwrite(&rec, sizeof(rec), 1, fp) == 1;
+		}
+	}
+	for (p = 0; ok && p < header.npages; p++) {
+		size_t n = (size_t)header.width * header.rows[p];
+		ok = fwrite(fons__texel(stash, p, 0, 0), 1, n, fp) == n;
+	}
+	if (fclose(fp) != 0) ok = 0;
+	return ok ? header.nglyphs : -1;
+}
+
+int fonsLoadGlyphCache(FONScontext* stash, const unsigned char* data, int ndata)
+{
+	FONScacheHeader header;
+	FONScacheGlyph rec;
+	const unsigned char* pixels;
+	unsigned int* hashes;
+	size_t size;
+	int i, j, p, n = 0, maxPages;
+
+	if (stash == NULL || data == NULL || ndata < (int)sizeof(header)) return -1;
+	memcpy(&header, data, sizeof(header));
+	maxPages = stash->params.pages < 1 ? 1 : fons__mini(stash->params.pages, FONS_MAX_PAGES);
+	if (header.magic != FONS_CACHE_MAGIC || header.version != FONS_CACHE_VERSION) return -1;
+	if (header.width != stash->params.width || header.height != stash->params.height) return -1;
+	if (header.npages < 1 || header.npages > maxPages || header.nglyphs < 0) return -1;
+	size = sizeof(header) + (size_t)header.nglyphs * sizeof(rec);
+	for (p = 0; p < header.npages; p++) {
+		if (header.rows[p] < 0 || header.rows[p] > header.height) return -1;
+		size += (size_t)header.width * header.rows[p];
+	}
+	if (size > (size_t)ndata) return -1;
+
+	// Only loaded into an empty atlas, the glyph rects are taken as they are.
+	for (i = 0; i < stash->nfonts; i++) {
+		FONSfont* font = stash->fonts[i];
+		for (j = 0; j < font->nglyphs; j++) {
+			if (font->glyphs[j].x0 >= 0 || font->glyphs[j].pending) return -1;
+		}
+	}
+	while (stash->npages < header.npages) {
+		if (!fons__addPage(stash)) return -1;
+	}
+	hashes = (unsigned int*)malloc(sizeof(unsigned int) * (stash->nfonts + 1));
+	if (hashes == NULL) return -1;
+	for (i = 0; i < stash->nfonts; i++)
+		hashes[i] = fons__fontHash(stash->fonts[i]);
+
+	pixels = data + sizeof(header) + (size_t)header.nglyphs * sizeof(rec);
+	for (p = 0; p < header.npages; p++) {
+		memcpy(fons__texel(stash, p, 0, 0), pixels, (size_t)header.width * header.rows[p]);
+		pixels += (size_t)header.width * header.rows[p];
+		if (header.rows[p] > 0)
+			fons__addDirty(stash, p, 0, 0, header.width, header.rows[p]);
+	}
+
+	for (j = 0; j < header.nglyphs; j++) {
+		FONSfont* font = NULL;
+		FONSglyph* glyph;
+		memcpy(&rec, data + sizeof(header) + (size_t)j * sizeof(rec), sizeof(rec));
+		if (rec.page < 0 || rec.page >= header.npages || rec.x0 < 0 || rec.y0 < 0 ||
+			rec.x1 <= rec.x0 || rec.y1 <= rec.y0 || rec.x1 > header.width || rec.y1 > header.rows[rec.page])
+			continue;
+		for (i = 0; i < stash->nfonts && font == NULL; i++) {
+			if (hashes[i] == rec.font && stash->fonts[i]->data != NULL)
+				font = stash->fonts[i];
+		}
+		if (font == NULL) continue;
+
+		glyph = fons__findGlyph(font, rec.codepoint, rec.size, rec.blur);
+		if (glyph == NULL) {
+			unsigned int h = fons__hashint(rec.codepoint) & (FONS_HASH_LUT_SIZE-1);
+			glyph = fons__allocGlyph(font);
+			if (glyph == NULL) break;
+			glyph->codepoint = rec.codepoint;
+			glyph->size = rec.size;
+			glyph->blur = rec.blur;
+			glyph->pending = 0;
+			glyph->next = font->lut[h];
+			font->lut[h] = font->nglyphs-1;
+		}
+		glyph->index = rec.index;
+		glyph->page = rec.page;
+		glyph->x0 = rec.x0;
+		glyph->y0 = rec.y0;
+		glyph->x1 = rec.x1;
+		glyph->y1 = rec.y1;
+		glyph->xadv = rec.xadv;
+		glyph->xoff = rec.xoff;
+		glyph->yoff = rec.yoff;
+		// Not drawn yet, the glyph can be evicted for the glyphs drawn this frame.
+		glyph->lastUsed = stash->frame-1;
+		n++;
+	}
+	free(hashes);
+
+	// The space of the glyphs skipped is free.
+	for (p = 0; p < header.npages; p++) {
+		stash->pages[p].lastUsed = stash->frame-1;
+		fons__rebuildFreeSpace(stash, p);
+	}
+	return n;
+}
+
+int fonsPrewarmGlyphs(FONScontext* stash, unsigned int first, unsigned int last)
+{
+	FONSstate* state = fons__getState(stash);
+	FONSfont* font;
+	FONSglyph* glyph;
+	unsigned int codepoint;
+	short isize, iblur;
+	int n = 0;
+
+	if (stash == NULL) return 0;
+	if (state->font < 0 || state->font >= stash->nfonts) return 0;
+	font = stash->fonts[state->font];
+	if (font->data == NULL) return 0;
+
+	isize = (short)(state->size*10.0f);
+	iblur = (short)state->blur;
+	fons__sdfKey(state, &isize, &iblur);
+	for (codepoint = first; codepoint >= first && codepoint <= last; codepoint++) {
+		if (!fons__hasGlyph(stash, font, codepoint)) continue;
+		glyph = fons__findGlyph(font, codepoint, isize, iblur);
+		if (glyph != NULL && (glyph->x0 >= 0 || glyph->pending)) continue;
+		glyph = fons__getGlyph(stash, font, codepoint, isize, iblur, FONS_GLYPH_BITMAP_REQUIRED);
+		if (glyph == NULL) continue;
+		// Not drawn, the glyph can be evicted for the glyphs drawn this frame.
+		glyph->lastUsed = stash->frame-1;
+		n++;
+	}
+	return n;
+}
+
 void fonsDeleteInternal(FONScontext* stash)
 {
 	int i;
 	if (stash == NULL) return;
 
+	fons__collectJobs(stash, 1);
 	if (stash->params.renderDelete)
 		stash->params.renderDelete(stash->params.userPtr);
 
 	for (i = 0; i < stash->nfonts; ++i)
 		fons__freeFont(stash->fonts[i]);
 
-	if (stash->atlas) fons__deleteAtlas(stash->atlas);
+	for (i = 0; i < FONS_MAX_PAGES; ++i)
+		if (stash->pages[i].atlas) fons__deleteAtlas(stash->pages[i].atlas);
 	if (stash->fonts) free(stash->fonts);
+	if (stash->freeRects) free(stash->freeRects);
 	if (stash->texData) free(stash->texData);
-	if (stash->scratch) free(stash->scratch);
+	if (stash->scratch.data) free(stash->scratch.data);
+	if (stash->outline.segs) free(stash->outline.segs);
+	if (stash->outline.near) free(stash->outline.near);
+	if (stash->outline.cross) free(stash->outline.cross);
+	if (stash->outline.accum) free(stash->outline.accum);
 	free(stash);
 	fons__tt_done(stash);
 }
@@ -1663,7 +3478,7 @@ void fonsGetAtlasSize(FONScontext* stash, int* width, int* height)
 
 int fonsExpandAtlas(FONScontext* stash, int width, int height)
 {
-	int i, maxy = 0;
+	int i, p, maxy;
 	unsigned char* data = NULL;
 	if (stash == NULL) return 0;
 
@@ -1681,33 +3496,41 @@ int fonsExpandAtlas(FONScontext* stash, int width, int height)
 		if (stash->params.renderResize(stash->params.userPtr, width, height) == 0)
 			return 0;
 	}
-	// Copy old texture data over.
-	data = (unsigned char*)malloc(width * height);
+	// Copy old texture data of each page over.
+	data = (unsigned char*)malloc((size_t)width * height * stash->npages);
 	if (data == NULL)
 		return 0;
-	for (i = 0; i < stash->params.height; i++) {
-		unsigned char* dst = &data[i*width];
-		unsigned char* src = &stash->texData[i*stash->params.width];
-		memcpy(dst, src, stash->params.width);
-		if (width > stash->params.width)
-			memset(dst+stash->params.width, 0, width - stash->params.width);
+	for (p = 0; p < stash->npages; p++) {
+		unsigned char* page = &data[(size_t)p * width * height];
+		for (i = 0; i < stash->params.height; i++) {
+			unsigned char* dst = &page[i*width];
+			unsigned char* src = fons__texel(stash, p, 0, i);
+			memcpy(dst, src, stash->params.width);
+			if (width > stash->params.width)
+				memset(dst+stash->params.width, 0, width - stash->params.width);
+		}
+		if (height > stash->params.height)
+			memset(&page[stash->params.height * width], 0, (height - stash->params.height) * width);
 	}
-	if (height > stash->params.height)
-		memset(&data[stash->params.height * width], 0, (height - stash->params.height) * width);
 
 	free(stash->texData);
 	stash->texData = data;
 
-	// Increase atlas size
-	fons__atlasExpand(stash->atlas, width, height);
+	for (p = 0; p < stash->npages; p++) {
+		FONSatlas* atlas = stash->pages[p].atlas;
+
+		// Increase atlas size
+		fons__atlasExpand(atlas, width, height);
 
-	// Add existing data as dirty.
-	for (i = 0; i < stash->atlas->nnodes; i++)
-		maxy = fons__maxi(maxy, stash->atlas->nodes[i].y);
-	stash->dirtyRect[0] = 0;
-	stash->dirtyRect[1] = 0;
-	stash->dirtyRect[2] = stash->params.width;
-	stash->dirtyRect[3] = maxy;
+		// Add existing data as dirty.
+		maxy = 0;
+		for (i = 0; i < atlas->nnodes; i++)
+			maxy = fons__maxi(maxy, atlas->nodes[i].y);
+		stash->pages[p].dirtyRect[0] = 0;
+		stash->pages[p].dirtyRect[1] = 0;
+		stash->pages[p].dirtyRect[2] = stash->params.width;
+		stash->pages[p].dirtyRect[3] = maxy;
+	}
 
 	stash->params.width = width;
 	stash->params.height = height;
@@ -1731,8 +3554,10 @@ int fonsResetAtlas(FONScontext* stash, int width, int height)
 			return 0;
 	}
 
-	// Reset atlas
-	fons__atlasReset(stash->atlas, width, height);
+	// Reset atlas to one page
+	fons__atlasReset(stash->pages[0].atlas, width, height);
+	stash->npages = 1;
+	stash->nfreeRects = 0;
 
 	// Clear texture data.
 	stash->texData = (unsigned char*)realloc(stash->texData, width * height);
@@ -1740,10 +3565,10 @@ int fonsResetAtlas(FONScontext* stash, int width, int height)
 	memset(stash->texData, 0, width * height);
 
 	// Reset dirty rect
-	stash->dirtyRect[0] = width;
-	stash->dirtyRect[1] = height;
-	stash->dirtyRect[2] = 0;
-	stash->dirtyRect[3] = 0;
+	stash->pages[0].dirtyRect[0] = width;
+	stash->pages[0].dirtyRect[1] = height;
+	stash->pages[0].dirtyRect[2] = 0;
+	stash->pages[0].dirtyRect[3] = 0;
 
 	// Reset cached glyphs
 	for (i = 0; i < stash->nfonts; i++) {
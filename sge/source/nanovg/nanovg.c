@@ -21,7 +21,13 @@
 #include <math.h>
 #include <memory.h>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NVG_SSE2
+#include <emmintrin.h>
+#endif
+
 #include "nanovg.h"
+#include <core/sgeProfiler.h>
 #define FONTSTASH_IMPLEMENTATION
 #include "fontstash.h"
 #include <image/stb_image.h>
@@ -36,15 +42,20 @@
 #pragma warning(disable: 4706)  // assignment within conditional expression
 #endif
 
-#define NVG_INIT_FONTIMAGE_SIZE  512
-#define NVG_MAX_FONTIMAGE_SIZE   2048
+#define NVG_FONTIMAGE_SIZE       1024
 #define NVG_MAX_FONTIMAGES       4
 
-#define NVG_INIT_COMMANDS_SIZE 256
-#define NVG_INIT_POINTS_SIZE 128
-#define NVG_INIT_PATHS_SIZE 16
-#define NVG_INIT_VERTS_SIZE 256
+#define NVG_INIT_COMMANDS_SIZE 1024
+#define NVG_INIT_POINTS_SIZE 512
+#define NVG_INIT_PATHS_SIZE 64
+#define NVG_INIT_VERTS_SIZE 1024
+#define NVG_INIT_ARENA_SIZE 65536
+#define NVG_ARENA_ALIGN 16
 #define NVG_MAX_STATES 32
+#define NVG_MAX_LAYERS 8
+#define NVG_TEXT_LAYOUTS 1024		// Strings kept laid out by the text layout cache.
+#define NVG_TEXT_LAYOUT_LUT 512		// Hash buckets of the text layout cache, a power of two.
+#define NVG_TEXT_LAYOUT_MAX 512		// Longest string in bytes the text layout cache keeps.
 
 #define NVG_KAPPA90 0.5522847493f	// Length proportional to radius of a cubic bezier handle for 90deg arcs.
 
@@ -83,6 +94,7 @@ struct NVGstate {
 	float letterSpacing;
 	float lineHeight;
 	float fontBlur;
+	int fontSDF;
 	int textAlign;
 	int fontId;
 };
@@ -98,6 +110,7 @@ struct NVGpoint {
 typedef struct NVGpoint NVGpoint;
 
 struct NVGpathCache {
+	NVGarena* arena;		// Arena of the buffers, NULL if they are on the heap.
 	NVGpoint* points;
 	int npoints;
 	int cpoints;
@@ -111,8 +124,152 @@ struct NVGpathCache {
 };
 typedef struct NVGpathCache NVGpathCache;
 
+enum NVGlistCallType {
+	NVG_LIST_FILL = 0,
+	NVG_LIST_STROKE = 1,
+	NVG_LIST_TEXT = 2,
+};
+
+struct NVGlistCall {
+	int type;
+	NVGstate state;			// State at record time, paints and scissor are in list space.
+	int commandOffset;
+	int ncommands;
+	int textOffset;
+	int textLength;
+	float x, y;
+	// Tessellated geometry, in device space of the list cache transform.
+	NVGpaint paint;
+	float strokeWidth;
+	float bounds[4];
+	NVGpath* paths;
+	int npaths;
+	int cpaths;
+	NVGvertex* verts;
+	int nverts;
+	int cverts;
+};
+typedef struct NVGlistCall NVGlistCall;
+
+struct NVGdisplayList {
+	NVGlistCall* calls;
+	int ncalls;
+	int ccalls;
+	float* commands;
+	int ncommands;
+	int ccommands;
+	char* text;
+	int ntext;
+	int ctext;
+	float xform[6];			// Transform at record time, maps list space to device space.
+	float cacheXform[6];	// Transform the cached geometry was tessellated with.
+	float cacheRatio;
+	int cached;
+	float scaleTolerance;
+	int tessellations;
+	float* tempCommands;
+	int ctempCommands;
+	NVGpath* tempPaths;
+	int ctempPaths;
+	NVGvertex* tempVerts;
+	int ctempVerts;
+};
+
+struct NVGtessCall {
+	int type;
+	NVGpaint paint;
+	NVGcompositeOperationState compositeOperation;
+	NVGscissor scissor;
+	float fringe;
+	float strokeWidth;
+	int lineCap;
+	int lineJoin;
+	float miterLimit;
+	int commandOffset;
+	int ncommands;
+	// Tessellation output, in the paths of the chunk.
+	int chunk;
+	int pathOffset;
+	int npaths;
+	float bounds[4];
+};
+typedef struct NVGtessCall NVGtessCall;
+
+struct NVGtessChunk {
+	struct NVGcontext* ctx;	// Scratch context, only the path cache and tolerances are used.
+	int first;
+	int count;
+	NVGpath* paths;
+	int npaths;
+	int cpaths;
+	int* offsets;			// Fill and stroke vertex offsets of each path.
+	int coffsets;
+	NVGvertex* verts;
+	int nverts;
+	int cverts;
+};
+typedef struct NVGtessChunk NVGtessChunk;
+
+struct NVGlayer {
+	int image;
+	float viewWidth, viewHeight;	// Viewport of the target drawn before.
+	int state;						// The saved state restored at the end.
+};
+typedef struct NVGlayer NVGlayer;
+
+// Text style a string was laid out in, the sizes are in device pixels.
+struct NVGtextKey {
+	int fontId;
+	int sdf;
+	float scale;
+	float size;
+	float spacing;
+	float blur;
+};
+typedef struct NVGtextKey NVGtextKey;
+
+// Row of a text box, the offsets are in bytes from the start of the string.
+struct NVGlayoutRow {
+	int start, end, next;
+	float width, minx, maxx;
+};
+typedef struct NVGlayoutRow NVGlayoutRow;
+
+// A string laid out in a text style, shared by measuring and drawing it. The shaped run, the bounds
+// and the rows are filled when they are first needed.
+struct NVGtextLayout {
+	NVGtextKey key;
+	unsigned int hash;
+	int next;				// Next layout of the hash bucket.
+	int frame;				// Last frame the layout was used.
+	char* str;
+	int len;
+	int cstr;
+	FONSrunGlyph* glyphs;	// Shaped run, nglyphs is -1 before the string is shaped.
+	int nglyphs;
+	int cglyphs;
+	float boundsOrigin[2];	// Origin and alignment the bounds were measured at, boundsAlign is -1 before.
+	int boundsAlign;
+	float bounds[4];
+	float boundsAdvance;
+	NVGlayoutRow* rows;		// Rows broken at breakWidth, nrows is -1 before the text is broken.
+	int nrows;
+	int crows;
+	float breakWidth;
+};
+typedef struct NVGtextLayout NVGtextLayout;
+
+struct NVGtextLayoutCache {
+	NVGtextLayout layouts[NVG_TEXT_LAYOUTS];
+	int nlayouts;
+	int lut[NVG_TEXT_LAYOUT_LUT];
+	int frame;
+};
+typedef struct NVGtextLayoutCache NVGtextLayoutCache;
+
 struct NVGcontext {
 	NVGparams params;
+	NVGarena* arena;		// Commands and path cache, reset at nvgBeginFrame().
 	float* commands;
 	int ccommands;
 	int ncommands;
@@ -126,11 +283,32 @@ struct NVGcontext {
 	float devicePxRatio;
 	struct FONScontext* fs;
 	int fontImages[NVG_MAX_FONTIMAGES];
-	int fontImageIdx;
 	int drawCallCount;
 	int fillTriCount;
 	int strokeTriCount;
 	int textTriCount;
+	NVGdisplayList* recording;
+	NVGparallelFunc tessRunner;
+	void* tessRunnerPtr;
+	NVGtessCall* tessCalls;
+	int ntessCalls;
+	int ctessCalls;
+	float* tessCommands;
+	int ntessCommands;
+	int ctessCommands;
+	NVGtessChunk* tessChunks;
+	int ntessChunks;
+	float viewWidth, viewHeight;
+	float commandBounds[4];	// Bounds of the transformed path commands.
+	int culling;
+	int culledCount;
+	int primitives;
+	NVGlayer layers[NVG_MAX_LAYERS];
+	int nlayers;
+	NVGtextLayoutCache* layouts;	// Allocated on first use while layout caching is enabled.
+	int layoutCaching;
+	int layoutHits;
+	int layoutMisses;
 };
 
 static float nvg__sqrtf(float a) { return sqrtf(a); }
@@ -163,32 +341,179 @@ static float nvg__normalize(float *x, float* y)
 }
 
 
+// Frame arena
+
+struct NVGarenaBlock {
+	struct NVGarenaBlock* next;
+	int size;
+	int used;
+};
+typedef struct NVGarenaBlock NVGarenaBlock;
+
+struct NVGarena {
+	NVGarenaBlock* blocks;	// The current block first.
+	void* last;				// The last allocation, it grows in place.
+	int lastSize;
+	int blockSize;
+	int used;
+	int peak;
+	int reserved;
+	int growths;
+};
+
+static int nvg__arenaAlign(int size)
+{
+	return (size + NVG_ARENA_ALIGN-1) & ~(NVG_ARENA_ALIGN-1);
+}
+
+static unsigned char* nvg__arenaData(NVGarenaBlock* block)
+{
+	return (unsigned char*)block + nvg__arenaAlign(sizeof(NVGarenaBlock));
+}
+
+static NVGarenaBlock* nvg__arenaAddBlock(NVGarena* arena, int size)
+{
+	NVGarenaBlock* block = (NVGarenaBlock*)malloc(nvg__arenaAlign(sizeof(NVGarenaBlock)) + size);
+	if (block == NULL) return NULL;
+	block->next = arena->blocks;
+	block->size = size;
+	block->used = 0;
+	arena->blocks = block;
+	arena->reserved += size;
+	return block;
+}
+
+static void nvg__arenaFreeBlocks(NVGarena* arena)
+{
+	while (arena->blocks != NULL) {
+		NVGarenaBlock* next = arena->blocks->next;
+		free(arena->blocks);
+		arena->blocks = next;
+	}
+	arena->reserved = 0;
+}
+
+NVGarena* nvgCreateArena(int size)
+{
+	NVGarena* arena = (NVGarena*)malloc(sizeof(NVGarena));
+	if (arena == NULL) return NULL;
+	memset(arena, 0, sizeof(NVGarena));
+	arena->blockSize = nvg__arenaAlign(nvg__maxi(size, NVG_ARENA_ALIGN));
+	if (nvg__arenaAddBlock(arena, arena->blockSize) == NULL) {
+		free(arena);
+		return NULL;
+	}
+	return arena;
+}
+
+void nvgDeleteArena(NVGarena* arena)
+{
+	if (arena == NULL) return;
+	nvg__arenaFreeBlocks(arena);
+	free(arena);
+}
+
+void* nvgArenaAlloc(NVGarena* arena, int size)
+{
+	NVGarenaBlock* block = arena->blocks;
+	unsigned char* ptr;
+	size = nvg__arenaAlign(size);
+	if (block == NULL || block->used + size > block->size) {
+		// Doubles the reserved bytes, the blocks are joined at the next reset.
+		block = nvg__arenaAddBlock(arena, nvg__maxi(nvg__maxi(size, arena->blockSize), arena->reserved));
+		if (block == NULL) return NULL;
+		arena->growths++;
+	}
+	ptr = nvg__arenaData(block) + block->used;
+	block->used += size;
+	arena->last = ptr;
+	arena->lastSize = size;
+	arena->used += size;
+	arena->peak = nvg__maxi(arena->peak, arena->used);
+	return ptr;
+}
+
+void* nvgArenaGrow(NVGarena* arena, void* ptr, int keep, int size)
+{
+	void* p;
+	if (ptr != NULL && ptr == arena->last) {
+		NVGarenaBlock* block = arena->blocks;
+		int extra = nvg__arenaAlign(size) - arena->lastSize;
+		if (extra <= 0)
+			return ptr;
+		if (block->used + extra <= block->size) {
+			block->used += extra;
+			arena->lastSize += extra;
+			arena->used += extra;
+			arena->peak = nvg__maxi(arena->peak, arena->used);
+			return ptr;
+		}
+	}
+	p = nvgArenaAlloc(arena, size);
+	if (p != NULL && ptr != NULL && keep > 0)
+		memcpy(p, ptr, keep);
+	return p;
+}
+
+void nvgResetArena(NVGarena* arena)
+{
+	if (arena->blocks == NULL || arena->blocks->next != NULL || arena->blocks->size < arena->peak) {
+		nvg__arenaFreeBlocks(arena);
+		nvg__arenaAddBlock(arena, nvg__maxi(arena->peak, arena->blockSize));
+	}
+	if (arena->blocks != NULL)
+		arena->blocks->used = 0;
+	arena->last = NULL;
+	arena->lastSize = 0;
+	arena->used = 0;
+}
+
+void nvgArenaStats(NVGarena* arena, NVGarenaStats* stats)
+{
+	memset(stats, 0, sizeof(NVGarenaStats));
+	if (arena == NULL) return;
+	stats->used = arena->used;
+	stats->peak = arena->peak;
+	stats->reserved = arena->reserved;
+	stats->growths = arena->growths;
+}
+
+// Grows a buffer in the arena, or on the heap without arena.
+static void* nvg__realloc(NVGarena* arena, void* data, int keep, int size)
+{
+	if (arena == NULL) return realloc(data, size);
+	return nvgArenaGrow(arena, data, keep, size);
+}
+
 static void nvg__deletePathCache(NVGpathCache* c)
 {
 	if (c == NULL) return;
-	if (c->points != NULL) free(c->points);
-	if (c->paths != NULL) free(c->paths);
-	if (c->verts != NULL) free(c->verts);
+	if (c->arena == NULL) {
+		if (c->points != NULL) free(c->points);
+		if (c->paths != NULL) free(c->paths);
+		if (c->verts != NULL) free(c->verts);
+	}
 	free(c);
 }
 
-static NVGpathCache* nvg__allocPathCache(void)
+static NVGpathCache* nvg__allocPathCache(NVGarena* arena)
 {
 	NVGpathCache* c = (NVGpathCache*)malloc(sizeof(NVGpathCache));
 	if (c == NULL) goto error;
 	memset(c, 0, sizeof(NVGpathCache));
+	c->arena = arena;
 
-	c->points = (NVGpoint*)malloc(sizeof(NVGpoint)*NVG_INIT_POINTS_SIZE);
+	c->points = (NVGpoint*)nvg__realloc(arena, NULL, 0, sizeof(NVGpoint)*NVG_INIT_POINTS_SIZE);
 	if (!c->points) goto error;
 	c->npoints = 0;
 	c->cpoints = NVG_INIT_POINTS_SIZE;
 
-	c->paths = (NVGpath*)malloc(sizeof(NVGpath)*NVG_INIT_PATHS_SIZE);
+	c->paths = (NVGpath*)nvg__realloc(arena, NULL, 0, sizeof(NVGpath)*NVG_INIT_PATHS_SIZE);
 	if (!c->paths) goto error;
 	c->npaths = 0;
 	c->cpaths = NVG_INIT_PATHS_SIZE;
 
-	c->verts = (NVGvertex*)malloc(sizeof(NVGvertex)*NVG_INIT_VERTS_SIZE);
+	c->verts = (NVGvertex*)nvg__realloc(arena, NULL, 0, sizeof(NVGvertex)*NVG_INIT_VERTS_SIZE);
 	if (!c->verts) goto error;
 	c->nverts = 0;
 	c->cverts = NVG_INIT_VERTS_SIZE;
@@ -199,6 +524,30 @@ error:
 	return NULL;
 }
 
+// Starts a frame in the arena, the buffers take back their capacity so steady frames do not grow.
+static void nvg__resetArena(NVGcontext* ctx)
+{
+	NVGpathCache* c = ctx->cache;
+	nvgResetArena(ctx->arena);
+	ctx->commands = (float*)nvgArenaAlloc(ctx->arena, sizeof(float)*ctx->ccommands);
+	ctx->ccommands = ctx->commands != NULL ? ctx->ccommands : 0;
+	ctx->ncommands = 0;
+	c->points = (NVGpoint*)nvgArenaAlloc(ctx->arena, sizeof(NVGpoint)*c->cpoints);
+	c->cpoints = c->points != NULL ? c->cpoints : 0;
+	c->npoints = 0;
+	c->paths = (NVGpath*)nvgArenaAlloc(ctx->arena, sizeof(NVGpath)*c->cpaths);
+	c->cpaths = c->paths != NULL ? c->cpaths : 0;
+	c->npaths = 0;
+	c->verts = (NVGvertex*)nvgArenaAlloc(ctx->arena, sizeof(NVGvertex)*c->cverts);
+	c->cverts = c->verts != NULL ? c->cverts : 0;
+	c->nverts = 0;
+}
+
+void nvgMemoryStats(NVGcontext* ctx, NVGarenaStats* stats)
+{
+	nvgArenaStats(ctx->arena, stats);
+}
+
 static void nvg__setDevicePixelRatio(NVGcontext* ctx, float ratio)
 {
 	ctx->tessTol = 0.25f / ratio;
@@ -285,6 +634,10 @@ static NVGstate* nvg__getState(NVGcontext* ctx)
 	return &ctx->states[ctx->nstates-1];
 }
 
+static void nvg__flushTessellation(NVGcontext* ctx);
+static void nvg__deleteTessellation(NVGcontext* ctx);
+static void nvg__deleteTextLayouts(NVGcontext* ctx);
+
 NVGcontext* nvgCreateInternal(NVGparams* params)
 {
 	FONSparams fontParams;
@@ -297,12 +650,20 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 	for (i = 0; i < NVG_MAX_FONTIMAGES; i++)
 		ctx->fontImages[i] = 0;
 
-	ctx->commands = (float*)malloc(sizeof(float)*NVG_INIT_COMMANDS_SIZE);
+	ctx->arena = nvgCreateArena(NVG_INIT_ARENA_SIZE);
+	if (ctx->arena == NULL) goto error;
+	ctx->commands = (float*)nvgArenaAlloc(ctx->arena, sizeof(float)*NVG_INIT_COMMANDS_SIZE);
 	if (!ctx->commands) goto error;
 	ctx->ncommands = 0;
 	ctx->ccommands = NVG_INIT_COMMANDS_SIZE;
-
-	ctx->cache = nvg__allocPathCache();
+	ctx->commandBounds[0] = ctx->commandBounds[1] = 1e6f;
+	ctx->commandBounds[2] = ctx->commandBounds[3] = -1e6f;
+	ctx->culling = 1;
+	ctx->primitives = 1;
+	ctx->layoutCaching = 1;
+	ctx->viewWidth = ctx->viewHeight = 1e6f;
+
+	ctx->cache = nvg__allocPathCache(ctx->arena);
 	if (ctx->cache == NULL) goto error;
 
 	nvgSave(ctx);
@@ -314,8 +675,9 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 
 	// Init font rendering
 	memset(&fontParams, 0, sizeof(fontParams));
-	fontParams.width = NVG_INIT_FONTIMAGE_SIZE;
-	fontParams.height = NVG_INIT_FONTIMAGE_SIZE;
+	fontParams.width = NVG_FONTIMAGE_SIZE;
+	fontParams.height = NVG_FONTIMAGE_SIZE;
+	fontParams.pages = NVG_MAX_FONTIMAGES;
 	fontParams.flags = FONS_ZERO_TOPLEFT;
 	fontParams.renderCreate = NULL;
 	fontParams.renderUpdate = NULL;
@@ -325,10 +687,9 @@ NVGcontext* nvgCreateInternal(NVGparams* params)
 	ctx->fs = fonsCreateInternal(&fontParams);
 	if (ctx->fs == NULL) goto error;
 
-	// Create font texture
+	// Create font texture of the first page, the others are created when the glyphs need them.
 	ctx->fontImages[0] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, fontParams.width, fontParams.height, 0, NULL);
 	if (ctx->fontImages[0] == 0) goto error;
-	ctx->fontImageIdx = 0;
 
 	return ctx;
 
@@ -346,8 +707,10 @@ void nvgDeleteInternal(NVGcontext* ctx)
 {
 	int i;
 	if (ctx == NULL) return;
-	if (ctx->commands != NULL) free(ctx->commands);
 	if (ctx->cache != NULL) nvg__deletePathCache(ctx->cache);
+	nvgDeleteArena(ctx->arena);
+	nvg__deleteTessellation(ctx);
+	nvg__deleteTextLayouts(ctx);
 
 	if (ctx->fs)
 		fonsDeleteInternal(ctx->fs);
@@ -374,12 +737,21 @@ void nvgBeginFrame(NVGcontext* ctx, float windowWidth, float windowHeight, float
 	ctx->nstates = 0;
 	nvgSave(ctx);
 	nvgReset(ctx);
+	nvg__resetArena(ctx);
+	ctx->recording = NULL;
+	ctx->nlayers = 0;
 
 	nvg__setDevicePixelRatio(ctx, devicePixelRatio);
+	fonsBeginFrame(ctx->fs);
+	if (ctx->layouts != NULL)
+		ctx->layouts->frame++;
 
 	ctx->params.renderViewport(ctx->params.userPtr, windowWidth, windowHeight, devicePixelRatio);
+	ctx->viewWidth = windowWidth;
+	ctx->viewHeight = windowHeight;
 
 	ctx->drawCallCount = 0;
+	ctx->culledCount = 0;
 	ctx->fillTriCount = 0;
 	ctx->strokeTriCount = 0;
 	ctx->textTriCount = 0;
@@ -387,37 +759,15 @@ void nvgBeginFrame(NVGcontext* ctx, float windowWidth, float windowHeight, float
 
 void nvgCancelFrame(NVGcontext* ctx)
 {
+	ctx->ntessCalls = 0;
+	ctx->ntessCommands = 0;
 	ctx->params.renderCancel(ctx->params.userPtr);
 }
 
 void nvgEndFrame(NVGcontext* ctx)
 {
+	nvg__flushTessellation(ctx);
 	ctx->params.renderFlush(ctx->params.userPtr);
-	if (ctx->fontImageIdx != 0) {
-		int fontImage = ctx->fontImages[ctx->fontImageIdx];
-		int i, j, iw, ih;
-		// delete images that smaller than current one
-		if (fontImage == 0)
-			return;
-		nvgImageSize(ctx, fontImage, &iw, &ih);
-		for (i = j = 0; i < ctx->fontImageIdx; i++) {
-			if (ctx->fontImages[i] != 0) {
-				int nw, nh;
-				nvgImageSize(ctx, ctx->fontImages[i], &nw, &nh);
-				if (nw < iw || nh < ih)
-					nvgDeleteImage(ctx, ctx->fontImages[i]);
-				else
-					ctx->fontImages[j++] = ctx->fontImages[i];
-			}
-		}
-		// make current font image to first
-		ctx->fontImages[j++] = ctx->fontImages[0];
-		ctx->fontImages[0] = fontImage;
-		ctx->fontImageIdx = 0;
-		// clear all images after j
-		for (i = j; i < NVG_MAX_FONTIMAGES; i++)
-			ctx->fontImages[i] = 0;
-	}
 }
 
 NVGcolor nvgRGB(unsigned char r, unsigned char g, unsigned char b)
@@ -835,6 +1185,11 @@ void nvgUpdateImage(NVGcontext* ctx, int image, const unsigned char* data)
 	ctx->params.renderUpdateTexture(ctx->params.userPtr, image, 0,0, w,h, data);
 }
 
+void nvgUpdateImageRegion(NVGcontext* ctx, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	ctx->params.renderUpdateTexture(ctx->params.userPtr, image, x,y, w,h, data);
+}
+
 void nvgImageSize(NVGcontext* ctx, int image, int* w, int* h)
 {
 	ctx->params.renderGetTextureSize(ctx->params.userPtr, image, w, h);
@@ -1027,6 +1382,16 @@ void nvgResetScissor(NVGcontext* ctx)
 	state->scissor.extent[1] = -1.0f;
 }
 
+void nvgScissorCulling(NVGcontext* ctx, int enable)
+{
+	ctx->culling = enable;
+}
+
+int nvgCulledCount(NVGcontext* ctx)
+{
+	return ctx->culledCount;
+}
+
 // Global composite operation.
 void nvgGlobalCompositeOperation(NVGcontext* ctx, int op)
 {
@@ -1075,6 +1440,60 @@ static float nvg__distPtSeg(float x, float y, float px, float py, float qx, floa
 	return dx*dx + dy*dy;
 }
 
+static void nvg__growBounds(float* bounds, const float* pts, int npts)
+{
+	int i;
+	for (i = 0; i < npts; i++) {
+		bounds[0] = nvg__minf(bounds[0], pts[i*2]);
+		bounds[1] = nvg__minf(bounds[1], pts[i*2+1]);
+		bounds[2] = nvg__maxf(bounds[2], pts[i*2]);
+		bounds[3] = nvg__maxf(bounds[3], pts[i*2+1]);
+	}
+}
+
+// Bounding box of the scissor clipped to the viewport.
+static void nvg__clipBox(NVGcontext* ctx, const NVGscissor* scissor, float* box)
+{
+	box[0] = 0.0f;
+	box[1] = 0.0f;
+	box[2] = ctx->viewWidth;
+	box[3] = ctx->viewHeight;
+	if (scissor->extent[0] > -0.5f) {
+		const float* t = scissor->xform;
+		float ex = nvg__absf(t[0])*scissor->extent[0] + nvg__absf(t[2])*scissor->extent[1];
+		float ey = nvg__absf(t[1])*scissor->extent[0] + nvg__absf(t[3])*scissor->extent[1];
+		box[0] = nvg__maxf(box[0], t[4] - ex);
+		box[1] = nvg__maxf(box[1], t[5] - ey);
+		box[2] = nvg__minf(box[2], t[4] + ex);
+		box[3] = nvg__minf(box[3], t[5] + ey);
+	}
+}
+
+// Returns 1 and counts the cull if the bounds grown by pad are outside of the bounding box
+// of the scissor or of the viewport. Empty bounds are not culled.
+static int nvg__culled(NVGcontext* ctx, const NVGscissor* scissor, const float* bounds, float pad)
+{
+	float box[4];
+
+	if (!ctx->culling || bounds[0] > bounds[2] || bounds[1] > bounds[3])
+		return 0;
+
+	nvg__clipBox(ctx, scissor, box);
+	if (bounds[2] + pad < box[0] || bounds[0] - pad > box[2] || bounds[3] + pad < box[1] || bounds[1] - pad > box[3]) {
+		ctx->culledCount++;
+		return 1;
+	}
+	return 0;
+}
+
+// Max distance of the stroke outline from the path, miter joins reach miterLimit half widths and
+// square caps the half diagonal.
+static float nvg__strokePad(const NVGstate* state, float strokeWidth, float fringe)
+{
+	float reach = state->lineJoin == NVG_MITER ? nvg__maxf(state->miterLimit, 1.5f) : 1.5f;
+	return strokeWidth*0.5f*reach + fringe;
+}
+
 static void nvg__appendCommands(NVGcontext* ctx, float* vals, int nvals)
 {
 	NVGstate* state = nvg__getState(ctx);
@@ -1083,7 +1502,7 @@ static void nvg__appendCommands(NVGcontext* ctx, float* vals, int nvals)
 	if (ctx->ncommands+nvals > ctx->ccommands) {
 		float* commands;
 		int ccommands = ctx->ncommands+nvals + ctx->ccommands/2;
-		commands = (float*)realloc(ctx->commands, sizeof(float)*ccommands);
+		commands = (float*)nvg__realloc(ctx->arena, ctx->commands, sizeof(float)*ctx->ncommands, sizeof(float)*ccommands);
 		if (commands == NULL) return;
 		ctx->commands = commands;
 		ctx->ccommands = ccommands;
@@ -1101,16 +1520,20 @@ static void nvg__appendCommands(NVGcontext* ctx, float* vals, int nvals)
 		switch (cmd) {
 		case NVG_MOVETO:
 			nvgTransformPoint(&vals[i+1],&vals[i+2], state->xform, vals[i+1],vals[i+2]);
+			nvg__growBounds(ctx->commandBounds, &vals[i+1], 1);
 			i += 3;
 			break;
 		case NVG_LINETO:
 			nvgTransformPoint(&vals[i+1],&vals[i+2], state->xform, vals[i+1],vals[i+2]);
+			nvg__growBounds(ctx->commandBounds, &vals[i+1], 1);
 			i += 3;
 			break;
 		case NVG_BEZIERTO:
 			nvgTransformPoint(&vals[i+1],&vals[i+2], state->xform, vals[i+1],vals[i+2]);
 			nvgTransformPoint(&vals[i+3],&vals[i+4], state->xform, vals[i+3],vals[i+4]);
 			nvgTransformPoint(&vals[i+5],&vals[i+6], state->xform, vals[i+5],vals[i+6]);
+			// The curve is inside the hull of its control points.
+			nvg__growBounds(ctx->commandBounds, &vals[i+1], 3);
 			i += 7;
 			break;
 		case NVG_CLOSE:
@@ -1149,7 +1572,7 @@ static void nvg__addPath(NVGcontext* ctx)
 	if (ctx->cache->npaths+1 > ctx->cache->cpaths) {
 		NVGpath* paths;
 		int cpaths = ctx->cache->npaths+1 + ctx->cache->cpaths/2;
-		paths = (NVGpath*)realloc(ctx->cache->paths, sizeof(NVGpath)*cpaths);
+		paths = (NVGpath*)nvg__realloc(ctx->cache->arena, ctx->cache->paths, sizeof(NVGpath)*ctx->cache->npaths, sizeof(NVGpath)*cpaths);
 		if (paths == NULL) return;
 		ctx->cache->paths = paths;
 		ctx->cache->cpaths = cpaths;
@@ -1186,7 +1609,7 @@ static void nvg__addPoint(NVGcontext* ctx, float x, float y, int flags)
 	if (ctx->cache->npoints+1 > ctx->cache->cpoints) {
 		NVGpoint* points;
 		int cpoints = ctx->cache->npoints+1 + ctx->cache->cpoints/2;
-		points = (NVGpoint*)realloc(ctx->cache->points, sizeof(NVGpoint)*cpoints);
+		points = (NVGpoint*)nvg__realloc(ctx->cache->arena, ctx->cache->points, sizeof(NVGpoint)*ctx->cache->npoints, sizeof(NVGpoint)*cpoints);
 		if (points == NULL) return;
 		ctx->cache->points = points;
 		ctx->cache->cpoints = cpoints;
@@ -1216,7 +1639,7 @@ static void nvg__pathWinding(NVGcontext* ctx, int winding)
 	path->winding = winding;
 }
 
-static float nvg__getAverageScale(float *t)
+static float nvg__getAverageScale(const float *t)
 {
 	float sx = sqrtf(t[0]*t[0] + t[2]*t[2]);
 	float sy = sqrtf(t[1]*t[1] + t[3]*t[3]);
@@ -1228,7 +1651,7 @@ static NVGvertex* nvg__allocTempVerts(NVGcontext* ctx, int nverts)
 	if (nverts > ctx->cache->cverts) {
 		NVGvertex* verts;
 		int cverts = (nverts + 0xff) & ~0xff; // Round up to prevent allocations when things change just slightly.
-		verts = (NVGvertex*)realloc(ctx->cache->verts, sizeof(NVGvertex)*cverts);
+		verts = (NVGvertex*)nvg__realloc(ctx->cache->arena, ctx->cache->verts, 0, sizeof(NVGvertex)*cverts);
 		if (verts == NULL) return NULL;
 		ctx->cache->verts = verts;
 		ctx->cache->cverts = cverts;
@@ -1324,6 +1747,497 @@ static void nvg__tesselateBezier(NVGcontext* ctx,
 	nvg__tesselateBezier(ctx, x1234,y1234, x234,y234, x34,y34, x4,y4, level+1, type);
 }
 
+// Tessellation kernels, the SIMD versions are selected at run time by nvgSimdLevel().
+
+#define NVG_ARC_BATCH 64
+
+struct NVGkernels {
+	// Flattens a cubic bezier from the last point, adds the end point with flags type.
+	void (*flattenBezier)(NVGcontext* ctx, float x1, float y1, float x2, float y2,
+						  float x3, float y3, float x4, float y4, int type);
+	// Calculates the direction and length of the path segments, and grows the bounds.
+	void (*segments)(NVGpoint* pts, int count, float* bounds);
+	// Calculates the join extrusions and flags, returns the number of left turns.
+	int (*joins)(NVGpoint* pts, int count, float iw, int lineJoin, float miterLimit, int* nbevel);
+	// Emits the two stroke vertices of points without join vertices.
+	NVGvertex* (*miters)(NVGvertex* dst, const NVGpoint* pts, int count, float w, float u0, float u1);
+	// Calculates cos and sin of a0 + i/(n-1)*(a1-a0) for i in [first, first+count).
+	void (*arc)(float* cs, float* sn, float a0, float a1, int first, int count, int n);
+	// Finds the first min and the first max of count values, count > 0.
+	void (*minmax)(const float* v, int count, int* imin, int* imax);
+};
+typedef struct NVGkernels NVGkernels;
+
+static void nvg__flattenBezierScalar(NVGcontext* ctx, float x1, float y1, float x2, float y2,
+									 float x3, float y3, float x4, float y4, int type)
+{
+	nvg__tesselateBezier(ctx, x1,y1, x2,y2, x3,y3, x4,y4, 0, type);
+}
+
+static void nvg__segmentsScalar(NVGpoint* pts, int count, float* bounds)
+{
+	NVGpoint* p0 = &pts[count-1];
+	NVGpoint* p1 = &pts[0];
+	int i;
+	for (i = 0; i < count; i++) {
+		// Calculate segment direction and length
+		p0->dx = p1->x - p0->x;
+		p0->dy = p1->y - p0->y;
+		p0->len = nvg__normalize(&p0->dx, &p0->dy);
+		// Update bounds
+		bounds[0] = nvg__minf(bounds[0], p0->x);
+		bounds[1] = nvg__minf(bounds[1], p0->y);
+		bounds[2] = nvg__maxf(bounds[2], p0->x);
+		bounds[3] = nvg__maxf(bounds[3], p0->y);
+		// Advance
+		p0 = p1++;
+	}
+}
+
+static int nvg__joinPoint(NVGpoint* p0, NVGpoint* p1, float iw, int lineJoin, float miterLimit, int* nbevel)
+{
+	float dlx0, dly0, dlx1, dly1, dmr2, cross, limit;
+	int left = 0;
+	dlx0 = p0->dy;
+	dly0 = -p0->dx;
+	dlx1 = p1->dy;
+	dly1 = -p1->dx;
+	// Calculate extrusions
+	p1->dmx = (dlx0 + dlx1) * 0.5f;
+	p1->dmy = (dly0 + dly1) * 0.5f;
+	dmr2 = p1->dmx*p1->dmx + p1->dmy*p1->dmy;
+	if (dmr2 > 0.000001f) {
+		float scale = 1.0f / dmr2;
+		if (scale > 600.0f) {
+			scale = 600.0f;
+		}
+		p1->dmx *= scale;
+		p1->dmy *= scale;
+	}
+
+	// Clear flags, but keep the corner.
+	p1->flags = (p1->flags & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
+
+	// Keep track of left turns.
+	cross = p1->dx * p0->dy - p0->dx * p1->dy;
+	if (cross > 0.0f) {
+		left = 1;
+		p1->flags |= NVG_PT_LEFT;
+	}
+
+	// Calculate if we should use bevel or miter for inner join.
+	limit = nvg__maxf(1.01f, nvg__minf(p0->len, p1->len) * iw);
+	if ((dmr2 * limit*limit) < 1.0f)
+		p1->flags |= NVG_PR_INNERBEVEL;
+
+	// Check to see if the corner needs to be beveled.
+	if (p1->flags & NVG_PT_CORNER) {
+		if ((dmr2 * miterLimit*miterLimit) < 1.0f || lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND) {
+			p1->flags |= NVG_PT_BEVEL;
+		}
+	}
+
+	if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
+		(*nbevel)++;
+	return left;
+}
+
+static int nvg__joinsScalar(NVGpoint* pts, int count, float iw, int lineJoin, float miterLimit, int* nbevel)
+{
+	NVGpoint* p0 = &pts[count-1];
+	NVGpoint* p1 = &pts[0];
+	int j, nleft = 0;
+	for (j = 0; j < count; j++) {
+		nleft += nvg__joinPoint(p0, p1, iw, lineJoin, miterLimit, nbevel);
+		p0 = p1++;
+	}
+	return nleft;
+}
+
+static NVGvertex* nvg__mitersScalar(NVGvertex* dst, const NVGpoint* pts, int count, float w, float u0, float u1)
+{
+	int i;
+	for (i = 0; i < count; i++) {
+		const NVGpoint* p = &pts[i];
+		nvg__vset(dst, p->x + (p->dmx * w), p->y + (p->dmy * w), u0,1); dst++;
+		nvg__vset(dst, p->x - (p->dmx * w), p->y - (p->dmy * w), u1,1); dst++;
+	}
+	return dst;
+}
+
+static void nvg__arcScalar(float* cs, float* sn, float a0, float a1, int first, int count, int n)
+{
+	int i;
+	for (i = 0; i < count; i++) {
+		float u = (first+i)/(float)(n-1);
+		float a = a0 + u*(a1-a0);
+		cs[i] = cosf(a);
+		sn[i] = sinf(a);
+	}
+}
+
+static void nvg__minmaxScalar(const float* v, int count, int* imin, int* imax)
+{
+	int i, mn = 0, mx = 0;
+	for (i = 1; i < count; i++) {
+		if (v[i] < v[mn]) mn = i;
+		if (v[i] > v[mx]) mx = i;
+	}
+	*imin = mn;
+	*imax = mx;
+}
+
+static const NVGkernels nvg__kernelsScalar = {
+	nvg__flattenBezierScalar,
+	nvg__segmentsScalar,
+	nvg__joinsScalar,
+	nvg__mitersScalar,
+	nvg__arcScalar,
+	nvg__minmaxScalar,
+};
+
+#ifdef NVG_SSE2
+
+// Loads x, y, dx, dy of four points as columns.
+#define NVG_LOAD_POINTS4(p, r0, r1, r2, r3) \
+	r0 = _mm_loadu_ps(&(p)[0].x); \
+	r1 = _mm_loadu_ps(&(p)[1].x); \
+	r2 = _mm_loadu_ps(&(p)[2].x); \
+	r3 = _mm_loadu_ps(&(p)[3].x); \
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3)
+
+static void nvg__flattenBezierSSE2(NVGcontext* ctx, float x1, float y1, float x2, float y2,
+								   float x3, float y3, float x4, float y4, int type)
+{
+	// Step count from the bound of the second derivative, |B''| <= 6*dd and the
+	// chord error of uniform steps is at most max|B''|/(8*n^2). The recursive
+	// flattening accepts control points up to sqrt(tessTol) off the chord, which
+	// is a curve error of up to 0.75*sqrt(tessTol), use the same tolerance.
+	float ddx0 = x1 - 2.0f*x2 + x3, ddy0 = y1 - 2.0f*y2 + y3;
+	float ddx1 = x2 - 2.0f*x3 + x4, ddy1 = y2 - 2.0f*y3 + y4;
+	float dd = nvg__sqrtf(nvg__maxf(ddx0*ddx0 + ddy0*ddy0, ddx1*ddx1 + ddy1*ddy1));
+	int n = nvg__clampi((int)ceilf(nvg__sqrtf(dd / nvg__sqrtf(ctx->tessTol))), 1, 1024);
+	float ax = -x1 + 3.0f*x2 - 3.0f*x3 + x4, ay = -y1 + 3.0f*y2 - 3.0f*y3 + y4;
+	float bx = 3.0f*x1 - 6.0f*x2 + 3.0f*x3, by = 3.0f*y1 - 6.0f*y2 + 3.0f*y3;
+	float cx = 3.0f*(x2 - x1), cy = 3.0f*(y2 - y1);
+	__m128 vax = _mm_set1_ps(ax), vay = _mm_set1_ps(ay);
+	__m128 vbx = _mm_set1_ps(bx), vby = _mm_set1_ps(by);
+	__m128 vcx = _mm_set1_ps(cx), vcy = _mm_set1_ps(cy);
+	__m128 vx1 = _mm_set1_ps(x1), vy1 = _mm_set1_ps(y1);
+	__m128 step = _mm_set1_ps(1.0f / n);
+	__m128 idx = _mm_set_ps(4.0f, 3.0f, 2.0f, 1.0f);
+	float px[4], py[4];
+	int i, k;
+
+	for (i = 1; i < n; i += 4) {
+		__m128 t = _mm_mul_ps(idx, step);
+		__m128 x = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(vax, t), vbx), t), vcx), t), vx1);
+		__m128 y = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(vay, t), vby), t), vcy), t), vy1);
+		_mm_storeu_ps(px, x);
+		_mm_storeu_ps(py, y);
+		for (k = 0; k < 4 && i+k < n; k++)
+			nvg__addPoint(ctx, px[k], py[k], 0);
+		idx = _mm_add_ps(idx, _mm_set1_ps(4.0f));
+	}
+	nvg__addPoint(ctx, x4, y4, type);
+}
+
+static void nvg__segmentsSSE2(NVGpoint* pts, int count, float* bounds)
+{
+	__m128 eps = _mm_set1_ps(1e-6f);
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 minx = _mm_set1_ps(bounds[0]), miny = _mm_set1_ps(bounds[1]);
+	__m128 maxx = _mm_set1_ps(bounds[2]), maxy = _mm_set1_ps(bounds[3]);
+	float tmp[4];
+	int i = 0, k;
+
+	// Segments without wrap around, four at a time.
+	for (; i+4 < count; i += 4) {
+		NVGpoint* p = &pts[i];
+		__m128 x0, y0, dx, dy, x1, y1, t0, t1, d, id, mask;
+		NVG_LOAD_POINTS4(p, x0, y0, dx, dy);
+		NVG_LOAD_POINTS4(p+1, x1, y1, t0, t1);
+		dx = _mm_sub_ps(x1, x0);
+		dy = _mm_sub_ps(y1, y0);
+		d = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)));
+		mask = _mm_cmpgt_ps(d, eps);
+		id = _mm_or_ps(_mm_and_ps(mask, _mm_div_ps(one, d)), _mm_andnot_ps(mask, one));
+		dx = _mm_mul_ps(dx, id);
+		dy = _mm_mul_ps(dy, id);
+		minx = _mm_min_ps(minx, x0);
+		miny = _mm_min_ps(miny, y0);
+		maxx = _mm_max_ps(maxx, x0);
+		maxy = _mm_max_ps(maxy, y0);
+
+		_mm_storeu_ps(tmp, d);
+		t0 = x0;
+		t1 = y0;
+		_MM_TRANSPOSE4_PS(t0, t1, dx, dy);
+		_mm_storeu_ps(&p[0].x, t0);
+		_mm_storeu_ps(&p[1].x, t1);
+		_mm_storeu_ps(&p[2].x, dx);
+		_mm_storeu_ps(&p[3].x, dy);
+		for (k = 0; k < 4; k++)
+			p[k].len = tmp[k];
+	}
+
+	_mm_storeu_ps(tmp, minx);
+	bounds[0] = nvg__minf(nvg__minf(tmp[0], tmp[1]), nvg__minf(tmp[2], tmp[3]));
+	_mm_storeu_ps(tmp, miny);
+	bounds[1] = nvg__minf(nvg__minf(tmp[0], tmp[1]), nvg__minf(tmp[2], tmp[3]));
+	_mm_storeu_ps(tmp, maxx);
+	bounds[2] = nvg__maxf(nvg__maxf(tmp[0], tmp[1]), nvg__maxf(tmp[2], tmp[3]));
+	_mm_storeu_ps(tmp, maxy);
+	bounds[3] = nvg__maxf(nvg__maxf(tmp[0], tmp[1]), nvg__maxf(tmp[2], tmp[3]));
+
+	for (; i < count; i++) {
+		NVGpoint* p0 = &pts[i];
+		NVGpoint* p1 = &pts[(i+1) % count];
+		p0->dx = p1->x - p0->x;
+		p0->dy = p1->y - p0->y;
+		p0->len = nvg__normalize(&p0->dx, &p0->dy);
+		bounds[0] = nvg__minf(bounds[0], p0->x);
+		bounds[1] = nvg__minf(bounds[1], p0->y);
+		bounds[2] = nvg__maxf(bounds[2], p0->x);
+		bounds[3] = nvg__maxf(bounds[3], p0->y);
+	}
+}
+
+static int nvg__joinsSSE2(NVGpoint* pts, int count, float iw, int lineJoin, float miterLimit, int* nbevel)
+{
+	__m128 half = _mm_set1_ps(0.5f);
+	__m128 eps = _mm_set1_ps(0.000001f);
+	__m128 one = _mm_set1_ps(1.0f);
+	__m128 maxScale = _mm_set1_ps(600.0f);
+	__m128 minLimit = _mm_set1_ps(1.01f);
+	__m128 viw = _mm_set1_ps(iw);
+	__m128 vml = _mm_set1_ps(miterLimit);
+	__m128 sign = _mm_set1_ps(-0.0f);
+	int forceBevel = lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND;
+	float dmx[4], dmy[4];
+	int i, k, nleft;
+
+	if (count == 0)
+		return 0;
+
+	// The first point joins the last segment.
+	nleft = nvg__joinPoint(&pts[count-1], &pts[0], iw, lineJoin, miterLimit, nbevel);
+
+	for (i = 1; i+4 <= count; i += 4) {
+		NVGpoint* p = &pts[i];
+		__m128 x0, y0, dx0, dy0, x1, y1, dx1, dy1, len0, len1;
+		__m128 mx, my, dmr2, scale, mask, cross, limit;
+		int left, inner, bevel;
+		NVG_LOAD_POINTS4(p-1, x0, y0, dx0, dy0);
+		NVG_LOAD_POINTS4(p, x1, y1, dx1, dy1);
+		len0 = _mm_set_ps(p[2].len, p[1].len, p[0].len, p[-1].len);
+		len1 = _mm_set_ps(p[3].len, p[2].len, p[1].len, p[0].len);
+
+		// Calculate extrusions, dl = (dy, -dx)
+		mx = _mm_mul_ps(_mm_add_ps(dy0, dy1), half);
+		my = _mm_mul_ps(_mm_add_ps(_mm_xor_ps(dx0, sign), _mm_xor_ps(dx1, sign)), half);
+		dmr2 = _mm_add_ps(_mm_mul_ps(mx, mx), _mm_mul_ps(my, my));
+		mask = _mm_cmpgt_ps(dmr2, eps);
+		scale = _mm_min_ps(_mm_div_ps(one, dmr2), maxScale);
+		scale = _mm_or_ps(_mm_and_ps(mask, scale), _mm_andnot_ps(mask, one));
+		_mm_storeu_ps(dmx, _mm_mul_ps(mx, scale));
+		_mm_storeu_ps(dmy, _mm_mul_ps(my, scale));
+
+		cross = _mm_sub_ps(_mm_mul_ps(dx1, dy0), _mm_mul_ps(dx0, dy1));
+		left = _mm_movemask_ps(_mm_cmpgt_ps(cross, _mm_setzero_ps()));
+
+		limit = _mm_max_ps(minLimit, _mm_mul_ps(_mm_min_ps(len0, len1), viw));
+		inner = _mm_movemask_ps(_mm_cmplt_ps(_mm_mul_ps(_mm_mul_ps(dmr2, limit), limit), one));
+		bevel = forceBevel ? 0xf : _mm_movemask_ps(_mm_cmplt_ps(_mm_mul_ps(_mm_mul_ps(dmr2, vml), vml), one));
+
+		for (k = 0; k < 4; k++) {
+			NVGpoint* p1 = &p[k];
+			unsigned char flags = (p1->flags & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
+			p1->dmx = dmx[k];
+			p1->dmy = dmy[k];
+			if (left & (1 << k)) {
+				nleft++;
+				flags |= NVG_PT_LEFT;
+			}
+			if (inner & (1 << k))
+				flags |= NVG_PR_INNERBEVEL;
+			if ((flags & NVG_PT_CORNER) && (bevel & (1 << k)))
+				flags |= NVG_PT_BEVEL;
+			if ((flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
+				(*nbevel)++;
+			p1->flags = flags;
+		}
+	}
+
+	for (; i < count; i++)
+		nleft += nvg__joinPoint(&pts[i-1], &pts[i], iw, lineJoin, miterLimit, nbevel);
+	return nleft;
+}
+
+static NVGvertex* nvg__mitersSSE2(NVGvertex* dst, const NVGpoint* pts, int count, float w, float u0, float u1)
+{
+	__m128 vw = _mm_set_ps(-w, -w, w, w);
+	__m128 uv = _mm_set_ps(1.0f, u1, 1.0f, u0);
+	int i;
+	for (i = 0; i < count; i++) {
+		const NVGpoint* p = &pts[i];
+		__m128 xy = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)&p->x);
+		__m128 dm = _mm_loadl_pi(_mm_setzero_ps(), (const __m64*)&p->dmx);
+		xy = _mm_movelh_ps(xy, xy);
+		dm = _mm_movelh_ps(dm, dm);
+		__m128 v = _mm_add_ps(xy, _mm_mul_ps(dm, vw));
+		// (x + dmx*w, y + dmy*w, u0, 1) and (x - dmx*w, y - dmy*w, u1, 1)
+		_mm_storeu_ps(&dst[0].x, _mm_movelh_ps(v, uv));
+		_mm_storeu_ps(&dst[1].x, _mm_movehl_ps(uv, v));
+		dst += 2;
+	}
+	return dst;
+}
+
+// Cody-Waite reduction by pi/2 and the minimax polynomials of cephes sinf/cosf.
+static void nvg__sincosSSE2(__m128 x, __m128* s, __m128* c)
+{
+	__m128i q = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(0.63661977236758134f)));
+	__m128 fq = _mm_cvtepi32_ps(q);
+	__m128 r, r2, ps, pc, swap;
+	__m128i one = _mm_set1_epi32(1), two = _mm_set1_epi32(2);
+	r = _mm_sub_ps(x, _mm_mul_ps(fq, _mm_set1_ps(1.5703125f)));
+	r = _mm_sub_ps(r, _mm_mul_ps(fq, _mm_set1_ps(4.837512969970703125e-4f)));
+	r = _mm_sub_ps(r, _mm_mul_ps(fq, _mm_set1_ps(7.54978995489188216e-8f)));
+	r2 = _mm_mul_ps(r, r);
+
+	ps = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-1.9515295891e-4f), r2), _mm_set1_ps(8.3321608736e-3f));
+	ps = _mm_add_ps(_mm_mul_ps(ps, r2), _mm_set1_ps(-1.6666654611e-1f));
+	ps = _mm_add_ps(_mm_mul_ps(_mm_mul_ps(ps, r2), r), r);
+
+	// Horner form keeps the products away from denormals for r close to 0.
+	pc = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(2.443315711809948e-5f), r2), _mm_set1_ps(-1.388731625493765e-3f));
+	pc = _mm_add_ps(_mm_mul_ps(pc, r2), _mm_set1_ps(4.166664568298827e-2f));
+	pc = _mm_add_ps(_mm_mul_ps(pc, r2), _mm_set1_ps(-0.5f));
+	pc = _mm_add_ps(_mm_mul_ps(pc, r2), _mm_set1_ps(1.0f));
+
+	// Odd quadrants swap sin and cos, the signs follow the quadrant.
+	swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(q, one), one));
+	*s = _mm_or_ps(_mm_and_ps(swap, pc), _mm_andnot_ps(swap, ps));
+	*c = _mm_or_ps(_mm_and_ps(swap, ps), _mm_andnot_ps(swap, pc));
+	*s = _mm_xor_ps(*s, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(q, two), 30)));
+	*c = _mm_xor_ps(*c, _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(q, one), two), 30)));
+}
+
+static void nvg__arcSSE2(float* cs, float* sn, float a0, float a1, int first, int count, int n)
+{
+	__m128 va0 = _mm_set1_ps(a0);
+	__m128 da = _mm_set1_ps(a1 - a0);
+	__m128 idiv = _mm_set1_ps((float)(n-1));
+	__m128 idx = _mm_add_ps(_mm_set1_ps((float)first), _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f));
+	float c4[4], s4[4];
+	int i, k;
+	for (i = 0; i < count; i += 4) {
+		__m128 a = _mm_add_ps(va0, _mm_mul_ps(_mm_div_ps(idx, idiv), da));
+		__m128 s, c;
+		nvg__sincosSSE2(a, &s, &c);
+		if (i+4 <= count) {
+			_mm_storeu_ps(&cs[i], c);
+			_mm_storeu_ps(&sn[i], s);
+		} else {
+			_mm_storeu_ps(c4, c);
+			_mm_storeu_ps(s4, s);
+			for (k = 0; i+k < count; k++) {
+				cs[i+k] = c4[k];
+				sn[i+k] = s4[k];
+			}
+		}
+		idx = _mm_add_ps(idx, _mm_set1_ps(4.0f));
+	}
+}
+
+static void nvg__minmaxSSE2(const float* v, int count, int* imin, int* imax)
+{
+	__m128 vmin, vmax;
+	__m128i idx, imn, imx, four;
+	float mn4[4], mx4[4];
+	int in4[4], ix4[4];
+	int i, k, mn, mx;
+	if (count < 8) {
+		nvg__minmaxScalar(v, count, imin, imax);
+		return;
+	}
+	// Min, max and their first index per lane
+	vmin = vmax = _mm_loadu_ps(v);
+	idx = imn = imx = _mm_set_epi32(3, 2, 1, 0);
+	four = _mm_set1_epi32(4);
+	for (i = 4; i+4 <= count; i += 4) {
+		__m128 x = _mm_loadu_ps(&v[i]);
+		__m128i lt = _mm_castps_si128(_mm_cmplt_ps(x, vmin));
+		__m128i gt = _mm_castps_si128(_mm_cmpgt_ps(x, vmax));
+		idx = _mm_add_epi32(idx, four);
+		vmin = _mm_min_ps(vmin, x);
+		vmax = _mm_max_ps(vmax, x);
+		imn = _mm_or_si128(_mm_and_si128(lt, idx), _mm_andnot_si128(lt, imn));
+		imx = _mm_or_si128(_mm_and_si128(gt, idx), _mm_andnot_si128(gt, imx));
+	}
+	_mm_storeu_ps(mn4, vmin);
+	_mm_storeu_ps(mx4, vmax);
+	_mm_storeu_si128((__m128i*)in4, imn);
+	_mm_storeu_si128((__m128i*)ix4, imx);
+	// Reduce the lanes, the lower index wins ties
+	mn = in4[0];
+	mx = ix4[0];
+	for (k = 1; k < 4; k++) {
+		if (mn4[k] < v[mn] || (mn4[k] == v[mn] && in4[k] < mn)) mn = in4[k];
+		if (mx4[k] > v[mx] || (mx4[k] == v[mx] && ix4[k] < mx)) mx = ix4[k];
+	}
+	for (; i < count; i++) {
+		if (v[i] < v[mn]) mn = i;
+		if (v[i] > v[mx]) mx = i;
+	}
+	*imin = mn;
+	*imax = mx;
+}
+
+static const NVGkernels nvg__kernelsSSE2 = {
+	nvg__flattenBezierSSE2,
+	nvg__segmentsSSE2,
+	nvg__joinsSSE2,
+	nvg__mitersSSE2,
+	nvg__arcSSE2,
+	nvg__minmaxSSE2,
+};
+
+static const NVGkernels* nvg__kernels = &nvg__kernelsSSE2;
+static int nvg__simdLevel = NVG_SIMD_SSE2;
+
+#else
+
+static const NVGkernels* nvg__kernels = &nvg__kernelsScalar;
+static int nvg__simdLevel = NVG_SIMD_NONE;
+
+#endif
+
+int nvgSimdSupported(void)
+{
+#ifdef NVG_SSE2
+	return NVG_SIMD_SSE2;
+#else
+	return NVG_SIMD_NONE;
+#endif
+}
+
+int nvgGetSimdLevel(void)
+{
+	return nvg__simdLevel;
+}
+
+int nvgSimdLevel(int level)
+{
+	level = nvg__clampi(level, NVG_SIMD_NONE, nvgSimdSupported());
+#ifdef NVG_SSE2
+	nvg__kernels = level == NVG_SIMD_SSE2 ? &nvg__kernelsSSE2 : &nvg__kernelsScalar;
+#endif
+	nvg__simdLevel = level;
+	return level;
+}
+
 static void nvg__flattenPaths(NVGcontext* ctx)
 {
 	NVGpathCache* cache = ctx->cache;
@@ -1364,7 +2278,7 @@ static void nvg__flattenPaths(NVGcontext* ctx)
 				cp1 = &ctx->commands[i+1];
 				cp2 = &ctx->commands[i+3];
 				p = &ctx->commands[i+5];
-				nvg__tesselateBezier(ctx, last->x,last->y, cp1[0],cp1[1], cp2[0],cp2[1], p[0],p[1], 0, NVG_PT_CORNER);
+				nvg__kernels->flattenBezier(ctx, last->x,last->y, cp1[0],cp1[1], cp2[0],cp2[1], p[0],p[1], NVG_PT_CORNER);
 			}
 			i += 7;
 			break;
@@ -1394,7 +2308,6 @@ static void nvg__flattenPaths(NVGcontext* ctx)
 		p1 = &pts[0];
 		if (nvg__ptEquals(p0->x,p0->y, p1->x,p1->y, ctx->distTol)) {
 			path->count--;
-			p0 = &pts[path->count-1];
 			path->closed = 1;
 		}
 
@@ -1407,19 +2320,8 @@ static void nvg__flattenPaths(NVGcontext* ctx)
 				nvg__polyReverse(pts, path->count);
 		}
 
-		for(i = 0; i < path->count; i++) {
-			// Calculate segment direction and length
-			p0->dx = p1->x - p0->x;
-			p0->dy = p1->y - p0->y;
-			p0->len = nvg__normalize(&p0->dx, &p0->dy);
-			// Update bounds
-			cache->bounds[0] = nvg__minf(cache->bounds[0], p0->x);
-			cache->bounds[1] = nvg__minf(cache->bounds[1], p0->y);
-			cache->bounds[2] = nvg__maxf(cache->bounds[2], p0->x);
-			cache->bounds[3] = nvg__maxf(cache->bounds[3], p0->y);
-			// Advance
-			p0 = p1++;
-		}
+		// Calculate segment direction and length
+		nvg__kernels->segments(pts, path->count, cache->bounds);
 	}
 }
 
@@ -1454,6 +2356,7 @@ static NVGvertex* nvg__roundJoin(NVGvertex* dst, NVGpoint* p0, NVGpoint* p1,
 	float dly0 = -p0->dx;
 	float dlx1 = p1->dy;
 	float dly1 = -p1->dx;
+	float cs[NVG_ARC_BATCH], sn[NVG_ARC_BATCH];
 	NVG_NOTUSED(fringe);
 
 	if (p1->flags & NVG_PT_LEFT) {
@@ -1467,13 +2370,15 @@ static NVGvertex* nvg__roundJoin(NVGvertex* dst, NVGpoint* p0, NVGpoint* p1,
 		nvg__vset(dst, p1->x - dlx0*rw, p1->y - dly0*rw, ru,1); dst++;
 
 		n = nvg__clampi((int)ceilf(((a0 - a1) / NVG_PI) * ncap), 2, ncap);
-		for (i = 0; i < n; i++) {
-			float u = i/(float)(n-1);
-			float a = a0 + u*(a1-a0);
-			float rx = p1->x + cosf(a) * rw;
-			float ry = p1->y + sinf(a) * rw;
-			nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
-			nvg__vset(dst, rx, ry, ru,1); dst++;
+		for (i = 0; i < n; i += NVG_ARC_BATCH) {
+			int k, m = nvg__mini(NVG_ARC_BATCH, n-i);
+			nvg__kernels->arc(cs, sn, a0, a1, i, m, n);
+			for (k = 0; k < m; k++) {
+				float rx = p1->x + cs[k] * rw;
+				float ry = p1->y + sn[k] * rw;
+				nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
+				nvg__vset(dst, rx, ry, ru,1); dst++;
+			}
 		}
 
 		nvg__vset(dst, lx1, ly1, lu,1); dst++;
@@ -1490,13 +2395,15 @@ static NVGvertex* nvg__roundJoin(NVGvertex* dst, NVGpoint* p0, NVGpoint* p1,
 		nvg__vset(dst, rx0, ry0, ru,1); dst++;
 
 		n = nvg__clampi((int)ceilf(((a1 - a0) / NVG_PI) * ncap), 2, ncap);
-		for (i = 0; i < n; i++) {
-			float u = i/(float)(n-1);
-			float a = a0 + u*(a1-a0);
-			float lx = p1->x + cosf(a) * lw;
-			float ly = p1->y + sinf(a) * lw;
-			nvg__vset(dst, lx, ly, lu,1); dst++;
-			nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
+		for (i = 0; i < n; i += NVG_ARC_BATCH) {
+			int k, m = nvg__mini(NVG_ARC_BATCH, n-i);
+			nvg__kernels->arc(cs, sn, a0, a1, i, m, n);
+			for (k = 0; k < m; k++) {
+				float lx = p1->x + cs[k] * lw;
+				float ly = p1->y + sn[k] * lw;
+				nvg__vset(dst, lx, ly, lu,1); dst++;
+				nvg__vset(dst, p1->x, p1->y, 0.5f,1); dst++;
+			}
 		}
 
 		nvg__vset(dst, p1->x + dlx1*rw, p1->y + dly1*rw, lu,1); dst++;
@@ -1619,12 +2526,16 @@ static NVGvertex* nvg__roundCapStart(NVGvertex* dst, NVGpoint* p,
 	float py = p->y;
 	float dlx = dy;
 	float dly = -dx;
+	float cs[NVG_ARC_BATCH], sn[NVG_ARC_BATCH];
 	NVG_NOTUSED(aa);
-	for (i = 0; i < ncap; i++) {
-		float a = i/(float)(ncap-1)*NVG_PI;
-		float ax = cosf(a) * w, ay = sinf(a) * w;
-		nvg__vset(dst, px - dlx*ax - dx*ay, py - dly*ax - dy*ay, u0,1); dst++;
-		nvg__vset(dst, px, py, 0.5f,1); dst++;
+	for (i = 0; i < ncap; i += NVG_ARC_BATCH) {
+		int k, m = nvg__mini(NVG_ARC_BATCH, ncap-i);
+		nvg__kernels->arc(cs, sn, 0.0f, NVG_PI, i, m, ncap);
+		for (k = 0; k < m; k++) {
+			float ax = cs[k] * w, ay = sn[k] * w;
+			nvg__vset(dst, px - dlx*ax - dx*ay, py - dly*ax - dy*ay, u0,1); dst++;
+			nvg__vset(dst, px, py, 0.5f,1); dst++;
+		}
 	}
 	nvg__vset(dst, px + dlx*w, py + dly*w, u0,1); dst++;
 	nvg__vset(dst, px - dlx*w, py - dly*w, u1,1); dst++;
@@ -1640,14 +2551,18 @@ static NVGvertex* nvg__roundCapEnd(NVGvertex* dst, NVGpoint* p,
 	float py = p->y;
 	float dlx = dy;
 	float dly = -dx;
+	float cs[NVG_ARC_BATCH], sn[NVG_ARC_BATCH];
 	NVG_NOTUSED(aa);
 	nvg__vset(dst, px + dlx*w, py + dly*w, u0,1); dst++;
 	nvg__vset(dst, px - dlx*w, py - dly*w, u1,1); dst++;
-	for (i = 0; i < ncap; i++) {
-		float a = i/(float)(ncap-1)*NVG_PI;
-		float ax = cosf(a) * w, ay = sinf(a) * w;
-		nvg__vset(dst, px, py, 0.5f,1); dst++;
-		nvg__vset(dst, px - dlx*ax + dx*ay, py - dly*ax + dy*ay, u0,1); dst++;
+	for (i = 0; i < ncap; i += NVG_ARC_BATCH) {
+		int k, m = nvg__mini(NVG_ARC_BATCH, ncap-i);
+		nvg__kernels->arc(cs, sn, 0.0f, NVG_PI, i, m, ncap);
+		for (k = 0; k < m; k++) {
+			float ax = cs[k] * w, ay = sn[k] * w;
+			nvg__vset(dst, px, py, 0.5f,1); dst++;
+			nvg__vset(dst, px - dlx*ax + dx*ay, py - dly*ax + dy*ay, u0,1); dst++;
+		}
 	}
 	return dst;
 }
@@ -1665,62 +2580,13 @@ static void nvg__calculateJoins(NVGcontext* ctx, float w, int lineJoin, float mi
 	for (i = 0; i < cache->npaths; i++) {
 		NVGpath* path = &cache->paths[i];
 		NVGpoint* pts = &cache->points[path->first];
-		NVGpoint* p0 = &pts[path->count-1];
-		NVGpoint* p1 = &pts[0];
-		int nleft = 0;
+		int nleft;
 
 		path->nbevel = 0;
-
-		for (j = 0; j < path->count; j++) {
-			float dlx0, dly0, dlx1, dly1, dmr2, cross, limit;
-			dlx0 = p0->dy;
-			dly0 = -p0->dx;
-			dlx1 = p1->dy;
-			dly1 = -p1->dx;
-			// Calculate extrusions
-			p1->dmx = (dlx0 + dlx1) * 0.5f;
-			p1->dmy = (dly0 + dly1) * 0.5f;
-			dmr2 = p1->dmx*p1->dmx + p1->dmy*p1->dmy;
-			if (dmr2 > 0.000001f) {
-				float scale = 1.0f / dmr2;
-				if (scale > 600.0f) {
-					scale = 600.0f;
-				}
-				p1->dmx *= scale;
-				p1->dmy *= scale;
-			}
-
-			// Clear flags, but keep the corner.
-			p1->flags = (p1->flags & NVG_PT_CORNER) ? NVG_PT_CORNER : 0;
-
-			// Keep track of left turns.
-			cross = p1->dx * p0->dy - p0->dx * p1->dy;
-			if (cross > 0.0f) {
-				nleft++;
-				p1->flags |= NVG_PT_LEFT;
-			}
-
-			// Calculate if we should use bevel or miter for inner join.
-			limit = nvg__maxf(1.01f, nvg__minf(p0->len, p1->len) * iw);
-			if ((dmr2 * limit*limit) < 1.0f)
-				p1->flags |= NVG_PR_INNERBEVEL;
-
-			// Check to see if the corner needs to be beveled.
-			if (p1->flags & NVG_PT_CORNER) {
-				if ((dmr2 * miterLimit*miterLimit) < 1.0f || lineJoin == NVG_BEVEL || lineJoin == NVG_ROUND) {
-					p1->flags |= NVG_PT_BEVEL;
-				}
-			}
-
-			if ((p1->flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) != 0)
-				path->nbevel++;
-
-			p0 = p1++;
-		}
-
-		path->convex = (nleft == path->count) ? 1 : 0;
-	}
-}
+		nleft = nvg__kernels->joins(pts, path->count, iw, lineJoin, miterLimit, &path->nbevel);
+		path->convex = (nleft == path->count) ? 1 : 0;
+	}
+}
 
 
 static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap, int lineJoin, float miterLimit)
@@ -1815,11 +2681,17 @@ static int nvg__expandStroke(NVGcontext* ctx, float w, float fringe, int lineCap
 				} else {
 					dst = nvg__bevelJoin(dst, p0, p1, w, w, u0, u1, aa);
 				}
+				p0 = p1++;
 			} else {
-				nvg__vset(dst, p1->x + (p1->dmx * w), p1->y + (p1->dmy * w), u0,1); dst++;
-				nvg__vset(dst, p1->x - (p1->dmx * w), p1->y - (p1->dmy * w), u1,1); dst++;
+				// Run of points without join vertices.
+				int n = 1;
+				while (j+n < e && (p1[n].flags & (NVG_PT_BEVEL | NVG_PR_INNERBEVEL)) == 0)
+					n++;
+				dst = nvg__kernels->miters(dst, p1, n, w, u0, u1);
+				p0 = &p1[n-1];
+				p1 += n;
+				j += n-1;
 			}
-			p0 = p1++;
 		}
 
 		if (loop) {
@@ -1972,6 +2844,8 @@ static int nvg__expandFill(NVGcontext* ctx, float w, int lineJoin, float miterLi
 void nvgBeginPath(NVGcontext* ctx)
 {
 	ctx->ncommands = 0;
+	ctx->commandBounds[0] = ctx->commandBounds[1] = 1e6f;
+	ctx->commandBounds[2] = ctx->commandBounds[3] = -1e6f;
 	nvg__clearPathCache(ctx);
 }
 
@@ -2222,6 +3096,803 @@ void nvgDebugDumpPathCache(NVGcontext* ctx)
 	}
 }
 
+static void* nvg__growArray(void* data, int* cdata, int n, int size)
+{
+	void* p;
+	int c;
+	if (data != NULL && n <= *cdata)
+		return data;
+	c = n + *cdata/2 + 16;
+	p = realloc(data, (size_t)c * size);
+	if (p == NULL)
+		return NULL;
+	*cdata = c;
+	return p;
+}
+
+// Parallel tessellation
+
+#define NVG_TESS_MIN_CHUNK_COMMANDS 1024
+
+static void nvg__deleteTessChunks(NVGcontext* ctx)
+{
+	int i;
+	for (i = 0; i < ctx->ntessChunks; i++) {
+		NVGtessChunk* chunk = &ctx->tessChunks[i];
+		if (chunk->ctx != NULL) {
+			if (chunk->ctx->cache != NULL) nvg__deletePathCache(chunk->ctx->cache);
+			free(chunk->ctx);
+		}
+		free(chunk->paths);
+		free(chunk->offsets);
+		free(chunk->verts);
+	}
+	free(ctx->tessChunks);
+	ctx->tessChunks = NULL;
+	ctx->ntessChunks = 0;
+}
+
+static void nvg__deleteTessellation(NVGcontext* ctx)
+{
+	nvg__deleteTessChunks(ctx);
+	free(ctx->tessCalls);
+	free(ctx->tessCommands);
+}
+
+static void nvg__queueTessellation(NVGcontext* ctx, int type, NVGpaint* paint, float strokeWidth)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGtessCall* call;
+	NVGtessCall* calls;
+	float* commands = (float*)nvg__growArray(ctx->tessCommands, &ctx->ctessCommands, ctx->ntessCommands+ctx->ncommands, sizeof(float));
+	if (commands == NULL) return;
+	ctx->tessCommands = commands;
+	calls = (NVGtessCall*)nvg__growArray(ctx->tessCalls, &ctx->ctessCalls, ctx->ntessCalls+1, sizeof(NVGtessCall));
+	if (calls == NULL) return;
+	ctx->tessCalls = calls;
+
+	call = &ctx->tessCalls[ctx->ntessCalls++];
+	memset(call, 0, sizeof(*call));
+	call->type = type;
+	call->paint = *paint;
+	call->compositeOperation = state->compositeOperation;
+	call->scissor = state->scissor;
+	call->fringe = (ctx->params.edgeAntiAlias && state->shapeAntiAlias) ? ctx->fringeWidth : 0.0f;
+	call->strokeWidth = strokeWidth;
+	call->lineCap = state->lineCap;
+	call->lineJoin = state->lineJoin;
+	call->miterLimit = state->miterLimit;
+	call->commandOffset = ctx->ntessCommands;
+	call->ncommands = ctx->ncommands;
+	memcpy(&ctx->tessCommands[ctx->ntessCommands], ctx->commands, ctx->ncommands*sizeof(float));
+	ctx->ntessCommands += ctx->ncommands;
+}
+
+static void nvg__tessStorePaths(NVGtessChunk* chunk, NVGtessCall* call)
+{
+	NVGpathCache* cache = chunk->ctx->cache;
+	NVGpath* paths;
+	NVGvertex* verts;
+	int* offsets;
+	int i, nverts = 0;
+
+	for (i = 0; i < cache->npaths; i++) {
+		NVGpath* path = &cache->paths[i];
+		if (path->fill != NULL)
+			nverts = nvg__maxi(nverts, (int)(path->fill - cache->verts) + path->nfill);
+		if (path->stroke != NULL)
+			nverts = nvg__maxi(nverts, (int)(path->stroke - cache->verts) + path->nstroke);
+	}
+
+	paths = (NVGpath*)nvg__growArray(chunk->paths, &chunk->cpaths, chunk->npaths+cache->npaths, sizeof(NVGpath));
+	if (paths == NULL) return;
+	chunk->paths = paths;
+	offsets = (int*)nvg__growArray(chunk->offsets, &chunk->coffsets, (chunk->npaths+cache->npaths)*2, sizeof(int));
+	if (offsets == NULL) return;
+	chunk->offsets = offsets;
+	verts = (NVGvertex*)nvg__growArray(chunk->verts, &chunk->cverts, chunk->nverts+nverts, sizeof(NVGvertex));
+	if (verts == NULL) return;
+	chunk->verts = verts;
+
+	// Pointers are resolved once the chunk is done, the vertex buffer may still move.
+	for (i = 0; i < cache->npaths; i++) {
+		NVGpath* path = &cache->paths[i];
+		chunk->offsets[(chunk->npaths+i)*2+0] = path->fill != NULL ? chunk->nverts + (int)(path->fill - cache->verts) : -1;
+		chunk->offsets[(chunk->npaths+i)*2+1] = path->stroke != NULL ? chunk->nverts + (int)(path->stroke - cache->verts) : -1;
+	}
+	memcpy(&chunk->paths[chunk->npaths], cache->paths, cache->npaths*sizeof(NVGpath));
+	memcpy(&chunk->verts[chunk->nverts], cache->verts, nverts*sizeof(NVGvertex));
+	call->pathOffset = chunk->npaths;
+	call->npaths = cache->npaths;
+	memcpy(call->bounds, cache->bounds, sizeof(float)*4);
+	chunk->npaths += cache->npaths;
+	chunk->nverts += nverts;
+}
+
+static void nvg__tessTask(void* data, int index)
+{
+	NVGcontext* ctx = (NVGcontext*)data;
+	NVGtessChunk* chunk = &ctx->tessChunks[index];
+	NVGcontext* tc = chunk->ctx;
+	int i;
+
+	SGE_PROFILE_BEGIN("nvg__tessTask");
+	chunk->npaths = 0;
+	chunk->nverts = 0;
+	for (i = chunk->first; i < chunk->first + chunk->count; i++) {
+		NVGtessCall* call = &ctx->tessCalls[i];
+		call->chunk = index;
+		call->npaths = 0;
+		tc->commands = &ctx->tessCommands[call->commandOffset];
+		tc->ncommands = call->ncommands;
+		tc->ccommands = call->ncommands;
+		nvg__clearPathCache(tc);
+		nvg__flattenPaths(tc);
+		if (call->type == NVG_LIST_FILL)
+			nvg__expandFill(tc, call->fringe, NVG_MITER, 2.4f);
+		else
+			nvg__expandStroke(tc, call->strokeWidth*0.5f, call->fringe, call->lineCap, call->lineJoin, call->miterLimit);
+		nvg__tessStorePaths(chunk, call);
+	}
+	tc->commands = NULL;
+	tc->ncommands = 0;
+
+	for (i = 0; i < chunk->npaths; i++) {
+		int fill = chunk->offsets[i*2+0];
+		int stroke = chunk->offsets[i*2+1];
+		chunk->paths[i].fill = fill >= 0 ? &chunk->verts[fill] : NULL;
+		chunk->paths[i].stroke = stroke >= 0 ? &chunk->verts[stroke] : NULL;
+	}
+	SGE_PROFILE_END();
+}
+
+static void nvg__flushTessellation(NVGcontext* ctx)
+{
+	int i, nchunks, first, commands;
+
+	if (ctx->ntessCalls == 0)
+		return;
+
+	// Split the queue in chunks of about the same number of commands.
+	nchunks = nvg__clampi(ctx->ntessCommands / NVG_TESS_MIN_CHUNK_COMMANDS, 1, nvg__mini(ctx->ntessChunks, ctx->ntessCalls));
+	for (i = 0, first = 0, commands = 0; i < nchunks; i++) {
+		NVGtessChunk* chunk = &ctx->tessChunks[i];
+		int target = (int)((long long)ctx->ntessCommands * (i+1) / nchunks);
+		chunk->first = first;
+		while (first < ctx->ntessCalls && (commands < target || i == nchunks-1)) {
+			commands += ctx->tessCalls[first].ncommands;
+			first++;
+		}
+		chunk->count = first - chunk->first;
+		chunk->ctx->tessTol = ctx->tessTol;
+		chunk->ctx->distTol = ctx->distTol;
+		chunk->ctx->fringeWidth = ctx->fringeWidth;
+	}
+
+	if (nchunks > 1)
+		ctx->tessRunner(ctx->tessRunnerPtr, nvg__tessTask, ctx, nchunks);
+	else
+		nvg__tessTask(ctx, 0);
+
+	// Submit in call order.
+	for (i = 0; i < ctx->ntessCalls; i++) {
+		NVGtessCall* call = &ctx->tessCalls[i];
+		const NVGpath* paths = &ctx->tessChunks[call->chunk].paths[call->pathOffset];
+		int j;
+		if (call->type == NVG_LIST_FILL) {
+			ctx->params.renderFill(ctx->params.userPtr, &call->paint, call->compositeOperation, &call->scissor, ctx->fringeWidth,
+								   call->bounds, paths, call->npaths);
+			for (j = 0; j < call->npaths; j++) {
+				ctx->fillTriCount += paths[j].nfill-2;
+				ctx->fillTriCount += paths[j].nstroke-2;
+				ctx->drawCallCount += 2;
+			}
+		} else {
+			ctx->params.renderStroke(ctx->params.userPtr, &call->paint, call->compositeOperation, &call->scissor, ctx->fringeWidth,
+									 call->strokeWidth, paths, call->npaths);
+			for (j = 0; j < call->npaths; j++) {
+				ctx->strokeTriCount += paths[j].nstroke-2;
+				ctx->drawCallCount++;
+			}
+		}
+	}
+
+	ctx->ntessCalls = 0;
+	ctx->ntessCommands = 0;
+}
+
+// Layers
+
+int nvgBeginLayer(NVGcontext* ctx, int image)
+{
+	NVGlayer* layer;
+	int w, h;
+
+	if (ctx->params.renderTarget == NULL || ctx->recording != NULL || ctx->nlayers >= NVG_MAX_LAYERS)
+		return 0;
+	if (ctx->params.renderGetTextureSize(ctx->params.userPtr, image, &w, &h) == 0)
+		return 0;
+
+	// The queued paths belong to the previous target.
+	nvg__flushTessellation(ctx);
+	layer = &ctx->layers[ctx->nlayers++];
+	layer->image = image;
+	layer->viewWidth = ctx->viewWidth;
+	layer->viewHeight = ctx->viewHeight;
+	ctx->params.renderTarget(ctx->params.userPtr, image, 1);
+	ctx->viewWidth = (float)w;
+	ctx->viewHeight = (float)h;
+
+	layer->state = nvgSave(ctx);
+	nvgReset(ctx);
+	return 1;
+}
+
+void nvgEndLayer(NVGcontext* ctx)
+{
+	NVGlayer* layer;
+
+	if (ctx->nlayers == 0)
+		return;
+
+	nvg__flushTessellation(ctx);
+	layer = &ctx->layers[--ctx->nlayers];
+	ctx->viewWidth = layer->viewWidth;
+	ctx->viewHeight = layer->viewHeight;
+	ctx->params.renderTarget(ctx->params.userPtr, ctx->nlayers > 0 ? ctx->layers[ctx->nlayers-1].image : 0, 0);
+	nvgRestore(ctx, layer->state);
+}
+
+// Local bounds of the primitive including the blurred edge.
+static void nvg__primitiveBounds(const NVGprimitive* prim, float* bounds)
+{
+	float pad = prim->feather*0.5f;
+	if (prim->type == NVG_PRIM_LINE) {
+		pad += prim->radius;
+		bounds[0] = nvg__minf(prim->x, prim->w) - pad;
+		bounds[1] = nvg__minf(prim->y, prim->h) - pad;
+		bounds[2] = nvg__maxf(prim->x, prim->w) + pad;
+		bounds[3] = nvg__maxf(prim->y, prim->h) + pad;
+	} else {
+		bounds[0] = prim->x - pad;
+		bounds[1] = prim->y - pad;
+		bounds[2] = prim->x + prim->w + pad;
+		bounds[3] = prim->y + prim->h + pad;
+	}
+}
+
+static int nvg__primitiveCulled(NVGcontext* ctx, const NVGprimitive* prim)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float local[4], bounds[4], x, y;
+	int i;
+
+	if (!ctx->culling)
+		return 0;
+	nvg__primitiveBounds(prim, local);
+	bounds[0] = bounds[1] = 1e6f;
+	bounds[2] = bounds[3] = -1e6f;
+	for (i = 0; i < 4; i++) {
+		nvgTransformPoint(&x, &y, state->xform, local[(i & 1) ? 2 : 0], local[(i & 2) ? 3 : 1]);
+		bounds[0] = nvg__minf(bounds[0], x);
+		bounds[1] = nvg__minf(bounds[1], y);
+		bounds[2] = nvg__maxf(bounds[2], x);
+		bounds[3] = nvg__maxf(bounds[3], y);
+	}
+	return nvg__culled(ctx, &state->scissor, bounds, ctx->fringeWidth);
+}
+
+// Draws a primitive as paths, when the back-end has no primitives or while recording.
+static void nvg__primitivePaths(NVGcontext* ctx, const NVGprimitive* prim)
+{
+	float r;
+
+	if (prim->type == NVG_PRIM_LINE) {
+		nvgBeginPath(ctx);
+		nvgMoveTo(ctx, prim->x, prim->y);
+		nvgLineTo(ctx, prim->w, prim->h);
+		nvgLineCap(ctx, NVG_ROUND);
+		nvgStrokeWidth(ctx, prim->radius*2.0f);
+		nvgStrokeColor(ctx, prim->fillColor);
+		nvgStroke(ctx);
+		return;
+	}
+
+	r = nvg__minf(prim->radius, nvg__minf(prim->w, prim->h)*0.5f);
+	if (prim->feather > 0.0f) {
+		float pad = prim->feather*0.5f;
+		nvgBeginPath(ctx);
+		nvgRect(ctx, prim->x - pad, prim->y - pad, prim->w + pad*2, prim->h + pad*2);
+		nvgFillPaint(ctx, nvgBoxGradient(ctx, prim->x, prim->y, prim->w, prim->h, r, prim->feather,
+			prim->fillColor, nvgTransRGBAf(prim->fillColor, 0.0f)));
+		nvgFill(ctx);
+		return;
+	}
+
+	nvgBeginPath(ctx);
+	nvgRoundedRect(ctx, prim->x, prim->y, prim->w, prim->h, r);
+	if (prim->fillColor.a > 0.0f) {
+		nvgFillColor(ctx, prim->fillColor);
+		nvgFill(ctx);
+	}
+	if (prim->border > 0.0f) {
+		float b = nvg__minf(prim->border, nvg__minf(prim->w, prim->h)*0.5f);
+		nvgBeginPath(ctx);
+		nvgRoundedRect(ctx, prim->x + b*0.5f, prim->y + b*0.5f, prim->w - b, prim->h - b, nvg__maxf(r - b*0.5f, 0.0f));
+		nvgStrokeWidth(ctx, b);
+		nvgStrokeColor(ctx, prim->borderColor);
+		nvgStroke(ctx);
+	}
+}
+
+void nvgPrimitives(NVGcontext* ctx, const NVGprimitive* prims, int count)
+{
+	NVGstate* state = nvg__getState(ctx);
+	int i, first;
+
+	nvgBeginPath(ctx);
+	if (count <= 0)
+		return;
+
+	if (ctx->params.renderPrimitives == NULL || !ctx->primitives || ctx->recording != NULL) {
+		int save = nvgSave(ctx);
+		for (i = 0; i < count; i++)
+			nvg__primitivePaths(ctx, &prims[i]);
+		nvgRestore(ctx, save);
+		nvgBeginPath(ctx);
+		return;
+	}
+
+	// The queued paths are drawn before.
+	nvg__flushTessellation(ctx);
+
+	// Submit the runs of visible primitives.
+	for (first = 0, i = 0; i <= count; i++) {
+		if (i < count && !nvg__primitiveCulled(ctx, &prims[i]))
+			continue;
+		if (i > first) {
+			ctx->params.renderPrimitives(ctx->params.userPtr, state->compositeOperation, &state->scissor, ctx->fringeWidth,
+										 state->xform, state->alpha, &prims[first], i - first);
+			ctx->fillTriCount += (i - first)*2;
+			ctx->drawCallCount++;
+		}
+		first = i + 1;
+	}
+}
+
+int nvgInstancedPrimitives(NVGcontext* ctx, int enable)
+{
+	ctx->primitives = enable;
+	return enable && ctx->params.renderPrimitives != NULL;
+}
+
+void nvgParallelTessellation(NVGcontext* ctx, NVGparallelFunc runner, void* uptr, int chunks)
+{
+	int i;
+
+	nvg__flushTessellation(ctx);
+	nvg__deleteTessChunks(ctx);
+	ctx->tessRunner = NULL;
+	ctx->tessRunnerPtr = NULL;
+	if (runner == NULL || chunks < 1)
+		return;
+
+	ctx->tessChunks = (NVGtessChunk*)malloc(sizeof(NVGtessChunk)*chunks);
+	if (ctx->tessChunks == NULL) return;
+	memset(ctx->tessChunks, 0, sizeof(NVGtessChunk)*chunks);
+	ctx->ntessChunks = chunks;
+	for (i = 0; i < chunks; i++) {
+		NVGcontext* tc = (NVGcontext*)malloc(sizeof(NVGcontext));
+		if (tc == NULL) goto error;
+		memset(tc, 0, sizeof(NVGcontext));
+		ctx->tessChunks[i].ctx = tc;
+		tc->cache = nvg__allocPathCache(NULL);
+		if (tc->cache == NULL) goto error;
+	}
+	ctx->tessRunner = runner;
+	ctx->tessRunnerPtr = uptr;
+	return;
+
+error:
+	nvg__deleteTessChunks(ctx);
+}
+
+// Display lists
+
+static void nvg__transformCommands(float* dst, const float* src, int n, const float* t)
+{
+	int i = 0;
+	memcpy(dst, src, n*sizeof(float));
+	while (i < n) {
+		int cmd = (int)dst[i];
+		switch (cmd) {
+		case NVG_MOVETO:
+		case NVG_LINETO:
+			nvgTransformPoint(&dst[i+1],&dst[i+2], t, dst[i+1],dst[i+2]);
+			i += 3;
+			break;
+		case NVG_BEZIERTO:
+			nvgTransformPoint(&dst[i+1],&dst[i+2], t, dst[i+1],dst[i+2]);
+			nvgTransformPoint(&dst[i+3],&dst[i+4], t, dst[i+3],dst[i+4]);
+			nvgTransformPoint(&dst[i+5],&dst[i+6], t, dst[i+5],dst[i+6]);
+			i += 7;
+			break;
+		case NVG_CLOSE:
+			i++;
+			break;
+		case NVG_WINDING:
+			i += 2;
+			break;
+		default:
+			i++;
+		}
+	}
+}
+
+static NVGlistCall* nvg__listAddCall(NVGcontext* ctx, int type)
+{
+	NVGdisplayList* list = ctx->recording;
+	NVGlistCall* call;
+	NVGlistCall* calls = (NVGlistCall*)nvg__growArray(list->calls, &list->ccalls, list->ncalls+1, sizeof(NVGlistCall));
+	if (calls == NULL) return NULL;
+	list->calls = calls;
+	call = &list->calls[list->ncalls++];
+	memset(call, 0, sizeof(*call));
+	call->type = type;
+	call->state = *nvg__getState(ctx);
+	list->cached = 0;
+	return call;
+}
+
+static void nvg__recordPath(NVGcontext* ctx, int type)
+{
+	NVGdisplayList* list = ctx->recording;
+	NVGlistCall* call;
+	float* commands = (float*)nvg__growArray(list->commands, &list->ccommands, list->ncommands+ctx->ncommands, sizeof(float));
+	if (commands == NULL) return;
+	list->commands = commands;
+
+	call = nvg__listAddCall(ctx, type);
+	if (call == NULL) return;
+	// The path commands are already in device space, which is the list space while recording.
+	call->commandOffset = list->ncommands;
+	call->ncommands = ctx->ncommands;
+	memcpy(&list->commands[list->ncommands], ctx->commands, ctx->ncommands*sizeof(float));
+	list->ncommands += ctx->ncommands;
+}
+
+static float nvg__recordText(NVGcontext* ctx, float x, float y, const char* string, const char* end)
+{
+	NVGdisplayList* list = ctx->recording;
+	NVGlistCall* call;
+	int n = (int)(end - string);
+	char* text = (char*)nvg__growArray(list->text, &list->ctext, list->ntext+n, 1);
+	if (text == NULL) return x;
+	list->text = text;
+
+	call = nvg__listAddCall(ctx, NVG_LIST_TEXT);
+	if (call == NULL) return x;
+	call->textOffset = list->ntext;
+	call->textLength = n;
+	call->x = x;
+	call->y = y;
+	memcpy(&list->text[list->ntext], string, n);
+	list->ntext += n;
+
+	return nvgTextBounds(ctx, x, y, string, end, NULL);
+}
+
+static void nvg__listStorePaths(NVGcontext* ctx, NVGlistCall* call)
+{
+	NVGpathCache* cache = ctx->cache;
+	NVGpath* paths;
+	NVGvertex* verts;
+	int i, nverts = 0;
+
+	for (i = 0; i < cache->npaths; i++) {
+		NVGpath* path = &cache->paths[i];
+		if (path->fill != NULL)
+			nverts = nvg__maxi(nverts, (int)(path->fill - cache->verts) + path->nfill);
+		if (path->stroke != NULL)
+			nverts = nvg__maxi(nverts, (int)(path->stroke - cache->verts) + path->nstroke);
+	}
+
+	call->npaths = 0;
+	call->nverts = 0;
+	paths = (NVGpath*)nvg__growArray(call->paths, &call->cpaths, cache->npaths, sizeof(NVGpath));
+	if (paths == NULL) return;
+	call->paths = paths;
+	verts = (NVGvertex*)nvg__growArray(call->verts, &call->cverts, nverts, sizeof(NVGvertex));
+	if (verts == NULL) return;
+	call->verts = verts;
+
+	memcpy(call->paths, cache->paths, cache->npaths*sizeof(NVGpath));
+	memcpy(call->verts, cache->verts, nverts*sizeof(NVGvertex));
+	for (i = 0; i < cache->npaths; i++) {
+		NVGpath* path = &call->paths[i];
+		if (path->fill != NULL)
+			path->fill = call->verts + (path->fill - cache->verts);
+		if (path->stroke != NULL)
+			path->stroke = call->verts + (path->stroke - cache->verts);
+	}
+	call->npaths = cache->npaths;
+	call->nverts = nverts;
+	memcpy(call->bounds, cache->bounds, sizeof(float)*4);
+}
+
+static void nvg__listTessellate(NVGcontext* ctx, NVGdisplayList* list, const float* m)
+{
+	float* commands = ctx->commands;
+	int ncommands = ctx->ncommands;
+	int ccommands = ctx->ccommands;
+	float* temp;
+	int i;
+
+	SGE_PROFILE_BEGIN("nvg__listTessellate");
+
+	temp = (float*)nvg__growArray(list->tempCommands, &list->ctempCommands, list->ncommands, sizeof(float));
+	if (temp == NULL) {
+		SGE_PROFILE_END();
+		return;
+	}
+	list->tempCommands = temp;
+	nvg__transformCommands(list->tempCommands, list->commands, list->ncommands, m);
+
+	// Run the regular flatten and expand passes over the transformed list commands.
+	for (i = 0; i < list->ncalls; i++) {
+		NVGlistCall* call = &list->calls[i];
+		NVGstate* state = &call->state;
+		int aa = ctx->params.edgeAntiAlias && state->shapeAntiAlias;
+		if (call->type == NVG_LIST_TEXT)
+			continue;
+
+		ctx->commands = &list->tempCommands[call->commandOffset];
+		ctx->ncommands = call->ncommands;
+		ctx->ccommands = call->ncommands;
+		nvg__clearPathCache(ctx);
+		nvg__flattenPaths(ctx);
+
+		if (call->type == NVG_LIST_FILL) {
+			call->paint = state->fill;
+			call->strokeWidth = 0.0f;
+			nvg__expandFill(ctx, aa ? ctx->fringeWidth : 0.0f, NVG_MITER, 2.4f);
+		} else {
+			float xform[6];
+			memcpy(xform, state->xform, sizeof(float)*6);
+			nvgTransformMultiply(xform, m);
+			call->paint = state->stroke;
+			call->strokeWidth = nvg__clampf(state->strokeWidth * nvg__getAverageScale(xform), 0.0f, 200.0f);
+			if (call->strokeWidth < ctx->fringeWidth) {
+				float alpha = nvg__clampf(call->strokeWidth / ctx->fringeWidth, 0.0f, 1.0f);
+				call->paint.innerColor.a *= alpha*alpha;
+				call->paint.outerColor.a *= alpha*alpha;
+				call->strokeWidth = ctx->fringeWidth;
+			}
+			nvg__expandStroke(ctx, call->strokeWidth*0.5f, aa ? ctx->fringeWidth : 0.0f, state->lineCap, state->lineJoin, state->miterLimit);
+		}
+		call->paint.innerColor.a *= state->alpha;
+		call->paint.outerColor.a *= state->alpha;
+		nvg__listStorePaths(ctx, call);
+	}
+
+	ctx->commands = commands;
+	ctx->ncommands = ncommands;
+	ctx->ccommands = ccommands;
+	nvg__clearPathCache(ctx);
+
+	SGE_PROFILE_END();
+}
+
+static void nvg__transformBounds(float* dst, const float* t, const float* src)
+{
+	float x, y;
+	int i;
+	dst[0] = dst[1] = 1e6f;
+	dst[2] = dst[3] = -1e6f;
+	for (i = 0; i < 4; i++) {
+		nvgTransformPoint(&x, &y, t, src[(i & 1) ? 2 : 0], src[(i & 2) ? 3 : 1]);
+		dst[0] = nvg__minf(dst[0], x);
+		dst[1] = nvg__minf(dst[1], y);
+		dst[2] = nvg__maxf(dst[2], x);
+		dst[3] = nvg__maxf(dst[3], y);
+	}
+}
+
+static const NVGpath* nvg__listTransformPaths(NVGdisplayList* list, const NVGlistCall* call, const float* t)
+{
+	NVGpath* paths = (NVGpath*)nvg__growArray(list->tempPaths, &list->ctempPaths, call->npaths, sizeof(NVGpath));
+	NVGvertex* verts;
+	int i;
+	if (paths == NULL) return NULL;
+	list->tempPaths = paths;
+	verts = (NVGvertex*)nvg__growArray(list->tempVerts, &list->ctempVerts, call->nverts, sizeof(NVGvertex));
+	if (verts == NULL) return NULL;
+	list->tempVerts = verts;
+
+	for (i = 0; i < call->nverts; i++) {
+		nvgTransformPoint(&verts[i].x, &verts[i].y, t, call->verts[i].x, call->verts[i].y);
+		verts[i].u = call->verts[i].u;
+		verts[i].v = call->verts[i].v;
+	}
+	memcpy(paths, call->paths, call->npaths*sizeof(NVGpath));
+	for (i = 0; i < call->npaths; i++) {
+		if (paths[i].fill != NULL)
+			paths[i].fill = verts + (paths[i].fill - call->verts);
+		if (paths[i].stroke != NULL)
+			paths[i].stroke = verts + (paths[i].stroke - call->verts);
+	}
+	return paths;
+}
+
+static void nvg__listDrawPaths(NVGcontext* ctx, NVGdisplayList* list, const NVGlistCall* call, const float* m, const float* t)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGpaint paint = call->paint;
+	NVGscissor scissor = call->state.scissor;
+	const NVGpath* paths = call->paths;
+	float bounds[4], pad;
+	int i;
+
+	nvgTransformMultiply(paint.xform, m);
+	paint.innerColor.a *= state->alpha;
+	paint.outerColor.a *= state->alpha;
+	if (scissor.extent[0] < 0.0f)
+		scissor = state->scissor;
+	else
+		nvgTransformMultiply(scissor.xform, m);
+
+	memcpy(bounds, call->bounds, sizeof(float)*4);
+	if (t != NULL)
+		nvg__transformBounds(bounds, t, call->bounds);
+	if (call->type == NVG_LIST_FILL)
+		pad = ctx->fringeWidth;
+	else
+		pad = nvg__strokePad(&call->state, call->strokeWidth * (t != NULL ? nvg__getAverageScale(t) : 1.0f), ctx->fringeWidth);
+	if (nvg__culled(ctx, &scissor, bounds, pad))
+		return;
+	if (t != NULL) {
+		paths = nvg__listTransformPaths(list, call, t);
+		if (paths == NULL) return;
+	}
+
+	if (call->type == NVG_LIST_FILL) {
+		ctx->params.renderFill(ctx->params.userPtr, &paint, call->state.compositeOperation, &scissor, ctx->fringeWidth,
+							   bounds, paths, call->npaths);
+		for (i = 0; i < call->npaths; i++) {
+			ctx->fillTriCount += paths[i].nfill-2;
+			ctx->fillTriCount += paths[i].nstroke-2;
+			ctx->drawCallCount += 2;
+		}
+	} else {
+		ctx->params.renderStroke(ctx->params.userPtr, &paint, call->state.compositeOperation, &scissor, ctx->fringeWidth,
+								 call->strokeWidth, paths, call->npaths);
+		for (i = 0; i < call->npaths; i++) {
+			ctx->strokeTriCount += paths[i].nstroke-2;
+			ctx->drawCallCount++;
+		}
+	}
+}
+
+static void nvg__listDrawText(NVGcontext* ctx, NVGdisplayList* list, const NVGlistCall* call, const float* m)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGstate saved = *state;
+	const char* text = &list->text[call->textOffset];
+
+	*state = call->state;
+	nvgTransformMultiply(state->xform, m);
+	nvgTransformMultiply(state->fill.xform, m);
+	state->alpha *= saved.alpha;
+	if (state->scissor.extent[0] < 0.0f)
+		state->scissor = saved.scissor;
+	else
+		nvgTransformMultiply(state->scissor.xform, m);
+
+	nvgText(ctx, call->x, call->y, text, text + call->textLength);
+	*state = saved;
+}
+
+NVGdisplayList* nvgCreateDisplayList(void)
+{
+	NVGdisplayList* list = (NVGdisplayList*)malloc(sizeof(NVGdisplayList));
+	if (list == NULL) return NULL;
+	memset(list, 0, sizeof(NVGdisplayList));
+	nvgTransformIdentity(list->xform);
+	list->scaleTolerance = 0.1f;
+	return list;
+}
+
+void nvgDeleteDisplayList(NVGdisplayList* list)
+{
+	if (list == NULL) return;
+	nvgClearDisplayList(list);
+	free(list->calls);
+	free(list->commands);
+	free(list->text);
+	free(list->tempCommands);
+	free(list->tempPaths);
+	free(list->tempVerts);
+	free(list);
+}
+
+void nvgClearDisplayList(NVGdisplayList* list)
+{
+	int i;
+	for (i = 0; i < list->ncalls; i++) {
+		free(list->calls[i].paths);
+		free(list->calls[i].verts);
+	}
+	list->ncalls = 0;
+	list->ncommands = 0;
+	list->ntext = 0;
+	list->cached = 0;
+}
+
+int nvgDisplayListEmpty(NVGdisplayList* list)
+{
+	return list->ncalls == 0;
+}
+
+void nvgDisplayListScaleTolerance(NVGdisplayList* list, float tolerance)
+{
+	list->scaleTolerance = nvg__maxf(0.0f, tolerance);
+}
+
+int nvgDisplayListTessellations(NVGdisplayList* list)
+{
+	return list->tessellations;
+}
+
+void nvgBeginDisplayList(NVGcontext* ctx, NVGdisplayList* list)
+{
+	nvgClearDisplayList(list);
+	memcpy(list->xform, nvg__getState(ctx)->xform, sizeof(float)*6);
+	ctx->recording = list;
+}
+
+void nvgEndDisplayList(NVGcontext* ctx)
+{
+	ctx->recording = NULL;
+}
+
+void nvgDrawDisplayList(NVGcontext* ctx, NVGdisplayList* list)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float m[6], t[6];
+	int i, identity;
+
+	if (ctx->recording != NULL || list->ncalls == 0)
+		return;
+	nvg__flushTessellation(ctx);
+
+	// Maps list space to current device space.
+	nvgTransformInverse(m, list->xform);
+	nvgTransformMultiply(m, state->xform);
+
+	// Maps cached geometry to current device space.
+	nvgTransformInverse(t, list->cacheXform);
+	nvgTransformMultiply(t, state->xform);
+
+	if (!list->cached || list->cacheRatio != ctx->devicePxRatio
+		|| nvg__absf(nvg__sqrtf(t[0]*t[0] + t[1]*t[1]) - 1.0f) > list->scaleTolerance
+		|| nvg__absf(nvg__sqrtf(t[2]*t[2] + t[3]*t[3]) - 1.0f) > list->scaleTolerance) {
+		nvg__listTessellate(ctx, list, m);
+		memcpy(list->cacheXform, state->xform, sizeof(float)*6);
+		list->cacheRatio = ctx->devicePxRatio;
+		list->cached = 1;
+		list->tessellations++;
+	}
+	identity = memcmp(list->cacheXform, state->xform, sizeof(float)*6) == 0;
+
+	for (i = 0; i < list->ncalls; i++) {
+		NVGlistCall* call = &list->calls[i];
+		if (call->type == NVG_LIST_TEXT)
+			nvg__listDrawText(ctx, list, call, m);
+		else
+			nvg__listDrawPaths(ctx, list, call, m, identity ? NULL : t);
+	}
+}
+
 void nvgFill(NVGcontext* ctx)
 {
 	NVGstate* state = nvg__getState(ctx);
@@ -2229,16 +3900,29 @@ void nvgFill(NVGcontext* ctx)
 	NVGpaint fillPaint = state->fill;
 	int i;
 
+	if (ctx->recording != NULL) {
+		nvg__recordPath(ctx, NVG_LIST_FILL);
+		return;
+	}
+
+	if (nvg__culled(ctx, &state->scissor, ctx->commandBounds, ctx->fringeWidth))
+		return;
+
+	// Apply global alpha
+	fillPaint.innerColor.a *= state->alpha;
+	fillPaint.outerColor.a *= state->alpha;
+
+	if (ctx->tessRunner != NULL) {
+		nvg__queueTessellation(ctx, NVG_LIST_FILL, &fillPaint, 0.0f);
+		return;
+	}
+
 	nvg__flattenPaths(ctx);
 	if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
 		nvg__expandFill(ctx, ctx->fringeWidth, NVG_MITER, 2.4f);
 	else
 		nvg__expandFill(ctx, 0.0f, NVG_MITER, 2.4f);
 
-	// Apply global alpha
-	fillPaint.innerColor.a *= state->alpha;
-	fillPaint.outerColor.a *= state->alpha;
-
 	ctx->params.renderFill(ctx->params.userPtr, &fillPaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
 						   ctx->cache->bounds, ctx->cache->paths, ctx->cache->npaths);
 
@@ -2251,37 +3935,42 @@ void nvgFill(NVGcontext* ctx)
 	}
 }
 
-void nvgStroke(NVGcontext* ctx)
+// Returns the stroke width in device space and the paint with the global alpha applied.
+static float nvg__strokeStyle(NVGcontext* ctx, NVGpaint* strokePaint)
 {
 	NVGstate* state = nvg__getState(ctx);
 	float scale = nvg__getAverageScale(state->xform);
 	float strokeWidth = nvg__clampf(state->strokeWidth * scale, 0.0f, 200.0f);
-	NVGpaint strokePaint = state->stroke;
-	const NVGpath* path;
-	int i;
-
 
+	*strokePaint = state->stroke;
 	if (strokeWidth < ctx->fringeWidth) {
 		// If the stroke width is less than pixel size, use alpha to emulate coverage.
 		// Since coverage is area, scale by alpha*alpha.
 		float alpha = nvg__clampf(strokeWidth / ctx->fringeWidth, 0.0f, 1.0f);
-		strokePaint.innerColor.a *= alpha*alpha;
-		strokePaint.outerColor.a *= alpha*alpha;
+		strokePaint->innerColor.a *= alpha*alpha;
+		strokePaint->outerColor.a *= alpha*alpha;
 		strokeWidth = ctx->fringeWidth;
 	}
 
 	// Apply global alpha
-	strokePaint.innerColor.a *= state->alpha;
-	strokePaint.outerColor.a *= state->alpha;
+	strokePaint->innerColor.a *= state->alpha;
+	strokePaint->outerColor.a *= state->alpha;
+	return strokeWidth;
+}
 
-	nvg__flattenPaths(ctx);
+// Expands the stroke of the flattened paths in the cache and submits it.
+static void nvg__submitStroke(NVGcontext* ctx, NVGpaint* strokePaint, float strokeWidth)
+{
+	NVGstate* state = nvg__getState(ctx);
+	const NVGpath* path;
+	int i;
 
 	if (ctx->params.edgeAntiAlias && state->shapeAntiAlias)
 		nvg__expandStroke(ctx, strokeWidth*0.5f, ctx->fringeWidth, state->lineCap, state->lineJoin, state->miterLimit);
 	else
 		nvg__expandStroke(ctx, strokeWidth*0.5f, 0.0f, state->lineCap, state->lineJoin, state->miterLimit);
 
-	ctx->params.renderStroke(ctx->params.userPtr, &strokePaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
+	ctx->params.renderStroke(ctx->params.userPtr, strokePaint, state->compositeOperation, &state->scissor, ctx->fringeWidth,
 							 strokeWidth, ctx->cache->paths, ctx->cache->npaths);
 
 	// Count triangles
@@ -2292,6 +3981,299 @@ void nvgStroke(NVGcontext* ctx)
 	}
 }
 
+void nvgStroke(NVGcontext* ctx)
+{
+	NVGstate* state = nvg__getState(ctx);
+	NVGpaint strokePaint;
+	float strokeWidth;
+
+	if (ctx->recording != NULL) {
+		nvg__recordPath(ctx, NVG_LIST_STROKE);
+		return;
+	}
+
+	strokeWidth = nvg__strokeStyle(ctx, &strokePaint);
+	if (nvg__culled(ctx, &state->scissor, ctx->commandBounds, nvg__strokePad(state, strokeWidth, ctx->fringeWidth)))
+		return;
+
+	if (ctx->tessRunner != NULL) {
+		nvg__queueTessellation(ctx, NVG_LIST_STROKE, &strokePaint, strokeWidth);
+		return;
+	}
+
+	nvg__flattenPaths(ctx);
+	nvg__submitStroke(ctx, &strokePaint, strokeWidth);
+}
+
+// Polylines
+
+#define NVG_POLYLINE_LEVELS 8
+
+struct NVGpolylineLevel {
+	int level;			// The buckets are 2^level wide.
+	float* x;
+	float* y;
+	int count;
+	int cpoints;
+	int stamp;			// Last use, the least recently used level is replaced.
+};
+typedef struct NVGpolylineLevel NVGpolylineLevel;
+
+struct NVGpolyline {
+	float* x;
+	float* y;
+	int npts;
+	int cpts;
+	float bounds[4];
+	float spacing;		// Average x distance of the points.
+	NVGpolylineLevel levels[NVG_POLYLINE_LEVELS];
+	int nlevels;
+	int stamp;
+	int stroked;
+};
+
+NVGpolyline* nvgCreatePolyline(void)
+{
+	NVGpolyline* line = (NVGpolyline*)malloc(sizeof(NVGpolyline));
+	if (line == NULL) return NULL;
+	memset(line, 0, sizeof(NVGpolyline));
+	return line;
+}
+
+void nvgDeletePolyline(NVGpolyline* line)
+{
+	int i;
+	if (line == NULL) return;
+	for (i = 0; i < NVG_POLYLINE_LEVELS; i++) {
+		free(line->levels[i].x);
+		free(line->levels[i].y);
+	}
+	free(line->x);
+	free(line->y);
+	free(line);
+}
+
+int nvgPolylinePoints(NVGpolyline* line, const float* pts, int npts)
+{
+	int i;
+	line->npts = 0;
+	line->nlevels = 0;
+	line->stroked = 0;
+	if (npts <= 0) return 1;
+	if (npts > line->cpts) {
+		float* x = (float*)realloc(line->x, sizeof(float)*npts);
+		float* y;
+		if (x == NULL) return 0;
+		line->x = x;
+		y = (float*)realloc(line->y, sizeof(float)*npts);
+		if (y == NULL) return 0;
+		line->y = y;
+		line->cpts = npts;
+	}
+	// Separate x and y, the min and max search reads y only
+	line->bounds[0] = line->bounds[1] = 1e30f;
+	line->bounds[2] = line->bounds[3] = -1e30f;
+	for (i = 0; i < npts; i++) {
+		line->x[i] = pts[i*2];
+		line->y[i] = pts[i*2+1];
+		line->bounds[1] = nvg__minf(line->bounds[1], line->y[i]);
+		line->bounds[3] = nvg__maxf(line->bounds[3], line->y[i]);
+	}
+	line->bounds[0] = line->x[0];
+	line->bounds[2] = line->x[npts-1];
+	line->spacing = npts > 1 ? (line->bounds[2] - line->bounds[0]) / (npts-1) : 0.0f;
+	line->npts = npts;
+	return 1;
+}
+
+int nvgPolylineStrokedCount(NVGpolyline* line)
+{
+	return line->stroked;
+}
+
+// Returns the first index in [from, n) with x >= v, or n. Gallops first, the buckets are often short.
+static int nvg__polylineSeek(const float* x, int from, int n, float v)
+{
+	int lo = from, hi = from, step = 1;
+	while (hi < n && x[hi] < v) {
+		lo = hi + 1;
+		hi += step;
+		step *= 2;
+	}
+	hi = nvg__mini(hi, n);
+	while (lo < hi) {
+		int mid = lo + (hi - lo) / 2;
+		if (x[mid] < v)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+// Keeps the first min and max y of each bucket of width w from x0, in x order.
+static int nvg__polylineDecimate(const float* sx, const float* sy, int n, float x0, float w, float* dx, float* dy)
+{
+	int i = 0, count = 0;
+	while (i < n) {
+		float end = x0 + (floorf((sx[i] - x0) / w) + 1.0f) * w;
+		int j = nvg__polylineSeek(sx, i+1, n, end);
+		int mn, mx, a, b;
+		nvg__kernels->minmax(&sy[i], j - i, &mn, &mx);
+		a = i + nvg__mini(mn, mx);
+		b = i + nvg__maxi(mn, mx);
+		dx[count] = sx[a];
+		dy[count] = sy[a];
+		count++;
+		if (b != a) {
+			dx[count] = sx[b];
+			dy[count] = sy[b];
+			count++;
+		}
+		i = j;
+	}
+	return count;
+}
+
+// Returns the cached level, decimated from the next finer cached level or the points if missing.
+// Returns NULL if the points are not denser than the buckets.
+static NVGpolylineLevel* nvg__polylineLevel(NVGpolyline* line, int level)
+{
+	NVGpolylineLevel* src = NULL;
+	NVGpolylineLevel* dst = NULL;
+	float w = ldexpf(1.0f, level);
+	int i, n;
+
+	if (w < line->spacing * 2.0f)
+		return NULL;
+
+	line->stamp++;
+	for (i = 0; i < line->nlevels; i++) {
+		NVGpolylineLevel* lv = &line->levels[i];
+		if (lv->level == level) {
+			lv->stamp = line->stamp;
+			return lv;
+		}
+		if (lv->level < level && (src == NULL || lv->level > src->level))
+			src = lv;
+	}
+
+	// Take a free slot, or replace the least recently used level but the source
+	if (line->nlevels < NVG_POLYLINE_LEVELS) {
+		dst = &line->levels[line->nlevels++];
+	} else {
+		for (i = 0; i < line->nlevels; i++) {
+			NVGpolylineLevel* lv = &line->levels[i];
+			if (lv != src && (dst == NULL || lv->stamp < dst->stamp))
+				dst = lv;
+		}
+	}
+
+	n = src != NULL ? src->count : line->npts;
+	if (n > dst->cpoints) {
+		float* x = (float*)realloc(dst->x, sizeof(float)*n);
+		float* y;
+		if (x != NULL) dst->x = x;
+		y = (float*)realloc(dst->y, sizeof(float)*n);
+		if (y != NULL) dst->y = y;
+		if (x == NULL || y == NULL) {
+			dst->level = level - 64;	// Unused, the next lookups fail the same
+			dst->count = 0;
+			return NULL;
+		}
+		dst->cpoints = n;
+	}
+	dst->level = level;
+	dst->stamp = line->stamp;
+	if (src != NULL)
+		dst->count = nvg__polylineDecimate(src->x, src->y, src->count, line->x[0], w, dst->x, dst->y);
+	else
+		dst->count = nvg__polylineDecimate(line->x, line->y, line->npts, line->x[0], w, dst->x, dst->y);
+	return dst;
+}
+
+void nvgStrokePolyline(NVGcontext* ctx, NVGpolyline* line)
+{
+	NVGstate* state = nvg__getState(ctx);
+	const float* t = state->xform;
+	const NVGpolylineLevel* lv = NULL;
+	const float* xs;
+	const float* ys;
+	NVGpaint strokePaint;
+	NVGpath* path;
+	float bounds[4], box[4], strokeWidth, scale, pad;
+	int first, last, n, i, e;
+
+	nvgBeginPath(ctx);
+	line->stroked = 0;
+	if (line->npts == 0)
+		return;
+
+	// Pick the level of buckets at most one device pixel wide
+	scale = nvg__sqrtf(t[0]*t[0] + t[1]*t[1]) * ctx->devicePxRatio;
+	if (scale > 0.0f) {
+		frexpf(1.0f / scale, &e);
+		lv = nvg__polylineLevel(line, e - 1);
+	}
+	xs = lv != NULL ? lv->x : line->x;
+	ys = lv != NULL ? lv->y : line->y;
+	n = lv != NULL ? lv->count : line->npts;
+
+	if (ctx->recording != NULL) {
+		for (i = 0; i < n; i++) {
+			if (i == 0)
+				nvgMoveTo(ctx, xs[i], ys[i]);
+			else
+				nvgLineTo(ctx, xs[i], ys[i]);
+		}
+		nvgStroke(ctx);
+		nvgBeginPath(ctx);
+		line->stroked = n;
+		return;
+	}
+
+	strokeWidth = nvg__strokeStyle(ctx, &strokePaint);
+	pad = nvg__strokePad(state, strokeWidth, ctx->fringeWidth);
+	nvg__transformBounds(bounds, t, line->bounds);
+	if (nvg__culled(ctx, &state->scissor, bounds, pad))
+		return;
+
+	// Without rotation only the points in the clip box, and the ones before and after
+	first = 0;
+	last = n;
+	if (t[1] == 0.0f && t[2] == 0.0f && t[0] != 0.0f) {
+		float x0, x1;
+		nvg__clipBox(ctx, &state->scissor, box);
+		x0 = (box[0] - pad - t[4]) / t[0];
+		x1 = (box[2] + pad - t[4]) / t[0];
+		if (x0 > x1) {
+			float tmp = x0;
+			x0 = x1;
+			x1 = tmp;
+		}
+		first = nvg__maxi(nvg__polylineSeek(xs, 0, n, x0) - 1, 0);
+		last = nvg__mini(nvg__polylineSeek(xs, first, n, x1) + 1, n);
+	}
+
+	// The points go to the path cache without commands, the queued paths are drawn before
+	nvg__flushTessellation(ctx);
+	nvg__addPath(ctx);
+	for (i = first; i < last; i++) {
+		float x, y;
+		nvgTransformPoint(&x, &y, t, xs[i], ys[i]);
+		nvg__addPoint(ctx, x, y, NVG_PT_CORNER);
+	}
+	path = nvg__lastPath(ctx);
+	if (path != NULL && path->count > 1) {
+		ctx->cache->bounds[0] = ctx->cache->bounds[1] = 1e6f;
+		ctx->cache->bounds[2] = ctx->cache->bounds[3] = -1e6f;
+		nvg__kernels->segments(&ctx->cache->points[path->first], path->count, ctx->cache->bounds);
+		nvg__submitStroke(ctx, &strokePaint, strokeWidth);
+		line->stroked = path->count;
+	}
+	nvg__clearPathCache(ctx);
+}
+
 // Add fonts
 int nvgCreateFont(NVGcontext* ctx, const char* name, const char* path)
 {
@@ -2313,6 +4295,8 @@ int nvgFindFont(NVGcontext* ctx, const char* name)
 int nvgAddFallbackFontId(NVGcontext* ctx, int baseFont, int fallbackFont)
 {
 	if(baseFont == -1 || fallbackFont == -1) return 0;
+	// The cached runs were shaped without the fallback glyphs.
+	nvg__deleteTextLayouts(ctx);
 	return fonsAddFallbackFont(ctx->fs, baseFont, fallbackFont);
 }
 
@@ -2334,6 +4318,13 @@ void nvgFontBlur(NVGcontext* ctx, float blur)
 	state->fontBlur = blur;
 }
 
+int nvgTextSDF(NVGcontext* ctx, int enabled)
+{
+	NVGstate* state = nvg__getState(ctx);
+	state->fontSDF = enabled;
+	return enabled && ctx->params.renderSDFTriangles != NULL;
+}
+
 void nvgTextLetterSpacing(NVGcontext* ctx, float spacing)
 {
 	NVGstate* state = nvg__getState(ctx);
@@ -2377,107 +4368,402 @@ static float nvg__getFontScale(NVGstate* state)
 static void nvg__flushTextTexture(NVGcontext* ctx)
 {
 	int dirty[4];
-
-	if (fonsValidateTexture(ctx->fs, dirty)) {
-		int fontImage = ctx->fontImages[ctx->fontImageIdx];
+	int page, npages;
+
+	fonsCollectGlyphs(ctx->fs);
+	npages = fonsPageCount(ctx->fs);
+
+	for (page = 0; page < npages && page < NVG_MAX_FONTIMAGES; page++) {
+		int iw, ih;
+		const unsigned char* data;
+		if (!fonsValidateTexture(ctx->fs, page, dirty))
+			continue;
+		data = fonsGetTextureData(ctx->fs, page, &iw, &ih);
+		if (ctx->fontImages[page] == 0)
+			ctx->fontImages[page] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, iw, ih, 0, NULL);
 		// Update texture
-		if (fontImage != 0) {
-			int iw, ih;
-			const unsigned char* data = fonsGetTextureData(ctx->fs, &iw, &ih);
+		if (ctx->fontImages[page] != 0) {
 			int x = dirty[0];
 			int y = dirty[1];
 			int w = dirty[2] - dirty[0];
 			int h = dirty[3] - dirty[1];
-			ctx->params.renderUpdateTexture(ctx->params.userPtr, fontImage, x,y, w,h, data);
+			ctx->params.renderUpdateTexture(ctx->params.userPtr, ctx->fontImages[page], x,y, w,h, data);
 		}
 	}
 }
 
-static int nvg__allocTextAtlas(NVGcontext* ctx)
+static int nvg__textSDF(NVGcontext* ctx, NVGstate* state)
 {
-	int iw, ih;
-	nvg__flushTextTexture(ctx);
-	if (ctx->fontImageIdx >= NVG_MAX_FONTIMAGES-1)
-		return 0;
-	// if next fontImage already have a texture
-	if (ctx->fontImages[ctx->fontImageIdx+1] != 0)
-		nvgImageSize(ctx, ctx->fontImages[ctx->fontImageIdx+1], &iw, &ih);
-	else { // calculate the new font image size and create it.
-		nvgImageSize(ctx, ctx->fontImages[ctx->fontImageIdx], &iw, &ih);
-		if (iw > ih)
-			ih *= 2;
-		else
-			iw *= 2;
-		if (iw > NVG_MAX_FONTIMAGE_SIZE || ih > NVG_MAX_FONTIMAGE_SIZE)
-			iw = ih = NVG_MAX_FONTIMAGE_SIZE;
-		ctx->fontImages[ctx->fontImageIdx+1] = ctx->params.renderCreateTexture(ctx->params.userPtr, NVG_TEXTURE_ALPHA, iw, ih, 0, NULL);
-	}
-	++ctx->fontImageIdx;
-	fonsResetAtlas(ctx->fs, iw, ih);
-	return 1;
+	return state->fontSDF && ctx->params.renderSDFTriangles != NULL;
 }
 
-static void nvg__renderText(NVGcontext* ctx, NVGvertex* verts, int nverts)
+static void nvg__renderText(NVGcontext* ctx, NVGvertex* verts, int nverts, int page)
 {
 	NVGstate* state = nvg__getState(ctx);
 	NVGpaint paint = state->fill;
+	float bounds[4];
+	int i;
+
+	if (nverts == 0) return;
+
+	// TODO: add back-end bit to do this just once per frame.
+	nvg__flushTextTexture(ctx);
+
+	// The glyphs are rasterized already, culling only saves the draw.
+	bounds[0] = bounds[1] = 1e6f;
+	bounds[2] = bounds[3] = -1e6f;
+	for (i = 0; i < nverts; i++)
+		nvg__growBounds(bounds, &verts[i].x, 1);
+	if (nvg__culled(ctx, &state->scissor, bounds, 0.0f))
+		return;
+
+	nvg__flushTessellation(ctx);
 
 	// Render triangles.
-	paint.image = ctx->fontImages[ctx->fontImageIdx];
+	paint.image = ctx->fontImages[page];
 
 	// Apply global alpha
 	paint.innerColor.a *= state->alpha;
 	paint.outerColor.a *= state->alpha;
 
-	ctx->params.renderTriangles(ctx->params.userPtr, &paint, state->compositeOperation, &state->scissor, verts, nverts);
+	if (nvg__textSDF(ctx, state))
+		ctx->params.renderSDFTriangles(ctx->params.userPtr, &paint, state->compositeOperation, &state->scissor,
+									   state->fontBlur * nvg__getFontScale(state) * ctx->devicePxRatio, verts, nverts);
+	else
+		ctx->params.renderTriangles(ctx->params.userPtr, &paint, state->compositeOperation, &state->scissor, verts, nverts);
 
 	ctx->drawCallCount++;
 	ctx->textTriCount += nverts/3;
 }
 
+// Returns 1 if a line of text at y is above or below the scissor, only tested for transforms without
+// rotation or skew since the width is not known before the glyphs are iterated.
+static int nvg__textCulled(NVGcontext* ctx, NVGstate* state, float y)
+{
+	const float* t = state->xform;
+	float reach = state->fontSize*2.0f + state->fontBlur*2.0f;
+	float bounds[4];
+	if (t[1] != 0.0f || t[2] != 0.0f)
+		return 0;
+	// Any finite x, the horizontal extent is not tested.
+	bounds[0] = -1e6f;
+	bounds[2] = 1e6f;
+	bounds[1] = t[3]*(y - reach) + t[5];
+	bounds[3] = t[3]*(y + reach) + t[5];
+	if (bounds[1] > bounds[3]) {
+		float tmp = bounds[1];
+		bounds[1] = bounds[3];
+		bounds[3] = tmp;
+	}
+	return nvg__culled(ctx, &state->scissor, bounds, 0.0f);
+}
+
+// Text layout cache
+
+static void nvg__deleteTextLayouts(NVGcontext* ctx)
+{
+	NVGtextLayoutCache* cache = ctx->layouts;
+	int i;
+	if (cache == NULL) return;
+	for (i = 0; i < cache->nlayouts; i++) {
+		free(cache->layouts[i].str);
+		free(cache->layouts[i].glyphs);
+		free(cache->layouts[i].rows);
+	}
+	free(cache);
+	ctx->layouts = NULL;
+}
+
+static unsigned int nvg__hashBytes(unsigned int h, const void* data, int n)
+{
+	const unsigned char* p = (const unsigned char*)data;
+	int i;
+	for (i = 0; i < n; i++)
+		h = (h ^ p[i]) * 16777619u;
+	return h;
+}
+
+// Returns the layout of the string in the current text style, or NULL when it is not cached: the cache
+// is disabled, the string is too long or all the layouts are used in this frame.
+static NVGtextLayout* nvg__textLayout(NVGcontext* ctx, NVGstate* state, float scale, const char* string, const char* end)
+{
+	NVGtextLayoutCache* cache = ctx->layouts;
+	NVGtextLayout* layout = NULL;
+	NVGtextKey key;
+	unsigned int hash;
+	int len = (int)(end - string);
+	int i, *prev;
+
+	if (!ctx->layoutCaching || len > NVG_TEXT_LAYOUT_MAX) return NULL;
+
+	if (cache == NULL) {
+		cache = (NVGtextLayoutCache*)malloc(sizeof(NVGtextLayoutCache));
+		if (cache == NULL) return NULL;
+		memset(cache, 0, sizeof(NVGtextLayoutCache));
+		for (i = 0; i < NVG_TEXT_LAYOUT_LUT; i++)
+			cache->lut[i] = -1;
+		ctx->layouts = cache;
+	}
+
+	memset(&key, 0, sizeof(key));
+	key.fontId = state->fontId;
+	key.sdf = nvg__textSDF(ctx, state);
+	key.scale = scale;
+	key.size = state->fontSize*scale;
+	key.spacing = state->letterSpacing*scale;
+	key.blur = state->fontBlur*scale;
+	hash = nvg__hashBytes(nvg__hashBytes(2166136261u, &key, sizeof(key)), string, len);
+
+	for (i = cache->lut[hash & (NVG_TEXT_LAYOUT_LUT-1)]; i != -1; i = layout->next) {
+		layout = &cache->layouts[i];
+		if (layout->hash == hash && layout->len == len && memcmp(&layout->key, &key, sizeof(key)) == 0 &&
+			memcmp(layout->str, string, len) == 0) {
+			layout->frame = cache->frame;
+			ctx->layoutHits++;
+			return layout;
+		}
+	}
+
+	// Take a free layout or the least recently used one, the layouts used in this frame are kept.
+	if (cache->nlayouts < NVG_TEXT_LAYOUTS) {
+		layout = &cache->layouts[cache->nlayouts++];
+	} else {
+		layout = NULL;
+		for (i = 0; i < cache->nlayouts; i++) {
+			NVGtextLayout* l = &cache->layouts[i];
+			if (l->frame != cache->frame && (layout == NULL || l->frame < layout->frame))
+				layout = l;
+		}
+		if (layout == NULL) return NULL;
+		prev = &cache->lut[layout->hash & (NVG_TEXT_LAYOUT_LUT-1)];
+		while (*prev != (int)(layout - cache->layouts))
+			prev = &cache->layouts[*prev].next;
+		*prev = layout->next;
+	}
+
+	layout->key = key;
+	layout->hash = hash;
+	layout->frame = cache->frame;
+	layout->len = -1;
+	layout->nglyphs = -1;
+	layout->boundsAlign = -1;
+	layout->nrows = -1;
+	layout->next = cache->lut[hash & (NVG_TEXT_LAYOUT_LUT-1)];
+	cache->lut[hash & (NVG_TEXT_LAYOUT_LUT-1)] = (int)(layout - cache->layouts);
+
+	if (layout->cstr < len + 1) {
+		char* str = (char*)realloc(layout->str, len + 1);
+		if (str == NULL) return NULL;
+		layout->str = str;
+		layout->cstr = len + 1;
+	}
+	memcpy(layout->str, string, len);
+	layout->len = len;
+	ctx->layoutMisses++;
+
+	return layout;
+}
+
+// Shapes the string of the layout once, the font state is set by the caller.
+static int nvg__shapeLayout(NVGcontext* ctx, NVGtextLayout* layout, const char* string, const char* end)
+{
+	if (layout->nglyphs >= 0) return 1;
+	if (layout->cglyphs < layout->len) {
+		FONSrunGlyph* glyphs = (FONSrunGlyph*)realloc(layout->glyphs, sizeof(FONSrunGlyph)*layout->len);
+		if (glyphs == NULL) return 0;
+		layout->glyphs = glyphs;
+		layout->cglyphs = layout->len;
+	}
+	layout->nglyphs = fonsShapeText(ctx->fs, string, end, layout->glyphs, layout->len);
+	return layout->nglyphs >= 0;
+}
+
+// Breaks the text of a box into the rows of the layout once for each width, the text is aligned left.
+static int nvg__breakLayout(NVGcontext* ctx, NVGtextLayout* layout, const char* string, const char* end, float breakRowWidth)
+{
+	NVGtextRow rows[2];
+	const char* base = string;
+	int nrows, i, n = 0;
+
+	if (layout->nrows >= 0 && layout->breakWidth == breakRowWidth) return 1;
+	layout->nrows = -1;
+
+	while ((nrows = nvgTextBreakLines(ctx, string, end, breakRowWidth, rows, 2))) {
+		for (i = 0; i < nrows; i++) {
+			NVGlayoutRow* row;
+			if (n == layout->crows) {
+				int crows = layout->crows > 0 ? layout->crows*2 : 4;
+				NVGlayoutRow* r = (NVGlayoutRow*)realloc(layout->rows, sizeof(NVGlayoutRow)*crows);
+				if (r == NULL) return 0;
+				layout->rows = r;
+				layout->crows = crows;
+			}
+			row = &layout->rows[n++];
+			row->start = (int)(rows[i].start - base);
+			row->end = (int)(rows[i].end - base);
+			row->next = (int)(rows[i].next - base);
+			row->width = rows[i].width;
+			row->minx = rows[i].minx;
+			row->maxx = rows[i].maxx;
+		}
+		string = rows[nrows-1].next;
+	}
+
+	layout->nrows = n;
+	layout->breakWidth = breakRowWidth;
+	return 1;
+}
+
+// Returns the next rows of a text box from string on, taken from the layout or broken like nvgTextBreakLines()
+// without one. The rows of the layout are offsets in base.
+static int nvg__textBoxRows(NVGcontext* ctx, NVGtextLayout* layout, const char* base, const char* string, const char* end,
+							float breakRowWidth, NVGtextRow* rows, int maxRows)
+{
+	int i, n = 0, offset = (int)(string - base);
+
+	if (layout == NULL)
+		return nvgTextBreakLines(ctx, string, end, breakRowWidth, rows, maxRows);
+
+	for (i = 0; i < layout->nrows && n < maxRows; i++) {
+		const NVGlayoutRow* row = &layout->rows[i];
+		if (row->start < offset) continue;
+		rows[n].start = base + row->start;
+		rows[n].end = base + row->end;
+		rows[n].next = base + row->next;
+		rows[n].width = row->width;
+		rows[n].minx = row->minx;
+		rows[n].maxx = row->maxx;
+		n++;
+	}
+	return n;
+}
+
+static void nvg__textIterInit(NVGcontext* ctx, NVGtextLayout* layout, FONStextIter* iter,
+							  float x, float y, const char* string, const char* end, int bitmapOption)
+{
+	if (layout != NULL)
+		fonsRunIterInit(ctx->fs, iter, x, y, layout->glyphs, layout->nglyphs, bitmapOption);
+	else
+		fonsTextIterInit(ctx->fs, iter, x, y, string, end, bitmapOption);
+}
+
+void nvgTextLayoutCache(NVGcontext* ctx, int enable)
+{
+	ctx->layoutCaching = enable;
+	if (!enable)
+		nvg__deleteTextLayouts(ctx);
+}
+
+void nvgTextLayoutStats(NVGcontext* ctx, NVGtextLayoutStats* stats)
+{
+	stats->layouts = ctx->layouts != NULL ? ctx->layouts->nlayouts : 0;
+	stats->hits = ctx->layoutHits;
+	stats->misses = ctx->layoutMisses;
+}
+
+void nvgAsyncGlyphs(NVGcontext* ctx, NVGsubmitFunc submit, NVGcollectFunc collect, void* uptr)
+{
+	if (submit == NULL || collect == NULL)
+		fonsAsyncRasterizer(ctx->fs, NULL, NULL, NULL);
+	else
+		fonsAsyncRasterizer(ctx->fs, submit, collect, uptr);
+}
+
+int nvgGlyphPlaceholders(NVGcontext* ctx)
+{
+	return fonsPlaceholderCount(ctx->fs);
+}
+
+int nvgPrewarmGlyphs(NVGcontext* ctx, const unsigned int* ranges, int nranges)
+{
+	NVGstate* state = nvg__getState(ctx);
+	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
+	int i, n = 0;
+
+	if (state->fontId == FONS_INVALID) return 0;
+
+	fonsSetSize(ctx->fs, state->fontSize*scale);
+	fonsSetBlur(ctx->fs, state->fontBlur*scale);
+	fonsSetSDF(ctx->fs, nvg__textSDF(ctx, state));
+	fonsSetFont(ctx->fs, state->fontId);
+	for (i = 0; i < nranges; i++)
+		n += fonsPrewarmGlyphs(ctx->fs, ranges[i*2], ranges[i*2+1]);
+	return n;
+}
+
+int nvgGlyphRasterizer(NVGcontext* ctx, int rasterizer)
+{
+	return fonsGlyphRasterizer(ctx->fs, rasterizer);
+}
+
+int nvgSaveGlyphCache(NVGcontext* ctx, const char* path)
+{
+	return fonsSaveGlyphCache(ctx->fs, path);
+}
+
+int nvgLoadGlyphCache(NVGcontext* ctx, const unsigned char* data, int ndata)
+{
+	int n = fonsLoadGlyphCache(ctx->fs, data, ndata);
+	if (n >= 0)
+		nvg__flushTextTexture(ctx);
+	return n;
+}
+
 float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char* end)
 {
 	NVGstate* state = nvg__getState(ctx);
-	FONStextIter iter, prevIter;
+	FONStextIter iter;
 	FONSquad q;
 	NVGvertex* verts;
+	NVGtextLayout* layout;
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	float invscale = 1.0f / scale;
 	int cverts = 0;
 	int nverts = 0;
+	int page = 0;
 
 	if (end == NULL)
 		end = string + strlen(string);
 
 	if (state->fontId == FONS_INVALID) return x;
 
+	if (ctx->recording != NULL)
+		return nvg__recordText(ctx, x, y, string, end);
+
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
+	fonsSetSDF(ctx->fs, nvg__textSDF(ctx, state));
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 
+	layout = nvg__textLayout(ctx, state, scale, string, end);
+	if (layout != NULL && !nvg__shapeLayout(ctx, layout, string, end))
+		layout = NULL;
+
+	if (nvg__textCulled(ctx, state, y)) {
+		// Only advance, the glyphs are not rasterized.
+		nvg__textIterInit(ctx, layout, &iter, x*scale, y*scale, string, end, FONS_GLYPH_BITMAP_OPTIONAL);
+		while (fonsTextIterNext(ctx->fs, &iter, &q))
+			;
+		return iter.nextx / scale;
+	}
+
 	cverts = nvg__maxi(2, (int)(end - string)) * 6; // conservative estimate.
 	verts = nvg__allocTempVerts(ctx, cverts);
 	if (verts == NULL) return x;
 
-	fonsTextIterInit(ctx->fs, &iter, x*scale, y*scale, string, end, FONS_GLYPH_BITMAP_REQUIRED);
-	prevIter = iter;
+	nvg__textIterInit(ctx, layout, &iter, x*scale, y*scale, string, end, FONS_GLYPH_BITMAP_REQUIRED);
 	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
 		float c[4*2];
-		if (iter.prevGlyphIndex == -1) { // can not retrieve glyph?
-			if (nverts != 0) {
-				nvg__renderText(ctx, verts, nverts);
-				nverts = 0;
-			}
-			if (!nvg__allocTextAtlas(ctx))
-				break; // no memory :(
-			iter = prevIter;
-			fonsTextIterNext(ctx->fs, &iter, &q); // try again
-			if (iter.prevGlyphIndex == -1) // still can not find glyph?
-				break;
+		if (iter.prevGlyphIndex == -1) // can not retrieve glyph?
+			continue;
+		// One draw per atlas page.
+		if (q.page != page) {
+			nvg__renderText(ctx, verts, nverts, page);
+			nverts = 0;
+			page = q.page;
 		}
-		prevIter = iter;
 		// Transform corners.
 		nvgTransformPoint(&c[0],&c[1], state->xform, q.x0*invscale, q.y0*invscale);
 		nvgTransformPoint(&c[2],&c[3], state->xform, q.x1*invscale, q.y0*invscale);
@@ -2494,10 +4780,7 @@ float nvgText(NVGcontext* ctx, float x, float y, const char* string, const char*
 		}
 	}
 
-	// TODO: add back-end bit to do this just once per frame.
-	nvg__flushTextTexture(ctx);
-
-	nvg__renderText(ctx, verts, nverts);
+	nvg__renderText(ctx, verts, nverts, page);
 
 	return iter.nextx / scale;
 }
@@ -2506,6 +4789,9 @@ void nvgTextBox(NVGcontext* ctx, float x, float y, float breakRowWidth, const ch
 {
 	NVGstate* state = nvg__getState(ctx);
 	NVGtextRow rows[2];
+	NVGtextLayout* layout;
+	const char* base = string;
+	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	int nrows = 0, i;
 	int oldAlign = state->textAlign;
 	int haling = state->textAlign & (NVG_ALIGN_LEFT | NVG_ALIGN_CENTER | NVG_ALIGN_RIGHT);
@@ -2514,11 +4800,18 @@ void nvgTextBox(NVGcontext* ctx, float x, float y, float breakRowWidth, const ch
 
 	if (state->fontId == FONS_INVALID) return;
 
+	if (end == NULL)
+		end = string + strlen(string);
+
 	nvgTextMetrics(ctx, NULL, NULL, &lineh);
 
 	state->textAlign = NVG_ALIGN_LEFT | valign;
 
-	while ((nrows = nvgTextBreakLines(ctx, string, end, breakRowWidth, rows, 2))) {
+	layout = nvg__textLayout(ctx, state, scale, string, end);
+	if (layout != NULL && !nvg__breakLayout(ctx, layout, string, end, breakRowWidth))
+		layout = NULL;
+
+	while ((nrows = nvg__textBoxRows(ctx, layout, base, string, end, breakRowWidth, rows, 2))) {
 		for (i = 0; i < nrows; i++) {
 			NVGtextRow* row = &rows[i];
 			if (haling & NVG_ALIGN_LEFT)
@@ -2540,7 +4833,7 @@ int nvgTextGlyphPositions(NVGcontext* ctx, float x, float y, const char* string,
 	NVGstate* state = nvg__getState(ctx);
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	float invscale = 1.0f / scale;
-	FONStextIter iter, prevIter;
+	FONStextIter iter;
 	FONSquad q;
 	int npos = 0;
 
@@ -2555,17 +4848,12 @@ int nvgTextGlyphPositions(NVGcontext* ctx, float x, float y, const char* string,
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
+	fonsSetSDF(ctx->fs, nvg__textSDF(ctx, state));
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 
 	fonsTextIterInit(ctx->fs, &iter, x*scale, y*scale, string, end, FONS_GLYPH_BITMAP_OPTIONAL);
-	prevIter = iter;
 	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
-		if (iter.prevGlyphIndex < 0 && nvg__allocTextAtlas(ctx)) { // can not retrieve glyph?
-			iter = prevIter;
-			fonsTextIterNext(ctx->fs, &iter, &q); // try again
-		}
-		prevIter = iter;
 		positions[npos].str = iter.str;
 		positions[npos].x = iter.x * invscale;
 		positions[npos].minx = nvg__minf(iter.x, q.x0) * invscale;
@@ -2590,7 +4878,7 @@ int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, floa
 	NVGstate* state = nvg__getState(ctx);
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	float invscale = 1.0f / scale;
-	FONStextIter iter, prevIter;
+	FONStextIter iter;
 	FONSquad q;
 	int nrows = 0;
 	float rowStartX = 0;
@@ -2619,19 +4907,14 @@ int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, floa
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
+	fonsSetSDF(ctx->fs, nvg__textSDF(ctx, state));
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 
 	breakRowWidth *= scale;
 
 	fonsTextIterInit(ctx->fs, &iter, 0, 0, string, end, FONS_GLYPH_BITMAP_OPTIONAL);
-	prevIter = iter;
 	while (fonsTextIterNext(ctx->fs, &iter, &q)) {
-		if (iter.prevGlyphIndex < 0 && nvg__allocTextAtlas(ctx)) { // can not retrieve glyph?
-			iter = prevIter;
-			fonsTextIterNext(ctx->fs, &iter, &q); // try again
-		}
-		prevIter = iter;
 		switch (iter.codepoint) {
 			case 9:			// \t
 			case 11:		// \v
@@ -2794,20 +5077,40 @@ int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, floa
 float nvgTextBounds(NVGcontext* ctx, float x, float y, const char* string, const char* end, float* bounds)
 {
 	NVGstate* state = nvg__getState(ctx);
+	NVGtextLayout* layout;
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	float invscale = 1.0f / scale;
-	float width;
+	float width, b[4];
 
 	if (state->fontId == FONS_INVALID) return 0;
 
+	if (end == NULL)
+		end = string + strlen(string);
+
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
+	fonsSetSDF(ctx->fs, nvg__textSDF(ctx, state));
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 
-	width = fonsTextBounds(ctx->fs, x*scale, y*scale, string, end, bounds);
+	layout = nvg__textLayout(ctx, state, scale, string, end);
+	if (layout != NULL && layout->boundsAlign == state->textAlign &&
+		layout->boundsOrigin[0] == x*scale && layout->boundsOrigin[1] == y*scale) {
+		width = layout->boundsAdvance;
+		memcpy(b, layout->bounds, sizeof(b));
+	} else {
+		width = fonsTextBounds(ctx->fs, x*scale, y*scale, string, end, b);
+		if (layout != NULL) {
+			layout->boundsOrigin[0] = x*scale;
+			layout->boundsOrigin[1] = y*scale;
+			layout->boundsAlign = state->textAlign;
+			layout->boundsAdvance = width;
+			memcpy(layout->bounds, b, sizeof(b));
+		}
+	}
 	if (bounds != NULL) {
+		memcpy(bounds, b, sizeof(b));
 		// Use line bounds for height.
 		fonsLineBounds(ctx->fs, y*scale, &bounds[1], &bounds[3]);
 		bounds[0] *= invscale;
@@ -2822,6 +5125,8 @@ void nvgTextBoxBounds(NVGcontext* ctx, float x, float y, float breakRowWidth, co
 {
 	NVGstate* state = nvg__getState(ctx);
 	NVGtextRow rows[2];
+	NVGtextLayout* layout;
+	const char* base = string;
 	float scale = nvg__getFontScale(state) * ctx->devicePxRatio;
 	float invscale = 1.0f / scale;
 	int nrows = 0, i;
@@ -2847,13 +5152,21 @@ void nvgTextBoxBounds(NVGcontext* ctx, float x, float y, float breakRowWidth, co
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
+	fonsSetSDF(ctx->fs, nvg__textSDF(ctx, state));
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 	fonsLineBounds(ctx->fs, 0, &rminy, &rmaxy);
 	rminy *= invscale;
 	rmaxy *= invscale;
 
-	while ((nrows = nvgTextBreakLines(ctx, string, end, breakRowWidth, rows, 2))) {
+	if (end == NULL)
+		end = string + strlen(string);
+
+	layout = nvg__textLayout(ctx, state, scale, string, end);
+	if (layout != NULL && !nvg__breakLayout(ctx, layout, string, end, breakRowWidth))
+		layout = NULL;
+
+	while ((nrows = nvg__textBoxRows(ctx, layout, base, string, end, breakRowWidth, rows, 2))) {
 		for (i = 0; i < nrows; i++) {
 			NVGtextRow* row = &rows[i];
 			float rminx, rmaxx, dx = 0;
@@ -2898,6 +5211,7 @@ void nvgTextMetrics(NVGcontext* ctx, float* ascender, float* descender, float* l
 	fonsSetSize(ctx->fs, state->fontSize*scale);
 	fonsSetSpacing(ctx->fs, state->letterSpacing*scale);
 	fonsSetBlur(ctx->fs, state->fontBlur*scale);
+	fonsSetSDF(ctx->fs, nvg__textSDF(ctx, state));
 	fonsSetAlign(ctx->fs, state->textAlign);
 	fonsSetFont(ctx->fs, state->fontId);
 
@@ -2909,4 +5223,14 @@ void nvgTextMetrics(NVGcontext* ctx, float* ascender, float* descender, float* l
 	if (lineh != NULL)
 		*lineh *= invscale;
 }
+
+void nvgGlyphCacheStats(NVGcontext* ctx, NVGglyphCacheStats* stats)
+{
+	FONSatlasStats fs;
+	fonsAtlasStats(ctx->fs, &fs);
+	stats->pages = fs.pages;
+	stats->hits = fs.hits;
+	stats->misses = fs.misses;
+	stats->evictions = fs.evictions;
+}
 // vim: ft=c nu noet ts=4
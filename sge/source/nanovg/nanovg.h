@@ -135,6 +135,21 @@ struct NVGtextRow {
 };
 typedef struct NVGtextRow NVGtextRow;
 
+struct NVGglyphCacheStats {
+	int pages;			// Font atlas pages in use, each is a texture.
+	int hits;			// Glyphs drawn from the atlas.
+	int misses;			// Glyphs rasterized to be drawn.
+	int evictions;		// Glyphs removed from the atlas to make room, instead of clearing the atlas.
+};
+typedef struct NVGglyphCacheStats NVGglyphCacheStats;
+
+struct NVGtextLayoutStats {
+	int layouts;		// Strings laid out in the cache.
+	int hits;			// Texts measured or drawn with a cached layout.
+	int misses;			// Texts laid out to be cached.
+};
+typedef struct NVGtextLayoutStats NVGtextLayoutStats;
+
 enum NVGimageFlags {
     NVG_IMAGE_GENERATE_MIPMAPS	= 1<<0,     // Generate mipmaps during creation of the image.
 	NVG_IMAGE_REPEATX			= 1<<1,		// Repeat image in X direction.
@@ -383,6 +398,9 @@ int nvgCreateImageRGBA(NVGcontext* ctx, int w, int h, int imageFlags, const unsi
 // Updates image data specified by image handle.
 void nvgUpdateImage(NVGcontext* ctx, int image, const unsigned char* data);
 
+// Updates the rectangle x,y,w,h of the image, data holds the whole image.
+void nvgUpdateImageRegion(NVGcontext* ctx, int image, int x, int y, int w, int h, const unsigned char* data);
+
 // Returns the dimensions of a created image.
 void nvgImageSize(NVGcontext* ctx, int image, int* w, int* h);
 
@@ -442,6 +460,14 @@ void nvgIntersectScissor(NVGcontext* ctx, float x, float y, float w, float h);
 // Reset and disables scissoring.
 void nvgResetScissor(NVGcontext* ctx);
 
+// Enables or disables culling, enabled by default. nvgFill(), nvgStroke(), nvgText() and the paths
+// of nvgDrawDisplayList() are skipped before tessellation when their transformed bounds, grown
+// by the stroke and the fringe, are outside of the bounding box of the scissor or the viewport.
+void nvgScissorCulling(NVGcontext* ctx, int enable);
+
+// Returns the number of fills, strokes and texts culled since nvgBeginFrame().
+int nvgCulledCount(NVGcontext* ctx);
+
 //
 // Paths
 //
@@ -566,6 +592,12 @@ void nvgFontSize(NVGcontext* ctx, float size);
 // Sets the blur of current text style.
 void nvgFontBlur(NVGcontext* ctx, float blur);
 
+// Enables or disables drawing the current text style from signed distance field glyphs, disabled by
+// default. Each glyph is rasterized once and scaled to any size, transform and blur by the back-end,
+// the glyphs are not snapped to pixels. The blur is limited to about an eighth of the font size.
+// Returns 1 if the back-end draws distance fields, 0 if the bitmap glyphs are used.
+int nvgTextSDF(NVGcontext* ctx, int enabled);
+
 // Sets the letter spacing of current text style.
 void nvgTextLetterSpacing(NVGcontext* ctx, float spacing);
 
@@ -608,11 +640,263 @@ int nvgTextGlyphPositions(NVGcontext* ctx, float x, float y, const char* string,
 // Measured values are returned in local coordinate space.
 void nvgTextMetrics(NVGcontext* ctx, float* ascender, float* descender, float* lineh);
 
+// Returns the glyph cache statistics since the context was created. The glyphs are packed on up to
+// four atlas pages, when they are full the least recently drawn glyphs are evicted.
+void nvgGlyphCacheStats(NVGcontext* ctx, NVGglyphCacheStats* stats);
+
+// Enables or disables the text layout cache, enabled by default. nvgText(), nvgTextBox(), nvgTextBounds()
+// and nvgTextBoxBounds() keep the shaped glyphs, the bounds and the line breaks of the last 1024 strings
+// with their text style, so unchanged text is not decoded, kerned and broken into lines again every frame.
+void nvgTextLayoutCache(NVGcontext* ctx, int enable);
+
+// Returns the text layout cache statistics since the context was created.
+void nvgTextLayoutStats(NVGcontext* ctx, NVGtextLayoutStats* stats);
+
 // Breaks the specified text into lines. If end is specified only the sub-string will be used.
 // White space is stripped at the beginning of the rows, the text is split at word boundaries or when new-line characters are encountered.
 // Words longer than the max width are slit at nearest character (i.e. no hyphenation).
 int nvgTextBreakLines(NVGcontext* ctx, const char* string, const char* end, float breakRowWidth, NVGtextRow* rows, int maxRows);
 
+//
+// Display Lists
+//
+// A display list records the fills, strokes and texts issued between nvgBeginDisplayList()
+// and nvgEndDisplayList() instead of drawing them. nvgDrawDisplayList() replays the recorded
+// content with the current transform. The tessellated fill and stroke geometry is cached in
+// the list and reused across frames, the cached vertices are only transformed on replay.
+// The paths are tessellated again when the scale of the replay transform differs from the
+// cached one by more than the scale tolerance, or when the device pixel ratio changes.
+//
+// The paint, stroke style, global alpha and scissor in effect at record time are stored with
+// each call. Calls recorded without scissor use the scissor current at replay time, and the
+// global alpha current at replay time is multiplied in. Texts are stored as strings and laid
+// out again on replay, since the glyph atlas may change between frames.
+
+typedef struct NVGdisplayList NVGdisplayList;
+
+// Creates an empty display list.
+NVGdisplayList* nvgCreateDisplayList(void);
+
+// Deletes a display list.
+void nvgDeleteDisplayList(NVGdisplayList* list);
+
+// Removes all recorded calls and cached geometry of the display list.
+void nvgClearDisplayList(NVGdisplayList* list);
+
+// Returns 1 if nothing is recorded in the display list.
+int nvgDisplayListEmpty(NVGdisplayList* list);
+
+// Sets the relative scale change allowed before the cached geometry is tessellated again, default 0.1.
+void nvgDisplayListScaleTolerance(NVGdisplayList* list, float tolerance);
+
+// Returns how many times the display list geometry has been tessellated.
+int nvgDisplayListTessellations(NVGdisplayList* list);
+
+// Clears the list and starts recording into it, the current transform becomes the list space.
+void nvgBeginDisplayList(NVGcontext* ctx, NVGdisplayList* list);
+
+// Stops recording.
+void nvgEndDisplayList(NVGcontext* ctx);
+
+// Draws the display list with the current transform. Must not be called while recording.
+void nvgDrawDisplayList(NVGcontext* ctx, NVGdisplayList* list);
+
+//
+// Layers
+//
+// A layer is an image the back-end can draw into, e.g. created with NVG_IMAGE_RENDER_TARGET by
+// the GL back-end. The fills, strokes and texts between nvgBeginLayer() and nvgEndLayer() are
+// drawn into the image instead of the frame, in the same call order, so a layer drawn in a frame
+// can be used as image pattern later in the same frame. Layers can be nested.
+
+// Starts drawing into the layer image, it is cleared to transparent. The state is saved and reset,
+// the layer size becomes the viewport. Returns 0 if the image can not be drawn into, or while
+// recording a display list.
+int nvgBeginLayer(NVGcontext* ctx, int image);
+
+// Stops drawing into the current layer, and restores the state and the previous target.
+void nvgEndLayer(NVGcontext* ctx);
+
+//
+// Primitives
+//
+// Rects, rounded rects, circles and lines drawn without building a path. A back-end supporting
+// instancing (GL3 and GLES3) draws them as quads, the coverage, border and blur are computed from
+// the distance to the shape in the fragment shader, and consecutive primitives with the same scissor
+// and composite operation are drawn together in one instanced call. Other back-ends, or drawing into
+// a display list, fill and stroke paths instead, the border is stroked over the fill and lines are
+// not blurred. The current transform, scissor, global alpha and composite operation apply, the
+// current path is cleared.
+
+enum NVGprimitiveType {
+	NVG_PRIM_RECT,		// Rounded rect at (x,y) of size (w,h), a circle if w and h are twice the radius.
+	NVG_PRIM_LINE,		// Line from (x,y) to (w,h) with round caps, radius is half the line width.
+};
+
+struct NVGprimitive {
+	int type;			// NVGprimitiveType
+	float x, y, w, h;
+	float radius;		// Corner radius, clamped to the half size
+	float border;		// Width of the border inside the shape replacing the fill, 0 for none
+	float feather;		// Width of the blurred edge for shadows, 0 for the anti-aliased edge, the border is not drawn
+	NVGcolor fillColor;
+	NVGcolor borderColor;
+};
+typedef struct NVGprimitive NVGprimitive;
+
+// Draws the primitives in order. Primitives outside of the scissor are culled as the paths.
+void nvgPrimitives(NVGcontext* ctx, const NVGprimitive* prims, int count);
+
+// Enables or disables drawing the primitives with the back-end, enabled by default.
+// Returns 1 if the back-end draws the primitives, 0 if they are drawn as paths.
+int nvgInstancedPrimitives(NVGcontext* ctx, int enable);
+
+//
+// Polylines
+//
+// A polyline keeps a copy of a series of points with increasing x, e.g. the samples of a time
+// series, and strokes it without encoding and flattening a path command per point. The points are
+// decimated to the min and max y of buckets of x at most one device pixel wide, so a few points per
+// pixel column are stroked however many samples there are. The buckets have power of two widths,
+// each decimated level is cached until the points change and built from the next finer cached
+// level, so redraws at the same zoom and pans reuse it. With a transform without rotation only
+// the points inside the viewport and scissor are stroked.
+
+typedef struct NVGpolyline NVGpolyline;
+
+// Creates an empty polyline.
+NVGpolyline* nvgCreatePolyline(void);
+
+// Deletes a polyline.
+void nvgDeletePolyline(NVGpolyline* line);
+
+// Copies npts points of x,y pairs, x must not decrease. Drops the cached levels.
+// Returns 0 if out of memory, the polyline is empty then.
+int nvgPolylinePoints(NVGpolyline* line, const float* pts, int npts);
+
+// Strokes the polyline like a path of its points, with the current stroke paint, width, cap, join,
+// transform and scissor. The current path is cleared. Drawn into a display list, the decimated
+// points are recorded as a path.
+void nvgStrokePolyline(NVGcontext* ctx, NVGpolyline* line);
+
+// Returns the number of points stroked by the last nvgStrokePolyline() of the polyline.
+int nvgPolylineStrokedCount(NVGpolyline* line);
+
+//
+// Parallel Tessellation
+//
+// When a task runner is set, nvgFill() and nvgStroke() only queue the path, the queued paths are
+// split into chunks and tessellated by the runner, each chunk has its own path cache. The results
+// are submitted to the back-end in call order at nvgEndFrame(), or before a text or display list
+// is drawn, so the output is the same as without the runner.
+
+// Task called by the runner for each chunk index.
+typedef void (*NVGtaskFunc)(void* data, int index);
+
+// Task runner, calls task(data, index) for each index in [0, count), possibly concurrently,
+// and returns when all tasks are done.
+typedef void (*NVGparallelFunc)(void* uptr, NVGtaskFunc task, void* data, int count);
+
+// Sets the task runner and the max number of chunks for tessellation, pass NULL runner to tessellate
+// on the calling thread at each nvgFill() and nvgStroke() again.
+void nvgParallelTessellation(NVGcontext* ctx, NVGparallelFunc runner, void* uptr, int chunks);
+
+//
+// Asynchronous Glyph Rasterization
+//
+// When a task submitter is set, the bitmaps of the glyphs missing from the atlas are rasterized by
+// tasks on other threads instead of in nvgText(). Until a task is collected the glyph is drawn
+// stretched from another size of it in the atlas, or not at all. The finished tasks are collected
+// before text is drawn. Only the stb_truetype back-end rasterizes asynchronously.
+
+// Submits task(data, 0) to run, possibly concurrently.
+typedef void (*NVGsubmitFunc)(void* uptr, NVGtaskFunc task, void* data);
+
+// Stores up to max data pointers of finished tasks and returns their number, with wait set it
+// first waits for all the submitted tasks to finish.
+typedef int (*NVGcollectFunc)(void* uptr, void** data, int max, int wait);
+
+// Sets the task submitter, pass NULL to rasterize in nvgText() again. The submitted tasks are waited for.
+void nvgAsyncGlyphs(NVGcontext* ctx, NVGsubmitFunc submit, NVGcollectFunc collect, void* uptr);
+
+// Returns the number of glyphs drawn without their bitmap in the current frame.
+int nvgGlyphPlaceholders(NVGcontext* ctx);
+
+// Rasterizes the glyphs of nranges codepoint ranges, pairs of first and last codepoint, in the current
+// font, size, blur and distance field state before they are drawn. Asynchronous when a submitter
+// is set. Returns the number of glyphs rasterized or submitted.
+int nvgPrewarmGlyphs(NVGcontext* ctx, const unsigned int* ranges, int nranges);
+
+//
+// Glyph Rasterizer
+//
+// With the stb_truetype back-end the glyph bitmaps are rasterized by accumulating the signed area
+// of the flattened outline per pixel and summing it along the rows, instead of the stb_truetype
+// scanline rasterizer. FreeType always rasterizes its hinted glyphs itself.
+
+enum NVGglyphRasterizer {
+	NVG_RASTER_ACCUMULATE = 0,
+	NVG_RASTER_BACKEND = 1,
+};
+
+// Sets the rasterizer of the glyphs added to the atlas from now on, returns the one in use.
+int nvgGlyphRasterizer(NVGcontext* ctx, int rasterizer);
+
+//
+// Glyph Cache
+//
+// The glyphs in the font atlas can be saved to a file with the atlas pages, and loaded by a context
+// with the same atlas size before any text is drawn instead of rasterizing them again. The glyphs
+// missing from the file are rasterized when they are drawn.
+
+// Saves the glyphs in the atlas. Returns the number of glyphs saved, -1 if the file can not be written.
+int nvgSaveGlyphCache(NVGcontext* ctx, const char* path);
+
+// Loads the glyphs of a glyph cache file read or mapped into data and uploads the atlas pages.
+// Returns the number of glyphs loaded, -1 if data is not a glyph cache of this atlas size or
+// glyphs were rasterized already.
+int nvgLoadGlyphCache(NVGcontext* ctx, const unsigned char* data, int ndata);
+
+//
+// SIMD Kernels
+//
+// Bezier flattening, segment and join calculation and stroke vertex generation have SIMD kernels,
+// the best supported ones are used by default. The SIMD bezier flattening uses uniform steps sized
+// from the curve bound instead of recursive subdivision. The selection is global to all contexts.
+
+enum NVGsimdLevel {
+	NVG_SIMD_NONE = 0,
+	NVG_SIMD_SSE2 = 1,
+};
+
+// Returns the best SIMD level supported by this build and processor.
+int nvgSimdSupported(void);
+
+// Returns the SIMD level in use.
+int nvgGetSimdLevel(void);
+
+// Selects the kernels of the SIMD level, clamped to nvgSimdSupported(). Returns the level in use.
+int nvgSimdLevel(int level);
+
+//
+// Frame Memory
+//
+// The path commands and the path cache of the context, and the calls, paths, vertices and uniforms
+// the back-end records, are allocated from frame arenas instead of growing each buffer with realloc.
+// An arena is reset when its frame starts and keeps the most bytes a frame used as one block, so
+// steady frames allocate nothing and a larger frame grows it once. Arenas are freed with their owner.
+
+struct NVGarenaStats {
+	int used;		// Bytes allocated since the last reset.
+	int peak;		// Most bytes allocated between two resets, reserved at each reset.
+	int reserved;	// Bytes of the blocks held.
+	int growths;	// Blocks allocated because a frame went over the reserved bytes.
+};
+typedef struct NVGarenaStats NVGarenaStats;
+
+// Returns the statistics of the arena of the context, the back-end reports its own arenas.
+void nvgMemoryStats(NVGcontext* ctx, NVGarenaStats* stats);
+
 //
 // Internal Render API
 //
@@ -660,6 +944,11 @@ struct NVGparams {
 	void (*renderFill)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe, const float* bounds, const NVGpath* paths, int npaths);
 	void (*renderStroke)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe, float strokeWidth, const NVGpath* paths, int npaths);
 	void (*renderTriangles)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, const NVGvertex* verts, int nverts);
+	void (*renderSDFTriangles)(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+							   float blur, const NVGvertex* verts, int nverts);	// Optional, the alpha image holds distance fields.
+	void (*renderTarget)(void* uptr, int image, int clear);	// Optional, image 0 is the frame.
+	void (*renderPrimitives)(void* uptr, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+							 const float* xform, float alpha, const NVGprimitive* prims, int nprims);	// Optional
 	void (*renderDelete)(void* uptr);
 };
 typedef struct NVGparams NVGparams;
@@ -670,6 +959,23 @@ void nvgDeleteInternal(NVGcontext* ctx);
 
 NVGparams* nvgInternalParams(NVGcontext* ctx);
 
+// Linear allocator of the frame buffers, see Frame Memory. The allocations are 16 byte aligned and
+// released all at once by nvgResetArena(), an arena is used by one thread at a time.
+typedef struct NVGarena NVGarena;
+
+NVGarena* nvgCreateArena(int size);
+void nvgDeleteArena(NVGarena* arena);
+void* nvgArenaAlloc(NVGarena* arena, int size);
+
+// Grows ptr to size bytes, allocates if ptr is NULL. The last allocation grows in place, others
+// move to the top and the first keep bytes are copied, the old space is reused after the reset.
+void* nvgArenaGrow(NVGarena* arena, void* ptr, int keep, int size);
+
+// Releases all allocations, the blocks are joined into one of the peak size.
+void nvgResetArena(NVGarena* arena);
+
+void nvgArenaStats(NVGarena* arena, NVGarenaStats* stats);
+
 // Debug function to dump cached path data.
 void nvgDebugDumpPathCache(NVGcontext* ctx);
 
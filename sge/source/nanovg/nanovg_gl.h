@@ -51,6 +51,40 @@ enum NVGcreateFlags {
 
 #define NANOVG_GL_USE_STATE_FILTER (1)
 
+// Merging indexes the uniform array by vertex, it needs GLSL ES 3.00 and the uniform array
+#if defined NANOVG_GLES3
+#  define NANOVG_GL_USE_MERGE 1
+#endif
+// Max calls merged into one draw
+#define NANOVG_GL_MERGE_MAX 16
+
+// Streaming uploads need fences and mapped ranges
+#if defined NANOVG_GL3 || defined NANOVG_GLES3
+#  define NANOVG_GL_USE_STREAM 1
+#endif
+// Regions of a persistent mapped buffer, the GPU may read the others while a frame writes one
+#define NANOVG_GL_STREAM_REGIONS 3
+// Min size of a region or orphaned buffer
+#define NANOVG_GL_STREAM_MIN_SIZE (256*1024)
+
+// Initial size of the arena of a frame, it grows to the largest frame recorded
+#define NANOVG_GL_ARENA_SIZE (256*1024)
+
+// Layers are drawn through framebuffer objects
+#if defined NANOVG_GL3 || defined NANOVG_GLES2 || defined NANOVG_GLES3
+#  define NANOVG_GL_USE_TARGETS 1
+#endif
+
+// Primitives are drawn as instanced quads
+#if defined NANOVG_GL3 || defined NANOVG_GLES3
+#  define NANOVG_GL_USE_PRIMITIVES 1
+#endif
+
+// Distance field text needs fwidth() of the core shaders
+#if defined NANOVG_GL3 || defined NANOVG_GLES3
+#  define NANOVG_GL_USE_SDF 1
+#endif
+
 // Creates NanoVG contexts for different OpenGL (ES) versions.
 // Flags should be combination of the create flags above.
 
@@ -94,9 +128,53 @@ GLuint nvglImageHandleGLES3(NVGcontext* ctx, int image);
 
 #endif
 
+// Deferred submission, nanovg records frames on one thread and the thread
+// owning the GL context draws them. In deferred mode the backend makes no GL
+// calls, texture create/update/delete are recorded into the frame too.
+typedef struct GLNVGframe NVGLframe;
+
+NVGLframe* nvglCreateFrame(void);
+void nvglDeleteFrame(NVGLframe* frame);
+
+// Enable or disable deferred mode, no frame may be in flight while switching.
+// Pending texture commands are executed when disabled, the GL context must be current.
+void nvglSetDeferred(NVGcontext* ctx, int deferred);
+
+// Move the commands recorded since last swap into frame, it must be rendered before swapped again.
+void nvglSwapFrame(NVGcontext* ctx, NVGLframe* frame);
+
+// Draw a swapped frame on the thread owning the GL context, the frame is empty after.
+void nvglRenderFrame(NVGcontext* ctx, NVGLframe* frame);
+
+// Draw call merging, consecutive convex fills, strokes and triangles with the same blend and texture
+// are drawn with one draw call, the vertices index the uniforms of their call. Stencil strokes are
+// merged only when not overlapping. Supported by the GLES3 backend, enabled by default.
+void nvglSetMergeCalls(NVGcontext* ctx, int merge);
+
+// Returns the number of calls recorded and drawn after merging in the last rendered frame.
+void nvglFrameStats(NVGcontext* ctx, int* calls, int* merged);
+
+// Returns the statistics of the arena of the frame being recorded. In deferred mode each frame
+// has its own arena, the arenas rotate with the swapped frames.
+void nvglMemoryStats(NVGcontext* ctx, NVGarenaStats* stats);
+
+// Upload modes of the vertices and the uniform buffer, streaming needs the GL3 or GLES3 backend.
+enum NVGstreamMode {
+	NVGL_STREAM_NONE = 0,		// Upload with glBufferData every flush.
+	NVGL_STREAM_ORPHAN = 1,		// Append with unsynchronized mapping, the buffer is orphaned when full.
+	NVGL_STREAM_PERSISTENT = 2,	// Persistent mapped buffer of three regions guarded by fences, the vertices are
+								// written in place when not deferred. Needs ARB_buffer_storage or EXT_buffer_storage.
+};
+
+// Sets the upload mode, unsupported modes fall back to the best supported one. Returns the mode to use.
+// The mode changes after the next rendered frame, on the thread owning the GL context.
+// The best supported mode is used by default.
+int nvglSetStreamMode(NVGcontext* ctx, int mode);
+
 // These are additional flags on top of NVGimageFlags.
 enum NVGimageFlagsGL {
 	NVG_IMAGE_NODELETE			= 1<<16,	// Do not delete GL texture handle.
+	NVG_IMAGE_RENDER_TARGET		= 1<<17,	// Attach a framebuffer with stencil, so nvgBeginLayer() can draw into the image.
 };
 
 #ifdef __cplusplus
@@ -112,6 +190,7 @@ enum NVGimageFlagsGL {
 #include <string.h>
 #include <math.h>
 #include "nanovg.h"
+#include <core/sgeProfiler.h>
 
 enum GLNVGuniformLoc {
 	GLNVG_LOC_VIEWSIZE,
@@ -144,6 +223,7 @@ typedef struct GLNVGshader GLNVGshader;
 struct GLNVGtexture {
 	int id;
 	GLuint tex;
+	GLuint fbo, rbo;	// Render targets only
 	int width, height;
 	int type;
 	int flags;
@@ -165,6 +245,8 @@ enum GLNVGcallType {
 	GLNVG_CONVEXFILL,
 	GLNVG_STROKE,
 	GLNVG_TRIANGLES,
+	GLNVG_TARGET,	// Binds the framebuffer of image, 0 the frame one, triangleCount is 1 to clear it
+	GLNVG_PRIMITIVES,	// Instances from triangleOffset, triangleCount instances
 };
 
 struct GLNVGcall {
@@ -176,9 +258,22 @@ struct GLNVGcall {
 	int triangleCount;
 	int uniformOffset;
 	GLNVGblend blendFunc;
+	int imageFlags;
+	float bounds[4];	// Stencil strokes only
 };
 typedef struct GLNVGcall GLNVGcall;
 
+// Consecutive calls drawn together, the calls of a single call batch are drawn as recorded
+struct GLNVGbatch {
+	int call;
+	int ncalls;
+	int image;
+	int imageFlags;
+	int indexOffset;
+	int indexCount;
+};
+typedef struct GLNVGbatch GLNVGbatch;
+
 struct GLNVGpath {
 	int fillOffset;
 	int fillCount;
@@ -228,10 +323,102 @@ struct GLNVGfragUniforms {
 };
 typedef struct GLNVGfragUniforms GLNVGfragUniforms;
 
+enum GLNVGtextureOpType {
+	GLNVG_TEXOP_CREATE,
+	GLNVG_TEXOP_UPDATE,
+	GLNVG_TEXOP_DELETE,
+	GLNVG_TEXOP_HANDLE,
+};
+
+// A deferred texture command, data is a copy owned by the command
+struct GLNVGtextureOp {
+	int op;
+	int image;
+	int type;
+	int flags;
+	int x, y, w, h;
+	int width;
+	GLuint handle;
+	unsigned char* data;
+};
+typedef struct GLNVGtextureOp GLNVGtextureOp;
+
+// The GL texture of image, owned by the GL thread in deferred mode
+struct GLNVGtextureName {
+	int id;
+	GLuint tex;
+	GLuint fbo, rbo;
+	int width, height;
+	int flags;
+};
+typedef struct GLNVGtextureName GLNVGtextureName;
+
+#if NANOVG_GL_USE_STREAM
+#if defined NANOVG_GLES3
+typedef PFNGLBUFFERSTORAGEEXTPROC GLNVGbufferStorage;
+#define GLNVG_MAP_PERSISTENT_BIT GL_MAP_PERSISTENT_BIT_EXT
+#define GLNVG_MAP_COHERENT_BIT GL_MAP_COHERENT_BIT_EXT
+#else
+typedef PFNGLBUFFERSTORAGEPROC GLNVGbufferStorage;
+#define GLNVG_MAP_PERSISTENT_BIT GL_MAP_PERSISTENT_BIT
+#define GLNVG_MAP_COHERENT_BIT GL_MAP_COHERENT_BIT
+#endif
+
+// A streaming buffer, size is the region size in persistent mode and the buffer size in orphan mode
+struct GLNVGstream {
+	int size;
+	int offset;
+	int region;
+	int pending;
+	unsigned char* mapped;
+	GLsync fences[NANOVG_GL_STREAM_REGIONS];
+};
+typedef struct GLNVGstream GLNVGstream;
+#endif
+
+#if NANOVG_GL_USE_PRIMITIVES
+// A primitive as a rounded box in its own frame, a line is a box along its direction
+struct GLNVGinstance {
+	float shape[4];			// Center and half size in local space
+	float axis[4];			// Direction of the box x axis, radius, border
+	float fillColor[4];		// Premultiplied
+	float borderColor[4];
+	float xform[8];			// Local to view transform, feather and the pixel size in local space
+};
+typedef struct GLNVGinstance GLNVGinstance;
+#define GLNVG_INSTANCE_ATTRIBS 6
+#endif
+
+// Per frame buffers
+struct GLNVGframe {
+	NVGarena* arena;		// Calls, paths, vertices, uniforms and instances, reset when the frame is emptied
+	GLNVGcall* calls;
+	int ccalls;
+	int ncalls;
+	GLNVGpath* paths;
+	int cpaths;
+	int npaths;
+	struct NVGvertex* verts;
+	int cverts;
+	int nverts;
+	unsigned char* uniforms;
+	int cuniforms;
+	int nuniforms;
+	GLNVGtextureOp* texops;
+	int ctexops;
+	int ntexops;
+#if NANOVG_GL_USE_PRIMITIVES
+	GLNVGinstance* instances;
+	int cinstances;
+	int ninstances;
+#endif
+	float view[2];
+};
+typedef struct GLNVGframe GLNVGframe;
+
 struct GLNVGcontext {
 	GLNVGshader shader;
 	GLNVGtexture* textures;
-	float view[2];
 	int ntextures;
 	int ctextures;
 	int textureId;
@@ -245,19 +432,67 @@ struct GLNVGcontext {
 	int fragSize;
 	int flags;
 
-	// Per frame buffers
-	GLNVGcall* calls;
-	int ccalls;
-	int ncalls;
-	GLNVGpath* paths;
-	int cpaths;
-	int npaths;
-	struct NVGvertex* verts;
-	int cverts;
-	int nverts;
-	unsigned char* uniforms;
-	int cuniforms;
-	int nuniforms;
+	// The recording frame
+	GLNVGframe frame;
+
+	// Deferred mode, texture names used by the GL thread
+	int deferred;
+	GLNVGtextureName* names;
+	int nnames;
+	int cnames;
+
+	// Draw call merging, the buffers are used by the thread drawing
+	int merge;
+	int mergeSize;
+	GLNVGbatch* batches;
+	int nbatches;
+	int cbatches;
+#if NANOVG_GL_USE_MERGE
+	GLuint slotBuf;
+	GLuint indexBuf;
+	GLuint* indices;
+	int nindices;
+	int cindices;
+	float* slots;
+	int cslots;
+	float* mergeUniforms;
+#endif
+
+	// Stats of the last rendered frame
+	int statCalls;
+	int statMerged;
+
+#if NANOVG_GL_USE_PRIMITIVES
+	GLNVGshader primShader;
+	GLuint primArr;
+	GLuint instanceBuf;
+	float primView[2];	// The view size of the bound target
+#endif
+
+#if NANOVG_GL_USE_TARGETS
+	// The layer bound on the thread drawing, the frame target is saved while a layer is bound
+	int target;
+	int targetFailed;
+	GLint defaultFBO;
+	GLint defaultViewport[4];
+#endif
+
+#if NANOVG_GL_USE_STREAM
+	// Streaming uploads, the recording frame writes vertices in place while streamVerts is set
+	int streamMode;
+	int nextStreamMode;
+	GLNVGbufferStorage bufferStorage;
+	GLNVGstream vertStream;
+	int streamVerts;
+	int streamBase;
+	struct NVGvertex* heapVerts;
+	int heapCverts;
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	GLNVGstream fragStream;
+	int fragAlign;
+#endif
+#endif
+	int fragBase;
 
 	// cached state
 	#if NANOVG_GL_USE_STATE_FILTER
@@ -273,6 +508,30 @@ typedef struct GLNVGcontext GLNVGcontext;
 
 static int glnvg__maxi(int a, int b) { return a > b ? a : b; }
 
+// Grows a buffer of the frame in its arena, the first count items are kept
+static void* glnvg__growFrameBuffer(GLNVGframe* frame, void* data, int* cdata, int count, int n, int min, int size)
+{
+	void* p;
+	int c;
+	if (frame->arena == NULL) {
+		frame->arena = nvgCreateArena(NANOVG_GL_ARENA_SIZE);
+		if (frame->arena == NULL) return NULL;
+	}
+	c = glnvg__maxi(n, min) + *cdata/2; // 1.5x Overallocate
+	p = nvgArenaGrow(frame->arena, data, count * size, c * size);
+	if (p == NULL) return NULL;
+	*cdata = c;
+	return p;
+}
+
+// Takes back the capacity of a buffer after the arena is reset
+static void* glnvg__reserveFrameBuffer(GLNVGframe* frame, int* cdata, int size)
+{
+	void* p = *cdata > 0 ? nvgArenaAlloc(frame->arena, *cdata * size) : NULL;
+	if (p == NULL) *cdata = 0;
+	return p;
+}
+
 #ifdef NANOVG_GLES2
 static unsigned int glnvg__nearestPow2(unsigned int num)
 {
@@ -381,11 +640,26 @@ static GLNVGtexture* glnvg__findTexture(GLNVGcontext* gl, int id)
 	return NULL;
 }
 
+#if NANOVG_GL_USE_TARGETS
+static void glnvg__deleteTargetGL(GLuint* fbo, GLuint* rbo)
+{
+	if (*fbo != 0)
+		glDeleteFramebuffers(1, fbo);
+	if (*rbo != 0)
+		glDeleteRenderbuffers(1, rbo);
+	*fbo = 0;
+	*rbo = 0;
+}
+#endif
+
 static int glnvg__deleteTexture(GLNVGcontext* gl, int id)
 {
 	int i;
 	for (i = 0; i < gl->ntextures; i++) {
 		if (gl->textures[i].id == id) {
+#if NANOVG_GL_USE_TARGETS
+			glnvg__deleteTargetGL(&gl->textures[i].fbo, &gl->textures[i].rbo);
+#endif
 			if (gl->textures[i].tex != 0 && (gl->textures[i].flags & NVG_IMAGE_NODELETE) == 0)
 				glDeleteTextures(1, &gl->textures[i].tex);
 			memset(&gl->textures[i], 0, sizeof(gl->textures[i]));
@@ -395,6 +669,70 @@ static int glnvg__deleteTexture(GLNVGcontext* gl, int id)
 	return 0;
 }
 
+static GLNVGtextureName* glnvg__allocTextureName(GLNVGcontext* gl)
+{
+	GLNVGtextureName* name = NULL;
+	int i;
+
+	for (i = 0; i < gl->nnames; i++) {
+		if (gl->names[i].id == 0) {
+			name = &gl->names[i];
+			break;
+		}
+	}
+	if (name == NULL) {
+		if (gl->nnames+1 > gl->cnames) {
+			GLNVGtextureName* names;
+			int cnames = glnvg__maxi(gl->nnames+1, 4) +  gl->cnames/2; // 1.5x Overallocate
+			names = (GLNVGtextureName*)realloc(gl->names, sizeof(GLNVGtextureName)*cnames);
+			if (names == NULL) return NULL;
+			gl->names = names;
+			gl->cnames = cnames;
+		}
+		name = &gl->names[gl->nnames++];
+	}
+
+	memset(name, 0, sizeof(*name));
+	return name;
+}
+
+static GLNVGtextureName* glnvg__findTextureName(GLNVGcontext* gl, int id)
+{
+	int i;
+	for (i = 0; i < gl->nnames; i++)
+		if (gl->names[i].id == id)
+			return &gl->names[i];
+	return NULL;
+}
+
+// Get the GL texture of image on the thread drawing
+static GLuint glnvg__textureName(GLNVGcontext* gl, int image)
+{
+	if (gl->deferred) {
+		GLNVGtextureName* name = glnvg__findTextureName(gl, image);
+		return name != NULL ? name->tex : 0;
+	} else {
+		GLNVGtexture* tex = glnvg__findTexture(gl, image);
+		return tex != NULL ? tex->tex : 0;
+	}
+}
+
+static GLNVGtextureOp* glnvg__allocTextureOp(GLNVGcontext* gl)
+{
+	GLNVGtextureOp* ret = NULL;
+	if (gl->frame.ntexops+1 > gl->frame.ctexops) {
+		GLNVGtextureOp* texops;
+		int ctexops = glnvg__maxi(gl->frame.ntexops+1, 16) + gl->frame.ctexops/2; // 1.5x Overallocate
+		texops = (GLNVGtextureOp*)realloc(gl->frame.texops, sizeof(GLNVGtextureOp) * ctexops);
+		if (texops == NULL) return NULL;
+		gl->frame.texops = texops;
+		gl->frame.ctexops = ctexops;
+	}
+	ret = &gl->frame.texops[gl->frame.ntexops++];
+	memset(ret, 0, sizeof(GLNVGtextureOp));
+	return ret;
+}
+
 static void glnvg__dumpShaderError(GLuint shader, const char* name, const char* type)
 {
 	GLchar str[512+1];
@@ -463,6 +801,14 @@ static int glnvg__createShader(GLNVGshader* shader, const char* name, const char
 
 	glBindAttribLocation(prog, 0, "vertex");
 	glBindAttribLocation(prog, 1, "tcoord");
+	glBindAttribLocation(prog, 2, "slot");
+	// Instance attributes of the primitive shader
+	glBindAttribLocation(prog, 0, "shape");
+	glBindAttribLocation(prog, 1, "axis");
+	glBindAttribLocation(prog, 2, "fillCol");
+	glBindAttribLocation(prog, 3, "borderCol");
+	glBindAttribLocation(prog, 4, "xform0");
+	glBindAttribLocation(prog, 5, "xform1");
 
 	glLinkProgram(prog);
 	glGetProgramiv(prog, GL_LINK_STATUS, &status);
@@ -500,10 +846,175 @@ static void glnvg__getUniforms(GLNVGshader* shader)
 #endif
 }
 
+#if NANOVG_GL_USE_STREAM
+static int glnvg__hasExtension(const char* name)
+{
+	GLint i, count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (i = 0; i < count; i++) {
+		const char* ext = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		if (ext != NULL && strcmp(ext, name) == 0)
+			return 1;
+	}
+	return 0;
+}
+
+static void glnvg__waitFence(GLsync* fence)
+{
+	if (*fence == NULL) return;
+	while (glClientWaitSync(*fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000) == GL_TIMEOUT_EXPIRED)
+		;
+	glDeleteSync(*fence);
+	*fence = NULL;
+}
+
+// Waits the GPU and releases the storage, a persistent buffer is recreated as a plain one
+static void glnvg__streamRelease(GLNVGstream* stream, GLuint* buf, GLenum target)
+{
+	int i;
+	for (i = 0; i < NANOVG_GL_STREAM_REGIONS; i++)
+		glnvg__waitFence(&stream->fences[i]);
+	if (stream->mapped != NULL) {
+		glBindBuffer(target, *buf);
+		glUnmapBuffer(target);
+		glBindBuffer(target, 0);
+		glDeleteBuffers(1, buf);
+		glGenBuffers(1, buf);
+	}
+	memset(stream, 0, sizeof(*stream));
+}
+
+static int glnvg__streamGrow(GLNVGcontext* gl, GLNVGstream* stream, GLuint* buf, GLenum target, int size, int align)
+{
+	GLbitfield flags = GL_MAP_WRITE_BIT | GLNVG_MAP_PERSISTENT_BIT | GLNVG_MAP_COHERENT_BIT;
+	size = glnvg__maxi(size + size/2, NANOVG_GL_STREAM_MIN_SIZE);
+	size = (size + align - 1) / align * align;
+
+	// Storage is immutable, the buffer is created again
+	glnvg__streamRelease(stream, buf, target);
+	glDeleteBuffers(1, buf);
+	glGenBuffers(1, buf);
+	glBindBuffer(target, *buf);
+	gl->bufferStorage(target, size * NANOVG_GL_STREAM_REGIONS, NULL, flags);
+	stream->mapped = (unsigned char*)glMapBufferRange(target, 0, size * NANOVG_GL_STREAM_REGIONS, flags);
+	glBindBuffer(target, 0);
+	if (stream->mapped == NULL) {
+		glnvg__checkError(gl, "stream map");
+		glDeleteBuffers(1, buf);
+		glGenBuffers(1, buf);
+		return 0;
+	}
+	stream->size = size;
+	return 1;
+}
+
+// Reserves size bytes to write at *ptr, returns the offset in the buffer or -1 on failure.
+// In persistent mode it takes the next region after the GPU is done with it.
+static int glnvg__streamReserve(GLNVGcontext* gl, GLNVGstream* stream, GLuint* buf, GLenum target, int size, int align, unsigned char** ptr)
+{
+	int offset;
+	if (gl->streamMode == NVGL_STREAM_PERSISTENT) {
+		if (size > stream->size && glnvg__streamGrow(gl, stream, buf, target, size, align) == 0) {
+			// Mapping failed, orphaning does not need the storage
+			gl->streamMode = gl->nextStreamMode = NVGL_STREAM_ORPHAN;
+			return glnvg__streamReserve(gl, stream, buf, target, size, align, ptr);
+		}
+		stream->region = (stream->region + 1) % NANOVG_GL_STREAM_REGIONS;
+		glnvg__waitFence(&stream->fences[stream->region]);
+		stream->pending = 1;
+		*ptr = stream->mapped + stream->region * stream->size;
+		return stream->region * stream->size;
+	}
+
+	offset = (stream->offset + align - 1) / align * align;
+	glBindBuffer(target, *buf);
+	if (offset + size > stream->size) {
+		// Orphan, the driver keeps the old storage while it is used
+		stream->size = glnvg__maxi(glnvg__maxi(size * 4, stream->size), NANOVG_GL_STREAM_MIN_SIZE);
+		glBufferData(target, stream->size, NULL, GL_STREAM_DRAW);
+		offset = 0;
+	}
+	*ptr = (unsigned char*)glMapBufferRange(target, offset, glnvg__maxi(size, 1),
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+	if (*ptr == NULL) {
+		glnvg__checkError(gl, "stream map range");
+		return -1;
+	}
+	stream->offset = offset + size;
+	return offset;
+}
+
+// Unmaps the range written in orphan mode, the buffer of target must be bound
+static void glnvg__streamCommit(GLNVGcontext* gl, GLenum target)
+{
+	if (gl->streamMode == NVGL_STREAM_ORPHAN)
+		glUnmapBuffer(target);
+}
+
+// Guards the region used by the frame, called after the draws
+static void glnvg__streamFence(GLNVGstream* stream)
+{
+	if (!stream->pending) return;
+	stream->fences[stream->region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	stream->pending = 0;
+}
+
+// Copies the vertices from the region to the heap, or drops them
+static void glnvg__endStreamVerts(GLNVGcontext* gl, int keep)
+{
+	NVGvertex* verts = gl->frame.verts;
+	if (!gl->streamVerts) return;
+	gl->streamVerts = 0;
+	gl->vertStream.pending = 0;
+	gl->frame.verts = gl->heapVerts;
+	gl->frame.cverts = gl->heapCverts;
+	gl->heapVerts = NULL;
+	gl->heapCverts = 0;
+	if (keep && gl->frame.nverts > 0) {
+		if (gl->frame.nverts > gl->frame.cverts) {
+			NVGvertex* heap = (NVGvertex*)glnvg__growFrameBuffer(&gl->frame, gl->frame.verts, &gl->frame.cverts, 0, gl->frame.nverts, 4096, sizeof(NVGvertex));
+			if (heap == NULL) {
+				gl->frame.nverts = 0;
+				return;
+			}
+			gl->frame.verts = heap;
+		}
+		memcpy(gl->frame.verts, verts, sizeof(NVGvertex) * gl->frame.nverts);
+	}
+}
+
+// The frame writes its vertices in place, the context is current when not deferred
+static void glnvg__beginStreamVerts(GLNVGcontext* gl)
+{
+	unsigned char* ptr = NULL;
+	int size = glnvg__maxi(gl->vertStream.size, NANOVG_GL_STREAM_MIN_SIZE);
+	int offset = glnvg__streamReserve(gl, &gl->vertStream, &gl->vertBuf, GL_ARRAY_BUFFER, size, sizeof(NVGvertex), &ptr);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	if (offset == -1 || gl->streamMode != NVGL_STREAM_PERSISTENT) return;
+	gl->streamVerts = 1;
+	gl->streamBase = offset;
+	gl->heapVerts = gl->frame.verts;
+	gl->heapCverts = gl->frame.cverts;
+	gl->frame.verts = (NVGvertex*)ptr;
+	gl->frame.cverts = gl->vertStream.size / sizeof(NVGvertex);
+}
+
+static void glnvg__applyStreamMode(GLNVGcontext* gl)
+{
+	if (gl->nextStreamMode == gl->streamMode) return;
+	glnvg__streamRelease(&gl->vertStream, &gl->vertBuf, GL_ARRAY_BUFFER);
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	glnvg__streamRelease(&gl->fragStream, &gl->fragBuf, GL_UNIFORM_BUFFER);
+#endif
+	gl->streamMode = gl->nextStreamMode;
+}
+#endif
+
 static int glnvg__renderCreate(void* uptr)
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
 	int align = 4;
+	char opts[64];
 
 	// TODO: mediump float may not be enough for GLES2 in iOS.
 	// see the following discussion: https://github.com/memononen/nanovg/issues/46
@@ -535,6 +1046,10 @@ static int glnvg__renderCreate(void* uptr)
 		"	in vec2 tcoord;\n"
 		"	out vec2 ftcoord;\n"
 		"	out vec2 fpos;\n"
+		"#ifdef MERGE_SIZE\n"
+		"	in float slot;\n"
+		"	flat out float fslot;\n"
+		"#endif\n"
 		"#else\n"
 		"	uniform vec2 viewSize;\n"
 		"	attribute vec2 vertex;\n"
@@ -545,6 +1060,9 @@ static int glnvg__renderCreate(void* uptr)
 		"void main(void) {\n"
 		"	ftcoord = tcoord;\n"
 		"	fpos = vertex;\n"
+		"#ifdef MERGE_SIZE\n"
+		"	fslot = slot;\n"
+		"#endif\n"
 		"	gl_Position = vec4(2.0*vertex.x/viewSize.x - 1.0, 1.0 - 2.0*vertex.y/viewSize.y, 0, 1);\n"
 		"}\n";
 
@@ -574,8 +1092,14 @@ static int glnvg__renderCreate(void* uptr)
 		"		int type;\n"
 		"	};\n"
 		"#else\n" // NANOVG_GL3 && !USE_UNIFORMBUFFER
+		"#ifdef MERGE_SIZE\n"
+		"	uniform vec4 frag[UNIFORMARRAY_SIZE*MERGE_SIZE];\n"
+		"	flat in float fslot;\n"
+		"	int ubase;\n"
+		"#else\n"
 		"	uniform vec4 frag[UNIFORMARRAY_SIZE];\n"
 		"#endif\n"
+		"#endif\n"
 		"	uniform sampler2D tex;\n"
 		"	in vec2 ftcoord;\n"
 		"	in vec2 fpos;\n"
@@ -587,19 +1111,24 @@ static int glnvg__renderCreate(void* uptr)
 		"	varying vec2 fpos;\n"
 		"#endif\n"
 		"#ifndef USE_UNIFORMBUFFER\n"
-		"	#define scissorMat mat3(frag[0].xyz, frag[1].xyz, frag[2].xyz)\n"
-		"	#define paintMat mat3(frag[3].xyz, frag[4].xyz, frag[5].xyz)\n"
-		"	#define innerCol frag[6]\n"
-		"	#define outerCol frag[7]\n"
-		"	#define scissorExt frag[8].xy\n"
-		"	#define scissorScale frag[8].zw\n"
-		"	#define extent frag[9].xy\n"
-		"	#define radius frag[9].z\n"
-		"	#define feather frag[9].w\n"
-		"	#define strokeMult frag[10].x\n"
-		"	#define strokeThr frag[10].y\n"
-		"	#define texType int(frag[10].z)\n"
-		"	#define type int(frag[10].w)\n"
+		"#ifdef MERGE_SIZE\n"
+		"	#define FRAG(i) frag[ubase+i]\n"
+		"#else\n"
+		"	#define FRAG(i) frag[i]\n"
+		"#endif\n"
+		"	#define scissorMat mat3(FRAG(0).xyz, FRAG(1).xyz, FRAG(2).xyz)\n"
+		"	#define paintMat mat3(FRAG(3).xyz, FRAG(4).xyz, FRAG(5).xyz)\n"
+		"	#define innerCol FRAG(6)\n"
+		"	#define outerCol FRAG(7)\n"
+		"	#define scissorExt FRAG(8).xy\n"
+		"	#define scissorScale FRAG(8).zw\n"
+		"	#define extent FRAG(9).xy\n"
+		"	#define radius FRAG(9).z\n"
+		"	#define feather FRAG(9).w\n"
+		"	#define strokeMult FRAG(10).x\n"
+		"	#define strokeThr FRAG(10).y\n"
+		"	#define texType int(FRAG(10).z)\n"
+		"	#define type int(FRAG(10).w)\n"
 		"#endif\n"
 		"\n"
 		"float sdroundrect(vec2 pt, vec2 ext, float rad) {\n"
@@ -623,6 +1152,9 @@ static int glnvg__renderCreate(void* uptr)
 		"\n"
 		"void main(void) {\n"
 		"   vec4 result;\n"
+		"#ifdef MERGE_SIZE\n"
+		"	ubase = int(fslot) * UNIFORMARRAY_SIZE;\n"
+		"#endif\n"
 		"	float scissor = scissorMask(fpos);\n"
 		"#ifdef EDGE_AA\n"
 		"	float strokeAlpha = strokeMask();\n"
@@ -662,7 +1194,13 @@ static int glnvg__renderCreate(void* uptr)
 		"		vec4 color = texture2D(tex, ftcoord);\n"
 		"#endif\n"
 		"		if (texType == 1) color = vec4(color.xyz*color.w,color.w);"
-		"		if (texType == 2) color = vec4(color.x);"
+		"		if (texType == 2) color = vec4(color.x);\n"
+		"#ifdef NANOVG_GL3\n"
+		"		if (texType == 3) {		// Distance field, the edge at 0.5 is smoothed over a pixel and the blur\n"
+		"			float w = max(fwidth(color.x), 1.0/1024.0) * (0.5 + feather);\n"
+		"			color = vec4(smoothstep(0.5 - w, 0.5 + w, color.x));\n"
+		"		}\n"
+		"#endif\n"
 		"		color *= scissor;\n"
 		"		result = color * innerCol;\n"
 		"	}\n"
@@ -673,24 +1211,145 @@ static int glnvg__renderCreate(void* uptr)
 		"#endif\n"
 		"}\n";
 
+#if NANOVG_GL_USE_PRIMITIVES
+	static const char* primVertShader =
+		"	uniform vec2 viewSize;\n"
+		"	in vec4 shape;\n"
+		"	in vec4 axis;\n"
+		"	in vec4 fillCol;\n"
+		"	in vec4 borderCol;\n"
+		"	in vec4 xform0;\n"
+		"	in vec4 xform1;\n"
+		"	out vec2 fpos;\n"
+		"	out vec2 flocal;\n"
+		"	flat out vec4 fshape;\n"
+		"	flat out float fedge;\n"
+		"	flat out vec4 ffill;\n"
+		"	flat out vec4 fborder;\n"
+		"void main(void) {\n"
+		"	// The quad covers the blurred edge and a pixel more for the anti-aliasing\n"
+		"	float width = max(xform1.z, xform1.w);\n"
+		"	vec2 corner = vec2(gl_VertexID < 2 ? 1.0 : -1.0, (gl_VertexID & 1) == 0 ? 1.0 : -1.0);\n"
+		"	vec2 local = corner * (shape.zw + vec2(width*0.5 + xform1.w));\n"
+		"	vec2 p = shape.xy + axis.xy * local.x + vec2(-axis.y, axis.x) * local.y;\n"
+		"	vec2 pos = vec2(xform0.x*p.x + xform0.z*p.y + xform1.x, xform0.y*p.x + xform0.w*p.y + xform1.y);\n"
+		"	fpos = pos;\n"
+		"	flocal = local;\n"
+		"	fshape = vec4(shape.zw, axis.zw);\n"
+		"	fedge = width;\n"
+		"	ffill = fillCol;\n"
+		"	fborder = borderCol;\n"
+		"	gl_Position = vec4(2.0*pos.x/viewSize.x - 1.0, 1.0 - 2.0*pos.y/viewSize.y, 0, 1);\n"
+		"}\n";
+
+	static const char* primFragShader =
+		"#ifdef GL_ES\n"
+		" precision highp float;\n"
+		"#endif\n"
+		"#ifdef USE_UNIFORMBUFFER\n"
+		"	layout(std140) uniform frag {\n"
+		"		mat3 scissorMat;\n"
+		"		mat3 paintMat;\n"
+		"		vec4 innerCol;\n"
+		"		vec4 outerCol;\n"
+		"		vec2 scissorExt;\n"
+		"		vec2 scissorScale;\n"
+		"	};\n"
+		"#else\n"
+		"	uniform vec4 frag[UNIFORMARRAY_SIZE];\n"
+		"	#define scissorMat mat3(frag[0].xyz, frag[1].xyz, frag[2].xyz)\n"
+		"	#define scissorExt frag[8].xy\n"
+		"	#define scissorScale frag[8].zw\n"
+		"#endif\n"
+		"	in vec2 fpos;\n"
+		"	in vec2 flocal;\n"
+		"	flat in vec4 fshape;\n"
+		"	flat in float fedge;\n"
+		"	flat in vec4 ffill;\n"
+		"	flat in vec4 fborder;\n"
+		"	out vec4 outColor;\n"
+		"\n"
+		"float sdroundrect(vec2 pt, vec2 ext, float rad) {\n"
+		"	vec2 ext2 = ext - vec2(rad,rad);\n"
+		"	vec2 d = abs(pt) - ext2;\n"
+		"	return min(max(d.x,d.y),0.0) + length(max(d,0.0)) - rad;\n"
+		"}\n"
+		"\n"
+		"float scissorMask(vec2 p) {\n"
+		"	vec2 sc = (abs((scissorMat * vec3(p,1.0)).xy) - scissorExt);\n"
+		"	sc = vec2(0.5,0.5) - sc * scissorScale;\n"
+		"	return clamp(sc.x,0.0,1.0) * clamp(sc.y,0.0,1.0);\n"
+		"}\n"
+		"\n"
+		"void main(void) {\n"
+		"	// Coverage ramps over the edge width centered on the outline, the border replaces the fill\n"
+		"	float d = sdroundrect(flocal, fshape.xy, fshape.z);\n"
+		"	float cover = clamp(0.5 - d/fedge, 0.0, 1.0);\n"
+		"	float inner = fshape.w > 0.0 ? clamp(0.5 - (d + fshape.w)/fedge, 0.0, 1.0) : 1.0;\n"
+		"	outColor = mix(fborder, ffill, inner) * (cover * scissorMask(fpos));\n"
+		"}\n";
+#endif
+
 	glnvg__checkError(gl, "init");
 
-	if (gl->flags & NVG_ANTIALIAS) {
-		if (glnvg__createShader(&gl->shader, "shader", shaderHeader, "#define EDGE_AA 1\n", fillVertShader, fillFragShader) == 0)
-			return 0;
-	} else {
-		if (glnvg__createShader(&gl->shader, "shader", shaderHeader, NULL, fillVertShader, fillFragShader) == 0)
-			return 0;
+	gl->mergeSize = 1;
+#if NANOVG_GL_USE_MERGE
+	{
+		// The merged uniforms share the fragment uniform vectors with the rest
+		GLint maxVectors = 0;
+		glGetIntegerv(GL_MAX_FRAGMENT_UNIFORM_VECTORS, &maxVectors);
+		gl->mergeSize = (maxVectors - 16) / NANOVG_GL_UNIFORMARRAY_SIZE;
+		if (gl->mergeSize > NANOVG_GL_MERGE_MAX) gl->mergeSize = NANOVG_GL_MERGE_MAX;
+		if (gl->mergeSize < 2) gl->mergeSize = 1;
 	}
+#endif
+	gl->merge = gl->mergeSize > 1;
+
+	opts[0] = '\0';
+	if (gl->flags & NVG_ANTIALIAS)
+		strcat(opts, "#define EDGE_AA 1\n");
+	if (gl->mergeSize > 1)
+		sprintf(opts + strlen(opts), "#define MERGE_SIZE %d\n", gl->mergeSize);
+	if (glnvg__createShader(&gl->shader, "shader", shaderHeader, opts, fillVertShader, fillFragShader) == 0)
+		return 0;
 
 	glnvg__checkError(gl, "uniform locations");
 	glnvg__getUniforms(&gl->shader);
 
+#if NANOVG_GL_USE_PRIMITIVES
+	if (glnvg__createShader(&gl->primShader, "primitive", shaderHeader, NULL, primVertShader, primFragShader) == 0)
+		return 0;
+	glnvg__getUniforms(&gl->primShader);
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	glUniformBlockBinding(gl->primShader.prog, gl->primShader.loc[GLNVG_LOC_FRAG], GLNVG_FRAG_BINDING);
+#endif
+	{
+		// The attributes step per instance, the pointers are set per call
+		int i;
+		glGenBuffers(1, &gl->instanceBuf);
+		glGenVertexArrays(1, &gl->primArr);
+		glBindVertexArray(gl->primArr);
+		for (i = 0; i < GLNVG_INSTANCE_ATTRIBS; i++) {
+			glEnableVertexAttribArray(i);
+			glVertexAttribDivisor(i, 1);
+		}
+		glBindVertexArray(0);
+	}
+#endif
+
 	// Create dynamic vertex array
 #if defined NANOVG_GL3
 	glGenVertexArrays(1, &gl->vertArr);
 #endif
 	glGenBuffers(1, &gl->vertBuf);
+#if NANOVG_GL_USE_MERGE
+	if (gl->mergeSize > 1) {
+		glGenBuffers(1, &gl->slotBuf);
+		glGenBuffers(1, &gl->indexBuf);
+		gl->mergeUniforms = (float*)malloc(sizeof(float) * 4 * NANOVG_GL_UNIFORMARRAY_SIZE * gl->mergeSize);
+		if (gl->mergeUniforms == NULL) return 0;
+	}
+#endif
 
 #if NANOVG_GL_USE_UNIFORMBUFFER
 	// Create UBOs
@@ -700,6 +1359,21 @@ static int glnvg__renderCreate(void* uptr)
 #endif
 	gl->fragSize = sizeof(GLNVGfragUniforms) + align - sizeof(GLNVGfragUniforms) % align;
 
+#if NANOVG_GL_USE_STREAM
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	gl->fragAlign = align;
+#endif
+#if defined NANOVG_GLES3
+	if (glnvg__hasExtension("GL_EXT_buffer_storage"))
+		gl->bufferStorage = (GLNVGbufferStorage)eglGetProcAddress("glBufferStorageEXT");
+#else
+	if (glnvg__hasExtension("GL_ARB_buffer_storage"))
+		gl->bufferStorage = glBufferStorage;
+#endif
+	gl->streamMode = gl->bufferStorage != NULL ? NVGL_STREAM_PERSISTENT : NVGL_STREAM_ORPHAN;
+	gl->nextStreamMode = gl->streamMode;
+#endif
+
 	glnvg__checkError(gl, "create done");
 
 	glFinish();
@@ -707,39 +1381,16 @@ static int glnvg__renderCreate(void* uptr)
 	return 1;
 }
 
-static int glnvg__renderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+static GLuint glnvg__createTextureGL(GLNVGcontext* gl, int type, int w, int h, int imageFlags, const unsigned char* data)
 {
-	GLNVGcontext* gl = (GLNVGcontext*)uptr;
-	GLNVGtexture* tex = glnvg__allocTexture(gl);
+	GLuint texName = 0;
 
-	if (tex == NULL) return 0;
-
-#ifdef NANOVG_GLES2
-	// Check for non-power of 2.
-	if (glnvg__nearestPow2(w) != (unsigned int)w || glnvg__nearestPow2(h) != (unsigned int)h) {
-		// No repeat
-		if ((imageFlags & NVG_IMAGE_REPEATX) != 0 || (imageFlags & NVG_IMAGE_REPEATY) != 0) {
-			printf("Repeat X/Y is not supported for non power-of-two textures (%d x %d)\n", w, h);
-			imageFlags &= ~(NVG_IMAGE_REPEATX | NVG_IMAGE_REPEATY);
-		}
-		// No mips.
-		if (imageFlags & NVG_IMAGE_GENERATE_MIPMAPS) {
-			printf("Mip-maps is not support for non power-of-two textures (%d x %d)\n", w, h);
-			imageFlags &= ~NVG_IMAGE_GENERATE_MIPMAPS;
-		}
-	}
-#endif
-
-	glGenTextures(1, &tex->tex);
-	tex->width = w;
-	tex->height = h;
-	tex->type = type;
-	tex->flags = imageFlags;
-	glnvg__bindTexture(gl, tex->tex);
+	glGenTextures(1, &texName);
+	glnvg__bindTexture(gl, texName);
 
 	glPixelStorei(GL_UNPACK_ALIGNMENT,1);
 #ifndef NANOVG_GLES2
-	glPixelStorei(GL_UNPACK_ROW_LENGTH, tex->width);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, w);
 	glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
 	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
 #endif
@@ -809,6 +1460,100 @@ static int glnvg__renderCreateTexture(void* uptr, int type, int w, int h, int im
 	glnvg__checkError(gl, "create tex");
 	glnvg__bindTexture(gl, 0);
 
+	return texName;
+}
+
+#if NANOVG_GL_USE_TARGETS
+// Attach the texture and a stencil buffer to a new framebuffer
+static int glnvg__createTargetGL(GLNVGcontext* gl, GLuint texName, int w, int h, GLuint* fbo, GLuint* rbo)
+{
+	GLint defaultFBO, defaultRBO;
+	int complete;
+
+	glGetIntegerv(GL_FRAMEBUFFER_BINDING, &defaultFBO);
+	glGetIntegerv(GL_RENDERBUFFER_BINDING, &defaultRBO);
+
+	glGenFramebuffers(1, fbo);
+	glBindFramebuffer(GL_FRAMEBUFFER, *fbo);
+	glGenRenderbuffers(1, rbo);
+	glBindRenderbuffer(GL_RENDERBUFFER, *rbo);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_STENCIL_INDEX8, w, h);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texName, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, *rbo);
+	complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+#ifdef GL_DEPTH24_STENCIL8
+	if (!complete) {
+		// Some drivers need a depth buffer along with the stencil
+		glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, w, h);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_STENCIL_ATTACHMENT, GL_RENDERBUFFER, *rbo);
+		complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+	}
+#endif
+
+	glBindFramebuffer(GL_FRAMEBUFFER, defaultFBO);
+	glBindRenderbuffer(GL_RENDERBUFFER, defaultRBO);
+	if (!complete)
+		glnvg__deleteTargetGL(fbo, rbo);
+	glnvg__checkError(gl, "create target");
+	return complete;
+}
+#endif
+
+static int glnvg__renderCreateTexture(void* uptr, int type, int w, int h, int imageFlags, const unsigned char* data)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+	GLNVGtexture* tex = glnvg__allocTexture(gl);
+
+	if (tex == NULL) return 0;
+
+#ifdef NANOVG_GLES2
+	// Check for non-power of 2.
+	if (glnvg__nearestPow2(w) != (unsigned int)w || glnvg__nearestPow2(h) != (unsigned int)h) {
+		// No repeat
+		if ((imageFlags & NVG_IMAGE_REPEATX) != 0 || (imageFlags & NVG_IMAGE_REPEATY) != 0) {
+			printf("Repeat X/Y is not supported for non power-of-two textures (%d x %d)\n", w, h);
+			imageFlags &= ~(NVG_IMAGE_REPEATX | NVG_IMAGE_REPEATY);
+		}
+		// No mips.
+		if (imageFlags & NVG_IMAGE_GENERATE_MIPMAPS) {
+			printf("Mip-maps is not support for non power-of-two textures (%d x %d)\n", w, h);
+			imageFlags &= ~NVG_IMAGE_GENERATE_MIPMAPS;
+		}
+	}
+#endif
+
+	tex->width = w;
+	tex->height = h;
+	tex->type = type;
+	tex->flags = imageFlags;
+
+	if (gl->deferred) {
+		GLNVGtextureOp* op = glnvg__allocTextureOp(gl);
+		if (op == NULL) {
+			memset(tex, 0, sizeof(*tex));
+			return 0;
+		}
+		op->op = GLNVG_TEXOP_CREATE;
+		op->image = tex->id;
+		op->type = type;
+		op->flags = imageFlags;
+		op->w = w;
+		op->h = h;
+		if (data != NULL) {
+			size_t size = (size_t)w * h * (type == NVG_TEXTURE_RGBA ? 4 : 1);
+			op->data = (unsigned char*)malloc(size);
+			if (op->data != NULL) memcpy(op->data, data, size);
+		}
+		return tex->id;
+	}
+
+	tex->tex = glnvg__createTextureGL(gl, type, w, h, imageFlags, data);
+#if NANOVG_GL_USE_TARGETS
+	if ((imageFlags & NVG_IMAGE_RENDER_TARGET) && !glnvg__createTargetGL(gl, tex->tex, w, h, &tex->fbo, &tex->rbo)) {
+		glnvg__deleteTexture(gl, tex->id);
+		return 0;
+	}
+#endif
 	return tex->id;
 }
 
@@ -816,40 +1561,44 @@ static int glnvg__renderCreateTexture(void* uptr, int type, int w, int h, int im
 static int glnvg__renderDeleteTexture(void* uptr, int image)
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+	if (gl->deferred) {
+		GLNVGtexture* tex = glnvg__findTexture(gl, image);
+		GLNVGtextureOp* op;
+		if (tex == NULL) return 0;
+		op = glnvg__allocTextureOp(gl);
+		if (op == NULL) return 0;
+		op->op = GLNVG_TEXOP_DELETE;
+		op->image = image;
+		memset(tex, 0, sizeof(*tex));
+		return 1;
+	}
 	return glnvg__deleteTexture(gl, image);
 }
 
-static int glnvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+// Upload the rows from y to y+h, rows points to the row y of a full width image
+static void glnvg__updateTextureGL(GLNVGcontext* gl, GLuint texName, int type, int width, int x, int y, int w, int h, const unsigned char* rows)
 {
-	GLNVGcontext* gl = (GLNVGcontext*)uptr;
-	GLNVGtexture* tex = glnvg__findTexture(gl, image);
-
-	if (tex == NULL) return 0;
-	glnvg__bindTexture(gl, tex->tex);
+	glnvg__bindTexture(gl, texName);
 
 	glPixelStorei(GL_UNPACK_ALIGNMENT,1);
 
 #ifndef NANOVG_GLES2
-	glPixelStorei(GL_UNPACK_ROW_LENGTH, tex->width);
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
 	glPixelStorei(GL_UNPACK_SKIP_PIXELS, x);
-	glPixelStorei(GL_UNPACK_SKIP_ROWS, y);
+	glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
 #else
 	// No support for all of skip, need to update a whole row at a time.
-	if (tex->type == NVG_TEXTURE_RGBA)
-		data += y*tex->width*4;
-	else
-		data += y*tex->width;
 	x = 0;
-	w = tex->width;
+	w = width;
 #endif
 
-	if (tex->type == NVG_TEXTURE_RGBA)
-		glTexSubImage2D(GL_TEXTURE_2D, 0, x,y, w,h, GL_RGBA, GL_UNSIGNED_BYTE, data);
+	if (type == NVG_TEXTURE_RGBA)
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x,y, w,h, GL_RGBA, GL_UNSIGNED_BYTE, rows);
 	else
 #if defined(NANOVG_GLES2) || defined(NANOVG_GL2)
-		glTexSubImage2D(GL_TEXTURE_2D, 0, x,y, w,h, GL_LUMINANCE, GL_UNSIGNED_BYTE, data);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x,y, w,h, GL_LUMINANCE, GL_UNSIGNED_BYTE, rows);
 #else
-		glTexSubImage2D(GL_TEXTURE_2D, 0, x,y, w,h, GL_RED, GL_UNSIGNED_BYTE, data);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x,y, w,h, GL_RED, GL_UNSIGNED_BYTE, rows);
 #endif
 
 	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
@@ -860,10 +1609,93 @@ static int glnvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w
 #endif
 
 	glnvg__bindTexture(gl, 0);
+}
+
+static int glnvg__renderUpdateTexture(void* uptr, int image, int x, int y, int w, int h, const unsigned char* data)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+	GLNVGtexture* tex = glnvg__findTexture(gl, image);
+	size_t rowSize;
+
+	if (tex == NULL) return 0;
+	rowSize = (size_t)tex->width * (tex->type == NVG_TEXTURE_RGBA ? 4 : 1);
+
+	if (gl->deferred) {
+		GLNVGtextureOp* op = glnvg__allocTextureOp(gl);
+		if (op == NULL) return 0;
+		op->op = GLNVG_TEXOP_UPDATE;
+		op->image = image;
+		op->type = tex->type;
+		op->width = tex->width;
+		op->x = x;
+		op->y = y;
+		op->w = w;
+		op->h = h;
+		op->data = (unsigned char*)malloc(rowSize * h);
+		if (op->data == NULL) {
+			gl->frame.ntexops--;
+			return 0;
+		}
+		memcpy(op->data, data + rowSize * y, rowSize * h);
+		return 1;
+	}
 
+	glnvg__updateTextureGL(gl, tex->tex, tex->type, tex->width, x, y, w, h, data + rowSize * y);
 	return 1;
 }
 
+// Execute the deferred texture commands of frame on the GL thread
+static void glnvg__runTextureOps(GLNVGcontext* gl, GLNVGframe* frame)
+{
+	int i;
+	for (i = 0; i < frame->ntexops; i++) {
+		GLNVGtextureOp* op = &frame->texops[i];
+		GLNVGtextureName* name = NULL;
+		switch (op->op) {
+		case GLNVG_TEXOP_CREATE:
+			name = glnvg__allocTextureName(gl);
+			if (name == NULL) break;
+			name->id = op->image;
+			name->flags = op->flags;
+			name->width = op->w;
+			name->height = op->h;
+			name->tex = glnvg__createTextureGL(gl, op->type, op->w, op->h, op->flags, op->data);
+#if NANOVG_GL_USE_TARGETS
+			// A failed target is skipped when drawn
+			if (op->flags & NVG_IMAGE_RENDER_TARGET)
+				glnvg__createTargetGL(gl, name->tex, op->w, op->h, &name->fbo, &name->rbo);
+#endif
+			break;
+		case GLNVG_TEXOP_HANDLE:
+			name = glnvg__allocTextureName(gl);
+			if (name == NULL) break;
+			name->id = op->image;
+			name->flags = op->flags;
+			name->tex = op->handle;
+			break;
+		case GLNVG_TEXOP_UPDATE:
+			name = glnvg__findTextureName(gl, op->image);
+			if (name != NULL)
+				glnvg__updateTextureGL(gl, name->tex, op->type, op->width, op->x, op->y, op->w, op->h, op->data);
+			break;
+		case GLNVG_TEXOP_DELETE:
+			name = glnvg__findTextureName(gl, op->image);
+			if (name != NULL) {
+#if NANOVG_GL_USE_TARGETS
+				glnvg__deleteTargetGL(&name->fbo, &name->rbo);
+#endif
+				if (name->tex != 0 && (name->flags & NVG_IMAGE_NODELETE) == 0)
+					glDeleteTextures(1, &name->tex);
+				memset(name, 0, sizeof(*name));
+			}
+			break;
+		}
+		free(op->data);
+		op->data = NULL;
+	}
+	frame->ntexops = 0;
+}
+
 static int glnvg__renderGetTextureSize(void* uptr, int image, int* w, int* h)
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
@@ -969,20 +1801,18 @@ static int glnvg__convertPaint(GLNVGcontext* gl, GLNVGfragUniforms* frag, NVGpai
 	return 1;
 }
 
-static GLNVGfragUniforms* nvg__fragUniformPtr(GLNVGcontext* gl, int i);
-
-static void glnvg__setUniforms(GLNVGcontext* gl, int uniformOffset, int image)
+static void glnvg__setUniforms(GLNVGcontext* gl, GLNVGframe* frame, int uniformOffset, int image)
 {
 #if NANOVG_GL_USE_UNIFORMBUFFER
-	glBindBufferRange(GL_UNIFORM_BUFFER, GLNVG_FRAG_BINDING, gl->fragBuf, uniformOffset, sizeof(GLNVGfragUniforms));
+	NVG_NOTUSED(frame);
+	glBindBufferRange(GL_UNIFORM_BUFFER, GLNVG_FRAG_BINDING, gl->fragBuf, gl->fragBase + uniformOffset, sizeof(GLNVGfragUniforms));
 #else
-	GLNVGfragUniforms* frag = nvg__fragUniformPtr(gl, uniformOffset);
+	GLNVGfragUniforms* frag = (GLNVGfragUniforms*)&frame->uniforms[uniformOffset];
 	glUniform4fv(gl->shader.loc[GLNVG_LOC_FRAG], NANOVG_GL_UNIFORMARRAY_SIZE, &(frag->uniformArray[0][0]));
 #endif
 
 	if (image != 0) {
-		GLNVGtexture* tex = glnvg__findTexture(gl, image);
-		glnvg__bindTexture(gl, tex != NULL ? tex->tex : 0);
+		glnvg__bindTexture(gl, glnvg__textureName(gl, image));
 		glnvg__checkError(gl, "tex paint tex");
 	} else {
 		glnvg__bindTexture(gl, 0);
@@ -993,13 +1823,13 @@ static void glnvg__renderViewport(void* uptr, float width, float height, float d
 {
 	NVG_NOTUSED(devicePixelRatio);
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
-	gl->view[0] = width;
-	gl->view[1] = height;
+	gl->frame.view[0] = width;
+	gl->frame.view[1] = height;
 }
 
-static void glnvg__fill(GLNVGcontext* gl, GLNVGcall* call)
+static void glnvg__fill(GLNVGcontext* gl, GLNVGframe* frame, GLNVGcall* call)
 {
-	GLNVGpath* paths = &gl->paths[call->pathOffset];
+	GLNVGpath* paths = &frame->paths[call->pathOffset];
 	int i, npaths = call->pathCount;
 
 	// Draw shapes
@@ -1009,7 +1839,7 @@ static void glnvg__fill(GLNVGcontext* gl, GLNVGcall* call)
 	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
 
 	// set bindpoint for solid loc
-	glnvg__setUniforms(gl, call->uniformOffset, 0);
+	glnvg__setUniforms(gl, frame, call->uniformOffset, 0);
 	glnvg__checkError(gl, "fill simple");
 
 	glStencilOpSeparate(GL_FRONT, GL_KEEP, GL_KEEP, GL_INCR_WRAP);
@@ -1022,7 +1852,7 @@ static void glnvg__fill(GLNVGcontext* gl, GLNVGcall* call)
 	// Draw anti-aliased pixels
 	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
 
-	glnvg__setUniforms(gl, call->uniformOffset + gl->fragSize, call->image);
+	glnvg__setUniforms(gl, frame, call->uniformOffset + gl->fragSize, call->image);
 	glnvg__checkError(gl, "fill fill");
 
 	if (gl->flags & NVG_ANTIALIAS) {
@@ -1041,12 +1871,12 @@ static void glnvg__fill(GLNVGcontext* gl, GLNVGcall* call)
 	glDisable(GL_STENCIL_TEST);
 }
 
-static void glnvg__convexFill(GLNVGcontext* gl, GLNVGcall* call)
+static void glnvg__convexFill(GLNVGcontext* gl, GLNVGframe* frame, GLNVGcall* call)
 {
-	GLNVGpath* paths = &gl->paths[call->pathOffset];
+	GLNVGpath* paths = &frame->paths[call->pathOffset];
 	int i, npaths = call->pathCount;
 
-	glnvg__setUniforms(gl, call->uniformOffset, call->image);
+	glnvg__setUniforms(gl, frame, call->uniformOffset, call->image);
 	glnvg__checkError(gl, "convex fill");
 
 	for (i = 0; i < npaths; i++) {
@@ -1058,9 +1888,9 @@ static void glnvg__convexFill(GLNVGcontext* gl, GLNVGcall* call)
 	}
 }
 
-static void glnvg__stroke(GLNVGcontext* gl, GLNVGcall* call)
+static void glnvg__stroke(GLNVGcontext* gl, GLNVGframe* frame, GLNVGcall* call)
 {
-	GLNVGpath* paths = &gl->paths[call->pathOffset];
+	GLNVGpath* paths = &frame->paths[call->pathOffset];
 	int npaths = call->pathCount, i;
 
 	if (gl->flags & NVG_STENCIL_STROKES) {
@@ -1071,13 +1901,13 @@ static void glnvg__stroke(GLNVGcontext* gl, GLNVGcall* call)
 		// Fill the stroke base without overlap
 		glnvg__stencilFunc(gl, GL_EQUAL, 0x0, 0xff);
 		glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
-		glnvg__setUniforms(gl, call->uniformOffset + gl->fragSize, call->image);
+		glnvg__setUniforms(gl, frame, call->uniformOffset + gl->fragSize, call->image);
 		glnvg__checkError(gl, "stroke fill 0");
 		for (i = 0; i < npaths; i++)
 			glDrawArrays(GL_TRIANGLE_STRIP, paths[i].strokeOffset, paths[i].strokeCount);
 
 		// Draw anti-aliased pixels.
-		glnvg__setUniforms(gl, call->uniformOffset, call->image);
+		glnvg__setUniforms(gl, frame, call->uniformOffset, call->image);
 		glnvg__stencilFunc(gl, GL_EQUAL, 0x00, 0xff);
 		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
 		for (i = 0; i < npaths; i++)
@@ -1097,7 +1927,7 @@ static void glnvg__stroke(GLNVGcontext* gl, GLNVGcall* call)
 //		glnvg__convertPaint(gl, nvg__fragUniformPtr(gl, call->uniformOffset + gl->fragSize), paint, scissor, strokeWidth, fringe, 1.0f - 0.5f/255.0f);
 
 	} else {
-		glnvg__setUniforms(gl, call->uniformOffset, call->image);
+		glnvg__setUniforms(gl, frame, call->uniformOffset, call->image);
 		glnvg__checkError(gl, "stroke fill");
 		// Draw Strokes
 		for (i = 0; i < npaths; i++)
@@ -1105,20 +1935,41 @@ static void glnvg__stroke(GLNVGcontext* gl, GLNVGcall* call)
 	}
 }
 
-static void glnvg__triangles(GLNVGcontext* gl, GLNVGcall* call)
+static void glnvg__triangles(GLNVGcontext* gl, GLNVGframe* frame, GLNVGcall* call)
 {
-	glnvg__setUniforms(gl, call->uniformOffset, call->image);
+	glnvg__setUniforms(gl, frame, call->uniformOffset, call->image);
 	glnvg__checkError(gl, "triangles fill");
 
 	glDrawArrays(GL_TRIANGLES, call->triangleOffset, call->triangleCount);
 }
 
+// Empties the frame for recording, the buffers take back their capacity in the reset arena
+static void glnvg__resetFrame(GLNVGcontext* gl, GLNVGframe* frame)
+{
+	frame->nverts = 0;
+	frame->npaths = 0;
+	frame->ncalls = 0;
+	frame->nuniforms = 0;
+#if NANOVG_GL_USE_PRIMITIVES
+	frame->ninstances = 0;
+#endif
+	if (frame->arena == NULL) return;
+	nvgResetArena(frame->arena);
+	frame->calls = (GLNVGcall*)glnvg__reserveFrameBuffer(frame, &frame->ccalls, sizeof(GLNVGcall));
+	frame->paths = (GLNVGpath*)glnvg__reserveFrameBuffer(frame, &frame->cpaths, sizeof(GLNVGpath));
+	frame->verts = (NVGvertex*)glnvg__reserveFrameBuffer(frame, &frame->cverts, sizeof(NVGvertex));
+	frame->uniforms = (unsigned char*)glnvg__reserveFrameBuffer(frame, &frame->cuniforms, gl->fragSize);
+#if NANOVG_GL_USE_PRIMITIVES
+	frame->instances = (GLNVGinstance*)glnvg__reserveFrameBuffer(frame, &frame->cinstances, sizeof(GLNVGinstance));
+#endif
+}
+
 static void glnvg__renderCancel(void* uptr) {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
-	gl->nverts = 0;
-	gl->npaths = 0;
-	gl->ncalls = 0;
-	gl->nuniforms = 0;
+#if NANOVG_GL_USE_STREAM
+	glnvg__endStreamVerts(gl, 0);
+#endif
+	glnvg__resetFrame(gl, &gl->frame);
 }
 
 static GLenum glnvg_convertBlendFuncFactor(int factor)
@@ -1165,12 +2016,370 @@ static GLNVGblend glnvg__blendCompositeOperation(NVGcompositeOperationState op)
 	return blend;
 }
 
-static void glnvg__renderFlush(void* uptr)
+static GLNVGbatch* glnvg__allocBatch(GLNVGcontext* gl)
 {
-	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+	GLNVGbatch* ret = NULL;
+	if (gl->nbatches+1 > gl->cbatches) {
+		GLNVGbatch* batches;
+		int cbatches = glnvg__maxi(gl->nbatches+1, 128) + gl->cbatches/2; // 1.5x Overallocate
+		batches = (GLNVGbatch*)realloc(gl->batches, sizeof(GLNVGbatch) * cbatches);
+		if (batches == NULL) return NULL;
+		gl->batches = batches;
+		gl->cbatches = cbatches;
+	}
+	ret = &gl->batches[gl->nbatches++];
+	memset(ret, 0, sizeof(GLNVGbatch));
+	return ret;
+}
+
+// Convex fills, strokes and triangles draw with the same state, stencil strokes
+// only with each other. Stencil fills are never merged.
+static int glnvg__mergeKind(GLNVGcontext* gl, const GLNVGcall* call)
+{
+	if (call->type == GLNVG_CONVEXFILL || call->type == GLNVG_TRIANGLES)
+		return 1;
+	if (call->type == GLNVG_STROKE)
+		return (gl->flags & NVG_STENCIL_STROKES) ? 2 : 1;
+	return 0;
+}
+
+static int glnvg__canMerge(GLNVGcontext* gl, GLNVGframe* frame, const GLNVGbatch* batch, const GLNVGcall* call)
+{
+	const GLNVGcall* first = &frame->calls[batch->call];
+	int i, kind = glnvg__mergeKind(gl, call);
+
+	if (kind == 0 || kind != glnvg__mergeKind(gl, first) || batch->ncalls >= gl->mergeSize)
+		return 0;
+	if (memcmp(&call->blendFunc, &first->blendFunc, sizeof(GLNVGblend)) != 0)
+		return 0;
+	// Calls without image can share the texture, unless it has mipmaps as the
+	// derivatives are not reliable where calls meet
+	if (call->image != batch->image) {
+		if (call->image != 0 && batch->image != 0)
+			return 0;
+		if ((call->imageFlags | batch->imageFlags) & NVG_IMAGE_GENERATE_MIPMAPS)
+			return 0;
+	}
+	// Stencil strokes draw each pixel once, the merged strokes must not overlap
+	if (kind == 2) {
+		for (i = batch->call; i < batch->call + batch->ncalls; i++) {
+			const float* b = frame->calls[i].bounds;
+			if (call->bounds[0] < b[2] && call->bounds[2] > b[0] &&
+				call->bounds[1] < b[3] && call->bounds[3] > b[1])
+				return 0;
+		}
+	}
+	return 1;
+}
+
+#if NANOVG_GL_USE_MERGE
+static int glnvg__allocIndices(GLNVGcontext* gl, int n)
+{
+	int ret = 0;
+	if (gl->nindices+n > gl->cindices) {
+		GLuint* indices;
+		int cindices = glnvg__maxi(gl->nindices + n, 4096) + gl->cindices/2; // 1.5x Overallocate
+		indices = (GLuint*)realloc(gl->indices, sizeof(GLuint) * cindices);
+		if (indices == NULL) return -1;
+		gl->indices = indices;
+		gl->cindices = cindices;
+	}
+	ret = gl->nindices;
+	gl->nindices += n;
+	return ret;
+}
+
+static int glnvg__triangleCount(int count)
+{
+	return count > 2 ? (count - 2) * 3 : 0;
+}
+
+static GLuint* glnvg__fanIndices(GLuint* dst, int offset, int count)
+{
+	int i;
+	for (i = 1; i+1 < count; i++) {
+		dst[0] = offset;
+		dst[1] = offset + i;
+		dst[2] = offset + i + 1;
+		dst += 3;
+	}
+	return dst;
+}
+
+// Odd triangles of a strip are flipped to keep the winding
+static GLuint* glnvg__stripIndices(GLuint* dst, int offset, int count)
+{
+	int i;
+	for (i = 0; i+2 < count; i++) {
+		dst[0] = offset + i + (i & 1);
+		dst[1] = offset + i + 1 - (i & 1);
+		dst[2] = offset + i + 2;
+		dst += 3;
+	}
+	return dst;
+}
+
+static void glnvg__setSlot(GLNVGcontext* gl, int offset, int count, float slot)
+{
+	int i;
+	for (i = 0; i < count; i++)
+		gl->slots[offset + i] = slot;
+}
+
+// Builds the triangle list of the batch, the vertices get the uniform slot of their call
+static int glnvg__mergeIndices(GLNVGcontext* gl, GLNVGframe* frame, GLNVGbatch* batch)
+{
+	int i, j, count = 0;
+	GLuint* dst;
+
+	for (i = batch->call; i < batch->call + batch->ncalls; i++) {
+		GLNVGcall* call = &frame->calls[i];
+		GLNVGpath* paths = &frame->paths[call->pathOffset];
+		if (call->type == GLNVG_TRIANGLES)
+			count += call->triangleCount;
+		for (j = 0; j < call->pathCount; j++) {
+			if (call->type == GLNVG_CONVEXFILL)
+				count += glnvg__triangleCount(paths[j].fillCount);
+			count += glnvg__triangleCount(paths[j].strokeCount);
+		}
+	}
+
+	batch->indexOffset = glnvg__allocIndices(gl, count);
+	if (batch->indexOffset == -1) return 0;
+	batch->indexCount = count;
+	dst = &gl->indices[batch->indexOffset];
+
+	for (i = batch->call; i < batch->call + batch->ncalls; i++) {
+		GLNVGcall* call = &frame->calls[i];
+		GLNVGpath* paths = &frame->paths[call->pathOffset];
+		float slot = (float)(i - batch->call);
+		if (call->type == GLNVG_TRIANGLES) {
+			for (j = 0; j < call->triangleCount; j++)
+				*dst++ = call->triangleOffset + j;
+			glnvg__setSlot(gl, call->triangleOffset, call->triangleCount, slot);
+		}
+		for (j = 0; j < call->pathCount; j++) {
+			if (call->type == GLNVG_CONVEXFILL) {
+				dst = glnvg__fanIndices(dst, paths[j].fillOffset, paths[j].fillCount);
+				glnvg__setSlot(gl, paths[j].fillOffset, paths[j].fillCount, slot);
+			}
+			dst = glnvg__stripIndices(dst, paths[j].strokeOffset, paths[j].strokeCount);
+			glnvg__setSlot(gl, paths[j].strokeOffset, paths[j].strokeCount, slot);
+		}
+	}
+	return 1;
+}
+#endif
+
+// Groups the calls into batches, returns the number of batches with merged calls
+static int glnvg__mergeCalls(GLNVGcontext* gl, GLNVGframe* frame)
+{
+	GLNVGbatch* batch = NULL;
+	int i, nmerged = 0;
+
+	gl->nbatches = 0;
+#if NANOVG_GL_USE_MERGE
+	gl->nindices = 0;
+	if (gl->merge && frame->nverts > gl->cslots) {
+		float* slots = (float*)realloc(gl->slots, sizeof(float) * frame->cverts);
+		if (slots == NULL) return 0;
+		gl->slots = slots;
+		gl->cslots = frame->cverts;
+	}
+#endif
+
+	for (i = 0; i < frame->ncalls; i++) {
+		GLNVGcall* call = &frame->calls[i];
+		if (gl->merge && batch != NULL && glnvg__canMerge(gl, frame, batch, call)) {
+			batch->ncalls++;
+			if (batch->image == 0) {
+				batch->image = call->image;
+				batch->imageFlags = call->imageFlags;
+			}
+			continue;
+		}
+		batch = glnvg__allocBatch(gl);
+		if (batch == NULL) return 0;
+		batch->call = i;
+		batch->ncalls = 1;
+		batch->image = call->image;
+		batch->imageFlags = call->imageFlags;
+	}
+
+#if NANOVG_GL_USE_MERGE
+	for (i = 0; i < gl->nbatches; i++) {
+		batch = &gl->batches[i];
+		if (batch->ncalls < 2) continue;
+		if (glnvg__mergeIndices(gl, frame, batch) == 0) {
+			// Out of memory, draw the calls one by one
+			batch->ncalls = 1;
+			continue;
+		}
+		nmerged++;
+	}
+#endif
+	return nmerged;
+}
+
+#if NANOVG_GL_USE_MERGE
+static void glnvg__setMergedUniforms(GLNVGcontext* gl, GLNVGframe* frame, GLNVGbatch* batch, int offset)
+{
+	int i, size = sizeof(float) * 4 * NANOVG_GL_UNIFORMARRAY_SIZE;
+	for (i = 0; i < batch->ncalls; i++) {
+		GLNVGcall* call = &frame->calls[batch->call + i];
+		memcpy(&gl->mergeUniforms[i * 4 * NANOVG_GL_UNIFORMARRAY_SIZE], &frame->uniforms[call->uniformOffset + offset], size);
+	}
+	glUniform4fv(gl->shader.loc[GLNVG_LOC_FRAG], NANOVG_GL_UNIFORMARRAY_SIZE * batch->ncalls, gl->mergeUniforms);
+
+	if (batch->image != 0) {
+		glnvg__bindTexture(gl, glnvg__textureName(gl, batch->image));
+		glnvg__checkError(gl, "merged tex paint tex");
+	} else {
+		glnvg__bindTexture(gl, 0);
+	}
+}
+
+static void glnvg__mergedDraw(GLNVGcontext* gl, GLNVGframe* frame, GLNVGbatch* batch)
+{
+	const GLvoid* indices = (const GLvoid*)(size_t)(batch->indexOffset * sizeof(GLuint));
+
+	glEnableVertexAttribArray(2);
+	if (glnvg__mergeKind(gl, &frame->calls[batch->call]) == 2) {
+		// Same passes as glnvg__stroke
+		glEnable(GL_STENCIL_TEST);
+		glnvg__stencilMask(gl, 0xff);
+
+		glnvg__stencilFunc(gl, GL_EQUAL, 0x0, 0xff);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_INCR);
+		glnvg__setMergedUniforms(gl, frame, batch, gl->fragSize);
+		glnvg__checkError(gl, "merged stroke fill 0");
+		glDrawElements(GL_TRIANGLES, batch->indexCount, GL_UNSIGNED_INT, indices);
+
+		glnvg__setMergedUniforms(gl, frame, batch, 0);
+		glnvg__stencilFunc(gl, GL_EQUAL, 0x00, 0xff);
+		glStencilOp(GL_KEEP, GL_KEEP, GL_KEEP);
+		glDrawElements(GL_TRIANGLES, batch->indexCount, GL_UNSIGNED_INT, indices);
+
+		glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+		glnvg__stencilFunc(gl, GL_ALWAYS, 0x0, 0xff);
+		glStencilOp(GL_ZERO, GL_ZERO, GL_ZERO);
+		glnvg__checkError(gl, "merged stroke fill 1");
+		glDrawElements(GL_TRIANGLES, batch->indexCount, GL_UNSIGNED_INT, indices);
+		glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+
+		glDisable(GL_STENCIL_TEST);
+	} else {
+		glnvg__setMergedUniforms(gl, frame, batch, 0);
+		glnvg__checkError(gl, "merged fill");
+		glDrawElements(GL_TRIANGLES, batch->indexCount, GL_UNSIGNED_INT, indices);
+	}
+	glDisableVertexAttribArray(2);
+}
+#endif
+
+#if NANOVG_GL_USE_PRIMITIVES
+static void glnvg__primitives(GLNVGcontext* gl, GLNVGframe* frame, GLNVGcall* call)
+{
+	size_t base = (size_t)call->triangleOffset * sizeof(GLNVGinstance);
 	int i;
 
-	if (gl->ncalls > 0) {
+	glUseProgram(gl->primShader.prog);
+	glUniform2fv(gl->primShader.loc[GLNVG_LOC_VIEWSIZE], 1, gl->primView);
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	glBindBufferRange(GL_UNIFORM_BUFFER, GLNVG_FRAG_BINDING, gl->fragBuf, gl->fragBase + call->uniformOffset, sizeof(GLNVGfragUniforms));
+#else
+	glUniform4fv(gl->primShader.loc[GLNVG_LOC_FRAG], NANOVG_GL_UNIFORMARRAY_SIZE,
+		&((GLNVGfragUniforms*)&frame->uniforms[call->uniformOffset])->uniformArray[0][0]);
+#endif
+	glBindVertexArray(gl->primArr);
+	glBindBuffer(GL_ARRAY_BUFFER, gl->instanceBuf);
+	for (i = 0; i < GLNVG_INSTANCE_ATTRIBS; i++)
+		glVertexAttribPointer(i, 4, GL_FLOAT, GL_FALSE, sizeof(GLNVGinstance), (const GLvoid*)(base + i*4*sizeof(float)));
+
+	// A mirrored transform flips the quads
+	glDisable(GL_CULL_FACE);
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, call->triangleCount);
+	glEnable(GL_CULL_FACE);
+
+	// Back to the path shader
+#if defined NANOVG_GL3
+	glBindVertexArray(gl->vertArr);
+#else
+	glBindVertexArray(0);
+#endif
+	glUseProgram(gl->shader.prog);
+}
+#endif
+
+#if NANOVG_GL_USE_TARGETS
+// Switch the framebuffer and the view size, the frame one is saved when leaving it
+static void glnvg__bindTarget(GLNVGcontext* gl, GLNVGframe* frame, const GLNVGcall* call)
+{
+	GLuint fbo = 0;
+	float view[2];
+
+	view[0] = frame->view[0];
+	view[1] = frame->view[1];
+	if (call->image != 0) {
+		if (gl->deferred) {
+			GLNVGtextureName* name = glnvg__findTextureName(gl, call->image);
+			if (name != NULL) {
+				fbo = name->fbo;
+				view[0] = (float)name->width;
+				view[1] = (float)name->height;
+			}
+		} else {
+			GLNVGtexture* tex = glnvg__findTexture(gl, call->image);
+			if (tex != NULL) {
+				fbo = tex->fbo;
+				view[0] = (float)tex->width;
+				view[1] = (float)tex->height;
+			}
+		}
+	}
+
+	if (gl->target == 0 && call->image != 0) {
+		glGetIntegerv(GL_FRAMEBUFFER_BINDING, &gl->defaultFBO);
+		glGetIntegerv(GL_VIEWPORT, gl->defaultViewport);
+	}
+	gl->target = call->image;
+	// The calls of a missing layer are skipped
+	gl->targetFailed = call->image != 0 && fbo == 0;
+	if (gl->targetFailed)
+		return;
+
+	if (call->image == 0) {
+		glBindFramebuffer(GL_FRAMEBUFFER, gl->defaultFBO);
+		glViewport(gl->defaultViewport[0], gl->defaultViewport[1], gl->defaultViewport[2], gl->defaultViewport[3]);
+	} else {
+		glBindFramebuffer(GL_FRAMEBUFFER, fbo);
+		glViewport(0, 0, (GLsizei)view[0], (GLsizei)view[1]);
+		if (call->triangleCount) {
+			glnvg__stencilMask(gl, 0xffffffff);
+			glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+			glClearStencil(0);
+			glClear(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
+		}
+	}
+	glUniform2fv(gl->shader.loc[GLNVG_LOC_VIEWSIZE], 1, view);
+#if NANOVG_GL_USE_PRIMITIVES
+	gl->primView[0] = view[0];
+	gl->primView[1] = view[1];
+#endif
+}
+#endif
+
+static void glnvg__renderFrame(GLNVGcontext* gl, GLNVGframe* frame)
+{
+	int i, vertBase;
+
+	SGE_GPU_PROFILE_BEGIN("glnvg__renderFrame");
+	glnvg__runTextureOps(gl, frame);
+	gl->statCalls = frame->ncalls;
+	gl->statMerged = frame->ncalls;
+	if (frame->ncalls > 0) {
+		int nmerged = glnvg__mergeCalls(gl, frame);
+		gl->statMerged = gl->nbatches;
 
 		// Setup require GL state.
 		glUseProgram(gl->shader.prog);
@@ -1201,41 +2410,142 @@ static void glnvg__renderFlush(void* uptr)
 
 #if NANOVG_GL_USE_UNIFORMBUFFER
 		// Upload ubo for frag shaders
-		glBindBuffer(GL_UNIFORM_BUFFER, gl->fragBuf);
-		glBufferData(GL_UNIFORM_BUFFER, gl->nuniforms * gl->fragSize, gl->uniforms, GL_STREAM_DRAW);
+		gl->fragBase = -1;
+#if NANOVG_GL_USE_STREAM
+		if (gl->streamMode != NVGL_STREAM_NONE) {
+			unsigned char* ptr = NULL;
+			gl->fragBase = glnvg__streamReserve(gl, &gl->fragStream, &gl->fragBuf, GL_UNIFORM_BUFFER,
+				frame->nuniforms * gl->fragSize, gl->fragAlign, &ptr);
+			if (gl->fragBase != -1) {
+				memcpy(ptr, frame->uniforms, frame->nuniforms * gl->fragSize);
+				glBindBuffer(GL_UNIFORM_BUFFER, gl->fragBuf);
+				glnvg__streamCommit(gl, GL_UNIFORM_BUFFER);
+			}
+		}
+#endif
+		if (gl->fragBase == -1) {
+			gl->fragBase = 0;
+			glBindBuffer(GL_UNIFORM_BUFFER, gl->fragBuf);
+			glBufferData(GL_UNIFORM_BUFFER, frame->nuniforms * gl->fragSize, frame->uniforms, GL_STREAM_DRAW);
+		}
 #endif
 
 		// Upload vertex data
 #if defined NANOVG_GL3
 		glBindVertexArray(gl->vertArr);
+#endif
+		vertBase = -1;
+#if NANOVG_GL_USE_STREAM
+		if (gl->streamVerts && frame == &gl->frame) {
+			// Written in place
+			vertBase = gl->streamBase;
+		} else if (gl->streamMode != NVGL_STREAM_NONE) {
+			unsigned char* ptr = NULL;
+			vertBase = glnvg__streamReserve(gl, &gl->vertStream, &gl->vertBuf, GL_ARRAY_BUFFER,
+				frame->nverts * sizeof(NVGvertex), sizeof(NVGvertex), &ptr);
+			if (vertBase != -1) {
+				memcpy(ptr, frame->verts, frame->nverts * sizeof(NVGvertex));
+				glBindBuffer(GL_ARRAY_BUFFER, gl->vertBuf);
+				glnvg__streamCommit(gl, GL_ARRAY_BUFFER);
+			}
+		}
 #endif
 		glBindBuffer(GL_ARRAY_BUFFER, gl->vertBuf);
-		glBufferData(GL_ARRAY_BUFFER, gl->nverts * sizeof(NVGvertex), gl->verts, GL_STREAM_DRAW);
+		if (vertBase == -1) {
+			vertBase = 0;
+			glBufferData(GL_ARRAY_BUFFER, frame->nverts * sizeof(NVGvertex), frame->verts, GL_STREAM_DRAW);
+		}
 		glEnableVertexAttribArray(0);
 		glEnableVertexAttribArray(1);
-		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(NVGvertex), (const GLvoid*)(size_t)0);
-		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(NVGvertex), (const GLvoid*)(0 + 2*sizeof(float)));
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(NVGvertex), (const GLvoid*)(size_t)vertBase);
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(NVGvertex), (const GLvoid*)(size_t)(vertBase + 2*sizeof(float)));
+#if NANOVG_GL_USE_MERGE
+		if (nmerged > 0) {
+			// Uniform slots of merged vertices and the triangle lists
+			glBindBuffer(GL_ARRAY_BUFFER, gl->slotBuf);
+			glBufferData(GL_ARRAY_BUFFER, frame->nverts * sizeof(float), gl->slots, GL_STREAM_DRAW);
+			glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(float), (const GLvoid*)(size_t)0);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gl->indexBuf);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, gl->nindices * sizeof(GLuint), gl->indices, GL_STREAM_DRAW);
+		}
+		// Calls drawn alone use the first slot
+		glVertexAttrib1f(2, 0.0f);
+#else
+		NVG_NOTUSED(nmerged);
+#endif
+
+#if NANOVG_GL_USE_PRIMITIVES
+		if (frame->ninstances > 0) {
+			glBindBuffer(GL_ARRAY_BUFFER, gl->instanceBuf);
+			glBufferData(GL_ARRAY_BUFFER, frame->ninstances * sizeof(GLNVGinstance), frame->instances, GL_STREAM_DRAW);
+		}
+		gl->primView[0] = frame->view[0];
+		gl->primView[1] = frame->view[1];
+#endif
 
 		// Set view and texture just once per frame.
 		glUniform1i(gl->shader.loc[GLNVG_LOC_TEX], 0);
-		glUniform2fv(gl->shader.loc[GLNVG_LOC_VIEWSIZE], 1, gl->view);
+		glUniform2fv(gl->shader.loc[GLNVG_LOC_VIEWSIZE], 1, frame->view);
 
 #if NANOVG_GL_USE_UNIFORMBUFFER
 		glBindBuffer(GL_UNIFORM_BUFFER, gl->fragBuf);
 #endif
 
-		for (i = 0; i < gl->ncalls; i++) {
-			GLNVGcall* call = &gl->calls[i];
+		for (i = 0; i < gl->nbatches; i++) {
+			GLNVGbatch* batch = &gl->batches[i];
+			GLNVGcall* call = &frame->calls[batch->call];
+#if NANOVG_GL_USE_TARGETS
+			if (call->type == GLNVG_TARGET) {
+				glnvg__bindTarget(gl, frame, call);
+				continue;
+			}
+			if (gl->targetFailed)
+				continue;
+#endif
 			glnvg__blendFuncSeparate(gl,&call->blendFunc);
-			if (call->type == GLNVG_FILL)
-				glnvg__fill(gl, call);
-			else if (call->type == GLNVG_CONVEXFILL)
-				glnvg__convexFill(gl, call);
-			else if (call->type == GLNVG_STROKE)
-				glnvg__stroke(gl, call);
-			else if (call->type == GLNVG_TRIANGLES)
-				glnvg__triangles(gl, call);
+#if NANOVG_GL_USE_MERGE
+			if (batch->ncalls > 1) {
+				SGE_GPU_PROFILE_BEGIN("glnvg__mergedDraw");
+				glnvg__mergedDraw(gl, frame, batch);
+				SGE_GPU_PROFILE_END();
+				continue;
+			}
+#endif
+			if (call->type == GLNVG_FILL) {
+				SGE_GPU_PROFILE_BEGIN("glnvg__fill");
+				glnvg__fill(gl, frame, call);
+				SGE_GPU_PROFILE_END();
+			} else if (call->type == GLNVG_CONVEXFILL) {
+				SGE_GPU_PROFILE_BEGIN("glnvg__convexFill");
+				glnvg__convexFill(gl, frame, call);
+				SGE_GPU_PROFILE_END();
+			} else if (call->type == GLNVG_STROKE) {
+				SGE_GPU_PROFILE_BEGIN("glnvg__stroke");
+				glnvg__stroke(gl, frame, call);
+				SGE_GPU_PROFILE_END();
+			} else if (call->type == GLNVG_TRIANGLES) {
+				SGE_GPU_PROFILE_BEGIN("glnvg__triangles");
+				glnvg__triangles(gl, frame, call);
+				SGE_GPU_PROFILE_END();
+			}
+#if NANOVG_GL_USE_PRIMITIVES
+			else if (call->type == GLNVG_PRIMITIVES) {
+				SGE_GPU_PROFILE_BEGIN("glnvg__primitives");
+				glnvg__primitives(gl, frame, call);
+				SGE_GPU_PROFILE_END();
+			}
+#endif
+		}
+
+#if NANOVG_GL_USE_TARGETS
+		// Back to the frame if a layer is left open
+		if (gl->target != 0) {
+			GLNVGcall call;
+			memset(&call, 0, sizeof(call));
+			call.type = GLNVG_TARGET;
+			glnvg__bindTarget(gl, frame, &call);
 		}
+#endif
 
 		glDisableVertexAttribArray(0);
 		glDisableVertexAttribArray(1);
@@ -1246,13 +2556,36 @@ static void glnvg__renderFlush(void* uptr)
 			glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glUseProgram(0);
 		glnvg__bindTexture(gl, 0);
+
+#if NANOVG_GL_USE_STREAM
+		glnvg__streamFence(&gl->vertStream);
+#if NANOVG_GL_USE_UNIFORMBUFFER
+		glnvg__streamFence(&gl->fragStream);
+#endif
+#endif
 	}
 
+#if NANOVG_GL_USE_STREAM
+	if (frame == &gl->frame)
+		glnvg__endStreamVerts(gl, 0);
+	glnvg__applyStreamMode(gl);
+#endif
+
 	// Reset calls
-	gl->nverts = 0;
-	gl->npaths = 0;
-	gl->ncalls = 0;
-	gl->nuniforms = 0;
+	glnvg__resetFrame(gl, frame);
+	SGE_GPU_PROFILE_END();
+}
+
+static void glnvg__renderFlush(void* uptr)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+
+	// Deferred, the recorded frame is taken by nvglSwapFrame
+	if (gl->deferred) return;
+
+	SGE_PROFILE_BEGIN("glnvg__renderFlush");
+	glnvg__renderFrame(gl, &gl->frame);
+	SGE_PROFILE_END();
 }
 
 static int glnvg__maxVertCount(const NVGpath* paths, int npaths)
@@ -1268,15 +2601,13 @@ static int glnvg__maxVertCount(const NVGpath* paths, int npaths)
 static GLNVGcall* glnvg__allocCall(GLNVGcontext* gl)
 {
 	GLNVGcall* ret = NULL;
-	if (gl->ncalls+1 > gl->ccalls) {
-		GLNVGcall* calls;
-		int ccalls = glnvg__maxi(gl->ncalls+1, 128) + gl->ccalls/2; // 1.5x Overallocate
-		calls = (GLNVGcall*)realloc(gl->calls, sizeof(GLNVGcall) * ccalls);
+	if (gl->frame.ncalls+1 > gl->frame.ccalls) {
+		GLNVGcall* calls = (GLNVGcall*)glnvg__growFrameBuffer(&gl->frame, gl->frame.calls, &gl->frame.ccalls,
+															  gl->frame.ncalls, gl->frame.ncalls+1, 128, sizeof(GLNVGcall));
 		if (calls == NULL) return NULL;
-		gl->calls = calls;
-		gl->ccalls = ccalls;
+		gl->frame.calls = calls;
 	}
-	ret = &gl->calls[gl->ncalls++];
+	ret = &gl->frame.calls[gl->frame.ncalls++];
 	memset(ret, 0, sizeof(GLNVGcall));
 	return ret;
 }
@@ -1284,54 +2615,55 @@ static GLNVGcall* glnvg__allocCall(GLNVGcontext* gl)
 static int glnvg__allocPaths(GLNVGcontext* gl, int n)
 {
 	int ret = 0;
-	if (gl->npaths+n > gl->cpaths) {
-		GLNVGpath* paths;
-		int cpaths = glnvg__maxi(gl->npaths + n, 128) + gl->cpaths/2; // 1.5x Overallocate
-		paths = (GLNVGpath*)realloc(gl->paths, sizeof(GLNVGpath) * cpaths);
+	if (gl->frame.npaths+n > gl->frame.cpaths) {
+		GLNVGpath* paths = (GLNVGpath*)glnvg__growFrameBuffer(&gl->frame, gl->frame.paths, &gl->frame.cpaths,
+															  gl->frame.npaths, gl->frame.npaths + n, 128, sizeof(GLNVGpath));
 		if (paths == NULL) return -1;
-		gl->paths = paths;
-		gl->cpaths = cpaths;
+		gl->frame.paths = paths;
 	}
-	ret = gl->npaths;
-	gl->npaths += n;
+	ret = gl->frame.npaths;
+	gl->frame.npaths += n;
 	return ret;
 }
 
 static int glnvg__allocVerts(GLNVGcontext* gl, int n)
 {
 	int ret = 0;
-	if (gl->nverts+n > gl->cverts) {
-		NVGvertex* verts;
-		int cverts = glnvg__maxi(gl->nverts + n, 4096) + gl->cverts/2; // 1.5x Overallocate
-		verts = (NVGvertex*)realloc(gl->verts, sizeof(NVGvertex) * cverts);
+#if NANOVG_GL_USE_STREAM
+	if (gl->frame.nverts == 0 && !gl->streamVerts && !gl->deferred && gl->streamMode == NVGL_STREAM_PERSISTENT)
+		glnvg__beginStreamVerts(gl);
+	// Over the region, the frame continues on the heap
+	if (gl->streamVerts && gl->frame.nverts+n > gl->frame.cverts)
+		glnvg__endStreamVerts(gl, 1);
+#endif
+	if (gl->frame.nverts+n > gl->frame.cverts) {
+		NVGvertex* verts = (NVGvertex*)glnvg__growFrameBuffer(&gl->frame, gl->frame.verts, &gl->frame.cverts,
+															  gl->frame.nverts, gl->frame.nverts + n, 4096, sizeof(NVGvertex));
 		if (verts == NULL) return -1;
-		gl->verts = verts;
-		gl->cverts = cverts;
+		gl->frame.verts = verts;
 	}
-	ret = gl->nverts;
-	gl->nverts += n;
+	ret = gl->frame.nverts;
+	gl->frame.nverts += n;
 	return ret;
 }
 
 static int glnvg__allocFragUniforms(GLNVGcontext* gl, int n)
 {
 	int ret = 0, structSize = gl->fragSize;
-	if (gl->nuniforms+n > gl->cuniforms) {
-		unsigned char* uniforms;
-		int cuniforms = glnvg__maxi(gl->nuniforms+n, 128) + gl->cuniforms/2; // 1.5x Overallocate
-		uniforms = (unsigned char*)realloc(gl->uniforms, structSize * cuniforms);
+	if (gl->frame.nuniforms+n > gl->frame.cuniforms) {
+		unsigned char* uniforms = (unsigned char*)glnvg__growFrameBuffer(&gl->frame, gl->frame.uniforms, &gl->frame.cuniforms,
+																		 gl->frame.nuniforms, gl->frame.nuniforms+n, 128, structSize);
 		if (uniforms == NULL) return -1;
-		gl->uniforms = uniforms;
-		gl->cuniforms = cuniforms;
+		gl->frame.uniforms = uniforms;
 	}
-	ret = gl->nuniforms * structSize;
-	gl->nuniforms += n;
+	ret = gl->frame.nuniforms * structSize;
+	gl->frame.nuniforms += n;
 	return ret;
 }
 
 static GLNVGfragUniforms* nvg__fragUniformPtr(GLNVGcontext* gl, int i)
 {
-	return (GLNVGfragUniforms*)&gl->uniforms[i];
+	return (GLNVGfragUniforms*)&gl->frame.uniforms[i];
 }
 
 static void glnvg__vset(NVGvertex* vtx, float x, float y, float u, float v)
@@ -1342,6 +2674,25 @@ static void glnvg__vset(NVGvertex* vtx, float x, float y, float u, float v)
 	vtx->v = v;
 }
 
+static int glnvg__imageFlags(GLNVGcontext* gl, int image)
+{
+	GLNVGtexture* tex;
+	if (image == 0) return 0;
+	tex = glnvg__findTexture(gl, image);
+	return tex != NULL ? tex->flags : 0;
+}
+
+static void glnvg__vertBounds(float* bounds, const NVGvertex* verts, int nverts)
+{
+	int i;
+	for (i = 0; i < nverts; i++) {
+		if (verts[i].x < bounds[0]) bounds[0] = verts[i].x;
+		if (verts[i].y < bounds[1]) bounds[1] = verts[i].y;
+		if (verts[i].x > bounds[2]) bounds[2] = verts[i].x;
+		if (verts[i].y > bounds[3]) bounds[3] = verts[i].y;
+	}
+}
+
 static void glnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
 							  const float* bounds, const NVGpath* paths, int npaths)
 {
@@ -1359,6 +2710,7 @@ static void glnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperation
 	if (call->pathOffset == -1) goto error;
 	call->pathCount = npaths;
 	call->image = paint->image;
+	call->imageFlags = glnvg__imageFlags(gl, paint->image);
 	call->blendFunc = glnvg__blendCompositeOperation(compositeOperation);
 
 	if (npaths == 1 && paths[0].convex)
@@ -1373,19 +2725,19 @@ static void glnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperation
 	if (offset == -1) goto error;
 
 	for (i = 0; i < npaths; i++) {
-		GLNVGpath* copy = &gl->paths[call->pathOffset + i];
+		GLNVGpath* copy = &gl->frame.paths[call->pathOffset + i];
 		const NVGpath* path = &paths[i];
 		memset(copy, 0, sizeof(GLNVGpath));
 		if (path->nfill > 0) {
 			copy->fillOffset = offset;
 			copy->fillCount = path->nfill;
-			memcpy(&gl->verts[offset], path->fill, sizeof(NVGvertex) * path->nfill);
+			memcpy(&gl->frame.verts[offset], path->fill, sizeof(NVGvertex) * path->nfill);
 			offset += path->nfill;
 		}
 		if (path->nstroke > 0) {
 			copy->strokeOffset = offset;
 			copy->strokeCount = path->nstroke;
-			memcpy(&gl->verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
+			memcpy(&gl->frame.verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
 			offset += path->nstroke;
 		}
 	}
@@ -1394,7 +2746,7 @@ static void glnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperation
 	if (call->type == GLNVG_FILL) {
 		// Quad
 		call->triangleOffset = offset;
-		quad = &gl->verts[call->triangleOffset];
+		quad = &gl->frame.verts[call->triangleOffset];
 		glnvg__vset(&quad[0], bounds[2], bounds[3], 0.5f, 1.0f);
 		glnvg__vset(&quad[1], bounds[2], bounds[1], 0.5f, 1.0f);
 		glnvg__vset(&quad[2], bounds[0], bounds[3], 0.5f, 1.0f);
@@ -1421,7 +2773,7 @@ static void glnvg__renderFill(void* uptr, NVGpaint* paint, NVGcompositeOperation
 error:
 	// We get here if call alloc was ok, but something else is not.
 	// Roll back the last call to prevent drawing it.
-	if (gl->ncalls > 0) gl->ncalls--;
+	if (gl->frame.ncalls > 0) gl->frame.ncalls--;
 }
 
 static void glnvg__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
@@ -1438,6 +2790,7 @@ static void glnvg__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperati
 	if (call->pathOffset == -1) goto error;
 	call->pathCount = npaths;
 	call->image = paint->image;
+	call->imageFlags = glnvg__imageFlags(gl, paint->image);
 	call->blendFunc = glnvg__blendCompositeOperation(compositeOperation);
 
 	// Allocate vertices for all the paths.
@@ -1445,19 +2798,25 @@ static void glnvg__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperati
 	offset = glnvg__allocVerts(gl, maxverts);
 	if (offset == -1) goto error;
 
+	// Bounds for merging, taken from the source since frame vertices may be in write only memory
+	call->bounds[0] = call->bounds[1] = 1e6f;
+	call->bounds[2] = call->bounds[3] = -1e6f;
 	for (i = 0; i < npaths; i++) {
-		GLNVGpath* copy = &gl->paths[call->pathOffset + i];
+		GLNVGpath* copy = &gl->frame.paths[call->pathOffset + i];
 		const NVGpath* path = &paths[i];
 		memset(copy, 0, sizeof(GLNVGpath));
 		if (path->nstroke) {
 			copy->strokeOffset = offset;
 			copy->strokeCount = path->nstroke;
-			memcpy(&gl->verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
+			memcpy(&gl->frame.verts[offset], path->stroke, sizeof(NVGvertex) * path->nstroke);
+			if (gl->flags & NVG_STENCIL_STROKES)
+				glnvg__vertBounds(call->bounds, path->stroke, path->nstroke);
 			offset += path->nstroke;
 		}
 	}
 
 	if (gl->flags & NVG_STENCIL_STROKES) {
+
 		// Fill shader
 		call->uniformOffset = glnvg__allocFragUniforms(gl, 2);
 		if (call->uniformOffset == -1) goto error;
@@ -1477,20 +2836,20 @@ static void glnvg__renderStroke(void* uptr, NVGpaint* paint, NVGcompositeOperati
 error:
 	// We get here if call alloc was ok, but something else is not.
 	// Roll back the last call to prevent drawing it.
-	if (gl->ncalls > 0) gl->ncalls--;
+	if (gl->frame.ncalls > 0) gl->frame.ncalls--;
 }
 
-static void glnvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
-								   const NVGvertex* verts, int nverts)
+static GLNVGfragUniforms* glnvg__addTriangles(GLNVGcontext* gl, NVGpaint* paint, NVGcompositeOperationState compositeOperation,
+											  NVGscissor* scissor, const NVGvertex* verts, int nverts)
 {
-	GLNVGcontext* gl = (GLNVGcontext*)uptr;
 	GLNVGcall* call = glnvg__allocCall(gl);
 	GLNVGfragUniforms* frag;
 
-	if (call == NULL) return;
+	if (call == NULL) return NULL;
 
 	call->type = GLNVG_TRIANGLES;
 	call->image = paint->image;
+	call->imageFlags = glnvg__imageFlags(gl, paint->image);
 	call->blendFunc = glnvg__blendCompositeOperation(compositeOperation);
 
 	// Allocate vertices for all the paths.
@@ -1498,7 +2857,7 @@ static void glnvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOper
 	if (call->triangleOffset == -1) goto error;
 	call->triangleCount = nverts;
 
-	memcpy(&gl->verts[call->triangleOffset], verts, sizeof(NVGvertex) * nverts);
+	memcpy(&gl->frame.verts[call->triangleOffset], verts, sizeof(NVGvertex) * nverts);
 
 	// Fill shader
 	call->uniformOffset = glnvg__allocFragUniforms(gl, 1);
@@ -1507,14 +2866,152 @@ static void glnvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOper
 	glnvg__convertPaint(gl, frag, paint, scissor, 1.0f, 1.0f, -1.0f);
 	frag->type = NSVG_SHADER_IMG;
 
-	return;
+	return frag;
 
 error:
 	// We get here if call alloc was ok, but something else is not.
 	// Roll back the last call to prevent drawing it.
-	if (gl->ncalls > 0) gl->ncalls--;
+	if (gl->frame.ncalls > 0) gl->frame.ncalls--;
+	return NULL;
 }
 
+static void glnvg__renderTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+								   const NVGvertex* verts, int nverts)
+{
+	glnvg__addTriangles((GLNVGcontext*)uptr, paint, compositeOperation, scissor, verts, nverts);
+}
+
+#if NANOVG_GL_USE_SDF
+static void glnvg__renderSDFTriangles(void* uptr, NVGpaint* paint, NVGcompositeOperationState compositeOperation, NVGscissor* scissor,
+									  float blur, const NVGvertex* verts, int nverts)
+{
+	GLNVGfragUniforms* frag = glnvg__addTriangles((GLNVGcontext*)uptr, paint, compositeOperation, scissor, verts, nverts);
+	if (frag == NULL) return;
+	frag->texType = 3;
+	frag->feather = blur;
+}
+#endif
+
+#if NANOVG_GL_USE_TARGETS
+static void glnvg__renderTarget(void* uptr, int image, int clear)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+	GLNVGcall* call = glnvg__allocCall(gl);
+	if (call == NULL) return;
+	call->type = GLNVG_TARGET;
+	call->image = image;
+	call->triangleCount = clear;
+}
+#endif
+
+#if NANOVG_GL_USE_PRIMITIVES
+static int glnvg__allocInstances(GLNVGcontext* gl, int n)
+{
+	int ret = 0;
+	if (gl->frame.ninstances+n > gl->frame.cinstances) {
+		GLNVGinstance* instances = (GLNVGinstance*)glnvg__growFrameBuffer(&gl->frame, gl->frame.instances, &gl->frame.cinstances,
+																		  gl->frame.ninstances, gl->frame.ninstances + n, 256, sizeof(GLNVGinstance));
+		if (instances == NULL) return -1;
+		gl->frame.instances = instances;
+	}
+	ret = gl->frame.ninstances;
+	gl->frame.ninstances += n;
+	return ret;
+}
+
+static void glnvg__instanceColor(float* dst, NVGcolor c, float alpha)
+{
+	c = glnvg__premulColor(c);
+	dst[0] = c.r * alpha;
+	dst[1] = c.g * alpha;
+	dst[2] = c.b * alpha;
+	dst[3] = c.a * alpha;
+}
+
+static void glnvg__renderPrimitives(void* uptr, NVGcompositeOperationState compositeOperation, NVGscissor* scissor, float fringe,
+									const float* xform, float alpha, const NVGprimitive* prims, int nprims)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)uptr;
+	GLNVGcall* call = gl->frame.ncalls > 0 ? &gl->frame.calls[gl->frame.ncalls-1] : NULL;
+	GLNVGblend blend = glnvg__blendCompositeOperation(compositeOperation);
+	GLNVGfragUniforms frag;
+	NVGpaint paint;
+	float scale = (sqrtf(xform[0]*xform[0] + xform[2]*xform[2]) + sqrtf(xform[1]*xform[1] + xform[3]*xform[3])) * 0.5f;
+	int i, offset;
+
+	if (scale <= 0.0f) return;
+
+	// Only the scissor of the uniforms is used
+	memset(&paint, 0, sizeof(paint));
+	nvgTransformIdentity(paint.xform);
+	glnvg__convertPaint(gl, &frag, &paint, scissor, 1.0f, fringe, -1.0f);
+
+	offset = glnvg__allocInstances(gl, nprims);
+	if (offset == -1) return;
+
+	// Continue the last call if it draws the previous instances with the same state
+	if (call == NULL || call->type != GLNVG_PRIMITIVES || call->triangleOffset + call->triangleCount != offset ||
+		memcmp(&call->blendFunc, &blend, sizeof(blend)) != 0 ||
+		memcmp(nvg__fragUniformPtr(gl, call->uniformOffset), &frag, sizeof(frag)) != 0) {
+		call = glnvg__allocCall(gl);
+		if (call == NULL) goto error;
+		call->type = GLNVG_PRIMITIVES;
+		call->blendFunc = blend;
+		call->triangleOffset = offset;
+		call->uniformOffset = glnvg__allocFragUniforms(gl, 1);
+		if (call->uniformOffset == -1) {
+			gl->frame.ncalls--;
+			goto error;
+		}
+		memcpy(nvg__fragUniformPtr(gl, call->uniformOffset), &frag, sizeof(frag));
+	}
+	call->triangleCount += nprims;
+
+	for (i = 0; i < nprims; i++) {
+		const NVGprimitive* prim = &prims[i];
+		GLNVGinstance* inst = &gl->frame.instances[offset + i];
+		float hw, hh, radius, border = 0.0f;
+
+		if (prim->type == NVG_PRIM_LINE) {
+			float dx = prim->w - prim->x, dy = prim->h - prim->y;
+			float len = sqrtf(dx*dx + dy*dy);
+			radius = prim->radius;
+			hw = len*0.5f + radius;
+			hh = radius;
+			inst->axis[0] = len > 0.0f ? dx / len : 1.0f;
+			inst->axis[1] = len > 0.0f ? dy / len : 0.0f;
+			inst->shape[0] = (prim->x + prim->w) * 0.5f;
+			inst->shape[1] = (prim->y + prim->h) * 0.5f;
+		} else {
+			float half;
+			hw = fabsf(prim->w) * 0.5f;
+			hh = fabsf(prim->h) * 0.5f;
+			half = hw < hh ? hw : hh;
+			radius = prim->radius < half ? prim->radius : half;
+			if (prim->feather <= 0.0f)
+				border = prim->border < half ? prim->border : half;
+			inst->axis[0] = 1.0f;
+			inst->axis[1] = 0.0f;
+			inst->shape[0] = prim->x + prim->w * 0.5f;
+			inst->shape[1] = prim->y + prim->h * 0.5f;
+		}
+		inst->shape[2] = hw;
+		inst->shape[3] = hh;
+		inst->axis[2] = radius > 0.0f ? radius : 0.0f;
+		inst->axis[3] = border;
+		glnvg__instanceColor(inst->fillColor, prim->fillColor, alpha);
+		glnvg__instanceColor(inst->borderColor, prim->borderColor, alpha);
+		memcpy(inst->xform, xform, sizeof(float) * 6);
+		inst->xform[6] = prim->feather > 0.0f ? prim->feather : 0.0f;
+		inst->xform[7] = fringe / scale;
+	}
+	return;
+
+error:
+	gl->frame.ninstances -= nprims;
+}
+#endif
+
 static void glnvg__renderDelete(void* uptr)
 {
 	GLNVGcontext* gl = (GLNVGcontext*)uptr;
@@ -1522,6 +3019,21 @@ static void glnvg__renderDelete(void* uptr)
 	if (gl == NULL) return;
 
 	glnvg__deleteShader(&gl->shader);
+#if NANOVG_GL_USE_PRIMITIVES
+	glnvg__deleteShader(&gl->primShader);
+	if (gl->primArr != 0)
+		glDeleteVertexArrays(1, &gl->primArr);
+	if (gl->instanceBuf != 0)
+		glDeleteBuffers(1, &gl->instanceBuf);
+#endif
+
+#if NANOVG_GL_USE_STREAM
+	glnvg__endStreamVerts(gl, 0);
+	glnvg__streamRelease(&gl->vertStream, &gl->vertBuf, GL_ARRAY_BUFFER);
+#if NANOVG_GL_USE_UNIFORMBUFFER
+	glnvg__streamRelease(&gl->fragStream, &gl->fragBuf, GL_UNIFORM_BUFFER);
+#endif
+#endif
 
 #if NANOVG_GL3
 #if NANOVG_GL_USE_UNIFORMBUFFER
@@ -1533,17 +3045,32 @@ static void glnvg__renderDelete(void* uptr)
 #endif
 	if (gl->vertBuf != 0)
 		glDeleteBuffers(1, &gl->vertBuf);
+#if NANOVG_GL_USE_MERGE
+	if (gl->slotBuf != 0)
+		glDeleteBuffers(1, &gl->slotBuf);
+	if (gl->indexBuf != 0)
+		glDeleteBuffers(1, &gl->indexBuf);
+	free(gl->indices);
+	free(gl->slots);
+	free(gl->mergeUniforms);
+#endif
+	free(gl->batches);
 
 	for (i = 0; i < gl->ntextures; i++) {
+#if NANOVG_GL_USE_TARGETS
+		glnvg__deleteTargetGL(&gl->textures[i].fbo, &gl->textures[i].rbo);
+#endif
 		if (gl->textures[i].tex != 0 && (gl->textures[i].flags & NVG_IMAGE_NODELETE) == 0)
 			glDeleteTextures(1, &gl->textures[i].tex);
 	}
 	free(gl->textures);
 
-	free(gl->paths);
-	free(gl->verts);
-	free(gl->uniforms);
-	free(gl->calls);
+	for (i = 0; i < gl->frame.ntexops; i++)
+		free(gl->frame.texops[i].data);
+	free(gl->frame.texops);
+	free(gl->names);
+
+	nvgDeleteArena(gl->frame.arena);
 
 	free(gl);
 }
@@ -1577,6 +3104,15 @@ NVGcontext* nvgCreateGLES3(int flags)
 	params.renderFill = glnvg__renderFill;
 	params.renderStroke = glnvg__renderStroke;
 	params.renderTriangles = glnvg__renderTriangles;
+#if NANOVG_GL_USE_SDF
+	params.renderSDFTriangles = glnvg__renderSDFTriangles;
+#endif
+#if NANOVG_GL_USE_TARGETS
+	params.renderTarget = glnvg__renderTarget;
+#endif
+#if NANOVG_GL_USE_PRIMITIVES
+	params.renderPrimitives = glnvg__renderPrimitives;
+#endif
 	params.renderDelete = glnvg__renderDelete;
 	params.userPtr = gl;
 	params.edgeAntiAlias = flags & NVG_ANTIALIAS ? 1 : 0;
@@ -1628,6 +3164,18 @@ int nvglCreateImageFromHandleGLES3(NVGcontext* ctx, GLuint textureId, int w, int
 	tex->width = w;
 	tex->height = h;
 
+	if (gl->deferred) {
+		GLNVGtextureOp* op = glnvg__allocTextureOp(gl);
+		if (op == NULL) {
+			memset(tex, 0, sizeof(*tex));
+			return 0;
+		}
+		op->op = GLNVG_TEXOP_HANDLE;
+		op->image = tex->id;
+		op->flags = imageFlags;
+		op->handle = textureId;
+	}
+
 	return tex->id;
 }
 
@@ -1646,4 +3194,121 @@ GLuint nvglImageHandleGLES3(NVGcontext* ctx, int image)
 	return tex->tex;
 }
 
+NVGLframe* nvglCreateFrame(void)
+{
+	NVGLframe* frame = (NVGLframe*)malloc(sizeof(NVGLframe));
+	if (frame == NULL) return NULL;
+	memset(frame, 0, sizeof(NVGLframe));
+	return frame;
+}
+
+void nvglDeleteFrame(NVGLframe* frame)
+{
+	int i;
+	if (frame == NULL) return;
+	for (i = 0; i < frame->ntexops; i++)
+		free(frame->texops[i].data);
+	free(frame->texops);
+	nvgDeleteArena(frame->arena);
+	free(frame);
+}
+
+void nvglSetDeferred(NVGcontext* ctx, int deferred)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	int i;
+
+	deferred = deferred ? 1 : 0;
+	if (gl->deferred == deferred) return;
+
+	if (deferred) {
+		// Hand over the existing textures to the GL thread
+		gl->nnames = 0;
+		for (i = 0; i < gl->ntextures; i++) {
+			GLNVGtextureName* name;
+			if (gl->textures[i].id == 0) continue;
+			name = glnvg__allocTextureName(gl);
+			if (name == NULL) break;
+			name->id = gl->textures[i].id;
+			name->tex = gl->textures[i].tex;
+			name->fbo = gl->textures[i].fbo;
+			name->rbo = gl->textures[i].rbo;
+			name->width = gl->textures[i].width;
+			name->height = gl->textures[i].height;
+			name->flags = gl->textures[i].flags;
+		}
+	} else {
+		// Take back the textures, includes the commands not swapped out
+		glnvg__runTextureOps(gl, &gl->frame);
+		for (i = 0; i < gl->nnames; i++) {
+			GLNVGtexture* tex;
+			if (gl->names[i].id == 0) continue;
+			tex = glnvg__findTexture(gl, gl->names[i].id);
+			if (tex != NULL) {
+				tex->tex = gl->names[i].tex;
+				tex->fbo = gl->names[i].fbo;
+				tex->rbo = gl->names[i].rbo;
+			}
+		}
+		gl->nnames = 0;
+	}
+	gl->deferred = deferred;
+}
+
+void nvglSwapFrame(NVGcontext* ctx, NVGLframe* frame)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	GLNVGframe recorded = gl->frame;
+
+	// The frame must be drawn before reused, keep its buffers for recording
+	gl->frame = *frame;
+	glnvg__resetFrame(gl, &gl->frame);
+	gl->frame.ntexops = 0;
+	*frame = recorded;
+}
+
+void nvglRenderFrame(NVGcontext* ctx, NVGLframe* frame)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	SGE_PROFILE_BEGIN("nvglRenderFrame");
+	glnvg__renderFrame(gl, frame);
+	SGE_PROFILE_END();
+}
+
+void nvglSetMergeCalls(NVGcontext* ctx, int merge)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	gl->merge = merge && gl->mergeSize > 1 ? 1 : 0;
+}
+
+int nvglSetStreamMode(NVGcontext* ctx, int mode)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)nvgInternalParams(ctx)->userPtr;
+#if NANOVG_GL_USE_STREAM
+	if (mode == NVGL_STREAM_PERSISTENT && gl->bufferStorage == NULL)
+		mode = NVGL_STREAM_ORPHAN;
+	if (mode < NVGL_STREAM_NONE || mode > NVGL_STREAM_PERSISTENT)
+		mode = NVGL_STREAM_NONE;
+	gl->nextStreamMode = mode;
+	return mode;
+#else
+	NVG_NOTUSED(gl);
+	NVG_NOTUSED(mode);
+	return NVGL_STREAM_NONE;
+#endif
+}
+
+void nvglFrameStats(NVGcontext* ctx, int* calls, int* merged)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	if (calls != NULL) *calls = gl->statCalls;
+	if (merged != NULL) *merged = gl->statMerged;
+}
+
+void nvglMemoryStats(NVGcontext* ctx, NVGarenaStats* stats)
+{
+	GLNVGcontext* gl = (GLNVGcontext*)nvgInternalParams(ctx)->userPtr;
+	nvgArenaStats(gl->frame.arena, stats);
+}
+
 #endif /* NANOVG_GL_IMPLEMENTATION */
@@ -99,10 +99,11 @@ namespace sge
                 {
                     requestMeasure();
                 }
+                invalidate();
             }
         }
 
-        inline const char * Label::getText() { return d->mText.c_str(); }
+        const char * Label::getText() { return d->mText.c_str(); }
 
         void Label::setMuiltLine(bool enable)
         {
@@ -115,10 +116,11 @@ namespace sge
                 {
                     requestMeasure();
                 }
+                invalidate();
             }
         }
 
-        inline bool Label::isMuiltLine()
+        bool Label::isMuiltLine()
         {
             return d->mMuiltLine;
         }
@@ -137,16 +139,17 @@ namespace sge
                 {
                     requestMeasure();
                 }
+                invalidate();
             }
         }
 
-        inline const char * Label::getFont()
+        const char * Label::getFont()
         {
             return d->mFont.c_str();
         }
 
 
-        inline void Label::setFontSize(float size)
+        void Label::setFontSize(float size)
         {
             if (size > 0 && size != d->mFontSize)
             {
@@ -157,29 +160,32 @@ namespace sge
                 {
                     requestMeasure();
                 }
+                invalidate();
             }
         }
-        inline float Label::getFontSize()
+        float Label::getFontSize()
         {
             return d->mFontSize;
         }
 
-        inline void Label::setFontColor(const float4 & color)
+        void Label::setFontColor(const float4 & color)
         {
             d->mFontColor = color;
+            invalidate();
         }
 
-        inline float4 Label::getFontColor()
+        float4 Label::getFontColor()
         {
             return d->mFontColor;
         }
 
-        inline void Label::setAlignment(Alignment align)
+        void Label::setAlignment(Alignment align)
         {
             d->mAlign = align;
+            invalidate();
         }
 
-        inline Alignment Label::getAlignment()
+        Alignment Label::getAlignment()
         {
             return d->mAlign;
         }
@@ -43,7 +43,10 @@
 #include <ui/sgeView.h>
 #include <core/sgeApplication.h>
 #include <core/sgeRenderer.h>
+#include <core/sgeScene.h>
 #include <ui/sgeViewGroup.h>
+#include <algorithm>
+#include <math.h>
 
 namespace sge
 {
@@ -69,10 +72,22 @@ namespace sge
             int         mTop;
             int         mWidth;
             int         mHeight;
+            float       mAlpha;
+            float2      mTranslation;
+
+            // the offscreen layer, drawn again while dirty
+            bool        mLayer;
+            bool        mLayerDirty;
+            // the children are being drawn into the layer
+            bool        mLayerDrawing;
+            int         mLayerId;
+            int2        mLayerSize;
 
             ViewPrivate(Application* app_not_null)
                 : mApp(app_not_null), mFlag(PFLAG_MEASURE | PFLAG_RELAYOUT),
                 mLeft(0), mTop(0), mWidth(0), mHeight(0),
+                mAlpha(1.0f), mTranslation(0, 0),
+                mLayer(false), mLayerDirty(true), mLayerDrawing(false), mLayerId(0), mLayerSize(0, 0),
                 mParent(NULL), mLayoutParam(NULL)
             {}
 
@@ -80,8 +95,56 @@ namespace sge
             {
                 ASSERT(mParent == NULL && "release but not remove from parent");
             }
+
+            /**
+             * Report a rect of the view to the parent, clipped by the frame as
+             * the scissor of doDraw, the layer of the view is not changed
+             */
+            void reportDamage(int x, int y, int width, int height)
+            {
+                int left = std::max(x, 0) + mLeft + (int)floorf(mTranslation.x);
+                int top = std::max(y, 0) + mTop + (int)floorf(mTranslation.y);
+                int right = std::min(x + width, mWidth) + mLeft + (int)ceilf(mTranslation.x);
+                int bottom = std::min(y + height, mHeight) + mTop + (int)ceilf(mTranslation.y);
+                if (mParent)
+                {
+                    mParent->invalidate(left, top, right - left, bottom - top);
+                    return;
+                }
+
+                Scene* scene = mApp->getCurrentScene();
+                if (scene)
+                {
+                    scene->invalidate(left, top, right - left, bottom - top);
+                }
+            }
+
+            void releaseLayer()
+            {
+                if (mLayerId)
+                {
+                    mApp->getRenderer()->releaseLayer(mLayerId);
+                    mLayerId = 0;
+                }
+                mLayerDirty = true;
+            }
         };
 
+        /**
+         * Outline the frame of views in debug
+         */
+        static void drawDebugFrame(Renderer* renderer, int width, int height)
+        {
+#ifdef _DEBUG
+            renderer->beginPath();            
+            renderer->rect(0, 0, (float)width, (float)height);
+            renderer->setStrokeColor(0, 0.6f, 0, 1.0f);
+            renderer->setStrokeWidth(4);
+            renderer->strokePath();
+            renderer->beginPath();
+#endif // _DEBUG
+        }
+
         View::View(Application* app_not_null)
             : d(new ViewPrivate(app_not_null))
         {
@@ -92,6 +155,7 @@ namespace sge
         {
             if (d)
             {
+                d->releaseLayer();
                 if (d->mParent)
                 {
                     d->mParent->removeChild(this);
@@ -102,11 +166,11 @@ namespace sge
             }
         }
         
-        inline Application* View::getApplication() const { return d->mApp; }
-        inline int View::getMeasuredWidth() const { return d->mWidth; }
-        inline int View::getMeasuredHeight() const { return d->mHeight; }
-        inline RefPtr<LayoutParams> View::getLayoutParams() const { return d->mLayoutParam; }
-        inline bool View::setLayoutParams(RefPtr<LayoutParams> params) 
+        Application* View::getApplication() const { return d->mApp; }
+        int View::getMeasuredWidth() const { return d->mWidth; }
+        int View::getMeasuredHeight() const { return d->mHeight; }
+        RefPtr<LayoutParams> View::getLayoutParams() const { return d->mLayoutParam; }
+        bool View::setLayoutParams(RefPtr<LayoutParams> params) 
         {
             if (d->mParent)
             {
@@ -116,29 +180,78 @@ namespace sge
             d->mLayoutParam = params;
             return true;
         }
-        inline ViewGroup* View::getParent() const { return d->mParent; }
-        inline void View::setParent(ViewGroup* parent)
+        ViewGroup* View::getParent() const { return d->mParent; }
+        void View::setParent(ViewGroup* parent)
         {
             ASSERT(parent == NULL || d->mParent == NULL);
             d->mParent = parent;
         }
-        inline void View::requestMeasure() 
+        void View::requestMeasure() 
         {
             ADD_FLAG(d->mFlag, PFLAG_MEASURE);
+            d->mLayerDirty = true;
             if (d->mParent)
             {
                 ADD_FLAG(d->mParent->d->mFlag, PFLAG_RELAYOUT);
                 d->mParent->requestMeasure();
             }
+            else
+            {
+                // the layout may move any view, redraw the whole scene
+                Scene* scene = d->mApp->getCurrentScene();
+                if (scene)
+                {
+                    scene->invalidate();
+                }
+            }
+        }
+        void View::invalidate()
+        {
+            invalidate(0, 0, d->mWidth, d->mHeight);
+        }
+        void View::invalidate(int x, int y, int width, int height)
+        {
+            d->mLayerDirty = true;
+            d->reportDamage(x, y, width, height);
         }
-        inline void View::onLayout(bool changed, int left, int top, int right, int bottom) {}
-        inline void View::onSizeChanged(int newWidth, int newHeight, int oldWidth, int oldHeight) {}
-        inline int View::getLeft() { return d->mLeft; }
-        inline int View::getTop() { return d->mTop; }
-        inline int View::getWidth() { return d->mWidth; }
-        inline int View::getHeight() { return d->mHeight; }
+        void View::setAlpha(float alpha)
+        {
+            alpha = std::min(std::max(alpha, 0.0f), 1.0f);
+            if (alpha != d->mAlpha)
+            {
+                d->mAlpha = alpha;
+                d->reportDamage(0, 0, d->mWidth, d->mHeight);
+            }
+        }
+        float View::getAlpha() { return d->mAlpha; }
+        void View::setTranslation(float x, float y)
+        {
+            if (x != d->mTranslation.x || y != d->mTranslation.y)
+            {
+                d->reportDamage(0, 0, d->mWidth, d->mHeight);
+                d->mTranslation = float2(x, y);
+                d->reportDamage(0, 0, d->mWidth, d->mHeight);
+            }
+        }
+        float2 View::getTranslation() { return d->mTranslation; }
+        void View::setLayerEnabled(bool enable)
+        {
+            if (enable != d->mLayer)
+            {
+                d->mLayer = enable;
+                d->releaseLayer();
+                d->reportDamage(0, 0, d->mWidth, d->mHeight);
+            }
+        }
+        bool View::isLayerEnabled() { return d->mLayer; }
+        void View::onLayout(bool changed, int left, int top, int right, int bottom) {}
+        void View::onSizeChanged(int newWidth, int newHeight, int oldWidth, int oldHeight) {}
+        int View::getLeft() { return d->mLeft; }
+        int View::getTop() { return d->mTop; }
+        int View::getWidth() { return d->mWidth; }
+        int View::getHeight() { return d->mHeight; }
 
-        inline int2 View::onMeasure(MeasureMode wMode, int wSize, MeasureMode hMode, int hSize)
+        int2 View::onMeasure(MeasureMode wMode, int wSize, MeasureMode hMode, int hSize)
         {
             int2 ret = int2(getDefaultSize(d->mLayoutParam->mWidth, wMode, wSize),
                 getDefaultSize(d->mLayoutParam->mHeight, hMode, hSize));
@@ -147,7 +260,7 @@ namespace sge
             return ret;
         }
 
-        inline void View::doMeasure(MeasureMode wMode, int wSize, MeasureMode hMode, int hSize)
+        void View::doMeasure(MeasureMode wMode, int wSize, MeasureMode hMode, int hSize)
         {
             if (HAS_FLAG(d->mFlag, PFLAG_MEASURE))
             {
@@ -176,22 +289,62 @@ namespace sge
 
         void View::doDraw()
         {
+            // the parents drawing this into their layer apply their alpha with it,
+            // those failed to update the layer are drawn directly and fade with the rest
+            float alpha = d->mAlpha;
+            for (View* parent = d->mParent; parent && !parent->d->mLayerDrawing; parent = parent->d->mParent)
+            {
+                alpha *= parent->d->mAlpha;
+            }
+            if (alpha <= 0.0f)
+                return;
+
             Renderer* renderer = d->mApp->getRenderer();
+            bool layer = d->mLayer && updateLayer();
             int saveCount = renderer->save();
-            renderer->doTranslate((float)d->mLeft, (float)d->mTop);
+            renderer->doTranslate((float)d->mLeft + d->mTranslation.x, (float)d->mTop + d->mTranslation.y);
             renderer->addIntersectScissor((float)d->mLeft, (float)d->mTop, (float)d->mWidth, (float)d->mHeight);
-            onDraw();
-#ifdef _DEBUG
-            renderer->beginPath();            
-            renderer->rect(0, 0, (float)d->mWidth, (float)d->mHeight);
-            renderer->setStrokeColor(0, 0.6f, 0, 1.0f);
-            renderer->setStrokeWidth(4);
-            renderer->strokePath();
-            renderer->beginPath();
-#endif // _DEBUG
+            if (layer)
+            {
+                renderer->drawLayer(d->mLayerId, 0, 0, (float)d->mWidth, (float)d->mHeight, alpha);
+            }
+            else
+            {
+                if (alpha < 1.0f)
+                    renderer->globalAlpha(alpha);
+                onDraw();
+                drawDebugFrame(renderer, d->mWidth, d->mHeight);
+            }
             renderer->restore(saveCount);
         }
 
+        bool View::updateLayer()
+        {
+            Renderer* renderer = d->mApp->getRenderer();
+            int2 size(d->mWidth, d->mHeight);
+            if (d->mLayerId == 0 || d->mLayerSize != size)
+            {
+                d->releaseLayer();
+                d->mLayerId = renderer->acquireLayer(size.x, size.y);
+                d->mLayerSize = size;
+            }
+            if (d->mLayerId == 0)
+                return false;
+
+            if (d->mLayerDirty)
+            {
+                if (!renderer->beginLayer(d->mLayerId))
+                    return false;
+                d->mLayerDrawing = true;
+                onDraw();
+                drawDebugFrame(renderer, d->mWidth, d->mHeight);
+                d->mLayerDrawing = false;
+                renderer->endLayer();
+                d->mLayerDirty = false;
+            }
+            return true;
+        }
+
         bool View::setFrame(int left, int top, int width, int height)
         {
             bool changed = false;
@@ -77,6 +77,7 @@ namespace sge
             }
             view->setParent(this);
             mChildren.push_back(view);
+            invalidate();
         }
 
         void ViewGroup::removeChild(View* view)
@@ -94,9 +95,9 @@ namespace sge
             requestMeasure();
         }
 
-        inline RefPtr<View> ViewGroup::getChildAt(int index) { return mChildren[index]; }
-        inline int ViewGroup::getChildCount() { return mChildren.size(); }
-        inline int ViewGroup::getChildIndex(View* view)
+        RefPtr<View> ViewGroup::getChildAt(int index) { return mChildren[index]; }
+        int ViewGroup::getChildCount() { return mChildren.size(); }
+        int ViewGroup::getChildIndex(View* view)
         {
             int ret = -1;
             int count = getChildCount();
@@ -173,7 +174,7 @@ namespace sge
             return RefPtr<LayoutParams>(new LayoutParams(WRAP_CONTENT, WRAP_CONTENT));
         }
 
-        inline bool ViewGroup::acceptChildLayoutParams(LayoutParams * params)
+        bool ViewGroup::acceptChildLayoutParams(LayoutParams * params)
         {
             if (params)
             {
@@ -187,7 +188,7 @@ namespace sge
             return false;
         }
 
-        inline void ViewGroup::onDraw()
+        void ViewGroup::onDraw()
         {
             int count = getChildCount();
             for (int i = 0; i < count; i++)
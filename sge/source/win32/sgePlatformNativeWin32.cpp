@@ -177,7 +177,7 @@ namespace sge
         UnregisterClassA(ENGINE_WIN32_WND_CLASS, 0);
     }
 
-    inline int2 PlatformWin32Native::getWindowSize()
+    int2 PlatformWin32Native::getWindowSize()
     {
         RECT rect;
         GetClientRect(_hWnd, &rect);
@@ -200,6 +200,12 @@ namespace sge
         return false;
     }
 
+    bool PlatformWin32Native::waitEvents(unsigned long ms)
+    {
+        DWORD ret = MsgWaitForMultipleObjects(0, NULL, FALSE, ms, QS_ALLINPUT);
+        return ret == WAIT_OBJECT_0;
+    }
+
     LRESULT PlatformWin32Native::wndProc(HWND hWnd, UINT msgId, WPARAM wParam, LPARAM lParam)
     {
         bool ret = false;